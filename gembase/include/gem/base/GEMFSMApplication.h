@@ -139,6 +139,13 @@ namespace gem {
        * @brief
        */
       bool reset(toolbox::task::WorkLoop *wl);
+
+      /**
+       * @brief sends the latest state to the GEMSupervisor(s), retrying with a back off on failure
+       * Runs in its own workloop, so a slow or absent supervisor does not hold up the transitions
+       * @returns true if the action has to run again, for a retry or a newer state
+       */
+      bool notify(toolbox::task::WorkLoop *wl);
       // bool noAction(toolbox::task::WorkLoop *wl) { return false; };
       // bool fail(toolbox::task::WorkLoop *wl) { return false; };
 
@@ -220,10 +227,22 @@ namespace gem {
 
       /**
        * @brief stateChanged
-       *
+       * Called by the GEMFSM after every state change, pushes the new state to any GEMSupervisor
        */
       virtual void stateChanged(toolbox::fsm::FiniteStateMachine &fsm);
 
+      /**
+       * @brief queues the current state and state message to be sent to the GEMSupervisor(s) in the zone
+       * Failures are not fatal, the supervisor falls back to querying the state
+       */
+      void notifySupervisors();
+
+      /**
+       * @brief sends a state notification to the GEMSupervisor(s) in the zone
+       * @returns false if sending to any of them failed
+       */
+      bool sendStateNotification(std::string const& stateName, std::string const& stateMessage);
+
       /**
        * @brief transitionFailed
        */
@@ -254,6 +273,7 @@ namespace gem {
       toolbox::task::ActionSignature* m_resumeSig;  ///<
       toolbox::task::ActionSignature* m_haltSig  ;  ///<
       toolbox::task::ActionSignature* m_resetSig ;  ///<
+      toolbox::task::ActionSignature* m_notifySig;  ///< state notification to the supervisor(s)
 
     public:
       //is it a problem to make this public?
@@ -284,6 +304,14 @@ namespace gem {
       GEMFSM m_gemfsm;
 
       bool b_accept_web_commands;  // should we allow state transition commands from the web interface
+      bool b_notify_supervisors;   // push state changes to the GEMSupervisor, cleared if there is none in the zone
+
+      // latest state to be sent by the notify workloop, protected by m_notifyLock
+      gem::utils::Lock m_notifyLock;
+      std::string m_notifyStateName, m_notifyStateMessage;
+      uint64_t    m_notifySequence;  // incremented at each state change
+      uint32_t    m_notifyFailures;  // consecutive failures, for the back off
+      bool        b_notify_queued;   // the notify action is in the workloop
 
       toolbox::BSem m_wl_semaphore;      // do we need a semaphore for the workloop?
       toolbox::BSem m_db_semaphore;      // do we need a semaphore for the database?
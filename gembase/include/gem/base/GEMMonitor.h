@@ -23,6 +23,7 @@
 #include "cgicc/HTMLClasses.h"
 
 #include "gem/base/utils/GEMInfoSpaceToolBox.h"
+#include "gem/utils/Lock.h"
 
 namespace toolbox {
   namespace task {
@@ -166,13 +167,25 @@ namespace gem {
 
         /**
          * Manages updating the items on web pages using json and ajax
+         * The values are written from formatters compiled on the first call, and only formatted
+         * again when they change. Each change is tagged with a sequence number, shared by all
+         * the monitors of the process, so that a client can ask for the changes since its last update
          * @param setname the name of the set for which to print the information
          * @param out is the output xgi page
+         * @param since sequence number returned to the client with its previous update, 0 for all items,
+         *        sets without changed items are then left out
+         * @returns true if any set was written (jsonUpdateItemSets)
          */
-        void jsonUpdateItemSet(   std::string const& setname, std::ostream *out);
-        void jsonUpdateItemSets(  xgi::Output *out);
+        void jsonUpdateItemSet(   std::string const& setname, std::ostream *out, uint32_t const& since=0);
+        bool jsonUpdateItemSets(  xgi::Output *out, uint32_t const& since=0);
         void jsonUpdateInfoSpaces(xgi::Output *out);
 
+        /**
+         * @returns the sequence number of the latest change seen by a JSON update, to be sent to the client
+         *          before the items are written
+         */
+        static uint32_t jsonSequence();
+
         /**
          * Takes care of cleaning up the monitor after a reset
          * should empty all lists and maps of known items
@@ -188,6 +201,11 @@ namespace gem {
         } GEMMonitorable;
 
       protected:
+        /**
+         * @brief drops the compiled JSON items, must be called when the monitorable maps are cleared
+         */
+        void clearJSONItems();
+
         // map between infoSpaceName and info space toolbox plus update interval
         std::unordered_map<std::string,
           std::pair<std::shared_ptr<gem::base::utils::GEMInfoSpaceToolBox>,
@@ -214,6 +232,37 @@ namespace gem {
         std::string m_timerName;
         toolbox::task::Timer* m_hwtimer;  // time for hw updates
         std::string m_hwTimerName;
+
+      private:
+        typedef struct {
+          std::string prefix;  // the JSON up to the value, including the item name
+          std::shared_ptr<gem::base::utils::GEMInfoSpaceToolBox> infoSpace;
+          gem::base::utils::GEMInfoSpaceToolBox::FormattedItem formatted;
+          std::string value;   // formatted value, escaped for JSON
+          uint32_t sequence;   // sequence number of the last change of the value
+        } GEMJSONItem;
+
+        typedef struct {
+          std::string name;
+          std::vector<GEMJSONItem> items;
+          uint32_t sequence;   // sequence number of the last change of any item in the set
+        } GEMJSONSet;
+
+        /**
+         * @brief builds the JSON items of all monitorable sets, m_jsonLock must be held
+         */
+        void compileJSONItems();
+
+        /**
+         * @brief updates the values and sequence numbers of the changed JSON items, m_jsonLock must be held
+         */
+        void refreshJSONItems();
+
+        void writeJSONItemSet(GEMJSONSet const& jsonSet, std::ostream *out, uint32_t const& since);
+
+        mutable gem::utils::Lock m_jsonLock;
+        bool                     m_jsonCompiled;
+        std::vector<GEMJSONSet>  m_jsonSets;
       };
   }  // namespace gem::base
 }  // namespace gem
@@ -49,6 +49,13 @@ namespace gem {
       static std::string jsonEscape(std::string const& orig);
       static std::string htmlEscape(std::string const& orig);
 
+      /**
+       * @brief reads the "since" parameter of a JSON update request
+       * @returns the sequence number sent to the client with its previous update, 0 for a full update,
+       *          which is also the case if the number is ahead of the monitors (e.g., after a restart)
+       */
+      static uint32_t jsonSince(xgi::Input* in);
+
     protected:
       // maybe only have the control panel built in the base class?
       // perhaps can extend it in derived classes
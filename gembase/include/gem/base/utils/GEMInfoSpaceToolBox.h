@@ -4,10 +4,13 @@
 #define GEM_BASE_UTILS_GEMINFOSPACETOOLBOX_H
 
 // using the infospace toolbox defined in the TCDS code base
+#include <functional>
+#include <list>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "xdata/InfoSpace.h"
 #include "xdata/InfoSpaceFactory.h"
@@ -93,6 +96,74 @@ namespace gem {
           std::string m_docstring;
         };
 
+        /**
+         * @class ItemUpdateList
+         * @brief Precompiled list of UINT32/UINT64 items of one info space, with the values to assign to them
+         *
+         * Filled once with addUInt32Update/addUInt64Update, the values are then set by index
+         * and pushed to the info space together with setItems.
+         * The list holds pointers to the items, it has to be compiled again after a reset of the toolbox
+         */
+        class ItemUpdateList
+        {
+        public:
+          ItemUpdateList() : p_owner(NULL) {};
+
+          /**
+           * @brief sets the value to assign to the item at position index on the next setItems
+           */
+          void setUInt32(size_t const& index, uint32_t const& value) { m_entries[index].value = value; };
+          void setUInt64(size_t const& index, uint64_t const& value) { m_entries[index].value = value; };
+
+          size_t size() const { return m_entries.size(); };
+
+        private:
+          friend class GEMInfoSpaceToolBox;
+
+          struct Entry {
+            xdata::UnsignedInteger32* uint32Item;  ///< NULL for a UINT64 item
+            xdata::UnsignedInteger64* uint64Item;  ///< NULL for a UINT32 item
+            uint64_t value;
+          };
+
+          GEMInfoSpaceToolBox const* p_owner;  ///< toolbox the item pointers were taken from
+          std::vector<Entry>         m_entries;
+          std::list<std::string>     m_names;    ///< item names, in the form fireItemGroupChanged takes
+        };
+
+        /**
+         * @class FormattedItem
+         * @brief Item of the info space bound to its display format, the type and format are resolved once
+         *
+         * Obtained from getItemFormatter, the value is only formatted again when the item has changed.
+         * The formatter holds a pointer to the item, it has to be obtained again after a reset of the toolbox
+         */
+        class FormattedItem
+        {
+        public:
+          typedef std::function<bool(std::string&)> Refresh;
+
+          FormattedItem() {};
+
+          /**
+           * @brief formats the value of the item, if it changed since the previous call
+           * The info space should be locked by the caller
+           * @returns true if the formatted value was updated, always the case on the first call
+           */
+          bool refresh() { return m_refresh ? m_refresh(m_value) : false; };
+
+          /**
+           * @returns the value formatted by the last refresh
+           */
+          std::string const& value() const { return m_value; };
+
+        private:
+          friend class GEMInfoSpaceToolBox;
+
+          Refresh     m_refresh;
+          std::string m_value;
+        };
+
         /**
          * Constructor from GEMApplication pointer, existing InfoSpace pointer, and GEMMonitor pointer
          * @param gemApp the pointer to the calling application
@@ -183,6 +254,23 @@ namespace gem {
         bool setUInt32(   std::string const& itemName, uint32_t    const& value);
         bool setUInt64(   std::string const& itemName, uint64_t    const& value);
 
+        /**
+         * Appends an existing item to an update list, the item is looked up only here
+         * @param itemName is the name of the item in the infospace
+         * @param updates is the list to append the item to, it must only be used with this toolbox
+         * @returns false if there is no item of the matching type with this name, the list is unchanged
+         */
+        bool addUInt32Update(std::string const& itemName, ItemUpdateList& updates);
+        bool addUInt64Update(std::string const& itemName, ItemUpdateList& updates);
+
+        /**
+         * Assigns all the values of an update list to their items
+         * The infospace is locked once for the whole list and a single item group changed
+         * notification is fired, rather than a retrieve and a changed notification per item
+         * @param updates is the list of items and values, compiled by this toolbox
+         */
+        bool setItems(ItemUpdateList const& updates);
+
         xdata::InfoSpace* getInfoSpace()  { return p_infoSpace;         };
         std::string       name()          { return p_infoSpace->name(); };
         bool find(std::string const& key) { return m_itemMap.find(key) != m_itemMap.end(); };
@@ -195,6 +283,14 @@ namespace gem {
          */
         std::string getFormattedItem(std::string const& itemName, std::string const& format);
 
+        /**
+         * Resolves the item and the formatting function for the format once, for repeated display
+         * @param itemName is the name of the item in the info space
+         * @param format is the format that the value should be displayed as, as for getFormattedItem
+         * @returns the formatter of the item, which gives "Item not found" if there is no such item
+         */
+        FormattedItem getItemFormatter(std::string const& itemName, std::string const& format);
+
         /**
          * Print the docstring associated with the infospace item
          * @param itemName is the name of the item in the info space
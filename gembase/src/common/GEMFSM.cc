@@ -369,6 +369,7 @@ void gem::base::GEMFSM::stateChanged(toolbox::fsm::FiniteStateMachine &fsm)
     XCEPT_RAISE(gem::utils::exception::SoftwareProblem, msg.str());
   }
   INFO("GEMFSM::stateChanged:Current state is: [" << m_gemFSMState.toString() << "]");
+  p_gemApp->stateChanged(fsm);
   DEBUG("GEMFSM::stateChanged:stateChanged() end");
 }
 
@@ -20,6 +20,7 @@
 #include "xcept/Exception.h"
 
 #include "xdaq/ApplicationStub.h"
+#include "xdaq/exception/ApplicationDescriptorNotFound.h"
 #include "xdaq/NamespaceURI.h"
 
 #include "xgi/Input.h"
@@ -42,12 +43,25 @@
 #include "gem/utils/soap/GEMSOAPToolBox.h"
 #include "gem/utils/exception/Exception.h"
 
+namespace {
+  // a notification is dropped after this many failed attempts, the supervisor still polls the state
+  const uint32_t NOTIFY_MAX_RETRIES = 5;
+  const uint32_t NOTIFY_BACKOFF_MS  = 100;  // doubled after each failure
+}
+
 gem::base::GEMFSMApplication::GEMFSMApplication(xdaq::ApplicationStub* stub)
   throw (xdaq::exception::Exception) :
   GEMApplication(stub),
   m_gemfsm(this),
   m_progress(0.0),
   b_accept_web_commands(true),
+  b_notify_supervisors(true),
+  m_notifyLock(toolbox::BSem::FULL, true),
+  m_notifyStateName(""),
+  m_notifyStateMessage(""),
+  m_notifySequence(0),
+  m_notifyFailures(0),
+  b_notify_queued(false),
   m_wl_semaphore(toolbox::BSem::FULL),
   m_db_semaphore(toolbox::BSem::FULL),
   m_cfg_semaphore(toolbox::BSem::FULL),
@@ -95,6 +109,7 @@ gem::base::GEMFSMApplication::GEMFSMApplication(xdaq::ApplicationStub* stub)
   m_resumeSig = toolbox::task::bind(this, &GEMFSMApplication::resume,     "resume"    );
   m_haltSig   = toolbox::task::bind(this, &GEMFSMApplication::halt,       "halt"      );
   m_resetSig  = toolbox::task::bind(this, &GEMFSMApplication::reset,      "reset"     );
+  m_notifySig = toolbox::task::bind(this, &GEMFSMApplication::notify,     "notify"    );
   DEBUG("GEMFSMApplication::Created task bindings");
 
   std::stringstream tmpLoopName;
@@ -405,6 +420,125 @@ void gem::base::GEMFSMApplication::stateChanged(toolbox::fsm::FiniteStateMachine
   INFO(msgBase << "stateChanged");
   updateState();
   // gem::base::utils::GEMInfoSpaceToolBox::setString(p_appInfoSpace, "State", m_stateName.toString());
+  notifySupervisors();
+}
+
+void gem::base::GEMFSMApplication::notifySupervisors()
+{
+  std::string msgBase = "[GEMFSMApplication::notifySupervisors] ";
+
+  // only the latest state is sent, a notification still queued picks it up
+  {
+    gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_notifyLock);
+    if (!b_notify_supervisors)
+      return;
+    m_notifyStateName    = m_stateName.toString();
+    m_notifyStateMessage = m_stateMessage.toString();
+    ++m_notifySequence;
+    if (b_notify_queued)
+      return;
+    b_notify_queued = true;
+  }
+
+  try {
+    toolbox::task::WorkLoopFactory* wlf  = toolbox::task::WorkLoopFactory::getInstance();
+    toolbox::task::WorkLoop*        loop = wlf->getWorkLoop(workLoopName+":notify", "waiting");
+    if (!loop->isActive()) loop->activate();
+    loop->submit(m_notifySig);
+  } catch (xcept::Exception& e) {
+    WARN(msgBase << "unable to queue the state notification: " << e.what());
+    gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_notifyLock);
+    b_notify_queued = false;
+  }
+}
+
+bool gem::base::GEMFSMApplication::notify(toolbox::task::WorkLoop *wl)
+{
+  std::string msgBase = "[GEMFSMApplication::notify] ";
+  std::string stateName, stateMessage;
+  uint64_t sequence;
+  {
+    gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_notifyLock);
+    stateName    = m_notifyStateName;
+    stateMessage = m_notifyStateMessage;
+    sequence     = m_notifySequence;
+  }
+
+  bool const sent = sendStateNotification(stateName, stateMessage);
+
+  uint32_t backoff = 0;
+  {
+    gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_notifyLock);
+    if (sent || !b_notify_supervisors) {
+      m_notifyFailures = 0;
+    } else if (++m_notifyFailures > NOTIFY_MAX_RETRIES) {
+      WARN(msgBase << "giving up on the notification of state " << stateName
+           << " after " << NOTIFY_MAX_RETRIES << " retries");
+      m_notifyFailures = 0;
+    } else {
+      backoff = NOTIFY_BACKOFF_MS << (m_notifyFailures - 1);
+    }
+
+    if (!backoff && (sequence == m_notifySequence || !b_notify_supervisors)) {
+      b_notify_queued = false;
+      return false;
+    }
+  }
+
+  // retry, or send the state reached in the meantime
+  if (backoff)
+    usleep(1000*backoff);
+  return true;
+}
+
+bool gem::base::GEMFSMApplication::sendStateNotification(std::string const& stateName,
+                                                         std::string const& stateMessage)
+{
+  std::string msgBase = "[GEMFSMApplication::sendStateNotification] ";
+
+  // push the new state so that the supervisor doesn't have to poll for it
+#ifdef x86_64_centos7
+  std::set<const xdaq::ApplicationDescriptor*> supervisors;
+#else
+  std::set<xdaq::ApplicationDescriptor*> supervisors;
+#endif
+  try {
+    supervisors = p_appZone->getApplicationDescriptors("gem::supervisor::GEMSupervisor");
+  } catch (xdaq::exception::ApplicationDescriptorNotFound& e) {
+    DEBUG(msgBase << "no GEMSupervisor in zone, disabling state notifications");
+    gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_notifyLock);
+    b_notify_supervisors = false;
+    return true;
+  }
+  if (supervisors.empty()) {
+    gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_notifyLock);
+    b_notify_supervisors = false;
+    return true;
+  }
+
+  bool sent = true;
+  for (auto sup = supervisors.begin(); sup != supervisors.end(); ++sup) {
+    if ((*sup) == p_appDescriptor)
+      continue;  // the supervisor knows its own state
+    try {
+      xoap::MessageReference msg =
+        gem::utils::soap::GEMSOAPToolBox::createStateNotificationMessage(p_appDescriptor->getClassName(),
+                                                                         p_appDescriptor->getInstance(),
+                                                                         stateName,
+                                                                         stateMessage);
+      p_appContext->postSOAP(msg, *p_appDescriptor, *const_cast<xdaq::ApplicationDescriptor*>(*sup));
+    } catch (xcept::Exception& e) {
+      // the supervisor will still see the state through its own periodic query
+      WARN(msgBase << "unable to notify " << (*sup)->getClassName() << ":" << (*sup)->getInstance()
+           << " of state change to " << stateName << ": " << e.what());
+      sent = false;
+    } catch (std::exception& e) {
+      WARN(msgBase << "unable to notify " << (*sup)->getClassName() << ":" << (*sup)->getInstance()
+           << " of state change to " << stateName << ": " << e.what());
+      sent = false;
+    }
+  }
+  return sent;
 }
 
 void gem::base::GEMFSMApplication::transitionFailed(toolbox::Event::Reference event)
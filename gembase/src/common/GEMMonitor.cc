@@ -10,6 +10,9 @@
 // GEMMonitor.cc
 
 #include "gem/base/GEMMonitor.h"
+
+#include <atomic>
+
 #include "gem/base/GEMApplication.h"
 #include "gem/base/GEMWebApplication.h"
 #include "gem/base/GEMFSMApplication.h"
@@ -19,8 +22,17 @@
 
 #include "xdata/InfoSpace.h"
 
+#include "gem/utils/LockGuard.h"
+
+namespace {
+  // shared by all monitors, a web page is usually fed by the monitors of several devices
+  std::atomic<uint32_t> s_jsonSequence(0);
+}
+
 gem::base::GEMMonitor::GEMMonitor(log4cplus::Logger& logger, xdaq::Application* xdaqApp, int const& index) :
-  m_gemLogger(logger)
+  m_gemLogger(logger),
+  m_jsonLock(toolbox::BSem::FULL, true),
+  m_jsonCompiled(false)
 {
   std::stringstream timerName;
   timerName << xdaqApp->getApplicationDescriptor()->getURN() << ":MonitoringTimer" << index;
@@ -39,7 +51,9 @@ gem::base::GEMMonitor::GEMMonitor(log4cplus::Logger& logger, xdaq::Application*
 }
 
 gem::base::GEMMonitor::GEMMonitor(log4cplus::Logger& logger, GEMApplication* gemApp, int const& index) :
-  m_gemLogger(logger)
+  m_gemLogger(logger),
+  m_jsonLock(toolbox::BSem::FULL, true),
+  m_jsonCompiled(false)
 {
   p_gemApp = gemApp;
 
@@ -67,7 +81,9 @@ gem::base::GEMMonitor::GEMMonitor(log4cplus::Logger& logger, GEMApplication* gem
 }
 
 gem::base::GEMMonitor::GEMMonitor(log4cplus::Logger& logger, GEMFSMApplication* gemFSMApp, int const& index) :
-  m_gemLogger(logger)
+  m_gemLogger(logger),
+  m_jsonLock(toolbox::BSem::FULL, true),
+  m_jsonCompiled(false)
 {
   p_gemApp = static_cast<gem::base::GEMApplication*>(gemFSMApp);
   // maybe it's really better to use the listener functionality... which we can put into the actionPerformed callback!
@@ -206,6 +222,7 @@ void gem::base::GEMMonitor::addMonitorableSet(std::string const& setname, std::s
   m_infoSpaceMonitorableSetMap.find(infoSpaceName)->second.push_back(setname);
 
   m_monitorableSetInfoSpaceMap.insert(std::make_pair(setname, infoSpaceName));
+  clearJSONItems();
 }
 
 void gem::base::GEMMonitor::addMonitorable(std::string const& setname,
@@ -232,6 +249,7 @@ void gem::base::GEMMonitor::addMonitorable(std::string const& setname,
     GEMMonitorable monitem = {monpair.first, monpair.second, infoSpace, type, format};
     (*it).second.insert(std::make_pair(monpair.first, monitem));
     // (*it).second.push_back(std::make_pair(monpair.first, monitem));
+    clearJSONItems();
   } else {
     ERROR("GEMMonitor::addMonitorable monitorable '" << monpair.first << "' does not exist in infospace '"
            << infoSpaceName << "'!");
@@ -259,12 +277,12 @@ std::list<std::vector<std::string> > gem::base::GEMMonitor::getFormattedItemSet(
     return result;
   }
 
-  std::unordered_map<std::string, GEMMonitorable> itemList = itemSet->second;
+  std::unordered_map<std::string, GEMMonitorable> const& itemList = itemSet->second;
   // std::list<std::pair<std::string, GEMMonitorable> > itemList = itemSet->second;
   for (auto item = itemList.begin(); item != itemList.end(); ++item) {
-    auto gemItem = item->second;
+    GEMMonitorable const& gemItem = item->second;
     std::vector<std::string> itl;
-    auto gemIS = gemItem.infoSpace;
+    auto const& gemIS = gemItem.infoSpace;
     std::string val = gemIS->getFormattedItem(gemItem.name, gemItem.format);
     std::string doc = gemIS->getItemDocstring(gemItem.name);
     itl.push_back(gemItem.name);
@@ -281,49 +299,117 @@ std::list<std::vector<std::string> > gem::base::GEMMonitor::getFormattedItemSet(
   return result;
 }
 
-void gem::base::GEMMonitor::jsonUpdateItemSet(std::string const& setname, std::ostream *out)
+uint32_t gem::base::GEMMonitor::jsonSequence()
 {
-  std::list< std::vector<std::string> > items = getFormattedItemSet(setname);
-  std::list< std::vector<std::string> >::const_iterator it;
-
-  std::list< std::vector<std::string> >::const_iterator end = items.end();
-  for ( it = items.begin(); it != items.end(); ++it ) {
-    std::string val = gem::base::GEMWebApplication::jsonEscape( (*it)[1] );
-    *out << "{ \"name\":\"" << getInfoSpace(setname)->name() << "-" << (*it)[0]
-         << "\",\"value\":\"" << val;
-    // can't have a trailing comma for the last entry...
-    if (std::distance(it, end) == 1) {
-      *out << "\" }"  << std::endl;
-    } else {
-      *out << "\" }," << std::endl;
+  return s_jsonSequence.load();
+}
+
+void gem::base::GEMMonitor::clearJSONItems()
+{
+  gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_jsonLock);
+  m_jsonSets.clear();
+  m_jsonCompiled = false;
+}
+
+void gem::base::GEMMonitor::compileJSONItems()
+{
+  DEBUG("GEMMonitor::compileJSONItems");
+  m_jsonSets.clear();
+  m_jsonSets.reserve(m_monitorableSetsMap.size());
+  for (auto iset = m_monitorableSetsMap.begin(); iset != m_monitorableSetsMap.end(); ++iset) {
+    GEMJSONSet jsonSet;
+    jsonSet.name     = iset->first;
+    jsonSet.sequence = 0;
+    jsonSet.items.reserve(iset->second.size());
+    std::string const isName = iset->second.empty() ? "" : getInfoSpace(iset->first)->name();
+    for (auto item = iset->second.begin(); item != iset->second.end(); ++item) {
+      GEMJSONItem jsonItem;
+      jsonItem.prefix    = "{ \"name\":\"" + gem::base::GEMWebApplication::jsonEscape(isName + "-" + item->first)
+        + "\",\"value\":\"";
+      jsonItem.infoSpace = item->second.infoSpace;
+      jsonItem.formatted = item->second.infoSpace->getItemFormatter(item->second.name, item->second.format);
+      jsonItem.sequence  = 0;
+      jsonSet.items.push_back(jsonItem);
     }
+    m_jsonSets.push_back(jsonSet);
   }
+  m_jsonCompiled = true;
 }
 
-void gem::base::GEMMonitor::jsonUpdateItemSets(xgi::Output *out)
+void gem::base::GEMMonitor::refreshJSONItems()
 {
-  auto end = m_monitorableSetsMap.end();
-  for (auto iset = m_monitorableSetsMap.begin(); iset != m_monitorableSetsMap.end(); ++iset) {
-    *out << "\"" << iset->first << "\" : [ " << std::endl;
+  for (auto jsonSet = m_jsonSets.begin(); jsonSet != m_jsonSets.end(); ++jsonSet) {
+    // the items of a set normally share one info space, it is only locked again when it changes
+    xdata::InfoSpace* locked = NULL;
+    for (auto item = jsonSet->items.begin(); item != jsonSet->items.end(); ++item) {
+      xdata::InfoSpace* is = item->infoSpace->getInfoSpace();
+      if (is != locked) {
+        if (locked)
+          locked->unlock();
+        is->lock();
+        locked = is;
+      }
+      if (item->formatted.refresh()) {
+        item->value    = gem::base::GEMWebApplication::jsonEscape(item->formatted.value());
+        item->sequence = ++s_jsonSequence;
+        jsonSet->sequence = item->sequence;
+      }
+    }
+    if (locked)
+      locked->unlock();
+  }
+}
 
-    if (m_monitorableSetsMap.find(iset->first) == m_monitorableSetsMap.end()) {
-      DEBUG("GEMMonitor::Monitorable set " << iset->first << " not found, not exporting as JSON");
-    } else if (m_monitorableSetsMap.find(iset->first)->second.empty()) {
-      DEBUG("GEMMonitor::Monitorable set " << iset->first << " is empty, not exporting as JSON");
-    } else {
-      DEBUG("GEMMonitor::Found monitorable set " << iset->first << " while updating for JSON export");
+void gem::base::GEMMonitor::writeJSONItemSet(GEMJSONSet const& jsonSet, std::ostream *out, uint32_t const& since)
+{
+  bool first = true;
+  for (auto item = jsonSet.items.begin(); item != jsonSet.items.end(); ++item) {
+    if (item->sequence <= since)
+      continue;
+    // can't have a trailing comma for the last entry...
+    if (!first)
+      *out << "," << std::endl;
+    first = false;
+    *out << item->prefix << item->value << "\" }";
+  }
+  if (!first)
+    *out << std::endl;
+}
 
-      jsonUpdateItemSet(iset->first, out);
-    }
+void gem::base::GEMMonitor::jsonUpdateItemSet(std::string const& setname, std::ostream *out, uint32_t const& since)
+{
+  gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_jsonLock);
+  if (!m_jsonCompiled)
+    compileJSONItems();
+  refreshJSONItems();
+
+  for (auto jsonSet = m_jsonSets.begin(); jsonSet != m_jsonSets.end(); ++jsonSet)
+    if (jsonSet->name == setname)
+      writeJSONItemSet(*jsonSet, out, since);
+}
+
+bool gem::base::GEMMonitor::jsonUpdateItemSets(xgi::Output *out, uint32_t const& since)
+{
+  gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_jsonLock);
+  if (!m_jsonCompiled)
+    compileJSONItems();
+  refreshJSONItems();
+
+  bool first = true;
+  for (auto jsonSet = m_jsonSets.begin(); jsonSet != m_jsonSets.end(); ++jsonSet) {
+    // with since set, only the sets with changed items are sent
+    if (since && jsonSet->sequence <= since)
+      continue;
     // can't have a trailing comma for the last entry...
-    if (std::distance(iset, end) == 1) {
-      DEBUG("GEMMonitor::Found last monitorable set " << iset->first << ", no trailing comma (])");
-      *out << " ]"  << std::endl;
-    } else {
-      DEBUG("GEMMonitor::Found monitorable set " << iset->first << ", trailing comma (],)");
+    if (!first)
       *out << " ]," << std::endl;
-    }
+    first = false;
+    *out << "\"" << jsonSet->name << "\" : [ " << std::endl;
+    writeJSONItemSet(*jsonSet, out, since);
   }
+  if (!first)
+    *out << " ]" << std::endl;
+  return !first;
 }
 
 void gem::base::GEMMonitor::jsonUpdateInfoSpaces(xgi::Output *out)
@@ -352,6 +438,7 @@ void gem::base::GEMMonitor::reset()
   } catch (toolbox::task::exception::Exception& te) {
     ERROR("GEMMonitor::Caught exception while removing timer " << m_timerName << " " << te.what());
   }
+  clearJSONItems();
 
   // is this necessary? how to do for some applications and not others?
   // make this simply an interface and force every derived application to implement it properly
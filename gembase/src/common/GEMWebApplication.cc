@@ -2,6 +2,8 @@
 
 #include "gem/base/GEMWebApplication.h"
 
+#include "cgicc/Cgicc.h"
+
 #include "xcept/tools.h"
 
 #include "xgi/framework/UIManager.h"
@@ -294,17 +296,38 @@ void gem::base::GEMWebApplication::jsonUpdate(xgi::Input *in, xgi::Output *out)
   throw (xgi::exception::Exception)
 {
   DEBUG("GEMWebApplication::jsonUpdate");
+  uint32_t const since    = jsonSince(in);
+  // taken before the items are refreshed, the changes seen while writing are sent again next time
+  uint32_t const sequence = gem::base::GEMMonitor::jsonSequence();
   out->getHTTPResponseHeader().addHeader("Content-Type", "application/json");
   *out << " { " << std::endl;
   auto monitor = p_gemFSMApp->p_gemMonitor;
   // if (p_gemMonitor) {
   if (monitor) {
     // p_gemMonitor->jsonUpdateItemSets(out);
-    monitor->jsonUpdateItemSets(out);
+    if (monitor->jsonUpdateItemSets(out, since))
+      *out << "," << std::endl;
   }
+  *out << "\"sequence\" : " << sequence << std::endl;
   *out << " } " << std::endl;
 }
 
+uint32_t gem::base::GEMWebApplication::jsonSince(xgi::Input* in)
+{
+  uint32_t since = 0;
+  try {
+    cgicc::Cgicc cgi(in);
+    cgicc::const_form_iterator element = cgi.getElement("since");
+    if (element != cgi.getElements().end() && element->getIntegerValue() > 0)
+      since = static_cast<uint32_t>(element->getIntegerValue());
+  } catch (std::exception const& e) {
+    return 0;
+  }
+  if (since > gem::base::GEMMonitor::jsonSequence())
+    return 0;
+  return since;
+}
+
 /* *FSM callbacks */
 /*To be filled in with the startup (enable) routine*/
 void gem::base::GEMWebApplication::webInitialize(xgi::Input *in, xgi::Output *out)
@@ -724,6 +724,79 @@ bool gem::base::utils::GEMInfoSpaceToolBox::setUInt64(std::string const& itemNam
   }
 }
 
+bool gem::base::utils::GEMInfoSpaceToolBox::addUInt32Update(std::string const& itemName, ItemUpdateList& updates)
+{
+  auto item = m_uint32Items.find(itemName);
+  if (item == m_uint32Items.end() || !(item->second).second) {
+    WARN("GEMInfoSpaceToolBox::addUInt32Update no UnsignedInteger32 item '" << itemName
+         << "' in infoSpace " << p_infoSpace->name());
+    return false;
+  }
+  if (updates.p_owner && updates.p_owner != this) {
+    ERROR("GEMInfoSpaceToolBox::addUInt32Update update list belongs to another infoSpace, not adding " << itemName);
+    return false;
+  }
+  updates.p_owner = this;
+  ItemUpdateList::Entry entry = {(item->second).second, NULL, (item->second).second->value_};
+  updates.m_entries.push_back(entry);
+  updates.m_names.push_back(itemName);
+  return true;
+}
+
+bool gem::base::utils::GEMInfoSpaceToolBox::addUInt64Update(std::string const& itemName, ItemUpdateList& updates)
+{
+  auto item = m_uint64Items.find(itemName);
+  if (item == m_uint64Items.end() || !(item->second).second) {
+    WARN("GEMInfoSpaceToolBox::addUInt64Update no UnsignedInteger64 item '" << itemName
+         << "' in infoSpace " << p_infoSpace->name());
+    return false;
+  }
+  if (updates.p_owner && updates.p_owner != this) {
+    ERROR("GEMInfoSpaceToolBox::addUInt64Update update list belongs to another infoSpace, not adding " << itemName);
+    return false;
+  }
+  updates.p_owner = this;
+  ItemUpdateList::Entry entry = {NULL, (item->second).second, (item->second).second->value_};
+  updates.m_entries.push_back(entry);
+  updates.m_names.push_back(itemName);
+  return true;
+}
+
+bool gem::base::utils::GEMInfoSpaceToolBox::setItems(ItemUpdateList const& updates)
+{
+  if (updates.m_entries.empty())
+    return true;
+  if (updates.p_owner != this) {
+    std::string msg = "Trying to set the items of an update list compiled for another InfoSpace in " + p_infoSpace->name();
+    ERROR("GEMInfoSpaceToolBox::" << msg);
+    XCEPT_RAISE(gem::base::utils::exception::InfoSpaceProblem, msg);
+    return false;
+  }
+
+  // the item pointers were resolved when the list was compiled, no find or cast is needed here
+  p_infoSpace->lock();
+  try {
+    for (auto entry = updates.m_entries.begin(); entry != updates.m_entries.end(); ++entry) {
+      if (entry->uint32Item)
+        *(entry->uint32Item) = static_cast<uint32_t>(entry->value);
+      else
+        *(entry->uint64Item) = entry->value;
+    }
+    // fireItemGroupChanged takes a non-const list, but does not modify it
+    p_infoSpace->fireItemGroupChanged(const_cast<std::list<std::string>&>(updates.m_names), this);
+  } catch (xdata::exception::Exception const& err) {
+    p_infoSpace->unlock();
+    std::string msg = toolbox::toString("Error notifying the change of %d items in InfoSpace %s.",
+                                        int(updates.m_entries.size()), p_infoSpace->name().c_str());
+    ERROR("GEMInfoSpaceToolBox::" << msg << " " << err.what());
+    XCEPT_RAISE(gem::base::utils::exception::InfoSpaceProblem, msg);
+    return false;
+  }
+  p_infoSpace->unlock();
+  DEBUG("GEMInfoSpaceToolBox::set " << updates.m_entries.size() << " items in infoSpace " << p_infoSpace->name());
+  return true;
+}
+
 //////// static methods
 std::string gem::base::utils::GEMInfoSpaceToolBox::getString(xdata::InfoSpace* infoSpace, std::string const& itemName)
 {
@@ -885,136 +958,259 @@ uint64_t gem::base::utils::GEMInfoSpaceToolBox::getUInt64(xdata::InfoSpace* info
   }
 }
 
-std::string gem::base::utils::GEMInfoSpaceToolBox::getFormattedItem(std::string const& itemName, std::string const& format)
+namespace {
+  // display formats, selected once per item by getItemFormatter
+  typedef void (*UInt32Format)(std::ostream&, uint32_t const&);
+  typedef void (*UInt64Format)(std::ostream&, uint64_t const&);
+
+  void formatNone(std::ostream& result, uint32_t const& val) {}
+
+  void formatNone64(std::ostream& result, uint64_t const& val) {}
+
+  template<typename T>
+  void formatDec(std::ostream& result, T const& val)
+  {
+    result << std::dec << val;
+  }
+
+  template<typename T>
+  void formatHex(std::ostream& result, T const& val)
+  {
+    result << "0x" << std::setw(8) << std::setfill('0') << std::hex << val;
+  }
+
+  template<typename T>
+  void formatHexDec(std::ostream& result, T const& val)
+  {
+    result << "0x" << std::setw(8) << std::setfill('0') << std::hex
+           << val << " / " << std::dec << val;
+  }
+
+  void formatBit(std::ostream& result, uint32_t const& val)
+  {
+    result << "0x" << std::hex << val;
+  }
+
+  void formatIP(std::ostream& result, uint32_t const& val)
+  {
+    result << std::dec << gem::utils::uint32ToDottedQuad(val);
+  }
+
+  void formatID(std::ostream& result, uint32_t const& val)
+  {
+    // expects four 8-bit chars
+    result << std::dec << gem::utils::uint32ToString(val);
+  }
+
+  void formatDate(std::ostream& result, uint32_t const& val)
+  {
+    result <<         std::setfill('0') << std::setw(2) << (val&0x1f)
+           << "/"  << std::setfill('0') << std::setw(2) << ((val>>5)&0x0f)
+           << "/"  << std::setw(4) << 2000+((val>>9)&0x7f);
+  }
+
+  void formatDateOH(std::ostream& result, uint32_t const& val)
+  {
+    // 0x20161124
+    result << std::hex
+           <<         std::setfill('0') << std::setw(2)  << (val&0xff)
+           << "/"  << std::setfill('0') << std::setw(2)  << ((val>>8)&0xff)
+           << "/"  << std::setw(4) << ((val>>16)&0xffff)
+           << std::dec;
+  }
+
+  void formatFWVer(std::ostream& result, uint32_t const& val)
+  {
+    // expects Major(4).Minor(4).Build(8)
+    result << ((val>>12) & 0x0f) << "."
+           << ((val>>8)  & 0x0f) << "."
+           << ((val)     & 0xff);
+  }
+
+  void formatFWVerGLIB(std::ostream& result, uint32_t const& val)
+  {
+    // expects Major(8).Minor(8).Build(8)
+    result << std::hex
+           << ((val>>16) & 0xff) << "."
+           << ((val>>8)  & 0xff) << "."
+           << ((val)     & 0xff)
+           << std::dec;
+  }
+
+  void formatFWVerOH(std::ostream& result, uint32_t const& val)
+  {
+    // expects Major(8).Minor(8).Version(8).Patch(8)
+    result << std::hex
+           << ((val>>24) & 0xff) << "."
+           << ((val>>16) & 0xff) << "."
+           << ((val>>8)  & 0xff) << "."
+           << ((val)     & 0xff)
+           << std::dec;
+  }
+
+  void formatI2CDec(std::ostream& result, uint64_t const& val)
+  {
+    result << (val&(uint32_t)0xffffffff) << " (str.)" << std::endl
+           << (val>>32) << " (ack.) ";
+  }
+
+  void formatI2CHex(std::ostream& result, uint64_t const& val)
+  {
+    result << "0x" << std::setw(8) << std::setfill('0')
+           << std::hex << (val&(uint32_t)0xffffffff) << " (str.)" << std::endl
+           << "0x" << std::setw(8) << std::setfill('0')
+           << (val>>32) << " (ack.) " << std::dec;
+  }
+
+  void formatMAC(std::ostream& result, uint64_t const& val)
+  {
+    result << gem::utils::uint32ToGroupedHex((val>>32), val&(uint32_t)0xffffffff);
+  }
+
+  void formatString(std::ostream& result, std::string const& val)
+  {
+    result << val;
+  }
+
+  UInt32Format uint32Format(std::string const& format)
+  {
+    if (format == "" || format == "hex" || format == "raw/rate")  // raw/rate: for a counter, the raw count
+      return &formatHex<uint32_t>;
+    else if (format == "bit")
+      return &formatBit;
+    else if (format == "dec")
+      return &formatDec<uint32_t>;
+    else if (format == "hex/dec")
+      return &formatHexDec<uint32_t>;
+    else if (format == "ip")
+      return &formatIP;
+    else if (format == "id")
+      return &formatID;
+    else if (format == "date" || format == "dateglib")
+      return &formatDate;
+    else if (format == "dateoh")
+      return &formatDateOH;
+    else if (format == "fwver")
+      return &formatFWVer;
+    else if (format == "fwverglib")
+      return &formatFWVerGLIB;
+    else if (format == "fwveroh")
+      return &formatFWVerOH;
+    return &formatNone;
+  }
+
+  UInt64Format uint64Format(std::string const& format)
+  {
+    if (format == "i2c/dec")
+      return &formatI2CDec;
+    else if (format == "i2c/hex")
+      return &formatI2CHex;
+    else if (format == "" || format == "hex")
+      return &formatHex<uint64_t>;
+    else if (format == "dec")
+      return &formatDec<uint64_t>;
+    else if (format == "hex/dec")
+      return &formatHexDec<uint64_t>;
+    else if (format == "mac")
+      return &formatMAC;
+    return &formatNone64;
+  }
+
+  /**
+   * the returned function formats the value of the item into its argument when it differs
+   * from the value seen on the previous call
+   */
+  template<typename X, typename V>
+  gem::base::utils::GEMInfoSpaceToolBox::FormattedItem::Refresh makeRefresh(X* item,
+                                                                            void (*format)(std::ostream&, V const&))
+  {
+    bool first = true;
+    V    last  = V();
+    return [item, format, first, last](std::string& formatted) mutable -> bool {
+      V const val = item->value_;
+      if (!first && val == last)
+        return false;
+      first = false;
+      last  = val;
+      std::stringstream result;
+      format(result, val);
+      formatted = result.str();
+      return true;
+    };
+  }
+
+  gem::base::utils::GEMInfoSpaceToolBox::FormattedItem::Refresh makeConstant(std::string const& value)
+  {
+    bool first = true;
+    return [value, first](std::string& formatted) mutable -> bool {
+      if (!first)
+        return false;
+      first     = false;
+      formatted = value;
+      return true;
+    };
+  }
+}
+
+gem::base::utils::GEMInfoSpaceToolBox::FormattedItem gem::base::utils::GEMInfoSpaceToolBox::getItemFormatter(std::string const& itemName, std::string const& format)
 {
-  DEBUG("GEMInfoSpaceToolBox::getFormattedItem(" << itemName << ", " << format << ")");
+  DEBUG("GEMInfoSpaceToolBox::getItemFormatter(" << itemName << ", " << format << ")");
+  FormattedItem formatter;
   auto item = m_itemMap.find(itemName);
   if (item == m_itemMap.end()) {
     std::string err = itemName + "' does not exist in this infospace.";
     WARN("GEMInfoSpaceToolBox::" << err);
-    return "Item not found";
+    formatter.m_refresh = makeConstant("Item not found");
+    return formatter;
   }
-  std::stringstream result;
-  GEMInfoSpaceItem* isItem = item->second;
-  DEBUG(itemName << " found in infospace " << std::hex << isItem << std::dec);
-  ItemType type = isItem->m_itype;
+  ItemType type = item->second->m_itype;
 
+  // the types without a display format give an empty value
+  formatter.m_refresh = makeConstant("");
   if ( type == INTEGER ) {
-    int val = this->getInteger(itemName);
-    DEBUG(itemName << " has value " << val << std::dec);
-    if ( format == "dec" ) {
-      result << std::dec << val;
-    } else {
+    auto it = m_intItems.find(itemName);
+    if ( format != "dec" )
       WARN("Invalid format specified for INTEGER type item " << itemName << " formating as simple \"dec\"");
-      result << std::dec << val;
-    }
+    if (it != m_intItems.end())
+      formatter.m_refresh = makeRefresh(it->second.second, &formatDec<int>);
   } else if ( type == INTEGER32 ) {
-    int32_t val = this->getInteger32(itemName);
-    DEBUG(itemName << " has value " << val << std::dec);
-    if ( format == "dec" ) {
-      result << std::dec << val;
-    } else {
+    auto it = m_int32Items.find(itemName);
+    if ( format != "dec" )
       WARN("Invalid format specified for INTEGER32 type item " << itemName << " formating as simple \"dec\"");
-      result << std::dec << val;
-    }
+    if (it != m_int32Items.end())
+      formatter.m_refresh = makeRefresh(it->second.second, &formatDec<int32_t>);
   } else if ( type == INTEGER64 ) {
-    int64_t val = this->getInteger64(itemName);
-    DEBUG(itemName << " has value " << val << std::dec);
-    if ( format == "dec" ) {
-      result << std::dec << val;
-    } else {
+    auto it = m_int64Items.find(itemName);
+    if ( format != "dec" )
       WARN("Invalid format specified for INTEGER64 type item " << itemName << " formating as simple \"dec\"");
-      result << std::dec << val;
-    }
+    if (it != m_int64Items.end())
+      formatter.m_refresh = makeRefresh(it->second.second, &formatDec<int64_t>);
   } else if ( type == UINT32 ) {
-    uint32_t val = this->getUInt32(itemName);
-    DEBUG(itemName << " has value " << std::hex << val << std::dec);
-    if ( format == "" || format == "hex" ) {
-      result << "0x" << std::setw(8) << std::setfill('0') << std::hex << val;
-    } else if ( format == "bit" ) {
-      result << "0x" << std::hex << val;
-    } else if ( format == "dec" ) {
-      result << std::dec << val;
-    } else if ( format == "hex/dec" ) {
-      result << "0x" << std::setw(8) << std::setfill('0') << std::hex
-             << val << " / " << std::dec << val;
-    } else if ( format == "raw/rate" ) {  // for a counter, get the raw count, plus the rate
-      result << "0x" << std::setw(8) << std::setfill('0') << std::hex << val;
-    } else if ( format == "ip" ) {
-      result << std::dec << gem::utils::uint32ToDottedQuad(val);
-    } else if ( format == "id" ) {
-      // expects four 8-bit chars
-      result << std::dec << gem::utils::uint32ToString(val);
-    } else if ( format == "date" ) {
-      result <<         std::setfill('0') << std::setw(2) << (val&0x1f)
-             << "/"  << std::setfill('0') << std::setw(2) << ((val>>5)&0x0f)
-             << "/"  << std::setw(4) << 2000+((val>>9)&0x7f);
-    } else if ( format == "dateglib" ) {
-      result <<         std::setfill('0') << std::setw(2) << (val&0x1f)
-             << "/"  << std::setfill('0') << std::setw(2) << ((val>>5)&0x0f)
-             << "/"  << std::setw(4) << 2000+((val>>9)&0x7f);
-    } else if ( format == "dateoh" ) {
-      // 0x20161124
-      result << std::hex
-             <<         std::setfill('0') << std::setw(2)  << (val&0xff)
-             << "/"  << std::setfill('0') << std::setw(2)  << ((val>>8)&0xff)
-             << "/"  << std::setw(4) << ((val>>16)&0xffff)
-             << std::dec;
-    } else if ( format == "fwver" ) {
-      // expects Major(4).Minor(4).Build(8)
-      result << ((val>>12) & 0x0f) << "."
-             << ((val>>8)  & 0x0f) << "."
-             << ((val)     & 0xff);
-    } else if ( format == "fwverglib" ) {
-      // expects Major(8).Minor(8).Build(8)
-      result << std::hex
-             << ((val>>16) & 0xff) << "."
-             << ((val>>8)  & 0xff) << "."
-             << ((val)     & 0xff)
-             << std::dec;
-    } else if ( format == "fwveroh" ) {
-      // expects Major(8).Minor(8).Version(8).Patch(8)
-      result << std::hex
-             << ((val>>24) & 0xff) << "."
-             << ((val>>16) & 0xff) << "."
-             << ((val>>8)  & 0xff) << "."
-             << ((val)     & 0xff)
-             << std::dec;
-    }
-  } else if (type == UINT64) {  // end of type == UINT32
-    uint64_t val = this->getUInt64(itemName);
-    DEBUG(itemName << " has value " << std::hex << val << std::dec);
-    if ( format == "i2c/dec" ) {
-      result << (val&(uint32_t)0xffffffff) << " (str.)" << std::endl
-             << (val>>32) << " (ack.) ";
-    } else if ( format == "i2c/hex" ) {
-      result << "0x" << std::setw(8) << std::setfill('0')
-             << std::hex << (val&(uint32_t)0xffffffff) << " (str.)" << std::endl
-             << "0x" << std::setw(8) << std::setfill('0')
-             << (val>>32) << " (ack.) " << std::dec;
-    } else if ( format == "" || format == "hex" ) {
-      result << "0x" << std::setw(8) << std::setfill('0') << std::hex << val;
-    } else if ( format == "dec" ) {
-      result << std::dec << val;
-    } else if ( format == "hex/dec" ) {
-      result << "0x" << std::setw(8) << std::setfill('0') << std::hex
-             << val << " / " << std::dec << val;
-    } else if ( format == "mac" ) {
-      result << gem::utils::uint32ToGroupedHex((val>>32), val&(uint32_t)0xffffffff);
-    }
-
-  } else if (type == STRING) {  // end of type == UINT64
-    std::string val = this->getString(itemName);
-    DEBUG(itemName << " has value " << val);
-    if ( format == "" ) {
-      result << val;
-    } else  {
+    auto it = m_uint32Items.find(itemName);
+    if (it != m_uint32Items.end())
+      formatter.m_refresh = makeRefresh(it->second.second, uint32Format(format));
+  } else if ( type == UINT64 ) {
+    auto it = m_uint64Items.find(itemName);
+    if (it != m_uint64Items.end())
+      formatter.m_refresh = makeRefresh(it->second.second, uint64Format(format));
+  } else if ( type == STRING ) {
+    auto it = m_stringItems.find(itemName);
+    if ( format != "" )
       WARN("GEMInfoSpaceToolBox::Unsupported format " << format);
-      result << val;
-    }
-  }  // end of type == STRING
+    if (it != m_stringItems.end())
+      formatter.m_refresh = makeRefresh(it->second.second, &formatString);
+  }
+  return formatter;
+}
 
-  return result.str();
+std::string gem::base::utils::GEMInfoSpaceToolBox::getFormattedItem(std::string const& itemName, std::string const& format)
+{
+  DEBUG("GEMInfoSpaceToolBox::getFormattedItem(" << itemName << ", " << format << ")");
+  FormattedItem formatter = getItemFormatter(itemName, format);
+  p_infoSpace->lock();
+  formatter.refresh();
+  p_infoSpace->unlock();
+  return formatter.value();
 }
 
 std::string gem::base::utils::GEMInfoSpaceToolBox::getItemDocstring(std::string const& itemName)
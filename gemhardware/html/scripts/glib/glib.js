@@ -1,9 +1,13 @@
+// sequence number of the last update, only the items changed since are sent by the application
+var jsonSequence = 0;
+
 function sendrequest( jsonurl )
 {
     if (window.jQuery) {
         // can use jQuery libraries rather than raw javascript
-        $.getJSON(jsonurl)
+        $.getJSON(jsonurl, { since: jsonSequence })
             .done(function(data) {
+                    jsonSequence = data.sequence || 0;
                     updateGLIBMonitorables( data );
                 })
             .fail(function(data, textStatus, error) {
@@ -20,12 +24,13 @@ function sendrequest( jsonurl )
             {
                 if (xmlhttp.readyState==4 && xmlhttp.status==200) {
                     var res = eval( "(" + xmlhttp.responseText + ")" );
+                    jsonSequence = res.sequence || 0;
                     console.log("response:"+xmlhttp.responseText);
                     console.log("res:"+res);
                     updateGLIBMonitorables( res );
                 }
             };
-        xmlhttp.open("GET", jsonurl, true);
+        xmlhttp.open("GET", jsonurl + "?since=" + jsonSequence, true);
         xmlhttp.send();
     }
 };
@@ -33,6 +38,8 @@ function sendrequest( jsonurl )
 function updateGLIBMonitorables( glibjson )
 {
     for ( var glib in glibjson ) {
+        if ( glib === "sequence" )
+            continue;
         var monitorset = glibjson[glib];
         for ( var monitem in monitorset ) {
             var arr = monitorset[monitem];
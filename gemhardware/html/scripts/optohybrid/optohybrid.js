@@ -5,12 +5,16 @@ function pdebug( text )
     document.getElementById("debug").innerHTML = text;
 };
 
+// sequence number of the last update, only the items changed since are sent by the application
+var jsonSequence = 0;
+
 function sendrequest( jsonurl )
 {
     if (window.jQuery) {
         // can use jQuery libraries rather than raw javascript
-        $.getJSON(jsonurl)
+        $.getJSON(jsonurl, { since: jsonSequence })
             .done(function(data) {
+                    jsonSequence = data.sequence || 0;
                     updateOptoHybridMonitorables( data );
                 })
             .fail(function(data, textStatus, error) {
@@ -27,12 +31,13 @@ function sendrequest( jsonurl )
             {
                 if (xmlhttp.readyState==4 && xmlhttp.status==200) {
                     var res = eval( "(" + xmlhttp.responseText + ")" );
+                    jsonSequence = res.sequence || 0;
                     console.log("response:"+xmlhttp.responseText);
                     console.log("res:"+res);
                     updateOptoHybridMonitorables( res );
                 }
             };
-        xmlhttp.open("GET", jsonurl, true);
+        xmlhttp.open("GET", jsonurl + "?since=" + jsonSequence, true);
         xmlhttp.send();
     }
 };
@@ -40,6 +45,8 @@ function sendrequest( jsonurl )
 function updateOptoHybridMonitorables( ohjson )
 {
     for ( var oh in ohjson ) {
+        if ( oh === "sequence" )
+            continue;
         var monitorset = ohjson[oh];
         for ( var monitem in monitorset ) {
             var arr = monitorset[monitem];
@@ -5,6 +5,7 @@
 
 #include <iomanip>
 #include <memory>
+#include <unordered_map>
 
 //#include "xdata/InfoSpace.h"
 /* #include "xdata/InfoSpaceFactory.h" */
@@ -27,6 +28,7 @@
 #include "gem/utils/Lock.h"
 #include "gem/utils/LockGuard.h"
 
+#include "gem/hw/GEMHwDeviceStats.h"
 #include "gem/hw/exception/Exception.h"
 
 typedef uhal::exception::exception uhalException;
@@ -54,6 +56,8 @@ namespace uhal {
 namespace gem {
   namespace hw {
 
+    class GEMHwTransaction;
+
     class GEMHwDevice
     {
 
@@ -123,6 +127,44 @@ namespace gem {
         void reset() { BadHeader=0; ReadError=0; Timeout=0; ControlHubErr=0; return; };
       } DeviceErrors;
 
+      /**
+       * @struct RegisterHandle
+       * @brief A register resolved from the address table once, so that it can be read and
+       * written without building its name or looking up its node again
+       * @var RegisterHandle::name
+       * name is the full name of the register in the address table, used in the error messages
+       * @var RegisterHandle::address
+       * address is the address of the register
+       * @var RegisterHandle::mask
+       * mask is the mask of the register, values are shifted as for a named register
+       * @var RegisterHandle::size
+       * size is the number of words of a memory block or FIFO
+       * @var RegisterHandle::permission
+       * permission is the read/write permission of the register
+       * @var RegisterHandle::mode
+       * mode is the block read/write mode, incremental or not
+       * @var RegisterHandle::valid
+       * valid is false if the register could not be found in the address table
+       */
+      typedef struct RegisterHandle {
+        std::string                    name;
+        uint32_t                       address;
+        uint32_t                       mask;
+        uint32_t                       size;
+        uhal::defs::NodePermission     permission;
+        uhal::defs::BlockReadWriteMode mode;
+        bool                           valid;
+
+      RegisterHandle() :
+        name(""),
+          address(0x0),
+          mask(0x0),
+          size(0),
+          permission(uhal::defs::READWRITE),
+          mode(uhal::defs::SINGLE),
+          valid(false) {};
+      } RegisterHandle;
+
       typedef std::pair<uint8_t, OpticalLinkStatus>  linkStatus;
       //typedef std::vector<linkStatus>                linkStatus;
 
@@ -153,6 +195,33 @@ namespace gem {
        * unless there are GEM specific functions we need to implement)
        */
 
+      /**
+       * getRegisterHandle(std::string const& regName)
+       * resolves a register in the address table, the handle is cached so each
+       * register is only looked up once for the lifetime of the device
+       * @param regName name of the register to resolve
+       * @retval returns the handle, not valid if the register is not in the address table,
+       *         the reference stays valid until the device is reconnected (clearRegisterHandles)
+       */
+      RegisterHandle const& getRegisterHandle(std::string const& regName);
+
+      /**
+       * getRegisterHandle(std::string const& regPrefix, std::string const& regName)
+       * @param regPrefix prefix in the address table, possibly root nodes
+       * @param regName name of the register to resolve
+       * @retval returns the handle of the register
+       */
+      RegisterHandle const& getRegisterHandle(const std::string &regPrefix,
+                                              const std::string &regName) {
+        return getRegisterHandle(regPrefix+"."+regName); };
+
+      /**
+       * readReg(RegisterHandle const& reg)
+       * @param reg handle of the register to read
+       * @retval returns the 32 bit unsigned value in the register
+       */
+      uint32_t readReg(RegisterHandle const& reg);
+
       /**
        * readReg(std::string const& regName)
        * @param regName name of the register to read
@@ -216,8 +285,16 @@ namespace gem {
        * into the supplied vector regList
        * @param regList list of register address/mask pair and uint32_t value to store the result
        * @param freq integer number of transactions to bundle (-1 for all)
+       * @retval false if the registers could not be read within the allowed number of retries
        */
-      void     readRegs(masked_register_pair_list &regList, int const& freq=8);
+      bool     readRegs(masked_register_pair_list &regList, int const& freq=8);
+
+      /**
+       * writeReg(RegisterHandle const& reg, uint32_t const val)
+       * @param reg handle of the register to write to
+       * @param val value to write to the register
+       */
+      void     writeReg(RegisterHandle const& reg, uint32_t const val);
 
       /**
        * writeReg(std::string const& regName, uint32_t const val)
@@ -297,10 +374,59 @@ namespace gem {
       std::vector<uint32_t> readBlock(std::string const& regName,
                                       size_t      const& nWords);
 
+      /**
+       * readBlock(std::string const& regName, uint32_t* buffer, size_t const nWords)
+       * read from a memory block into a caller provided buffer
+       * @param regName memory block to read from
+       * @param buffer destination, must hold at least nWords words
+       * @param nWords number of words to read
+       * @retval returns the number of words read, 0 on failure
+       */
       uint32_t readBlock(std::string const& regName, uint32_t* buffer, size_t const& nWords);
+
+      /**
+       * readBlock(RegisterHandle const& reg, uint32_t* buffer, size_t const nWords)
+       * read from a memory block or FIFO into a caller provided buffer
+       * @param reg handle of the memory block to read from
+       * @param buffer destination, must hold at least nWords words
+       * @param nWords number of words to read
+       * @retval returns the number of words read, 0 on failure
+       */
+      uint32_t readBlock(RegisterHandle const& reg, uint32_t* buffer, size_t const& nWords);
+
+      /**
+       * readBlocks(std::vector<RegisterHandle> const& regs, uint32_t* buffer, size_t const nWords)
+       * read the same number of words from several memory blocks with a single dispatch
+       * @param regs handles of the memory blocks to read from
+       * @param buffer destination, must hold regs.size()*nWords words, block i is written from buffer+i*nWords
+       * @param nWords number of words to read from each block
+       * @retval returns the total number of words read, 0 on failure
+       */
+      uint32_t readBlocks(std::vector<RegisterHandle> const& regs, uint32_t* buffer, size_t const& nWords);
+
+      /**
+       * readBlock(std::string const& regName, std::vector<toolbox::mem::Reference*>& buffer, size_t const nWords)
+       * read from a memory block into pre-allocated memory pool frames
+       * @param regName memory block to read from
+       * @param buffer frames to fill in order, each up to the size of its buffer, the data size
+       *        of each frame used is set to the number of bytes read into it
+       * @param nWords number of words to read
+       * @retval returns the total number of words read
+       */
       uint32_t readBlock(std::string const& regName, std::vector<toolbox::mem::Reference*>& buffer,
                          size_t const& nWords);
 
+      /**
+       * readBlock(RegisterHandle const& reg, std::vector<toolbox::mem::Reference*>& buffer, size_t const nWords)
+       * read from a memory block into pre-allocated memory pool frames
+       * @param reg handle of the memory block to read from
+       * @param buffer frames to fill in order, as for the named version
+       * @param nWords number of words to read
+       * @retval returns the total number of words read
+       */
+      uint32_t readBlock(RegisterHandle const& reg, std::vector<toolbox::mem::Reference*>& buffer,
+                         size_t const& nWords);
+
       /**
        * writeBlock(std::string const& regName, std::vector<uint32_t> const values)
        * write to a memory block
@@ -396,6 +522,17 @@ namespace gem {
 
       virtual std::string printErrorCounts() const;
 
+      /**
+       * @brief latency, retry and lock wait statistics of the accesses to this device
+       * The categories are set by the callers with a GEMHwDeviceStats::ScopedCategory
+       */
+      GEMHwDeviceStats const& getStats() const { return m_stats; };
+
+      /**
+       * @brief clears the access statistics, not the IPBus error counters
+       */
+      void resetStats() { m_stats.reset(); };
+
       /**
        * @brief performs a general reset of the GLIB
        */
@@ -428,9 +565,38 @@ namespace gem {
 
       mutable gem::utils::Lock m_hwLock;
 
+      /**
+       * @brief LockGuard of m_hwLock that records the time spent waiting for it,
+       *        only the outermost acquisition of the lock by a thread can wait and is recorded
+       */
+      class TimedLockGuard
+      {
+      public:
+        explicit TimedLockGuard(GEMHwDevice const& device);
+        ~TimedLockGuard();
+
+      private:
+        gem::utils::Lock& m_lock;
+
+        TimedLockGuard(TimedLockGuard const&);
+        TimedLockGuard& operator=(TimedLockGuard const&);
+      };
+
+      /**
+       * @brief dispatches the queued uhal operations, recording the time taken
+       */
+      void dispatch(uhal::HwInterface& hw);
+
       /* void setParametersFromInfoSpace(); */
       void setup(std::string const& deviceName);
 
+      /**
+       * @brief drops the cached register handles, called whenever p_gemHW is (re)connected
+       *        as the address table may have changed, derived classes keeping pointers to
+       *        handles drop them as well
+       */
+      virtual void clearRegisterHandles();
+
     private:
       // Do Not use default constructor. GEMHwDevice object should only be made using
       // either connection file method or with a list of URIs and Address Tables
@@ -460,8 +626,22 @@ namespace gem {
       xdata::UnsignedInteger32 xs_controlHubPort;
       xdata::UnsignedInteger32 xs_ipBusPort;
 
+      friend class GEMHwTransaction;
+
       bool knownErrorCode(std::string const& errCode) const;
 
+      /**
+       * @brief sends the writes queued in the active transaction, before any other access to the hardware
+       */
+      void flushTransaction();
+
+      GEMHwTransaction* p_transaction;  ///< transaction queueing the writes, NULL if none is in scope
+
+      // resolved registers by name, node based so the handles are never moved
+      std::unordered_map<std::string, RegisterHandle> m_registerHandles;
+
+      mutable GEMHwDeviceStats m_stats;
+
       //std::string registerToChar(uint32_t value) const;
     };  // class GEMHwDevice
   }  // namespace gem::hw
@@ -0,0 +1,98 @@
+/** @file GEMHwDeviceStats.h */
+
+#ifndef GEM_HW_GEMHWDEVICESTATS_H
+#define GEM_HW_GEMHWDEVICESTATS_H
+
+#include <stdint.h>
+
+#include <atomic>
+#include <ostream>
+#include <string>
+
+#include "gem/utils/LatencyHistogram.h"
+
+namespace gem {
+  namespace hw {
+
+    /**
+     * @class GEMHwDeviceStats
+     * @brief Latency, retry and lock wait statistics of the IPBus accesses of one device
+     *
+     * The accesses are attributed to the category of the calling thread, set with a ScopedCategory,
+     * so that a monitoring or readout thread starving the link shows up next to the control accesses.
+     * All counters are atomics, recording never takes a lock.
+     */
+    class GEMHwDeviceStats
+    {
+    public:
+      enum AccessCategory {
+        CONTROL    = 0,  ///< default for threads that did not set a category, e.g., the state transitions
+        MONITORING = 1,
+        READOUT    = 2,
+        N_CATEGORIES
+      };
+
+      static std::string categoryName(AccessCategory const& category);
+
+      /**
+       * @class ScopedCategory
+       * @brief sets the category of the accesses made by the current thread until it goes out of scope
+       */
+      class ScopedCategory
+      {
+      public:
+        explicit ScopedCategory(AccessCategory const& category);
+        ~ScopedCategory();
+
+      private:
+        AccessCategory m_previous;
+
+        ScopedCategory(ScopedCategory const&);
+        ScopedCategory& operator=(ScopedCategory const&);
+      };
+
+      /**
+       * @returns the category of the accesses made by the current thread
+       */
+      static AccessCategory currentCategory();
+
+      typedef gem::utils::LatencyHistogram LatencyHistogram;
+
+      struct CategoryStats {
+        LatencyHistogram      dispatch;  ///< duration of the uhal dispatch calls
+        LatencyHistogram      lockWait;  ///< time spent waiting for the device lock
+        std::atomic<uint64_t> retries;   ///< dispatches failing with a known IPBus error and retried
+        std::atomic<uint64_t> failures;  ///< accesses given up after MAX_IPBUS_RETRIES
+
+        CategoryStats();
+      };
+
+      GEMHwDeviceStats();
+
+      void recordDispatch(uint64_t const& ns) { current().dispatch.record(ns); };
+      void recordLockWait(uint64_t const& ns) { current().lockWait.record(ns); };
+      void recordRetry()   { current().retries.fetch_add(1, std::memory_order_relaxed); };
+      void recordFailure() { current().failures.fetch_add(1, std::memory_order_relaxed); };
+
+      CategoryStats const& getCategory(AccessCategory const& category) const {
+        return m_categories[category]; };
+
+      /**
+       * @brief writes {"CONTROL": {...}, "MONITORING": {...}, "READOUT": {...}} with the full histograms
+       */
+      void writeJSON(std::ostream& out) const;
+
+      void reset();
+
+    private:
+      CategoryStats& current() { return m_categories[currentCategory()]; };
+
+      CategoryStats m_categories[N_CATEGORIES];
+
+      GEMHwDeviceStats(GEMHwDeviceStats const&);
+      GEMHwDeviceStats& operator=(GEMHwDeviceStats const&);
+    };  // class GEMHwDeviceStats
+  }  // namespace gem::hw
+}  // namespace gem
+
+#endif  // GEM_HW_GEMHWDEVICESTATS_H
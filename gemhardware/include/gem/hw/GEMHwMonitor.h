@@ -0,0 +1,124 @@
+/** @file GEMHwMonitor.h */
+
+#ifndef GEM_HW_GEMHWMONITOR_H
+#define GEM_HW_GEMHWMONITOR_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gem/base/GEMMonitor.h"
+#include "gem/hw/GEMHwDevice.h"
+
+namespace gem {
+  namespace hw {
+
+    /**
+     * @class GEMHwMonitor
+     * @brief Common base for monitors of uHAL devices (GLIB, OptoHybrid, CTP7)
+     *
+     * The register monitorables are resolved once, in compileMonitorables, into a
+     * flat list of (address, mask) pairs per monitorable set.
+     * updateMonitorables then refreshes each set with queued reads and a single
+     * dispatch, only falling back to one read per register if the batch fails,
+     * and publishes the values of the set with one update per info space.
+     * The accesses made from the monitoring thread are counted in the MONITORING
+     * category of the device access statistics.
+     */
+    class GEMHwMonitor : public gem::base::GEMMonitor
+    {
+    public:
+      /**
+       * Constructor
+       * @param device the uhal device which is to be monitored
+       * @param logger the logger object from the calling application
+       * @param xdaqApp the manager application for the device to be monitored
+       * @param index index of the monitor, used to name the timer
+       */
+      GEMHwMonitor(std::shared_ptr<GEMHwDevice> device,
+                   log4cplus::Logger& logger,
+                   xdaq::Application* xdaqApp,
+                   int const& index);
+
+      virtual ~GEMHwMonitor();
+
+      /**
+       * @brief refreshes every compiled monitorable set from the hardware
+       */
+      virtual void updateMonitorables();
+
+    protected:
+      /**
+       * @brief resolves the address and mask of all register monitorables
+       * Must be called once all monitorables have been added (i.e., at the end of setupHwMonitoring)
+       */
+      void compileMonitorables();
+
+      /**
+       * @brief drops the compiled register lists and JSON items, should be called when the monitorables are cleared
+       */
+      void clearCompiledMonitorables();
+
+      /**
+       * @brief adds the "IPBus Statistics" set, with the device access statistics of each caller category
+       * The items are created in the info space if needed, and are refreshed by updateMonitorables
+       * @param infoSpaceName name of the info space of the monitor in which to create the items
+       */
+      void addIPBusStatsMonitorables(std::string const& infoSpaceName);
+
+      typedef std::pair<std::shared_ptr<gem::base::utils::GEMInfoSpaceToolBox>,
+        gem::base::utils::GEMInfoSpaceToolBox::ItemUpdateList> infospace_update_list;
+
+      typedef struct {
+        std::string name;
+        std::shared_ptr<gem::base::utils::GEMInfoSpaceToolBox> infoSpace;
+        gem::base::utils::GEMInfoSpaceToolBox::UpdateType updatetype;
+        size_t regIndex;     // position of the (first) register in the set register list
+        size_t updateList;   // position of the update list of the item's info space in the set
+        size_t updateIndex;  // position of the item in that update list
+      } GEMHwMonitorable;
+
+      typedef struct {
+        std::vector<GEMHwMonitorable>      monitorables;
+        masked_register_pair_list          registers;
+        std::vector<infospace_update_list> updates;  // one per info space used by the set
+      } GEMHwMonitorableSet;
+
+      // map between monitorable set name and the resolved registers of the set
+      std::unordered_map<std::string, GEMHwMonitorableSet> m_compiledSetsMap;
+
+    private:
+      /**
+       * @brief appends the address and mask of the node to the register list
+       * @retval false if the node could not be found in the address table
+       */
+      bool addRegister(std::string const& regName, masked_register_pair_list& registers);
+
+      /**
+       * @brief appends the info space item of the monitorable to the set update list of its info space
+       * @retval false if the item does not exist in the info space with the type of its update
+       */
+      bool addUpdate(GEMHwMonitorable& hwitem, GEMHwMonitorableSet& monset);
+
+      /**
+       * @brief copies the values in the set register list into the info space items,
+       *        with one lock and one change notification per info space
+       */
+      void publishSet(GEMHwMonitorableSet& monset);
+
+      /**
+       * @brief copies the device access statistics into the info space items of the "IPBus Statistics" set
+       */
+      void publishIPBusStats();
+
+      std::shared_ptr<GEMHwDevice> p_hwDevice;
+
+      // items of the "IPBus Statistics" set, empty if the set was not added
+      infospace_update_list m_ipBusStatsUpdates;
+    };  // class GEMHwMonitor
+
+  }  // namespace gem::hw
+}  // namespace gem
+
+#endif  // GEM_HW_GEMHWMONITOR_H
@@ -0,0 +1,146 @@
+/** @file GEMHwTransaction.h */
+
+#ifndef GEM_HW_GEMHWTRANSACTION_H
+#define GEM_HW_GEMHWTRANSACTION_H
+
+#include <memory>
+#include <vector>
+
+#include "gem/hw/GEMHwDevice.h"
+
+namespace gem {
+  namespace hw {
+
+    /**
+     * @class GEMHwTransaction
+     * @brief Scoped batch of register reads and writes, sent to the hardware with as few dispatch calls as possible
+     *
+     * While a transaction is in scope it holds the hardware lock of its device, and every
+     * writeReg made through the device, including those inside the device's own methods,
+     * is queued in the transaction rather than dispatched, e.g.,
+     *   {
+     *     gem::hw::GEMHwTransaction batch(*amc);
+     *     amc->resetL1ACount();
+     *     amc->resetDAQLink();
+     *   }  // both sent here
+     * Any other access through the device (readReg, readBlock, ...) first dispatches what is queued,
+     * so the order of the operations is kept.
+     * Reads can be queued too, the values are available once the transaction has been dispatched.
+     * Queued operations are sent in groups of at most dispatchSize, each group is retried as
+     * a whole on the recognized IPBus errors, as the single register methods are.
+     * Queued writes are not read back, unlike GEMHwDevice::writeReg, queue a read to check them.
+     */
+    class GEMHwTransaction
+    {
+    public:
+      static const size_t DEFAULT_DISPATCH_SIZE = 256;  ///< operations per dispatch call
+
+      /**
+       * @class Value
+       * @brief Value of a queued read, available once the transaction has been dispatched
+       */
+      class Value
+      {
+      public:
+        Value() {};
+
+        /**
+         * @returns true if the read was dispatched successfully
+         */
+        bool valid() const { return p_result && p_result->valid; };
+
+        /**
+         * @returns the value read, 0 if the read was not dispatched successfully
+         */
+        uint32_t value() const { return valid() ? p_result->value : 0x0; };
+
+        struct Result {
+          Result() : value(0x0), valid(false) {};
+          uint32_t value;
+          bool     valid;
+        };
+
+      private:
+        friend class GEMHwTransaction;
+
+        std::shared_ptr<Result> p_result;
+      };
+
+      /**
+       * @brief Starts a transaction on a device, queueing the device's register writes until it goes out of scope
+       * @param device the device to queue the operations for
+       * @param dispatchSize maximum number of operations sent with a single dispatch call
+       */
+      explicit GEMHwTransaction(GEMHwDevice& device, size_t const& dispatchSize=DEFAULT_DISPATCH_SIZE);
+
+      /**
+       * @brief Dispatches the queued operations, failures are logged
+       */
+      ~GEMHwTransaction();
+
+      /**
+       * @brief queues a read of a register
+       * @returns the deferred value of the register
+       */
+      Value read(GEMHwDevice::RegisterHandle const& reg);
+      Value read(std::string const& regName);
+
+      /**
+       * @brief queues a read of a raw address
+       * @param mask the value is shifted down to the first bit of the mask
+       */
+      Value read(uint32_t const& address, uint32_t const& mask=0xffffffff);
+
+      /**
+       * @brief queues a write to a register, a read-modify-write if the register does not span the full word
+       */
+      void write(GEMHwDevice::RegisterHandle const& reg, uint32_t const val);
+      void write(std::string const& regName, uint32_t const val);
+
+      /**
+       * @brief queues a write to a raw address
+       * @param mask bits of the word to modify, the value is shifted up to the first bit of the mask,
+       *        a read-modify-write for any mask other than 0xffffffff
+       */
+      void write(uint32_t const& address, uint32_t const val, uint32_t const& mask=0xffffffff);
+
+      /**
+       * @brief sends the queued operations to the hardware
+       * @returns false if any group of operations could not be sent, the values of its reads are not valid
+       */
+      bool dispatch();
+
+      /**
+       * @returns the number of operations waiting to be dispatched
+       */
+      size_t pending() const { return m_operations.size(); };
+
+    private:
+      struct Operation {
+        bool        isRead;
+        uint32_t    address;
+        uint32_t    mask;
+        uint32_t    value;
+        std::string const* name;  ///< name of the register for the error messages, NULL for a raw address
+        std::shared_ptr<Value::Result> result;
+      };
+
+      bool dispatchGroup(uhal::HwInterface& hw, size_t const& first, size_t const& last);
+
+      std::string operationName(Operation const& op) const;
+
+      log4cplus::Logger      m_gemLogger;
+      GEMHwDevice&           m_device;
+      GEMHwDevice::TimedLockGuard m_hwLockGuard;  ///< hardware lock of the device, released even if the constructor throws
+      size_t                 m_dispatchSize;
+      GEMHwTransaction*      p_outer;       ///< transaction that was active on the device before this one
+      std::vector<Operation> m_operations;
+
+      // Prevent copying.
+      GEMHwTransaction(GEMHwTransaction const&);
+      GEMHwTransaction& operator=(GEMHwTransaction const&);
+    };  // class GEMHwTransaction
+  }  // namespace gem::hw
+}  // namespace gem
+
+#endif  // GEM_HW_GEMHWTRANSACTION_H
@@ -318,50 +318,50 @@ namespace gem {
          */
         virtual void flushTriggerFIFO(uint8_t const& gtx);
 
-        ///** obsolete in generic AMC firmware **/
-        ///**
-        // * Read the tracking data FIFO occupancy in terms of raw 32bit words
-        // * @param uint8_t gtx is the number of the gtx to query
-        // * @retval uint32_t returns the number of words in the tracking data FIFO
-        // */
-        //virtual uint32_t getFIFOOccupancy(uint8_t const& gtx);
-        //
-        ///**
-        // * Read the tracking data FIFO occupancy in terms of the number of 7x32bit words
-        // * composing a single VFAT block
-        // * @param uint8_t gtx is the number of the gtx to query
-        // * @retval uint32_t returns the number of VFAT blocks in the tracking data FIFO
-        // */
-        //virtual uint32_t getFIFOVFATBlockOccupancy(uint8_t const& gtx);
-        //
-        ///**
-        // * see if there is tracking data available
-        // * @param uint8_t gtx is the number of the column of the tracking data to read
-        // * @retval bool returns true if there is tracking data in the FIFO
-        // TRK_DATA.COLX.DATA_RDY
-        //*/
-        //virtual bool hasTrackingData(uint8_t const& gtx);
-        //
-        ///**
-        // * get the tracking data, have to do this intelligently, as IPBus transactions are expensive
-        // * and need to pack all events together
-        // * @param uint8_t gtx is the number of the GTX tracking data to read
-        // * @param sizeo_t nBlocks is the number of VFAT data blocks (7*32bit words) to read
-        // * @retval std::vector<uint32_t> returns the 7*nBlocks data words in the buffer
-        // */
-        //std::vector<uint32_t> getTrackingData(uint8_t const& gtx, size_t const& nBlocks=1);
-        ////which of these will be better and do what we want
-        //virtual uint32_t getTrackingData(uint8_t const& gtx, uint32_t* data, size_t const& nBlocks=1);
-        ////which of these will be better and do what we want
-        //virtual uint32_t getTrackingData(uint8_t const& gtx, std::vector<toolbox::mem::Reference*>& data,
-        //                         size_t const& nBlocks=1);
-        //
-        ///**
-        // * Empty the tracking data FIFO
-        // * @param uint8_t gtx is the number of the gtx to query
-        // *
-        // */
-        //virtual void flushFIFO(uint8_t const& gtx);
+        /** tracking data FIFO, read by the GLIB readout **/
+        /**
+         * Read the tracking data FIFO occupancy in terms of raw 32bit words
+         * @param uint8_t gtx is the number of the gtx to query
+         * @retval uint32_t returns the number of words in the tracking data FIFO
+         */
+        virtual uint32_t getFIFOOccupancy(uint8_t const& gtx);
+
+        /**
+         * Read the tracking data FIFO occupancy in terms of the number of 7x32bit words
+         * composing a single VFAT block
+         * @param uint8_t gtx is the number of the gtx to query
+         * @retval uint32_t returns the number of VFAT blocks in the tracking data FIFO
+         */
+        virtual uint32_t getFIFOVFATBlockOccupancy(uint8_t const& gtx);
+
+        /**
+         * see if there is tracking data available
+         * @param uint8_t gtx is the number of the column of the tracking data to read
+         * @retval bool returns true if there is tracking data in the FIFO
+         TRK_DATA.COLX.DATA_RDY
+        */
+        virtual bool hasTrackingData(uint8_t const& gtx);
+
+        /**
+         * get the tracking data, have to do this intelligently, as IPBus transactions are expensive
+         * and need to pack all events together
+         * @param uint8_t gtx is the number of the GTX tracking data to read
+         * @param sizeo_t nBlocks is the number of VFAT data blocks (7*32bit words) to read
+         * @retval std::vector<uint32_t> returns the 7*nBlocks data words in the buffer
+         */
+        std::vector<uint32_t> getTrackingData(uint8_t const& gtx, size_t const& nBlocks=1);
+        //which of these will be better and do what we want
+        virtual uint32_t getTrackingData(uint8_t const& gtx, uint32_t* data, size_t const& nBlocks=1);
+        //which of these will be better and do what we want
+        virtual uint32_t getTrackingData(uint8_t const& gtx, std::vector<toolbox::mem::Reference*>& data,
+                                         size_t const& nBlocks=1);
+
+        /**
+         * Empty the tracking data FIFO
+         * @param uint8_t gtx is the number of the gtx to query
+         *
+         */
+        virtual void flushFIFO(uint8_t const& gtx);
 
         /**************************/
         /** DAQ link information **/
@@ -797,6 +797,40 @@ namespace gem {
 
         std::vector<linkStatus> v_activeLinks;
 
+        /**
+         * @struct AMCLinkRegisters
+         * @brief Handles of the per-link registers read by LinkStatus and getIPBusCounters
+         */
+        typedef struct AMCLinkRegisters {
+          bool resolved;
+          RegisterHandle const* trackLinkErrors;
+          RegisterHandle const* triggerMissedComma;
+          RegisterHandle const* vfatBlocks;
+          RegisterHandle const* ohStrobe;
+          RegisterHandle const* ohAck;
+          RegisterHandle const* counterStrobe;
+          RegisterHandle const* counterAck;
+
+        AMCLinkRegisters() :
+          resolved(false),
+            trackLinkErrors(NULL), triggerMissedComma(NULL), vfatBlocks(NULL),
+            ohStrobe(NULL), ohAck(NULL), counterStrobe(NULL), counterAck(NULL) {}
+        } AMCLinkRegisters;
+
+        /**
+         * @brief returns the register handles of a link, resolving them on first use,
+         *        which is the link status check in isHwConnected
+         * @param gtx is the link, must be less than N_GTX
+         */
+        AMCLinkRegisters const& linkRegisters(uint8_t const& gtx);
+
+        AMCLinkRegisters m_linkRegisters[N_GTX];
+
+        /**
+         * @brief drops the link register handles along with the cached handles of the device
+         */
+        virtual void clearRegisterHandles();
+
         /**
          * @brief sets the expected board ID string to be matched when reading from the firmware
          * @param boardID is the expected board ID
@@ -3,6 +3,8 @@
 #ifndef GEM_HW_AMC13_AMC13MANAGER_H
 #define GEM_HW_AMC13_AMC13MANAGER_H
 
+#include <atomic>
+#include <chrono>
 #include <iomanip>
 
 //copying general structure of the HCAL DTCManager (HCAL name for AMC13)
@@ -83,8 +85,43 @@ namespace gem {
           xoap::MessageReference enableTriggers(xoap::MessageReference mns);
           xoap::MessageReference disableTriggers(xoap::MessageReference mns);
 
+          /**
+           * @brief Queues the EndScanPoint notification to the supervisor on a workloop, the supervisor
+           *        pauses this application before replying, so it is never sent from the timer thread
+           */
 	  void endScanPoint();
 
+          /**
+           * @brief Sends the EndScanPoint command to the supervisor, run on the scan workloop
+           */
+          bool sendEndScanPoint(toolbox::task::WorkLoop* wl);
+
+          /**
+           * @brief Arms the trigger counting for a new scan point
+           * With local L1As (not LEMO) the AMC13 is programmed to send exactly the number of
+           * triggers requested for the point, in bursts of at most MAX_L1A_BURST, otherwise the
+           * triggers are stopped once the L1A counter reaches the requested number
+           */
+          void startScanPoint();
+
+          /**
+           * @brief Schedules the next check of the scan point trigger counter
+           * @param seconds delay before the check
+           */
+          void scheduleScanPointCheck(double const& seconds);
+
+          /**
+           * @brief Marks the current scan point as done, a check already scheduled neither ends
+           *        the point nor schedules another one
+           */
+          void abortScanPoint();
+
+          /**
+           * @brief Marks the current scan point as done and stops the trigger counter timer,
+           *        must be called without holding m_amc13Lock as timeExpired takes it
+           */
+          void stopScanPointTimer();
+
 	  virtual void timeExpired(toolbox::task::TimerEvent& event);
 
           // virtual void noAction();
@@ -230,12 +267,20 @@ namespace gem {
           };
 
         private:
+          static const uint32_t MAX_L1A_BURST = 4096;  ///< largest burst of local L1As the AMC13 can send
+
+          // bounds of the delay between two checks of the scan point trigger counter, in seconds
+          static constexpr double MIN_SCAN_POLL_INTERVAL = 0.001;
+          static constexpr double MAX_SCAN_POLL_INTERVAL = 0.1;
+
           mutable gem::utils::Lock m_amc13Lock;
 
           amc13_ptr p_amc13;
 
 	  toolbox::task::Timer* p_timer;    // timer for general info space updates
 
+          toolbox::task::ActionSignature* m_endScanPointSig;  ///< EndScanPoint sent from the scan workloop
+
           //paramters taken from hcal::DTCManager (the amc13 manager for hcal)
           xdata::Integer m_crateID, m_slot;
 
@@ -261,6 +306,14 @@ namespace gem {
             m_internalPeriodicPeriod, m_L1Aburst;
           //uint64_t m_localL1AMask;
 	  uint64_t m_updatedL1ACount;
+
+          // scan point trigger counting, set up by the FSM actions and advanced by the timer callback
+          bool              m_scanBursts;     ///< the triggers of the scan point are sent as local L1A bursts
+          std::atomic<bool> m_scanPointDone;  ///< EndScanPoint has been sent for the current point, or the run stopped
+          uint64_t m_scanTriggersSent;    ///< L1As requested with bursts for the current point
+          uint64_t m_scanLastSeen;        ///< L1As seen at the previous check
+          std::chrono::steady_clock::time_point m_scanLastCheck;  ///< time of the previous check
+          double   m_scanPollInterval;    ///< delay before the next check, in seconds
           ////counters
 
         protected:
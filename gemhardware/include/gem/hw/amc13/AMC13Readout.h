@@ -3,9 +3,15 @@
 #ifndef GEM_HW_AMC13_AMC13READOUT_H
 #define GEM_HW_AMC13_AMC13READOUT_H
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+
 #include <gem/readout/GEMReadoutApplication.h>
+#include <gem/utils/SPSCRingBuffer.h>
 #include <gem/hw/amc13/exception/Exception.h>
-#include <ctime>
 
 namespace amc13 {
   class AMC13;
@@ -19,16 +25,37 @@ namespace gem {
 
       typedef std::shared_ptr< ::amc13::AMC13>  amc13_shared_ptr;
 
+      class AMC13ChunkWriterTask;
+
+      /**
+       * @class AMC13Readout
+       * @brief Reads the events from the AMC13 monitor buffer and writes them to chunk files
+       *
+       * The readout task drains the monitor buffer, packing the events into frames from the
+       * readout memory pool, the frames are queued to a writer task which streams them into
+       * the current chunk file and gives them back to the pool.
+       * A new chunk file is started when the current one exceeds chunkSizeMB or has been open
+       * for more than chunkSeconds of wall-clock time.
+       */
       class AMC13Readout: public gem::readout::GEMReadoutApplication
         {
         public:
           XDAQ_INSTANTIATOR();
 
+          static const uint32_t kQUEUESIZE;   ///< capacity of the chunk queue, in pool frames
+          static const uint32_t kFRAMESIZE;   ///< size of the frames the events are packed into, in bytes
+
           AMC13Readout(xdaq::ApplicationStub* s)
             throw (xdaq::exception::Exception);
 
           virtual ~AMC13Readout();
 
+          /**
+           * @brief writes the queued frames to the chunk files until the application is destroyed
+           * Runs in the AMC13ChunkWriterTask
+           */
+          int writerTask();
+
         protected:
           virtual void actionPerformed(xdata::Event& event);
 
@@ -44,16 +71,78 @@ namespace gem {
 
           virtual int readout(unsigned int expected, unsigned int* eventNumbers, std::vector< ::toolbox::mem::Reference* >& data);
 
+          /**
+           * @brief reads all events in the monitor buffer and queues them to the writer
+           * Events are left in the monitor buffer while no frame is available
+           * @returns the number of events read
+           */
           int dumpData();
 
         private:
+          /**
+           * @brief queues the frame being filled to the writer, waiting for space in the queue
+           */
+          void queueFrame();
+
+          // writer side, only called from writerTask
+          void openChunk();
+          void closeChunk();
+          void writeFrame(toolbox::mem::Reference* frame);
+
+          typedef gem::readout::GEMReadoutMetrics::clock metrics_clock;
+
+          /**
+           * @brief a filled frame and the time its first event was read, for the read to write latency
+           */
+          struct QueuedFrame {
+            toolbox::mem::Reference* frame;
+            metrics_clock::time_point readTime;
+          };
+
           amc13_shared_ptr p_amc13;
           xdata::String  m_cardName;
           xdata::Integer m_crateID, m_slot;
-          int cnt;
-          int nwrote_global;
-          std::clock_t m_start;
-          double m_duration;
+
+          // chunk rotation
+          xdata::UnsignedInteger32 m_chunkSizeMB;   // start a new chunk after this many MB, 0 for no limit
+          xdata::UnsignedInteger32 m_chunkSeconds;  // start a new chunk after this many seconds, 0 for no limit
+
+          // frames filled by the readout task and drained by the writer task
+          gem::utils::SPSCRingBuffer<QueuedFrame> m_chunkQueue;
+          toolbox::mem::Reference* p_frame;  // frame being filled by the readout task
+          metrics_clock::time_point m_frameReadTime;  // when the first event in p_frame was read
+
+          std::shared_ptr<AMC13ChunkWriterTask> m_writerTask;
+          std::atomic<bool> m_writerExit;
+
+          // set by writerTask once it has returned from its loop, the destructor waits for it
+          std::mutex              m_writerMutex;
+          std::condition_variable m_writerFinished;
+          bool                    m_writerDone;
+          std::atomic<bool> m_running;       // cleared at stop, the writer closes the chunk once the queue is empty
+
+          // chunk file name, set at start and read by the writer when it opens a chunk
+          std::mutex  m_chunkMutex;
+          std::string m_chunkBaseName;
+          std::atomic<uint32_t> m_runIndex;  // incremented at each start, the writer restarts the chunk numbering
+
+          // writer task state
+          std::ofstream m_chunkFile;
+          uint32_t      m_writerRunIndex;
+          uint32_t      m_chunkIndex;
+          uint64_t      m_chunkBytes;
+          std::chrono::steady_clock::time_point m_chunkOpened;
+      };
+
+      class AMC13ChunkWriterTask : public toolbox::Task {
+      public:
+        AMC13ChunkWriterTask(AMC13Readout* app) : toolbox::Task("AMC13ChunkWriterTask")
+        {
+          p_readoutApp = app;
+        }
+        virtual int svc() { return p_readoutApp->writerTask(); }
+      private:
+        AMC13Readout* p_readoutApp;
       };
     }  // namespace gem::hw::amc13
   }  // namespace gem::hw
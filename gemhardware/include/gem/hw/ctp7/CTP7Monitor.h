@@ -3,7 +3,7 @@
 #ifndef GEM_HW_CTP7_CTP7MONITOR_H
 #define GEM_HW_CTP7_CTP7MONITOR_H
 
-#include "gem/base/GEMMonitor.h"
+#include "gem/hw/GEMHwMonitor.h"
 #include "gem/hw/ctp7/exception/Exception.h"
 #include "gem/hw/ctp7/HwCTP7.h"
 
@@ -14,7 +14,7 @@ namespace gem {
       class HwCTP7;
       class CTP7Manager;
 
-      class CTP7Monitor : public gem::base::GEMMonitor
+      class CTP7Monitor : public gem::hw::GEMHwMonitor
       {
       public:
 
@@ -27,7 +27,6 @@ namespace gem {
 
         virtual ~CTP7Monitor();
 
-        virtual void updateMonitorables();
         virtual void reset();
         void setupHwMonitoring();
         void buildMonitorPage(xgi::Output* out);
@@ -3,8 +3,13 @@
 #ifndef GEM_HW_CTP7_CTP7READOUT_H
 #define GEM_HW_CTP7_CTP7READOUT_H
 
+#include <atomic>
+
 #include "gem/readout/GEMReadoutApplication.h"
 #include "gem/readout/GEMDataAMCformat.h"
+#include "gem/readout/GEMEventWriter.h"
+#include "gem/readout/GEMVFATDecoder.h"
+#include "gem/utils/SPSCRingBuffer.h"
 #include "gem/hw/ctp7/exception/Exception.h"
 
 namespace gem {
@@ -25,6 +30,8 @@ namespace gem {
 
           static const uint32_t kUPDATE;
           static const uint32_t kUPDATE7;
+          static const uint32_t kQUEUESIZE;    ///< capacity of the data queue, in pool frames
+          static const uint32_t kFRAMEBLOCKS;  ///< maximum number of VFAT blocks read into one pool frame
 
           CTP7Readout(xdaq::ApplicationStub* s);
           //CTP7Readout(xdaq::ApplicationStub* s, ctp7_shared_ptr ctp7);
@@ -80,14 +87,14 @@ namespace gem {
           void GEMfillTrailers(gem::readout::GEMDataAMCformat::GEMData& gem,
                                gem::readout::GEMDataAMCformat::GEBData& geb);
 
-          void writeGEMevent(std::string outFile,
+          void writeGEMevent(gem::readout::GEMEventWriter& writer,
                              bool const& OKprint,
                              std::string const& TypeDataFlag,
                              gem::readout::GEMDataAMCformat::GEMData& gem,
                              gem::readout::GEMDataAMCformat::GEBData& geb,
                              gem::readout::GEMDataAMCformat::VFATData& vfat);
 
-          int queueDepth() {return m_dataque.size();}
+          int queueDepth() {return m_queuedWords.load();}
 
         private:
           uint32_t m_runType;
@@ -101,14 +108,20 @@ namespace gem {
           //uint64_t m_ZSFlag;
           uint32_t m_contvfats;
 
-          void readVFATblock(std::queue<uint32_t>& dataque);
+          /**
+           * @brief takes the next decoded VFAT block
+           * Once the decoded blocks are used up, the next queued frame is decoded as a whole
+           * and given back to the pool. Words preceding a block header are dropped
+           * @param vfat the decoded block
+           * @returns false if no complete block is available yet
+           */
+          bool readVFATblock(gem::readout::GEMDataAMCformat::VFATData& vfat);
 
-          // this can't be the best way to do this...
-          uint32_t dat10,dat11, dat20,dat21, dat30,dat31, dat40,dat41;
-          uint32_t BX;
-          uint16_t bcn, evn, chipid, vfatcrc;
-          uint16_t b1010, b1100, b1110;
-          uint8_t  flags;
+          /**
+           * @brief gives all queued frames back to the pool, neither the readout nor
+           * the event building may be running
+           */
+          void releaseFrames();
 
           uint8_t m_latency, m_VT1, m_VT2;
 
@@ -129,10 +142,19 @@ namespace gem {
           std::string m_errFileName;
           std::string m_outputType;
 
-          // queue safety
-          mutable gem::utils::Lock m_queueLock;
-          // The main data flow
-          std::queue<uint32_t> m_dataque;
+          // output files, opened at start and closed at stop
+          std::unique_ptr<gem::readout::GEMEventWriter> p_dataWriter;
+          std::unique_ptr<gem::readout::GEMEventWriter> p_errWriter;
+
+          // The main data flow, pool frames filled by the hardware readout and drained by the event builder
+          gem::utils::SPSCRingBuffer<toolbox::mem::Reference*> m_dataque;
+
+          // blocks of the last frame taken from the queue, and the position of the next one
+          gem::readout::VFATBlockBatch m_batch;
+          size_t                       m_batchIndex;
+
+          // words read from the hardware and not yet decoded
+          std::atomic<uint64_t> m_queuedWords;
 
           xdata::UnsignedInteger64 m_queueDepth;
           /*
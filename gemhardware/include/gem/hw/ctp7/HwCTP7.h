@@ -612,9 +612,23 @@ namespace gem {
            * @retval std::vector<uint32_t> returns the 7*nBlocks data words in the buffer
           */
           std::vector<uint32_t> getTrackingData(uint8_t const& gtx, size_t const& nBlocks=1);
-          //which of these will be better and do what we want
+
+          /**
+           * get the tracking data into a caller provided buffer, e.g., a memory pool frame
+           * @param uint8_t gtx is the number of the GTX tracking data to read
+           * @param uint32_t* data is the destination, must hold at least 7*nBlocks words
+           * @param size_t nBlocks is the number of VFAT data blocks (7*32bit words) to read
+           * @retval uint32_t returns the number of complete VFAT blocks read
+          */
           uint32_t getTrackingData(uint8_t const& gtx, uint32_t* data, size_t const& nBlocks=1);
-          //which of these will be better and do what we want
+
+          /**
+           * get the tracking data into pre-allocated memory pool frames
+           * @param uint8_t gtx is the number of the GTX tracking data to read
+           * @param data the frames to fill in order, the data size of each frame used is set
+           * @param size_t nBlocks is the number of VFAT data blocks (7*32bit words) to read
+           * @retval uint32_t returns the number of complete VFAT blocks read
+          */
           uint32_t getTrackingData(uint8_t const& gtx, std::vector<toolbox::mem::Reference*>& data,
                                    size_t const& nBlocks=1);
 
@@ -862,6 +876,35 @@ namespace gem {
 
           std::vector<linkStatus> v_activeLinks;
 
+          /**
+           * @struct TrackingFIFORegisters
+           * @brief Handles of the tracking data FIFO registers of a link, read on every readout cycle
+           */
+          typedef struct TrackingFIFORegisters {
+            bool resolved;
+            RegisterHandle const* depth;
+            RegisterHandle const* isEmpty;
+            RegisterHandle const* fifo;
+
+          TrackingFIFORegisters() :
+            resolved(false), depth(NULL), isEmpty(NULL), fifo(NULL) {}
+          } TrackingFIFORegisters;
+
+          /**
+           * @brief returns the tracking FIFO handles of a link, resolving them on first use,
+           *        isHwConnected resolves them for every link present
+           * @param gtx is the link
+           * @throws gem::hw::ctp7::exception::InvalidLink if the gtx number is outside of 0-N_GTX
+           */
+          TrackingFIFORegisters const& trackingRegisters(uint8_t const& gtx);
+
+          TrackingFIFORegisters m_trackingRegisters[N_GTX];
+
+          /**
+           * @brief drops the tracking FIFO handles along with the link and device handles
+           */
+          virtual void clearRegisterHandles();
+
         private:
           // uint8_t m_controlLink;
           int m_crate, m_slot;
@@ -0,0 +1,191 @@
+/** @file GEMHwEmulatorModel.h */
+
+#ifndef GEM_HW_EMULATOR_GEMHWEMULATORMODEL_H
+#define GEM_HW_EMULATOR_GEMHWEMULATORMODEL_H
+
+#include <stdint.h>
+
+#include <array>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gem/utils/GEMLogging.h"
+
+namespace gem {
+  namespace hw {
+    namespace emulator {
+
+      /**
+       * @class GEMHwEmulatorModel
+       * @brief Register space and firmware behaviour of an AMC (GLIB/CTP7) with its OptoHybrids and VFAT2s
+       *
+       * The registers are taken from the uHAL address tables used by the devices, every register is
+       * plain memory except for the firmware blocks that are recognised from their paths:
+       *  - <OH>.GEB.Broadcast: I2C broadcast reads and writes of the VFAT registers, with the results
+       *    in the 0x00XXYYZZ (status, slot, value) format
+       *  - <OH>.ScanController.THLAT and .ULTRA: synthetic threshold, latency and S-curve results
+       *  - <OH>.T1Controller and <OH>.COUNTERS.T1: the T1 generator and its counters
+       *  - <AMC>.TRK_DATA.OptoHybrid_N: the tracking data FIFO of OptoHybrid N, filled with one
+       *    VFAT block with a valid CRC per VFAT for each L1A sent by the T1 generator or by the
+       *    emulated external trigger
+       * Time dependent behaviour (triggers, scan duration) is computed from the wall clock when the
+       * registers are accessed, no thread runs in the background.
+       * Not thread safe, the model is driven by a single IPbusUDPServer.
+       */
+      class GEMHwEmulatorModel
+      {
+      public:
+        static const uint32_t N_VFATS     = 24;
+        static const uint32_t BLOCK_WORDS = 7;  ///< 32-bit words per VFAT block in the tracking data FIFO
+
+        struct Config {
+          Config();
+
+          uint32_t vfatsPerOH;      ///< VFATs answering in the slots 0 to vfatsPerOH-1 of each GEB
+          double   l1aRate;         ///< rate of the emulated external L1As in Hz, 0 for none
+          uint32_t fifoDepth;       ///< capacity of each tracking data FIFO in 32-bit words
+          uint32_t scanPointTime;   ///< time taken by each scan point in microseconds
+          uint32_t occupancyBits;   ///< each channel fires with a probability 2^-occupancyBits, 0 for no hits
+          uint32_t seed;            ///< seed of the hit generator
+        };
+
+        GEMHwEmulatorModel(Config const& config, log4cplus::Logger const& logger);
+
+        /**
+         * @brief adds the registers of a uHAL address table and binds the firmware blocks it contains
+         * @param addressTable uHAL address table expression, e.g., file://uhal_gem_amc_ctp7_amc.xml
+         */
+        void addAddressTable(std::string const& addressTable);
+
+        /**
+         * @brief adds one register, the firmware blocks are bound by bind()
+         * @param path full register name, e.g., GEM_AMC.OH.OH0.T1Controller.TOGGLE
+         * @param mask bits of the 32-bit word holding the register
+         * @param port true for non-incrementing block registers, e.g., FIFOs
+         */
+        void addNode(std::string const& path, uint32_t const& address, uint32_t const& mask, bool const& port);
+
+        /**
+         * @brief recognises the firmware blocks among the registers added since the last call
+         */
+        void bind();
+
+        size_t nRegisters()   const { return m_nodes.size();       };
+        size_t nOptoHybrids() const { return m_optohybrids.size(); };
+        size_t nFIFOs()       const { return m_fifos.size();       };
+
+        /** IPbus transactions **/
+        uint32_t read(uint32_t const& address);
+        void     write(uint32_t const& address, uint32_t const& value);
+        void     readBlock(uint32_t const& address, uint32_t const& nWords, bool const& incremental, uint32_t* values);
+        void     writeBlock(uint32_t const& address, uint32_t const& nWords, bool const& incremental,
+                            uint32_t const* values);
+        uint32_t readModifyWriteBits(uint32_t const& address, uint32_t const& andTerm, uint32_t const& orTerm);
+        uint32_t readModifyWriteSum(uint32_t const& address, uint32_t const& addend);
+
+      private:
+        typedef std::chrono::steady_clock Clock;
+        typedef std::function<void()>     Hook;
+
+        struct Node {
+          uint32_t address;
+          uint32_t mask;
+          bool     port;
+        };
+
+        struct TrackingFIFO {
+          TrackingFIFO();
+
+          std::deque<uint32_t> words;
+          uint64_t             dropped;  ///< blocks lost because the FIFO was full
+        };
+
+        struct ScanModule {
+          ScanModule();
+
+          std::deque<uint32_t>                         results;      ///< THLAT
+          std::array<std::deque<uint32_t>, N_VFATS>    vfatResults;  ///< ULTRA
+          Clock::time_point                            end;
+        };
+
+        struct T1Generator {
+          T1Generator();
+
+          bool              running;
+          Clock::time_point start;
+          uint32_t          type;
+          uint32_t          number;    ///< signals to send, 0 for no limit
+          uint32_t          interval;  ///< BX between two signals
+          uint64_t          sent;
+        };
+
+        struct OptoHybrid {
+          OptoHybrid();
+
+          std::string                   prefix;
+          uint32_t                      index;
+          std::array<uint16_t, N_VFATS> chipIDs;
+          std::deque<uint32_t>          broadcastResults;
+          ScanModule                    thlat;
+          ScanModule                    ultra;
+          T1Generator                   t1;
+          uint64_t                      externalL1As;  ///< emulated external L1As already sent
+          uint32_t                      eventCounter;
+        };
+
+        /**
+         * @returns the register, NULL if it is not in the address tables
+         */
+        Node const* node(std::string const& path) const;
+
+        uint32_t getField(std::string const& path) const;
+        void     setField(std::string const& path, uint32_t const& value);
+
+        void onRead(std::string const& path, Hook const& hook);
+        void onWrite(std::string const& path, Hook const& hook);
+        void onPortRead(std::string const& path, std::function<uint32_t()> const& source);
+
+        void bindOptoHybrid(std::string const& prefix, uint32_t const& index);
+        void bindTrackingFIFO(std::string const& prefix, uint32_t const& index);
+        void bindScanModule(OptoHybrid& oh, ScanModule& scan, std::string const& base, bool const& ultra);
+
+        void broadcast(OptoHybrid& oh, std::string const& name, bool const& write);
+        void startScan(OptoHybrid& oh, ScanModule& scan, std::string const& base, bool const& ultra);
+        uint32_t scanCount(uint32_t const& mode, uint32_t const& vfat, uint32_t const& channel,
+                           uint32_t const& value, uint32_t const& nTriggers) const;
+
+        /**
+         * @brief sends the T1 signals and external L1As due since the last update
+         */
+        void update(OptoHybrid& oh);
+        void sendT1(OptoHybrid& oh, uint32_t const& type, std::string const& source, uint64_t const& n);
+        void pushEvent(OptoHybrid& oh, uint32_t const& bx);
+        uint64_t randomHits();
+
+        log4cplus::Logger m_gemLogger;
+
+        Config            m_config;
+        Clock::time_point m_startTime;
+        uint64_t          m_random;
+
+        std::map<std::string, Node>                                m_nodes;
+        std::vector<std::string>                                   m_unbound;  ///< paths added since the last bind()
+        std::unordered_map<uint32_t, uint32_t>                     m_memory;
+        std::unordered_map<uint32_t, std::vector<Hook> >           m_readHooks;
+        std::unordered_map<uint32_t, std::vector<Hook> >           m_writeHooks;
+        std::unordered_map<uint32_t, std::function<uint32_t()> >   m_ports;
+
+        std::map<uint32_t, std::shared_ptr<OptoHybrid> >   m_optohybrids;
+        std::map<uint32_t, std::shared_ptr<TrackingFIFO> > m_fifos;
+      };  // class GEMHwEmulatorModel
+    }  // namespace gem::hw::emulator
+  }  // namespace gem::hw
+}  // namespace gem
+
+#endif  // GEM_HW_EMULATOR_GEMHWEMULATORMODEL_H
@@ -0,0 +1,102 @@
+/** @file IPbusUDPServer.h */
+
+#ifndef GEM_HW_EMULATOR_IPBUSUDPSERVER_H
+#define GEM_HW_EMULATOR_IPBUSUDPSERVER_H
+
+#include <stdint.h>
+
+#include <atomic>
+#include <map>
+#include <vector>
+
+#include "gem/utils/GEMLogging.h"
+
+#include "gem/hw/emulator/GEMHwEmulatorModel.h"
+
+namespace gem {
+  namespace hw {
+    namespace emulator {
+
+      /**
+       * @class IPbusUDPServer
+       * @brief IPbus 2.0 target over UDP, serving the registers of a GEMHwEmulatorModel
+       *
+       * Implements the control, status and resend packets used by the uHAL ipbusudp-2.0 client,
+       * with the packet ID reliability mechanism, so the devices and managers can be pointed at
+       * the emulator through a connection file, e.g., uri="ipbusudp-2.0://localhost:50001".
+       * Each reply can be delayed to reproduce the latency of a crate:
+       * packet + transactions*transaction + words*word.
+       */
+      class IPbusUDPServer
+      {
+      public:
+        static const uint32_t MTU_BYTES        = 1500;  ///< advertised in the status packet
+        static const uint32_t N_REPLY_BUFFERS  = 16;    ///< replies kept for resend requests
+
+        struct Latency {
+          Latency();
+
+          uint32_t packet;       ///< microseconds per control packet
+          uint32_t transaction;  ///< microseconds per transaction
+          uint32_t word;         ///< nanoseconds per word read or written
+        };
+
+        /**
+         * @param port UDP port to listen on, 0 to let the system pick one, see port()
+         * @throws gem::hw::exception::SoftwareProblem if the socket can not be bound
+         */
+        IPbusUDPServer(GEMHwEmulatorModel& model, uint16_t const& port, Latency const& latency,
+                       log4cplus::Logger const& logger);
+
+        ~IPbusUDPServer();
+
+        uint16_t port() const { return m_port; };
+
+        /**
+         * @brief serves packets until stop() is called
+         */
+        void run();
+
+        /**
+         * @brief makes run() return within 100ms, can be called from any thread
+         */
+        void stop() { m_stop = true; };
+
+        uint64_t nPackets()      const { return m_nPackets;      };
+        uint64_t nTransactions() const { return m_nTransactions; };
+
+      private:
+        // Prevent copying of IPbusUDPServer objects
+        IPbusUDPServer(IPbusUDPServer const&);
+        IPbusUDPServer& operator=(IPbusUDPServer const&);
+
+        /**
+         * @brief executes the transactions of a control packet
+         * @param in the packet, in host byte order
+         * @param out the reply, starting with the packet header
+         * @returns the number of transactions executed
+         */
+        uint32_t control(std::vector<uint32_t> const& in, std::vector<uint32_t>& out, uint64_t& nWords);
+
+        void status(std::vector<uint32_t>& out) const;
+
+        log4cplus::Logger m_gemLogger;
+
+        GEMHwEmulatorModel& m_model;
+        Latency             m_latency;
+        int                 m_socket;
+        uint16_t            m_port;
+        std::atomic<bool>   m_stop;
+
+        uint16_t                                   m_nextPacketID;
+        std::map<uint16_t, std::vector<uint32_t> > m_replies;  ///< last replies, by packet ID, in host byte order
+        std::vector<uint16_t>                      m_replyOrder;
+
+        uint64_t m_nPackets;
+        uint64_t m_nTransactions;
+      };  // class IPbusUDPServer
+    }  // namespace gem::hw::emulator
+  }  // namespace gem::hw
+}  // namespace gem
+
+#endif  // GEM_HW_EMULATOR_IPBUSUDPSERVER_H
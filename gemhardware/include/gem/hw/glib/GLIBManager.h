@@ -70,7 +70,31 @@ namespace gem {
            */
           void dumpGLIBFIFO(xgi::Input* in, xgi::Output* out);
 
+          /**
+           * @brief JSON page with the IPBus access statistics of each AMC, with the full latency histograms
+           */
+          void ipBusStats(xgi::Input* in, xgi::Output* out);
+
         private:
+          /**
+           * @brief configures the AMC in one slot, run as a GEMSlotTasks task by configureAction
+           * @throws gem::hw::glib::exception::Exception if the AMC is not connected
+           */
+          void configureAMC(unsigned const& slot);
+
+          /**
+           * @brief starts the AMC in one slot, run as a GEMSlotTasks task by startAction
+           * @throws gem::hw::glib::exception::Exception if the AMC is not connected
+           */
+          void startAMC(unsigned const& slot);
+
+          /**
+           * @brief logs the firmware, TTC and DAQ link status of the AMC in one slot,
+           *        failures to read the status are only logged
+           * @param transition the caller, prefixed to the log message
+           */
+          void logAMCStatus(unsigned const& slot, std::string const& transition);
+
 	  //uint16_t parseAMCEnableList(std::string const&);
 	  //bool     isValidSlotNumber( std::string const&);
           void     createGLIBInfoSpaceItems(is_toolbox_ptr is_glib, glib_shared_ptr glib);
@@ -130,6 +154,7 @@ namespace gem {
           };
 
           mutable gem::utils::Lock m_deviceLock;  // [MAX_AMCS_PER_CRATE];
+          gem::utils::Lock m_confChambersLock;  // confAllChambers is run for one slot at a time
 
           std::array<glib_shared_ptr, MAX_AMCS_PER_CRATE>              m_glibs;
           std::array<std::shared_ptr<GLIBMonitor>, MAX_AMCS_PER_CRATE> m_glibMonitors;
@@ -138,9 +163,10 @@ namespace gem {
           xdata::Vector<xdata::Bag<GLIBInfo> > m_glibInfo;  // [MAX_AMCS_PER_CRATE];
           xdata::String                        m_amcSlots;
           xdata::String                        m_connectionFile;
-          xdata::Boolean                       m_uhalPhaseShift;
+          xdata::Boolean                       m_uhalPhaseShift;  // unused, the phase shift is always done through uHAL
           xdata::Boolean                       m_bc0LockPhaseShift;
           xdata::Boolean                       m_relockPhase;
+          xdata::UnsignedInteger32             m_maxSlotWorkers;  // slots configured at the same time
 
 	  uint32_t m_lastLatency, m_lastVT1, m_lastVT2;
         };  // class GLIBManager
@@ -53,6 +53,9 @@ namespace gem {
           void dumpGLIBFIFO(xgi::Input *in, xgi::Output *out)
             throw (xgi::exception::Exception);
 
+          void ipBusStats(xgi::Input *in, xgi::Output *out)
+            throw (xgi::exception::Exception);
+
         private:
           size_t activeCard;
 
@@ -3,7 +3,7 @@
 #ifndef GEM_HW_GLIB_GLIBMONITOR_H
 #define GEM_HW_GLIB_GLIBMONITOR_H
 
-#include "gem/base/GEMMonitor.h"
+#include "gem/hw/GEMHwMonitor.h"
 #include "gem/hw/glib/exception/Exception.h"
 #include "gem/hw/glib/HwGLIB.h"
 
@@ -14,7 +14,7 @@ namespace gem {
       class HwGLIB;
       class GLIBManager;
 
-      class GLIBMonitor : public gem::base::GEMMonitor
+      class GLIBMonitor : public gem::hw::GEMHwMonitor
       {
       public:
 
@@ -27,7 +27,6 @@ namespace gem {
 
         virtual ~GLIBMonitor();
 
-        virtual void updateMonitorables();
         virtual void reset();
         void setupHwMonitoring();
         void buildMonitorPage(xgi::Output* out);
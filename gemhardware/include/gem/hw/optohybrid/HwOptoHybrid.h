@@ -370,7 +370,8 @@ namespace gem {
            *
            */
           void resetVFATs() {
-            return writeReg(getDeviceBaseNode(),toolbox::toString("CONTROL.VFAT.RESET"),0x1); };
+            writeReg(getDeviceBaseNode(),toolbox::toString("CONTROL.VFAT.RESET"),0x1);
+            gem::hw::vfat::HwVFAT2::invalidateAllShadows(); };
 
           /**
            * Set the S-bit mask
@@ -847,7 +848,8 @@ namespace gem {
            *  - 3 VCal
            *  - 4 VT1
            * @param uint8_t step is the size of the step between successive points
-           * @param uint8_t chip is the VFAT to run the scan on (if useUltra is true, this will be the mask)
+           * @param uint32_t chip is the VFAT to run the scan on (if useUltra is true, this will be the 24-bit mask
+           *        of the VFATs to leave out of the scan)
            * @param uint8_t channel is the channel to run the scan on (for modes 1 and 3 only)
            * @param uint8_t min is the minimum value of the parameter to scan from
            * @param uint8_t max is the maximum value of the paramter to scan to (must be greater than min)
@@ -856,7 +858,7 @@ namespace gem {
            * @param bool useUltra says whether to use the 24 VFATs in parallel mode (default is true)
            * @param bool reset says whether to reset the module or not (default is false)
            */
-          void configureScanModule(uint8_t const& mode, uint8_t const& chip, uint8_t const& channel,
+          void configureScanModule(uint8_t const& mode, uint32_t const& chip, uint8_t const& channel,
                                    uint8_t const& min,  uint8_t const& max,
                                    uint8_t const& step, uint32_t const& nevts,
                                    bool useUltra=true, bool reset=false);
@@ -900,6 +902,15 @@ namespace gem {
            *          ZZZZZZ is the number of events seen at that point
            */
           std::vector<std::vector<uint32_t> > getUltraScanResults(uint32_t const& npoints);
+
+          /**
+           * @brief Read the results of the ULTRA Scan controller for all VFATs with a single dispatch,
+           *        without checking whether the scan has finished
+           * @param npoints number of points to read for each VFAT
+           * @param buffer destination of 24*npoints words, VFAT0 first, in the format of getUltraScanResults
+           * @returns the number of words read, 0 on failure
+           */
+          uint32_t readUltraScanResults(uint32_t const& npoints, uint32_t* buffer);
           /** @} */ // end of scanmodule
 
 
@@ -214,6 +214,15 @@ namespace gem {
 
           void     createOptoHybridInfoSpaceItems(is_toolbox_ptr is_optohybrid, optohybrid_shared_ptr optohybrid);
 
+          /**
+           * @brief connects the OptoHybrids of one AMC slot and reads their VFAT masks,
+           *        run as a GEMSlotTasks task by initializeAction
+           * @param deviceNames device name of each link, empty if no OptoHybrid is expected
+           * @throws gem::hw::optohybrid::exception::Exception if an OptoHybrid is not responding
+           */
+          void     connectOptoHybrids(unsigned const& slot,
+                                      std::array<std::string, MAX_OPTOHYBRIDS_PER_AMC> const& deviceNames);
+
           mutable gem::utils::Lock m_deviceLock;  // [MAX_OPTOHYBRIDS_PER_AMC*MAX_AMCS_PER_CRATE];
 
           // Matrix<optohybrid_shared_ptr, MAX_OPTOHYBRIDS_PER_AMC, MAX_AMCS_PER_CRATE>
@@ -228,6 +237,7 @@ namespace gem {
 
           xdata::Vector<xdata::Bag<OptoHybridInfo> > m_optohybridInfo;
           xdata::String        m_connectionFile;
+          xdata::UnsignedInteger32 m_maxSlotWorkers;  ///< AMC slots initialized at the same time
 
           std::array<std::array<uint32_t, MAX_OPTOHYBRIDS_PER_AMC>, MAX_AMCS_PER_CRATE>
             m_trackingMask;   ///< VFAT slots to ignore tracking data
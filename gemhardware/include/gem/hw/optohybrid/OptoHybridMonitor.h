@@ -3,7 +3,7 @@
 #ifndef GEM_HW_OPTOHYBRID_OPTOHYBRIDMONITOR_H
 #define GEM_HW_OPTOHYBRID_OPTOHYBRIDMONITOR_H
 
-#include "gem/base/GEMMonitor.h"
+#include "gem/hw/GEMHwMonitor.h"
 #include "gem/hw/optohybrid/exception/Exception.h"
 #include "gem/hw/optohybrid/HwOptoHybrid.h"
 
@@ -14,7 +14,7 @@ namespace gem {
       class HwOptoHybrid;
       class OptoHybridManager;
 
-      class OptoHybridMonitor : public gem::base::GEMMonitor
+      class OptoHybridMonitor : public gem::hw::GEMHwMonitor
       {
       public:
 
@@ -27,7 +27,6 @@ namespace gem {
 
         virtual ~OptoHybridMonitor();
 
-        virtual void updateMonitorables();
         virtual void reset();
         void setupHwMonitoring();
 
@@ -0,0 +1,178 @@
+/** @file OptoHybridUltraScan.h */
+
+#ifndef GEM_HW_OPTOHYBRID_OPTOHYBRIDULTRASCAN_H
+#define GEM_HW_OPTOHYBRID_OPTOHYBRIDULTRASCAN_H
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "gem/hw/optohybrid/HwOptoHybrid.h"
+
+namespace gem {
+  namespace hw {
+    namespace optohybrid {
+
+      /**
+       * @class UltraScanResults
+       * @brief Event counts of an ULTRA scan of one OptoHybrid, stored as a VFAT x channel x scan point cube
+       *
+       * For the per VFAT modes (0, 2, 4) the channel dimension has a single entry.
+       * The counts are kept in a single contiguous block, indexed [vfat][channel][point].
+       */
+      class UltraScanResults
+      {
+      public:
+        UltraScanResults();
+
+        /**
+         * @param mode scan mode, as in HwOptoHybrid::configureScanModule
+         * @param channels channels scanned, one entry per channel dimension, ignored for the per VFAT modes
+         */
+        UltraScanResults(uint8_t const& mode, uint8_t const& min, uint8_t const& max, uint8_t const& step,
+                         uint32_t const& nTriggers, std::vector<uint8_t> const& channels);
+
+        static bool isPerChannel(uint8_t const& mode) { return mode == 1 || mode == 3; };
+
+        uint8_t  mode()      const { return m_mode;      };
+        uint32_t nTriggers() const { return m_nTriggers; };
+        uint32_t nPoints()   const { return m_nPoints;   };
+        size_t   nChannels() const { return m_channels.size(); };
+
+        /**
+         * @returns the channel of an entry of the channel dimension, -1 for the per VFAT modes
+         */
+        int channel(size_t const& channelIdx) const;
+
+        /**
+         * @returns the value of the scanned parameter at a scan point
+         */
+        uint32_t scanValue(uint32_t const& point) const { return m_min + point*m_step; };
+
+        uint32_t count(uint8_t const& vfat, size_t const& channelIdx, uint32_t const& point) const {
+          return m_counts[index(vfat, channelIdx, point)]; };
+
+        /**
+         * @brief Stores the words read from the ULTRA results blocks for one entry of the channel dimension
+         * @param words 24*nPoints() words, VFAT0 first, in the 0xYYZZZZZZ format of HwOptoHybrid::getUltraScanResults,
+         *        each count is placed at the point of its YY scan value, words outside of the scan range are dropped
+         * @returns the number of words dropped
+         */
+        uint32_t fill(size_t const& channelIdx, uint32_t const* words);
+
+        /**
+         * @brief Writes the results as text, one line per VFAT, channel and scan point:
+         *        vfat channel value nevents ntriggers
+         *        the channel is -1 for the per VFAT modes
+         */
+        void write(std::ostream& out, uint32_t const& vfatMask=0x0) const;
+
+      private:
+        size_t index(uint8_t const& vfat, size_t const& channelIdx, uint32_t const& point) const {
+          return (vfat*m_channels.size() + channelIdx)*m_nPoints + point; };
+
+        uint8_t  m_mode;
+        uint32_t m_min;
+        uint32_t m_step;
+        uint32_t m_nPoints;
+        uint32_t m_nTriggers;
+        std::vector<uint8_t>  m_channels;
+        std::vector<uint32_t> m_counts;
+      };  // class UltraScanResults
+
+      /**
+       * @class OptoHybridUltraScan
+       * @brief Runs the firmware ULTRA scan, all 24 VFATs in parallel, on several OptoHybrids at the same time
+       *
+       * Each OptoHybrid is driven from its own task of a GEMSlotTasks pool, as its uHAL connection
+       * is independent of the others.
+       * For the per channel modes the scan is repeated for each requested channel, a ChannelSetup
+       * callback can prepare the VFATs before each channel, e.g., to enable the calibration pulse.
+       * The results of each scan point are read with a single dispatch for all VFATs.
+       */
+      class OptoHybridUltraScan
+      {
+      public:
+        struct ScanConfig {
+          ScanConfig();
+
+          uint8_t  mode;
+          uint8_t  min;
+          uint8_t  max;
+          uint8_t  step;
+          uint32_t nTriggers;
+          std::vector<uint8_t> channels;  ///< channels to scan in the per channel modes
+          uint32_t pollInterval;          ///< time between two reads of the scan status, in milliseconds
+          uint32_t timeout;               ///< maximum duration of the scan of one channel, in seconds
+        };
+
+        /**
+         * @brief called before the scan of each channel in the per channel modes
+         */
+        typedef std::function<void(HwOptoHybrid&, uint8_t const&)> ChannelSetup;
+
+        OptoHybridUltraScan(ScanConfig const& config, log4cplus::Logger const& logger);
+
+        /**
+         * @brief adds an OptoHybrid to the scan
+         * @param name identifies the OptoHybrid in the results and the output files, e.g., "OH-03-00"
+         * @param vfatMask 24-bit mask of the VFATs to leave out of the scan
+         */
+        void addOptoHybrid(std::string const& name, std::shared_ptr<HwOptoHybrid> const& optohybrid,
+                           uint32_t const& vfatMask);
+
+        void setChannelSetup(ChannelSetup const& setup) { m_channelSetup = setup; };
+
+        /**
+         * @brief scans all OptoHybrids and waits for them to finish
+         * @param maxWorkers maximum number of OptoHybrids scanned at the same time
+         * @returns true if all scans succeeded, the errors are available from errors()
+         */
+        bool run(size_t const& maxWorkers);
+
+        /**
+         * @returns one line per failed OptoHybrid, empty if all succeeded
+         */
+        std::string errors() const { return m_errors; };
+
+        /**
+         * @returns the results of an OptoHybrid
+         * @throws gem::hw::optohybrid::exception::ValueError if the OptoHybrid is not part of the scan
+         */
+        UltraScanResults const& getResults(std::string const& name) const;
+
+        /**
+         * @brief writes the results of each OptoHybrid to <directory>/<name>.txt
+         * @throws gem::hw::optohybrid::exception::SoftwareProblem if a file can not be written
+         */
+        void writeResults(std::string const& directory) const;
+
+      private:
+        struct Target {
+          std::shared_ptr<HwOptoHybrid> optohybrid;
+          uint32_t                      vfatMask;
+          UltraScanResults              results;
+        };
+
+        void scan(std::string const& name, Target& target);
+
+        log4cplus::Logger m_gemLogger;
+
+        ScanConfig   m_config;
+        ChannelSetup m_channelSetup;
+        std::map<std::string, Target> m_targets;
+        std::string  m_errors;
+
+        // Prevent copying.
+        OptoHybridUltraScan(OptoHybridUltraScan const&);
+        OptoHybridUltraScan& operator=(OptoHybridUltraScan const&);
+      };  // class OptoHybridUltraScan
+
+    }  // namespace gem::hw::optohybrid
+  }  // namespace gem::hw
+}  // namespace gem
+
+#endif  // GEM_HW_OPTOHYBRID_OPTOHYBRIDULTRASCAN_H
@@ -0,0 +1,84 @@
+/** @file GEMSlotTasks.h */
+
+#ifndef GEM_HW_UTILS_GEMSLOTTASKS_H
+#define GEM_HW_UTILS_GEMSLOTTASKS_H
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace gem {
+  namespace hw {
+    namespace utils {
+
+      /**
+       * @class GEMSlotTasks
+       * @brief Runs independent per-slot operations on a bounded pool of worker threads
+       *
+       * Each task should only access the devices of its own slot, the devices of different
+       * slots have their own uHAL connections and can be driven concurrently.
+       * An exception thrown by a task is caught and stored in its result, so that one
+       * failing slot does not stop the others, the caller raises the aggregated error
+       * from its own thread once run() returns, e.g., in the FSM transition.
+       */
+      class GEMSlotTasks
+      {
+      public:
+        static const size_t DEFAULT_MAX_WORKERS = 4;
+
+        struct Result {
+          std::string name;
+          bool        success;
+          std::string error;
+          double      seconds;  ///< wall clock time taken by the task
+        };
+
+        /**
+         * @param maxWorkers maximum number of tasks running at the same time, the calling thread included
+         */
+        explicit GEMSlotTasks(size_t const& maxWorkers=DEFAULT_MAX_WORKERS);
+
+        /**
+         * @brief queues a task, nothing runs before run() is called
+         * @param name identifies the task in the results, e.g., "AMC03"
+         */
+        void add(std::string const& name, std::function<void()> const& task);
+
+        /**
+         * @brief runs all queued tasks and waits for them to finish
+         * If no worker thread can be started, the tasks run in the calling thread
+         * @returns true if all tasks succeeded
+         */
+        bool run();
+
+        std::vector<Result> const& results() const { return m_results; };
+
+        /**
+         * @returns one line per failed task, empty if all succeeded
+         */
+        std::string errors() const;
+
+        /**
+         * @returns one line per task with its status and duration
+         */
+        std::string summary() const;
+
+      private:
+        void work();
+
+        size_t m_maxWorkers;
+        std::vector<std::function<void()> > m_tasks;
+        std::vector<Result>                 m_results;
+        std::atomic<size_t>                 m_next;
+
+        // Prevent copying.
+        GEMSlotTasks(GEMSlotTasks const&);
+        GEMSlotTasks& operator=(GEMSlotTasks const&);
+      };  // class GEMSlotTasks
+
+    }  // namespace gem::hw::utils
+  }  // namespace gem::hw
+}  // namespace gem
+
+#endif  // GEM_HW_UTILS_GEMSLOTTASKS_H
@@ -3,6 +3,8 @@
 #ifndef GEM_HW_VFAT_HWVFAT2_H
 #define GEM_HW_VFAT_HWVFAT2_H
 
+#include <atomic>
+
 #include "gem/hw/GEMHwDevice.h"
 
 #include "gem/hw/vfat/VFAT2Settings.h"
@@ -43,9 +45,10 @@ namespace gem {
             int Error     ;
             int Invalid   ;
             int RWMismatch;
+            int Readback  ;
 
-          TransactionErrors() : Error(0),Invalid(0),RWMismatch(0) {}
-            void reset()       {Error=0; Invalid=0; RWMismatch=0;return; }
+          TransactionErrors() : Error(0),Invalid(0),RWMismatch(0),Readback(0) {}
+            void reset()       {Error=0; Invalid=0; RWMismatch=0; Readback=0;return; }
           } TransactionErrors;
 
           HwVFAT2(std::string const& vfatDevice, std::string const& connectionFile);
@@ -113,6 +116,24 @@ namespace gem {
            */
           uint8_t  readVFATReg( std::string const& regName);
 
+          /**
+           * @brief  uint8_t  readVFATReg( RegisterHandle const& reg, bool debug)
+           * Reads a register on the VFAT2 chip from its resolved handle,
+           * throws on a transaction error as the named version does
+           * @param reg is the handle of the VFAT2 register to read
+           * @param debug
+           * @returns 8-bit register from the VFAT chip
+           */
+          uint8_t  readVFATReg( RegisterHandle const& reg, bool debug);
+
+          /**
+           * @brief  uint8_t  readVFATReg( RegisterHandle const& reg)
+           * Reads a register on the VFAT2 chip from its resolved handle
+           * @param reg is the handle of the VFAT2 register to read
+           * @returns 8-bit register from the VFAT chip, 0xff on a transaction error
+           */
+          uint8_t  readVFATReg( RegisterHandle const& reg);
+
           /**
            * @brief  readVFATRegs( vfat_reg_pair_list &regList)
            * Reads a list of registers on the VFAT2 chip into the provided key pair
@@ -135,7 +156,18 @@ namespace gem {
            */
           void     writeVFATReg(std::string const& regName,
                                 uint8_t     const& writeVal) {
-            writeReg(getDeviceBaseNode(), regName, static_cast<uint32_t>(writeVal)); }
+            writeReg(getRegisterHandle(getDeviceBaseNode(), regName), static_cast<uint32_t>(writeVal));
+            markShadowStale(); }
+
+          /**
+           * @brief  writeVFATReg( RegisterHandle const& reg, uint8_t const& writeVal)
+           * Writes a value to a register on the VFAT2 chip from its resolved handle
+           * @param reg is the handle of the VFAT2 register to write to
+           * @param writeValue is the value to write into the VFAT register
+           */
+          void     writeVFATReg(RegisterHandle const& reg,
+                                uint8_t        const& writeVal) {
+            writeReg(reg, static_cast<uint32_t>(writeVal)); }
 
           /**
            * @brief  writeVFATReg( vfat_reg_pair_list const& regList)
@@ -148,6 +180,7 @@ namespace gem {
             for (auto curReg = regList.begin(); curReg != regList.end(); ++curReg)
               fullRegList.push_back(std::make_pair(getDeviceBaseNode()+"."+curReg->first,static_cast<uint32_t>(curReg->second)));
             writeRegs(fullRegList);
+            markShadowStale();
           }
 
           /**
@@ -160,7 +193,84 @@ namespace gem {
             std::vector<std::string > fullRegList;
             for (auto curReg = regList.begin(); curReg != regList.end(); ++curReg)
               fullRegList.push_back(getDeviceBaseNode()+"."+*curReg);
-            writeValueToRegs(regList,static_cast<uint32_t>(regValue)); }
+            writeValueToRegs(regList,static_cast<uint32_t>(regValue));
+            markShadowStale(); }
+
+          /**
+           * Shadow register file
+           * The writable registers (control, biases and the 128 channel registers) are shadowed in
+           * m_vfatParams.shadow.
+           * The setters and channel functions only write the registers whose value changes, and
+           * read the chip only for registers not yet known.
+           * Writes that bypass this object in the same process, the OptoHybrid broadcast writes and
+           * the VFAT reset, call invalidateAllShadows. After a write from anywhere else, e.g.,
+           * another application, the caller has to invalidateShadow.
+           */
+
+          /**
+           * @brief  readShadowReg( unsigned const& reg)
+           * @param reg is the register, a VFAT2ShadowRegs value, CHANREG1+channel-1 for a channel register
+           * @returns the value of the register, the shadowed one if known, otherwise read from
+           *          the chip,
+           *          throws on a transaction error as readVFATReg(reg, true)
+           */
+          uint8_t  readShadowReg(unsigned const& reg);
+
+          /**
+           * @brief  writeShadowReg( unsigned const& reg, uint8_t const& value)
+           * Writes a register through the shadow, nothing is sent if the value is already known,
+           * in deferred mode the value is only staged until flushShadowRegisters
+           * @param reg is the register, a VFAT2ShadowRegs value, CHANREG1+channel-1 for a channel register
+           * @param value is the value to write into the register
+           */
+          void     writeShadowReg(unsigned const& reg, uint8_t const& value);
+
+          /**
+           * @brief  readShadowRegisters( unsigned const& first, unsigned const& last)
+           * Reads the registers in [first,last) from the chip into the shadow with a single transaction,
+           * registers with a staged value are not overwritten
+           * @returns the number of registers read successfully
+           */
+          unsigned readShadowRegisters(unsigned const& first=0,
+                                       unsigned const& last=VFAT2ShadowRegs::N_SHADOW_REGS);
+
+          /**
+           * @brief  flushShadowRegisters()
+           * Writes all staged registers with a single transaction, read back if verification is on
+           * @returns the number of registers written
+           */
+          unsigned flushShadowRegisters();
+
+          /**
+           * @brief  invalidateShadow()
+           * Forgets the shadowed values, including any staged and not yet flushed,
+           * the next access to each register goes to the chip
+           */
+          void     invalidateShadow();
+          void     invalidateShadow(unsigned const& reg);
+
+          /**
+           * @brief  invalidateAllShadows()
+           * Marks the shadows of all VFAT2 objects of the process as stale, the next access to each
+           * register goes to the chip. Staged values are kept and still written by the flush
+           */
+          static void invalidateAllShadows() { ++s_shadowEpoch; }
+
+          /**
+           * @brief  setShadowDeferred( bool deferred)
+           * @param deferred if true, writeShadowReg stages the values for flushShadowRegisters,
+           *        switching it off flushes the staged values
+           */
+          void     setShadowDeferred(bool deferred);
+
+          /**
+           * @brief  setShadowVerify( bool verify)
+           * @param verify if true, each register written through the shadow is read back from the chip,
+           *        a mismatch is counted and the register is invalidated
+           */
+          void     setShadowVerify(bool verify) { m_shadowVerify = verify; }
+
+          unsigned shadowDirtyCount() const { return m_vfatParams.shadow.nDirty(); }
 
           //control functions
           //void reset();
@@ -196,14 +306,12 @@ namespace gem {
           void setAllSettings(const gem::hw::vfat::VFAT2ControlParams &params);
 
           //Control register settings
-          /// might be good to overload them to act on local variables
-          /// and do a single IPBus transaction...
+          /// the single setting versions modify the shadow copy of the register and write it
+          /// if it changed, the versions taking settings act on a local variable
 
           void setRunMode(VFAT2RunMode mode) {
-            uint8_t settings = readVFATReg("ContReg0");
-            writeVFATReg("ContReg0",
-                         (settings&~VFAT2ContRegBitMasks::RUNMODE)|
-                         (mode<<VFAT2ContRegBitShifts::RUNMODE)); }
+            writeShadowBits(VFAT2ShadowRegs::CONTREG0, VFAT2ContRegBitMasks::RUNMODE,
+                            (mode<<VFAT2ContRegBitShifts::RUNMODE)); }
 
           void setRunMode(VFAT2RunMode mode, uint8_t& settings) {
             settings = (settings&~VFAT2ContRegBitMasks::RUNMODE)|
@@ -215,10 +323,8 @@ namespace gem {
             setRunMode(static_cast<VFAT2RunMode>(mode), settings); }
 
           void setTriggerMode(VFAT2TrigMode mode) {
-            uint8_t settings = readVFATReg("ContReg0");
-            writeVFATReg("ContReg0",
-                         (settings&~VFAT2ContRegBitMasks::TRIGMODE)|
-                         (mode<<VFAT2ContRegBitShifts::TRIGMODE)); }
+            writeShadowBits(VFAT2ShadowRegs::CONTREG0, VFAT2ContRegBitMasks::TRIGMODE,
+                            (mode<<VFAT2ContRegBitShifts::TRIGMODE)); }
 
           void setTriggerMode(VFAT2TrigMode mode, uint8_t& settings) {
             settings = (settings&~VFAT2ContRegBitMasks::TRIGMODE)|
@@ -230,10 +336,8 @@ namespace gem {
             setTriggerMode(static_cast<VFAT2TrigMode>(mode), settings); }
 
           void setCalibrationMode(VFAT2CalibMode mode) {
-            uint8_t settings = readVFATReg("ContReg0");
-            writeVFATReg("ContReg0",
-                         (settings&~VFAT2ContRegBitMasks::CALMODE)|
-                         (mode<<VFAT2ContRegBitShifts::CALMODE)); }
+            writeShadowBits(VFAT2ShadowRegs::CONTREG0, VFAT2ContRegBitMasks::CALMODE,
+                            (mode<<VFAT2ContRegBitShifts::CALMODE)); }
 
           void setCalibrationMode(VFAT2CalibMode mode, uint8_t& settings) {
             settings = (settings&~VFAT2ContRegBitMasks::CALMODE)|
@@ -245,10 +349,8 @@ namespace gem {
             setCalibrationMode(static_cast<VFAT2CalibMode>(mode), settings); }
 
           void setMSPolarity(VFAT2MSPol polarity) {
-            uint8_t settings = readVFATReg("ContReg0");
-            writeVFATReg("ContReg0",
-                         (settings&~VFAT2ContRegBitMasks::MSPOL)|
-                         (polarity<<VFAT2ContRegBitShifts::MSPOL)); }
+            writeShadowBits(VFAT2ShadowRegs::CONTREG0, VFAT2ContRegBitMasks::MSPOL,
+                            (polarity<<VFAT2ContRegBitShifts::MSPOL)); }
 
           void setMSPolarity(VFAT2MSPol polarity, uint8_t& settings) {
             settings = (settings&~VFAT2ContRegBitMasks::MSPOL)|
@@ -260,10 +362,8 @@ namespace gem {
             setMSPolarity(static_cast<VFAT2MSPol>(mode), settings); }
 
           void setCalPolarity(VFAT2CalPol polarity) {
-            uint8_t settings = readVFATReg("ContReg0");
-            writeVFATReg("ContReg0",
-                         (settings&~VFAT2ContRegBitMasks::CALPOL)|
-                         (polarity<<VFAT2ContRegBitShifts::CALPOL)); }
+            writeShadowBits(VFAT2ShadowRegs::CONTREG0, VFAT2ContRegBitMasks::CALPOL,
+                            (polarity<<VFAT2ContRegBitShifts::CALPOL)); }
 
           void setCalPolarity(VFAT2CalPol polarity, uint8_t& settings) {
             settings = (settings&~VFAT2ContRegBitMasks::CALPOL)|
@@ -275,10 +375,8 @@ namespace gem {
             setCalPolarity(static_cast<VFAT2CalPol>(mode), settings); }
 
           void setProbeMode(VFAT2ProbeMode mode) {
-            uint8_t settings = readVFATReg("ContReg1");
-            writeVFATReg("ContReg1",
-                         (settings&~VFAT2ContRegBitMasks::PROBEMODE)|
-                         (mode<<VFAT2ContRegBitShifts::PROBEMODE)); }
+            writeShadowBits(VFAT2ShadowRegs::CONTREG1, VFAT2ContRegBitMasks::PROBEMODE,
+                            (mode<<VFAT2ContRegBitShifts::PROBEMODE)); }
 
           void setProbeMode(VFAT2ProbeMode mode, uint8_t& settings) {
             settings = (settings&~VFAT2ContRegBitMasks::PROBEMODE)|
@@ -290,10 +388,8 @@ namespace gem {
             setProbeMode(static_cast<VFAT2ProbeMode>(mode), settings); }
 
           void setLVDSMode(VFAT2LVDSMode mode) {
-            uint8_t settings = readVFATReg("ContReg1");
-            writeVFATReg("ContReg1",
-                         (settings&~VFAT2ContRegBitMasks::LVDSMODE)|
-                         (mode<<VFAT2ContRegBitShifts::LVDSMODE)); }
+            writeShadowBits(VFAT2ShadowRegs::CONTREG1, VFAT2ContRegBitMasks::LVDSMODE,
+                            (mode<<VFAT2ContRegBitShifts::LVDSMODE)); }
 
           void setLVDSMode(VFAT2LVDSMode mode, uint8_t& settings) {
             settings = (settings&~VFAT2ContRegBitMasks::LVDSMODE)|
@@ -305,10 +401,8 @@ namespace gem {
             setLVDSMode(static_cast<VFAT2LVDSMode>(mode), settings); }
 
           void setDACMode(VFAT2DACMode mode) {
-            uint8_t settings = readVFATReg("ContReg1");
-            writeVFATReg("ContReg1",
-                         (settings&~VFAT2ContRegBitMasks::DACMODE)|
-                         (mode<<VFAT2ContRegBitShifts::DACMODE)); }
+            writeShadowBits(VFAT2ShadowRegs::CONTREG1, VFAT2ContRegBitMasks::DACMODE,
+                            (mode<<VFAT2ContRegBitShifts::DACMODE)); }
 
           void setDACMode(VFAT2DACMode mode, uint8_t& settings) {
             settings = (settings&~VFAT2ContRegBitMasks::DACMODE)|
@@ -320,10 +414,8 @@ namespace gem {
             setDACMode(static_cast<VFAT2DACMode>(mode), settings); }
 
           void setHitCountCycleTime(VFAT2ReHitCT cycleTime) {
-            uint8_t settings = readVFATReg("ContReg1");
-            writeVFATReg("ContReg1",
-                         (settings&~VFAT2ContRegBitMasks::REHITCT)|
-                         (cycleTime<<VFAT2ContRegBitShifts::REHITCT)); }
+            writeShadowBits(VFAT2ShadowRegs::CONTREG1, VFAT2ContRegBitMasks::REHITCT,
+                            (cycleTime<<VFAT2ContRegBitShifts::REHITCT)); }
 
           void setHitCountCycleTime(VFAT2ReHitCT cycleTime, uint8_t& settings) {
             settings = (settings&~VFAT2ContRegBitMasks::REHITCT)|
@@ -335,10 +427,8 @@ namespace gem {
             setHitCountCycleTime(static_cast<VFAT2ReHitCT>(mode), settings); }
 
           void setHitCountMode(VFAT2HitCountMode mode) {
-            uint8_t settings = readVFATReg("ContReg2");
-            writeVFATReg("ContReg2",
-                         (settings&~VFAT2ContRegBitMasks::HITCOUNTMODE)|
-                         (mode<<VFAT2ContRegBitShifts::HITCOUNTMODE)); }
+            writeShadowBits(VFAT2ShadowRegs::CONTREG2, VFAT2ContRegBitMasks::HITCOUNTMODE,
+                            (mode<<VFAT2ContRegBitShifts::HITCOUNTMODE)); }
 
           void setHitCountMode(VFAT2HitCountMode mode, uint8_t& settings) {
             settings = (settings&~VFAT2ContRegBitMasks::HITCOUNTMODE)|
@@ -350,10 +440,8 @@ namespace gem {
             setHitCountMode(static_cast<VFAT2HitCountMode>(mode), settings); }
 
           void setMSPulseLength(VFAT2MSPulseLength length) {
-            uint8_t settings = readVFATReg("ContReg2");
-            writeVFATReg("ContReg2",
-                         (settings&~VFAT2ContRegBitMasks::MSPULSELENGTH)|
-                         (length<<VFAT2ContRegBitShifts::MSPULSELENGTH)); }
+            writeShadowBits(VFAT2ShadowRegs::CONTREG2, VFAT2ContRegBitMasks::MSPULSELENGTH,
+                            (length<<VFAT2ContRegBitShifts::MSPULSELENGTH)); }
 
           void setMSPulseLength(VFAT2MSPulseLength length, uint8_t& settings) {
             settings = (settings&~VFAT2ContRegBitMasks::MSPULSELENGTH)|
@@ -365,10 +453,8 @@ namespace gem {
             setMSPulseLength(static_cast<VFAT2MSPulseLength>(mode), settings); }
 
           void setInputPadMode(VFAT2DigInSel mode) {
-            uint8_t settings = readVFATReg("ContReg2");
-            writeVFATReg("ContReg2",
-                         (settings&~VFAT2ContRegBitMasks::DIGINSEL)|
-                         (mode<<VFAT2ContRegBitShifts::DIGINSEL)); }
+            writeShadowBits(VFAT2ShadowRegs::CONTREG2, VFAT2ContRegBitMasks::DIGINSEL,
+                            (mode<<VFAT2ContRegBitShifts::DIGINSEL)); }
 
           void setInputPadMode(VFAT2DigInSel mode, uint8_t& settings) {
             settings = (settings&~VFAT2ContRegBitMasks::DIGINSEL)|
@@ -380,10 +466,8 @@ namespace gem {
             setInputPadMode(static_cast<VFAT2DigInSel>(mode), settings); }
 
           void setTrimDACRange(VFAT2TrimDACRange range) {
-            uint8_t settings = readVFATReg("ContReg3");
-            writeVFATReg("ContReg3",
-                         (settings&~VFAT2ContRegBitMasks::TRIMDACRANGE)|
-                         (range<<VFAT2ContRegBitShifts::TRIMDACRANGE)); }
+            writeShadowBits(VFAT2ShadowRegs::CONTREG3, VFAT2ContRegBitMasks::TRIMDACRANGE,
+                            (range<<VFAT2ContRegBitShifts::TRIMDACRANGE)); }
 
           void setTrimDACRange(VFAT2TrimDACRange range, uint8_t& settings) {
             settings = (settings&~VFAT2ContRegBitMasks::TRIMDACRANGE)|
@@ -395,10 +479,8 @@ namespace gem {
             setTrimDACRange(static_cast<VFAT2TrimDACRange>(mode), settings); }
 
           void setBandgapPad(VFAT2PadBandgap mode) {
-            uint8_t settings = readVFATReg("ContReg3");
-            writeVFATReg("ContReg3",
-                         (settings&~VFAT2ContRegBitMasks::PADBANDGAP)|
-                         (mode<<VFAT2ContRegBitShifts::PADBANDGAP)); }
+            writeShadowBits(VFAT2ShadowRegs::CONTREG3, VFAT2ContRegBitMasks::PADBANDGAP,
+                            (mode<<VFAT2ContRegBitShifts::PADBANDGAP)); }
 
           void setBandgapPad(VFAT2PadBandgap mode, uint8_t& settings) {
             settings = (settings&~VFAT2ContRegBitMasks::PADBANDGAP)|
@@ -410,10 +492,8 @@ namespace gem {
             setBandgapPad(static_cast<VFAT2PadBandgap>(mode), settings); }
 
           void sendTestPattern(VFAT2DFTestPattern send) {
-            uint8_t settings = readVFATReg("ContReg3");
-            writeVFATReg("ContReg3",
-                         (settings&~VFAT2ContRegBitMasks::DFTESTMODE)|
-                         (send<<VFAT2ContRegBitShifts::DFTESTMODE)); }
+            writeShadowBits(VFAT2ShadowRegs::CONTREG3, VFAT2ContRegBitMasks::DFTESTMODE,
+                            (send<<VFAT2ContRegBitShifts::DFTESTMODE)); }
 
           void sendTestPattern(VFAT2DFTestPattern send, uint8_t& settings) {
             settings = (settings&~VFAT2ContRegBitMasks::DFTESTMODE)|
@@ -425,19 +505,19 @@ namespace gem {
             sendTestPattern(static_cast<VFAT2DFTestPattern>(mode), settings); }
 
           //////////////////////////////
-          void setLatency(uint8_t latency) {writeVFATReg("Latency",latency); }
+          void setLatency(uint8_t latency) {writeShadowReg(VFAT2ShadowRegs::LATENCY,latency); }
 
-          void setIPreampIn(  uint8_t value) { writeVFATReg("IPreampIn",  value); }
-          void setIPreampFeed(uint8_t value) { writeVFATReg("IPreampFeed",value); }
-          void setIPreampOut( uint8_t value) { writeVFATReg("IPreampOut", value); }
-          void setIShaper(    uint8_t value) { writeVFATReg("IShaper",    value); }
-          void setIShaperFeed(uint8_t value) { writeVFATReg("IShaperFeed",value); }
-          void setIComp(      uint8_t value) { writeVFATReg("IComp",      value); }
+          void setIPreampIn(  uint8_t value) { writeShadowReg(VFAT2ShadowRegs::IPREAMPIN,  value); }
+          void setIPreampFeed(uint8_t value) { writeShadowReg(VFAT2ShadowRegs::IPREAMPFEED,value); }
+          void setIPreampOut( uint8_t value) { writeShadowReg(VFAT2ShadowRegs::IPREAMPOUT, value); }
+          void setIShaper(    uint8_t value) { writeShadowReg(VFAT2ShadowRegs::ISHAPER,    value); }
+          void setIShaperFeed(uint8_t value) { writeShadowReg(VFAT2ShadowRegs::ISHAPERFEED,value); }
+          void setIComp(      uint8_t value) { writeShadowReg(VFAT2ShadowRegs::ICOMP,      value); }
 
-          void setVCal(       uint8_t value  ) { writeVFATReg("VCal",        value); }
-          void setVThreshold1(uint8_t value  ) { writeVFATReg("VThreshold1", value); }
-          void setVThreshold2(uint8_t value=0) { writeVFATReg("VThreshold2", value); }
-          void setCalPhase(   uint8_t value  ) { writeVFATReg("CalPhase",    value); }
+          void setVCal(       uint8_t value  ) { writeShadowReg(VFAT2ShadowRegs::VCAL,        value); }
+          void setVThreshold1(uint8_t value  ) { writeShadowReg(VFAT2ShadowRegs::VTHRESHOLD1, value); }
+          void setVThreshold2(uint8_t value=0) { writeShadowReg(VFAT2ShadowRegs::VTHRESHOLD2, value); }
+          void setCalPhase(   uint8_t value  ) { writeShadowReg(VFAT2ShadowRegs::CALPHASE,    value); }
 
           /*** may want to be able to set these values to a human readable number
                lookup done through a LUT
@@ -603,7 +683,7 @@ namespace gem {
            */
           void    maskChannel(uint8_t channel, bool on=true);
           uint8_t getChannelSettings(uint8_t channel) {
-            return readVFATReg(toolbox::toString("VFATChannels.ChanReg%d",(unsigned)channel)); }
+            return readVFATReg(channelRegister(channel)); }
           uint8_t getChannelTrimDAC(uint8_t channel);
           void    setChannelTrimDAC(uint8_t channel, uint8_t trimDAC);
           //void    setChannelTrimDAC(uint8_t channel, double trimDAC);
@@ -620,6 +700,60 @@ namespace gem {
 
         protected:
 
+          /**
+           * @brief returns the handle of a channel register, resolving the channel registers on
+           *        first use, which is the connection check in isHwConnected
+           * @param channel is the channel, 1 to 128
+           */
+          RegisterHandle const& channelRegister(uint8_t const& channel);
+
+          /**
+           * @brief returns the handle of a shadowed register, resolving all of them on first use
+           * @param reg is the register, a VFAT2ShadowRegs value, CHANREG1+channel-1 for a channel register
+           */
+          RegisterHandle const& shadowRegister(unsigned const& reg);
+
+          /**
+           * @brief modifies the bits of mask in a shadowed register, logs and leaves the register
+           *        untouched if its current value cannot be read
+           */
+          void writeShadowBits(unsigned const& reg, uint8_t const& mask, uint8_t const& bits);
+
+          /**
+           * @brief forgets the shadowed values that are not staged, for writes by register name
+           *        that bypass the shadow
+           */
+          void markShadowStale();
+
+          /**
+           * @brief marks the shadow stale if invalidateAllShadows was called since the last access
+           */
+          void syncShadowEpoch();
+
+          /**
+           * @brief checks the transaction status bits of a VFAT register read, throws if one is set
+           * @returns the 8-bit register value
+           */
+          uint8_t checkVFATTransaction(uint32_t const& readVal, std::string const& regName);
+
+          /**
+           * @brief fills the channel settings of m_vfatParams from the value of the channel register
+           */
+          void decodeVFAT2Channel(uint8_t const& channel, uint8_t const& chanSettings);
+
+          std::vector<RegisterHandle const*> m_shadowRegisters; ///< handles of the VFAT2ShadowRegs registers
+
+          /**
+           * @brief drops the shadow register handles along with the cached handles of the device
+           */
+          virtual void clearRegisterHandles();
+
+          bool m_shadowDeferred;  ///< writeShadowReg stages the values until flushShadowRegisters
+          bool m_shadowVerify;    ///< registers written through the shadow are read back
+          unsigned m_shadowEpoch; ///< value of s_shadowEpoch the shadow is valid for
+
+          static std::atomic<unsigned> s_shadowEpoch; ///< bumped by invalidateAllShadows
+
           TransactionErrors m_vfatErrors;
           gem::hw::vfat::VFAT2ControlParams m_vfatParams;
 
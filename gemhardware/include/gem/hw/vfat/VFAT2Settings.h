@@ -7,6 +7,9 @@
 #include "gem/hw/vfat/VFAT2Enums2Strings.h"
 #include "gem/hw/vfat/VFAT2Strings2Enums.h"
 
+#include <sstream>
+#include <string>
+
 #include "xdata/UnsignedShort.h"
 #include "xdata/Vector.h"
 #include "xdata/Bag.h"
@@ -35,6 +38,58 @@ namespace gem {
         return os;
       };
 
+      /**
+       * @struct VFAT2RegisterShadow
+       * @brief Copy of the writable 8-bit registers of a VFAT2, indexed by VFAT2ShadowRegs
+       * @var VFAT2RegisterShadow::value
+       * value is the last value read from or written to the register, or staged for writing
+       * @var VFAT2RegisterShadow::known
+       * known is set if value is the content of the register on the chip (or will be once written)
+       * @var VFAT2RegisterShadow::dirty
+       * dirty is set if value has been staged and not yet written to the chip
+       */
+      typedef struct VFAT2RegisterShadow {
+        uint8_t value[VFAT2ShadowRegs::N_SHADOW_REGS];
+        bool    known[VFAT2ShadowRegs::N_SHADOW_REGS];
+        bool    dirty[VFAT2ShadowRegs::N_SHADOW_REGS];
+
+      VFAT2RegisterShadow() { invalidate(); }
+
+        /**
+         * @brief forgets all values, the next access goes to the chip
+         */
+        void invalidate() {
+          for (unsigned reg = 0; reg < VFAT2ShadowRegs::N_SHADOW_REGS; ++reg) {
+            value[reg] = 0x0;
+            known[reg] = false;
+            dirty[reg] = false;
+          }
+        }
+
+        unsigned nDirty() const {
+          unsigned count = 0;
+          for (unsigned reg = 0; reg < VFAT2ShadowRegs::N_SHADOW_REGS; ++reg)
+            count += dirty[reg];
+          return count;
+        }
+
+        /**
+         * @returns the register name in the address table, relative to the VFAT base node
+         */
+        static std::string name(unsigned const& reg) {
+          static const char* names[VFAT2ShadowRegs::CHANREG1] = {
+            "ContReg0", "ContReg1", "ContReg2", "ContReg3",
+            "IPreampIn", "IPreampFeed", "IPreampOut", "IShaper", "IShaperFeed", "IComp",
+            "Latency", "VCal", "VThreshold1", "VThreshold2", "CalPhase"
+          };
+          if (reg < VFAT2ShadowRegs::CHANREG1)
+            return names[reg];
+          std::stringstream chanReg;
+          chanReg << "VFATChannels.ChanReg" << (reg - VFAT2ShadowRegs::CHANREG1 + 1);
+          return chanReg.str();
+        }
+      } VFAT2RegisterShadow;
+
       //class VFAT2Settings;
 
       typedef struct {
@@ -105,6 +160,8 @@ namespace gem {
         gem::hw::vfat::VFAT2ChannelParams channels[128];
         uint8_t activeChannel;
 
+        gem::hw::vfat::VFAT2RegisterShadow shadow;
+
       } VFAT2ControlParams;
 
       inline std::ostream& operator<<(std::ostream& os, const VFAT2ControlParams& controlParams)
@@ -245,6 +245,28 @@ namespace gem {
             SEND = 0x1          //Send the packet
           } DFTestPattern;
         };
+
+        struct ShadowRegisters {
+          enum EShadowRegisters { //Registers kept in the shadow register file, in register file order
+            CONTREG0      = 0,
+            CONTREG1      = 1,
+            CONTREG2      = 2,
+            CONTREG3      = 3,
+            IPREAMPIN     = 4,
+            IPREAMPFEED   = 5,
+            IPREAMPOUT    = 6,
+            ISHAPER       = 7,
+            ISHAPERFEED   = 8,
+            ICOMP         = 9,
+            LATENCY       = 10,
+            VCAL          = 11,
+            VTHRESHOLD1   = 12,
+            VTHRESHOLD2   = 13,
+            CALPHASE      = 14,
+            CHANREG1      = 15,  //ChanReg1 to ChanReg128 follow
+            N_SHADOW_REGS = 143
+          } ShadowRegisters;
+        };
       };  // class VFAT2Settings
     }  // namespace gem::hw::vfat
   }  // namespace gem::hw
@@ -256,6 +278,8 @@ namespace gem {
   typedef gem::hw::vfat::VFAT2Settings::ContRegBitMasks   VFAT2ContRegBitMasks;
   typedef gem::hw::vfat::VFAT2Settings::ContRegBitShifts  VFAT2ContRegBitShifts;
 
+  typedef gem::hw::vfat::VFAT2Settings::ShadowRegisters   VFAT2ShadowRegs;
+
   //typedef the enum for casting and access
   typedef gem::hw::vfat::VFAT2Settings::RunMode::ERunMode                 VFAT2RunMode;
   typedef gem::hw::vfat::VFAT2Settings::TriggerMode::ETriggerMode         VFAT2TrigMode;
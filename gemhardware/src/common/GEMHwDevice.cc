@@ -3,16 +3,50 @@
  */
 
 #include "gem/hw/GEMHwDevice.h"
+#include "gem/hw/GEMHwTransaction.h"
+
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
 
 #include "toolbox/net/URN.h"
 
 // #include "gem/base/utils/GEMInfoSpaceToolBox.h"
 
+namespace {
+  // depth of each device lock held by this thread, only the outermost acquisition of a lock can wait,
+  // waiting for one device while holding the lock of another is still recorded
+  thread_local std::unordered_map<gem::utils::Lock const*, unsigned> lockDepths;
+}
+
+gem::hw::GEMHwDevice::TimedLockGuard::TimedLockGuard(GEMHwDevice const& device) :
+  m_lock(device.m_hwLock)
+{
+  if (lockDepths[&m_lock]++) {
+    m_lock.lock();
+    return;
+  }
+  std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+  m_lock.lock();
+  device.m_stats.recordLockWait(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                  std::chrono::steady_clock::now() - start).count());
+}
+
+gem::hw::GEMHwDevice::TimedLockGuard::~TimedLockGuard()
+{
+  m_lock.unlock();
+  // dropped once released, the map only holds the locks currently held
+  auto depth = lockDepths.find(&m_lock);
+  if (--depth->second == 0)
+    lockDepths.erase(depth);
+}
+
 gem::hw::GEMHwDevice::GEMHwDevice(std::string const& deviceName,
                                   std::string const& connectionFile) :
   b_is_connected(false),
   m_gemLogger(log4cplus::Logger::getInstance(deviceName)),
-  m_hwLock(toolbox::BSem::FULL, true)
+  m_hwLock(toolbox::BSem::FULL, true),
+  p_transaction(NULL)
 {
   DEBUG("GEMHwDevice(std::string, std::string) ctor");
   setLogLevelTo(uhal::Error());
@@ -42,7 +76,8 @@ gem::hw::GEMHwDevice::GEMHwDevice(std::string const& deviceName,
                                   std::string const& addressTable) :
   b_is_connected(false),
   m_gemLogger(log4cplus::Logger::getInstance(deviceName)),
-  m_hwLock(toolbox::BSem::FULL, true)
+  m_hwLock(toolbox::BSem::FULL, true),
+  p_transaction(NULL)
 {
   DEBUG("GEMHwDevice(std::string, std::string, std::string) ctor");
   setLogLevelTo(uhal::Error());
@@ -74,7 +109,8 @@ gem::hw::GEMHwDevice::GEMHwDevice(std::string const& deviceName,
                                   uhal::HwInterface& uhalDevice) :
   b_is_connected(false),
   m_gemLogger(log4cplus::Logger::getInstance(deviceName)),
-  m_hwLock(toolbox::BSem::FULL, true)
+  m_hwLock(toolbox::BSem::FULL, true),
+  p_transaction(NULL)
 {
   DEBUG("GEMHwDevice(std::string, uhal::HwInterface) ctor");
   setLogLevelTo(uhal::Error());
@@ -231,9 +267,16 @@ void gem::hw::GEMHwDevice::setup(std::string const& deviceName)
   m_ipBusErrs.Timeout       = 0;
   m_ipBusErrs.ControlHubErr = 0;
 
+  clearRegisterHandles();
   setLogLevelTo(uhal::Error());
 }
 
+void gem::hw::GEMHwDevice::clearRegisterHandles()
+{
+  TimedLockGuard guardedLock(*this);
+  m_registerHandles.clear();
+}
+
 uhal::HwInterface& gem::hw::GEMHwDevice::getGEMHwInterface() const
 {
   if (p_gemHW == NULL) {
@@ -247,39 +290,75 @@ uhal::HwInterface& gem::hw::GEMHwDevice::getGEMHwInterface() const
   //have to fix the return value for failed access, better to return a pointer?
 }
 
-uint32_t gem::hw::GEMHwDevice::readReg(std::string const& name)
+gem::hw::GEMHwDevice::RegisterHandle const& gem::hw::GEMHwDevice::getRegisterHandle(std::string const& name)
+{
+  TimedLockGuard guardedLock(*this);
+  auto cached = m_registerHandles.find(name);
+  if (cached != m_registerHandles.end())
+    return cached->second;
+
+  // throws if not connected, nothing is cached before the address table is available
+  uhal::HwInterface& hw = getGEMHwInterface();
+
+  RegisterHandle handle;
+  handle.name = name;
+  try {
+    uhal::Node const& node = hw.getNode(name);
+    handle.address    = node.getAddress();
+    handle.mask       = node.getMask();
+    handle.size       = node.getSize();
+    handle.permission = node.getPermission();
+    handle.mode       = node.getMode();
+    handle.valid      = true;
+    DEBUG("GEMHwDevice::getRegisterHandle " << name << std::endl
+          << "Path  "      << node.getPath() << std::endl
+          << "Address 0x"  << std::hex << handle.address << std::dec << std::endl
+          << "Mask 0x"     << std::hex << handle.mask    << std::dec << std::endl
+          << "Permission " << handle.permission << std::endl
+          << "Mode "       << handle.mode << std::endl
+          << "Size "       << handle.size << std::endl
+          << std::endl);
+  } catch (uhal::exception::exception const& err) {
+    // cached as invalid, the lookup is not repeated on every access
+    std::string msg = toolbox::toString("Could not resolve register '%s' (uHAL): %s.", name.c_str(), err.what());
+    ERROR("GEMHwDevice::" << msg);
+  }
+  return m_registerHandles.emplace(name, handle).first->second;
+}
+
+uint32_t gem::hw::GEMHwDevice::readReg(RegisterHandle const& reg)
 {
-  gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_hwLock);
+  TimedLockGuard guardedLock(*this);
+  flushTransaction();
   uhal::HwInterface& hw = getGEMHwInterface();
 
   unsigned retryCount = 0;
   uint32_t res = 0x0;
-  DEBUG("GEMHwDevice::gem::hw::GEMHwDevice::readReg "  << name << std::endl
-        << "Path  "      << hw.getNode(name).getPath() << std::endl
-        << "Address 0x"  << std::hex << hw.getNode(name).getAddress() << std::dec << std::endl
-        << "Mask 0x"     << std::hex << hw.getNode(name).getMask()    << std::dec << std::endl
-        << "Permission " << hw.getNode(name).getPermission() << std::endl
-        << "Mode "       << hw.getNode(name).getMode() << std::endl
-        << "Size "       << hw.getNode(name).getSize() << std::endl
-        << std::endl);
+  if (!reg.valid) {
+    ERROR("GEMHwDevice::Unable to read unresolved register " << reg.name);
+    return res;
+  }
+
+  TRACE("GEMHwDevice::gem::hw::GEMHwDevice::readReg " << reg.name << " (0x" << std::setfill('0') << std::setw(8)
+        << std::hex << reg.address << std::dec << ")" << std::endl);
   while (retryCount < MAX_IPBUS_RETRIES) {
     ++retryCount;
     try {
-      uhal::ValWord<uint32_t> val = hw.getNode(name).read();
-      hw.dispatch();
+      uhal::ValWord<uint32_t> val = hw.getClient().read(reg.address,reg.mask);
+      dispatch(hw);
       res = val.value();
-      TRACE("GEMHwDevice::Successfully read register " << name.c_str() << " with value 0x"
+      TRACE("GEMHwDevice::Successfully read register " << reg.name.c_str() << " with value 0x"
             << std::setfill('0') << std::setw(8) << std::hex << res << std::dec
             << " retry count is " << retryCount << ". Should move on to next operation");
       return res;
     } catch (uhal::exception::exception const& err) {
-      std::string msgBase = toolbox::toString("Could not read register '%s' (uHAL)", name.c_str());
+      std::string msgBase = toolbox::toString("Could not read register '%s' (uHAL)", reg.name.c_str());
       std::string msg     = toolbox::toString("%s: %s.", msgBase.c_str(), err.what());
       std::string errCode = toolbox::toString("%s",err.what());
       if (knownErrorCode(errCode)) {
         ++retryCount;
         if (retryCount > (MAX_IPBUS_RETRIES-1))
-          DEBUG("GEMHwDevice::Failed to read register " << name <<
+          DEBUG("GEMHwDevice::Failed to read register " << reg.name <<
                 ". retryCount("<<retryCount<<")"
                 << std::endl);
         updateErrorCounters(errCode);
@@ -289,21 +368,29 @@ uint32_t gem::hw::GEMHwDevice::readReg(std::string const& name)
         // XCEPT_RAISE(gem::hw::exception::HardwareProblem, toolbox::toString("%s.", msgBase.c_str()));
       }
     } catch (std::exception const& err) {
-      std::string msgBase = toolbox::toString("Could not read register '%s' (std)", name.c_str());
+      std::string msgBase = toolbox::toString("Could not read register '%s' (std)", reg.name.c_str());
       std::string msg     = toolbox::toString("%s: %s.", msgBase.c_str(), err.what());
       ERROR("GEMHwDevice::" << msg);
       // XCEPT_RAISE(gem::hw::exception::HardwareProblem, msg);
     }
   }
-  std::string msg = toolbox::toString("Maximum number of retries reached, unable to read register %s",name.c_str());
+  m_stats.recordFailure();
+  std::string msg = toolbox::toString("Maximum number of retries reached, unable to read register %s",reg.name.c_str());
   ERROR("GEMHwDevice::" << msg);
   // XCEPT_RAISE(gem::hw::exception::HardwareProblem, msg);
   return res;
 }
 
+uint32_t gem::hw::GEMHwDevice::readReg(std::string const& name)
+{
+  TimedLockGuard guardedLock(*this);
+  return readReg(getRegisterHandle(name));
+}
+
 uint32_t gem::hw::GEMHwDevice::readReg(uint32_t const& address)
 {
-  gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_hwLock);
+  TimedLockGuard guardedLock(*this);
+  flushTransaction();
   uhal::HwInterface& hw = getGEMHwInterface();
 
   unsigned retryCount = 0;
@@ -314,7 +401,7 @@ uint32_t gem::hw::GEMHwDevice::readReg(uint32_t const& address)
     ++retryCount;
     try {
       uhal::ValWord<uint32_t> val = hw.getClient().read(address);
-      hw.dispatch();
+      dispatch(hw);
       res = val.value();
       TRACE("GEMHwDevice::Successfully read register 0x" << std::setfill('0') << std::setw(8)
             << std::hex << address << std::dec << " with value 0x"
@@ -345,6 +432,7 @@ uint32_t gem::hw::GEMHwDevice::readReg(uint32_t const& address)
       // XCEPT_RAISE(gem::hw::exception::HardwareProblem, msg);
     }
   }
+  m_stats.recordFailure();
   std::string msg = toolbox::toString("Maximum number of retries reached, unable to read register 0x%08x",
                                       address);
   ERROR("GEMHwDevice::" << msg);
@@ -354,7 +442,8 @@ uint32_t gem::hw::GEMHwDevice::readReg(uint32_t const& address)
 
 uint32_t gem::hw::GEMHwDevice::readReg(uint32_t const& address, uint32_t const& mask)
 {
-  gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_hwLock);
+  TimedLockGuard guardedLock(*this);
+  flushTransaction();
   uhal::HwInterface& hw = getGEMHwInterface();
 
   unsigned retryCount = 0;
@@ -365,7 +454,7 @@ uint32_t gem::hw::GEMHwDevice::readReg(uint32_t const& address, uint32_t const&
     ++retryCount;
     try {
       uhal::ValWord<uint32_t> val = hw.getClient().read(address,mask);
-      hw.dispatch();
+      dispatch(hw);
       res = val.value();
       TRACE("GEMHwDevice::Successfully read register 0x" << std::setfill('0') << std::setw(8)
             << std::hex << address << std::dec << " with mask "
@@ -398,6 +487,7 @@ uint32_t gem::hw::GEMHwDevice::readReg(uint32_t const& address, uint32_t const&
       // XCEPT_RAISE(gem::hw::exception::HardwareProblem, msg);
     }
   }
+  m_stats.recordFailure();
   std::string msg = toolbox::toString("Maximum number of retries reached, unable to read register 0x%08x",
                                       address);
   ERROR("GEMHwDevice::" << msg);
@@ -407,14 +497,13 @@ uint32_t gem::hw::GEMHwDevice::readReg(uint32_t const& address, uint32_t const&
 
 uint32_t gem::hw::GEMHwDevice::readMaskedAddress(std::string const& name)
 {
-  uint32_t address = getGEMHwInterface().getNode(name).getAddress();
-  uint32_t mask    = getGEMHwInterface().getNode(name).getMask();
-  return readReg(address,mask);
+  return readReg(getRegisterHandle(name));
 }
 
 void gem::hw::GEMHwDevice::readRegs(register_pair_list &regList, int const& freq)
 {
-  gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_hwLock);
+  TimedLockGuard guardedLock(*this);
+  flushTransaction();
   uhal::HwInterface& hw = getGEMHwInterface();
 
   unsigned retryCount = 0;
@@ -428,12 +517,12 @@ void gem::hw::GEMHwDevice::readRegs(register_pair_list &regList, int const& freq
         vals.push_back(std::make_pair(curReg->first,hw.getNode(curReg->first).read()));
         ++counter;
         if (freq > 0 && counter%freq == 0) {
-          hw.dispatch();
+          dispatch(hw);
           ++dispatchcounter;
         }
       }
       if (freq < 0 || counter%freq != 0) {
-        hw.dispatch();
+        dispatch(hw);
           ++dispatchcounter;
       }
 
@@ -467,6 +556,7 @@ void gem::hw::GEMHwDevice::readRegs(register_pair_list &regList, int const& freq
       // XCEPT_RAISE(gem::hw::exception::HardwareProblem, msg);
     }
   }
+  m_stats.recordFailure();
   std::string msg = toolbox::toString("Maximum number of retries reached, unable to read registers");
   ERROR("GEMHwDevice::" << msg);
   // XCEPT_RAISE(gem::hw::exception::HardwareProblem, msg);
@@ -474,7 +564,8 @@ void gem::hw::GEMHwDevice::readRegs(register_pair_list &regList, int const& freq
 
 void gem::hw::GEMHwDevice::readRegs(addressed_register_pair_list &regList, int const& freq)
 {
-  gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_hwLock);
+  TimedLockGuard guardedLock(*this);
+  flushTransaction();
   uhal::HwInterface& hw = getGEMHwInterface();
 
   unsigned retryCount = 0;
@@ -488,12 +579,12 @@ void gem::hw::GEMHwDevice::readRegs(addressed_register_pair_list &regList, int c
         vals.push_back(std::make_pair(curReg->first,hw.getClient().read(curReg->first)));
         ++counter;
         if (freq > 0 && counter%freq == 0) {
-          hw.dispatch();
+          dispatch(hw);
           ++dispatchcounter;
         }
       }
       if (freq < 0 || counter%freq != 0) {
-        hw.dispatch();
+        dispatch(hw);
           ++dispatchcounter;
       }
 
@@ -527,14 +618,16 @@ void gem::hw::GEMHwDevice::readRegs(addressed_register_pair_list &regList, int c
       // XCEPT_RAISE(gem::hw::exception::HardwareProblem, msg);
     }
   }
+  m_stats.recordFailure();
   std::string msg = toolbox::toString("Maximum number of retries reached, unable to read registers");
   ERROR("GEMHwDevice::" << msg);
   // XCEPT_RAISE(gem::hw::exception::HardwareProblem, msg);
 }
 
-void gem::hw::GEMHwDevice::readRegs(masked_register_pair_list &regList, int const& freq)
+bool gem::hw::GEMHwDevice::readRegs(masked_register_pair_list &regList, int const& freq)
 {
-  gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_hwLock);
+  TimedLockGuard guardedLock(*this);
+  flushTransaction();
   uhal::HwInterface& hw = getGEMHwInterface();
 
   unsigned retryCount = 0;
@@ -546,15 +639,15 @@ void gem::hw::GEMHwDevice::readRegs(masked_register_pair_list &regList, int cons
       int counter{0}, dispatchcounter{0};
       for (auto curReg = regList.begin(); curReg != regList.end(); ++curReg) {
         vals.push_back(std::make_pair(std::make_pair(curReg->first.first,curReg->first.second),
-                                      hw.getClient().read(curReg->first.first,curReg->second)));
+                                      hw.getClient().read(curReg->first.first,curReg->first.second)));
         ++counter;
         if (freq > 0 && counter%freq == 0) {
-          hw.dispatch();
+          dispatch(hw);
           ++dispatchcounter;
         }
       }
       if (freq < 0 || counter%freq != 0) {
-        hw.dispatch();
+        dispatch(hw);
           ++dispatchcounter;
       }
 
@@ -565,7 +658,7 @@ void gem::hw::GEMHwDevice::readRegs(masked_register_pair_list &regList, int cons
       auto curReg = regList.begin();
       for ( ; curReg != regList.end(); ++curVal,++curReg)
         curReg->second = (curVal->second).value();
-      return;
+      return true;
     } catch (uhal::exception::exception const& err) {
       std::string msgBase = "Could not read from register in list:";
       for (auto curReg = regList.begin(); curReg != regList.end(); ++curReg)
@@ -588,56 +681,66 @@ void gem::hw::GEMHwDevice::readRegs(masked_register_pair_list &regList, int cons
       // XCEPT_RAISE(gem::hw::exception::HardwareProblem, msg);
     }
   }
+  m_stats.recordFailure();
   std::string msg = toolbox::toString("Maximum number of retries reached, unable to read registers");
   ERROR("GEMHwDevice::" << msg);
   // XCEPT_RAISE(gem::hw::exception::HardwareProblem, msg);
+  return false;
 }
 
-void gem::hw::GEMHwDevice::writeReg(std::string const& name, uint32_t const val)
+void gem::hw::GEMHwDevice::writeReg(RegisterHandle const& reg, uint32_t const val)
 {
-  gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_hwLock);
+  TimedLockGuard guardedLock(*this);
   uhal::HwInterface& hw = getGEMHwInterface();
   unsigned retryCount = 0;
-  DEBUG("gem::hw::GEMHwDevice::writeReg " << name << std::endl
-        << "Path  "      << hw.getNode(name).getPath() << std::endl
-        << "Address 0x"  << std::hex << hw.getNode(name).getAddress() << std::dec << std::endl
-        << "Mask 0x"     << std::hex << hw.getNode(name).getMask()    << std::dec << std::endl
-        << "Permission " << hw.getNode(name).getPermission() << std::endl
-        << "Mode "       << hw.getNode(name).getMode() << std::endl
-        << "Size "       << hw.getNode(name).getSize() << std::endl
-        << std::endl);
+  if (!reg.valid) {
+    ERROR("GEMHwDevice::Unable to write to unresolved register " << reg.name);
+    return;
+  }
+  if (p_transaction) {
+    p_transaction->write(reg, val);
+    return;
+  }
+
+  TRACE("gem::hw::GEMHwDevice::writeReg " << reg.name << " (0x" << std::setfill('0') << std::setw(8)
+        << std::hex << reg.address << std::dec << ")" << std::endl);
+  bool const readBack = reg.permission != uhal::defs::WRITE;
+  uhal::ClientInterface& client = hw.getClient();
   while (retryCount < MAX_IPBUS_RETRIES) {
     ++retryCount;
     try {
       uhal::ValWord<uint32_t> ival;
-      if (hw.getNode(name).getPermission() != uhal::defs::WRITE)
-        ival = hw.getNode(name).read();
-      hw.getNode(name).write(val);
+      if (readBack)
+        ival = client.read(reg.address,reg.mask);
+      if (reg.mask == 0xffffffff)
+        client.write(reg.address,val);
+      else
+        client.write(reg.address,val,reg.mask);
       uhal::ValWord<uint32_t> rval;
-      if (hw.getNode(name).getPermission() != uhal::defs::WRITE)
-        rval = hw.getNode(name).read();
-      hw.dispatch();
-      if (hw.getNode(name).getPermission() != uhal::defs::WRITE)
+      if (readBack)
+        rval = client.read(reg.address,reg.mask);
+      dispatch(hw);
+      if (readBack) {
         DEBUG("gem::hw::GEMHwDevice::writeReg initial: "
               << std::hex << ival.value() << std::dec
               << ", write val: " << std::hex << val << std::dec
               << ", readback: "  << std::hex << rval.value() << std::dec
               << std::endl);
-      if (hw.getNode(name).getPermission() != uhal::defs::WRITE)
         if (rval.value() != val) {
           std::string msgBase = toolbox::toString("WriteValueMismatch write (0x%x) to register '%s' resulted in 0x%x (uHAL)",
-                                                  val, name.c_str(),rval.value());
+                                                  val, reg.name.c_str(),rval.value());
           XCEPT_RAISE(gem::hw::exception::WriteValueMismatch, toolbox::toString("%s.", msgBase.c_str()));
         }
+      }
       return;
     } catch (uhal::exception::exception const& err) {
-      std::string msgBase = toolbox::toString("Could not write to register '%s' (uHAL)", name.c_str());
+      std::string msgBase = toolbox::toString("Could not write to register '%s' (uHAL)", reg.name.c_str());
       std::string msg     = toolbox::toString("%s: %s.", msgBase.c_str(), err.what());
       std::string errCode = toolbox::toString("%s",err.what());
       if (knownErrorCode(errCode)) {
         ++retryCount;
         if (retryCount > (MAX_IPBUS_RETRIES-1))
-          DEBUG("GEMHwDevice::Failed to write value 0x" << std::hex<< val << std::dec << " to register " << name <<
+          DEBUG("GEMHwDevice::Failed to write value 0x" << std::hex<< val << std::dec << " to register " << reg.name <<
                 ". retryCount("<<retryCount<<")"
                 << std::endl);
         updateErrorCounters(errCode);
@@ -647,25 +750,35 @@ void gem::hw::GEMHwDevice::writeReg(std::string const& name, uint32_t const val)
         // XCEPT_RAISE(gem::hw::exception::HardwareProblem, toolbox::toString("%s.", msgBase.c_str()));
       }
     } catch (gem::hw::exception::WriteValueMismatch const& err) {
-      std::string msgBase = toolbox::toString("Could not write to register '%s' (uHAL)", name.c_str());
+      std::string msgBase = toolbox::toString("Could not write to register '%s' (uHAL)", reg.name.c_str());
       std::string msg     = toolbox::toString("%s: %s.", msgBase.c_str(), err.what());
-      std::string errCode = toolbox::toString("%s",err.what());
       ERROR("GEMHwDevice::" << msg);
     } catch (std::exception const& err) {
-      std::string msgBase = toolbox::toString("Could not write to register '%s' (std)", name.c_str());
+      std::string msgBase = toolbox::toString("Could not write to register '%s' (std)", reg.name.c_str());
       std::string msg     = toolbox::toString("%s: %s.", msgBase.c_str(), err.what());
       ERROR("GEMHwDevice::" << msg);
       // XCEPT_RAISE(gem::hw::exception::HardwareProblem, msg);
     }
   }
-  std::string msg = toolbox::toString("Maximum number of retries reached, unable to write to register %s",name.c_str());
+  m_stats.recordFailure();
+  std::string msg = toolbox::toString("Maximum number of retries reached, unable to write to register %s",reg.name.c_str());
   ERROR("GEMHwDevice::" << msg);
   // XCEPT_RAISE(gem::hw::exception::HardwareProblem, msg);
 }
 
+void gem::hw::GEMHwDevice::writeReg(std::string const& name, uint32_t const val)
+{
+  TimedLockGuard guardedLock(*this);
+  writeReg(getRegisterHandle(name), val);
+}
+
 void gem::hw::GEMHwDevice::writeReg(uint32_t const& address, uint32_t const val)
 {
-  gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_hwLock);
+  TimedLockGuard guardedLock(*this);
+  if (p_transaction) {
+    p_transaction->write(address, val);
+    return;
+  }
   uhal::HwInterface& hw = getGEMHwInterface();
   unsigned retryCount = 0;
   while (retryCount < MAX_IPBUS_RETRIES) {
@@ -674,7 +787,7 @@ void gem::hw::GEMHwDevice::writeReg(uint32_t const& address, uint32_t const val)
       uhal::ValWord<uint32_t> ival = hw.getClient().read(address);
       hw.getClient().write(address, val);
       uhal::ValWord<uint32_t> rval = hw.getClient().read(address);
-      hw.dispatch();
+      dispatch(hw);
       DEBUG("gem::hw::GEMHwDevice::writeReg initial: "
             << std::hex << ival.value() << std::dec
             << ", write val: " << std::hex << val << std::dec
@@ -715,6 +828,7 @@ void gem::hw::GEMHwDevice::writeReg(uint32_t const& address, uint32_t const val)
       // XCEPT_RAISE(gem::hw::exception::HardwareProblem, msg);
     }
   }
+  m_stats.recordFailure();
   std::string msg = toolbox::toString("Maximum number of retries reached, unable to write to register 0x%08x",
                                       address);
   ERROR("GEMHwDevice::" << msg);
@@ -723,7 +837,8 @@ void gem::hw::GEMHwDevice::writeReg(uint32_t const& address, uint32_t const val)
 
 void gem::hw::GEMHwDevice::writeRegs(register_pair_list const& regList, int const& freq)
 {
-  gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_hwLock);
+  TimedLockGuard guardedLock(*this);
+  flushTransaction();
   uhal::HwInterface& hw = getGEMHwInterface();
   unsigned retryCount = 0;
   while (retryCount < MAX_IPBUS_RETRIES) {
@@ -734,12 +849,12 @@ void gem::hw::GEMHwDevice::writeRegs(register_pair_list const& regList, int cons
         hw.getNode(curReg->first).write(curReg->second);
         ++counter;
         if (freq > 0 && counter%freq == 0) {
-          hw.dispatch();
+          dispatch(hw);
           ++dispatchcounter;
         }
       }
       if (freq < 0 || counter%freq != 0) {
-        hw.dispatch();
+        dispatch(hw);
           ++dispatchcounter;
       }
       DEBUG("GEMHwDevice::writeRegs dispatched " << dispatchcounter
@@ -767,6 +882,7 @@ void gem::hw::GEMHwDevice::writeRegs(register_pair_list const& regList, int cons
       // XCEPT_RAISE(gem::hw::exception::HardwareProblem, msg);
     }
   }
+  m_stats.recordFailure();
 }
 
 void gem::hw::GEMHwDevice::writeValueToRegs(std::vector<std::string> const& regNames, uint32_t const& regValue, int const& freq)
@@ -794,7 +910,7 @@ void gem::hw::GEMHwDevice::zeroRegs(std::vector<std::string> const& regNames, in
 
 std::vector<uint32_t> gem::hw::GEMHwDevice::readBlock(std::string const& name)
 {
-  gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_hwLock);
+  TimedLockGuard guardedLock(*this);
   uhal::HwInterface& hw = getGEMHwInterface();
   size_t numWords       = hw.getNode(name).getSize();
   TRACE("GEMHwDevice::reading block " << name << " which has size "<<numWords);
@@ -803,7 +919,8 @@ std::vector<uint32_t> gem::hw::GEMHwDevice::readBlock(std::string const& name)
 
 std::vector<uint32_t> gem::hw::GEMHwDevice::readBlock(std::string const& name, size_t const& numWords)
 {
-  gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_hwLock);
+  TimedLockGuard guardedLock(*this);
+  flushTransaction();
   uhal::HwInterface& hw = getGEMHwInterface();
 
   std::vector<uint32_t> res(numWords);
@@ -816,7 +933,7 @@ std::vector<uint32_t> gem::hw::GEMHwDevice::readBlock(std::string const& name, s
     ++retryCount;
     try {
       uhal::ValVector<uint32_t> values = hw.getNode(name).readBlock(numWords);
-      hw.dispatch();
+      dispatch(hw);
       std::copy(values.begin(), values.end(), res.begin());
       return res;
     } catch (uhal::exception::exception const& err) {
@@ -843,6 +960,7 @@ std::vector<uint32_t> gem::hw::GEMHwDevice::readBlock(std::string const& name, s
       // XCEPT_RAISE(gem::hw::exception::HardwareProblem, msg);
     }
   }
+  m_stats.recordFailure();
   std::string msg = toolbox::toString("Maximum number of retries reached, unable to read block");
   ERROR("GEMHwDevice::" << msg);
   // XCEPT_RAISE(gem::hw::exception::HardwareProblem, msg);
@@ -852,20 +970,156 @@ std::vector<uint32_t> gem::hw::GEMHwDevice::readBlock(std::string const& name, s
 uint32_t gem::hw::GEMHwDevice::readBlock(std::string const& name, uint32_t* buffer,
                                          size_t const& numWords)
 {
-  // not yet implemented
+  TimedLockGuard guardedLock(*this);
+  return readBlock(getRegisterHandle(name), buffer, numWords);
+}
+
+uint32_t gem::hw::GEMHwDevice::readBlock(RegisterHandle const& reg, uint32_t* buffer,
+                                         size_t const& numWords)
+{
+  TimedLockGuard guardedLock(*this);
+  flushTransaction();
+  uhal::HwInterface& hw = getGEMHwInterface();
+
+  unsigned retryCount = 0;
+  if (numWords < 1 || buffer == NULL)
+    return 0;
+  if (!reg.valid) {
+    ERROR("GEMHwDevice::Unable to read unresolved block " << reg.name);
+    return 0;
+  }
+
+  while (retryCount < MAX_IPBUS_RETRIES) {
+    ++retryCount;
+    try {
+      uhal::ValVector<uint32_t> values = hw.getClient().readBlock(reg.address, numWords, reg.mode);
+      dispatch(hw);
+      // straight into the caller's buffer, no intermediate vector
+      std::copy(values.begin(), values.end(), buffer);
+      return values.size();
+    } catch (uhal::exception::exception const& err) {
+      std::string msgBase = toolbox::toString("Could not read block '%s' (uHAL)", reg.name.c_str());
+      std::string msg     = toolbox::toString("%s: %s.", msgBase.c_str(), err.what());
+      std::string errCode = toolbox::toString("%s",err.what());
+      if (knownErrorCode(errCode)) {
+        ++retryCount;
+        if (retryCount > (MAX_IPBUS_RETRIES-1))
+          DEBUG("GEMHwDevice::Failed to read block " << reg.name << " with " << numWords << " words" <<
+                ". retryCount("<<retryCount<<")" << std::endl
+                << "error was " << errCode
+                << std::endl);
+        updateErrorCounters(errCode);
+        continue;
+      } else {
+        ERROR("GEMHwDevice::" << msg);
+      }
+    } catch (std::exception const& err) {
+      std::string msgBase = toolbox::toString("Could not read block '%s' (std)", reg.name.c_str());
+      std::string msg     = toolbox::toString("%s: %s.", msgBase.c_str(), err.what());
+      ERROR("GEMHwDevice::" << msg);
+    }
+  }
+  m_stats.recordFailure();
+  std::string msg = toolbox::toString("Maximum number of retries reached, unable to read block");
+  ERROR("GEMHwDevice::" << msg);
+  return 0;
+}
+
+uint32_t gem::hw::GEMHwDevice::readBlocks(std::vector<RegisterHandle> const& regs, uint32_t* buffer,
+                                          size_t const& numWords)
+{
+  TimedLockGuard guardedLock(*this);
+  flushTransaction();
+  uhal::HwInterface& hw = getGEMHwInterface();
+
+  unsigned retryCount = 0;
+  if (numWords < 1 || buffer == NULL || regs.empty())
+    return 0;
+  for (auto reg = regs.begin(); reg != regs.end(); ++reg) {
+    if (!reg->valid) {
+      ERROR("GEMHwDevice::Unable to read unresolved block " << reg->name);
+      return 0;
+    }
+  }
+
+  std::vector<uhal::ValVector<uint32_t> > values;
+  values.reserve(regs.size());
+  while (retryCount < MAX_IPBUS_RETRIES) {
+    ++retryCount;
+    try {
+      // everything is queued again on a retry, the values of a failed dispatch are not valid
+      values.clear();
+      for (auto reg = regs.begin(); reg != regs.end(); ++reg)
+        values.push_back(hw.getClient().readBlock(reg->address, numWords, reg->mode));
+      dispatch(hw);
+
+      uint32_t nRead = 0;
+      for (auto block = values.begin(); block != values.end(); ++block) {
+        std::copy(block->begin(), block->end(), buffer + (block - values.begin())*numWords);
+        nRead += block->size();
+      }
+      return nRead;
+    } catch (uhal::exception::exception const& err) {
+      std::string msgBase = toolbox::toString("Could not read %d blocks starting at '%s' (uHAL)",
+                                              int(regs.size()), regs.front().name.c_str());
+      std::string msg     = toolbox::toString("%s: %s.", msgBase.c_str(), err.what());
+      std::string errCode = toolbox::toString("%s",err.what());
+      if (knownErrorCode(errCode)) {
+        ++retryCount;
+        if (retryCount > (MAX_IPBUS_RETRIES-1))
+          DEBUG("GEMHwDevice::Failed to read " << regs.size() << " blocks with " << numWords << " words" <<
+                ". retryCount("<<retryCount<<")" << std::endl
+                << "error was " << errCode
+                << std::endl);
+        updateErrorCounters(errCode);
+        continue;
+      } else {
+        ERROR("GEMHwDevice::" << msg);
+      }
+    } catch (std::exception const& err) {
+      std::string msgBase = toolbox::toString("Could not read %d blocks starting at '%s' (std)",
+                                              int(regs.size()), regs.front().name.c_str());
+      std::string msg     = toolbox::toString("%s: %s.", msgBase.c_str(), err.what());
+      ERROR("GEMHwDevice::" << msg);
+    }
+  }
+  m_stats.recordFailure();
+  std::string msg = toolbox::toString("Maximum number of retries reached, unable to read blocks");
+  ERROR("GEMHwDevice::" << msg);
   return 0;
 }
 
 uint32_t gem::hw::GEMHwDevice::readBlock(std::string const& name, std::vector<toolbox::mem::Reference*>& buffer,
                                          size_t const& numWords)
 {
-  // not yet implemented
-  return 0;
+  TimedLockGuard guardedLock(*this);
+  return readBlock(getRegisterHandle(name), buffer, numWords);
+}
+
+uint32_t gem::hw::GEMHwDevice::readBlock(RegisterHandle const& reg, std::vector<toolbox::mem::Reference*>& buffer,
+                                         size_t const& numWords)
+{
+  // fill the frames in order, each up to the size of its buffer
+  TimedLockGuard guardedLock(*this);
+  size_t nRead = 0;
+  for (auto frame = buffer.begin(); frame != buffer.end() && nRead < numWords; ++frame) {
+    if (*frame == NULL)
+      continue;
+    size_t const frameWords = (*frame)->getBuffer()->getSize()/sizeof(uint32_t);
+    size_t const toRead     = std::min(numWords - nRead, frameWords);
+    uint32_t const got = readBlock(reg, static_cast<uint32_t*>((*frame)->getDataLocation()), toRead);
+    (*frame)->setDataSize(got*sizeof(uint32_t));
+    nRead += got;
+    if (got < toRead)
+      break;
+  }
+  return nRead;
 }
 
 void gem::hw::GEMHwDevice::writeBlock(std::string const& name, std::vector<uint32_t> const values)
 {
-  gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_hwLock);
+  TimedLockGuard guardedLock(*this);
+  flushTransaction();
   if (values.size() < 1)
     return;
 
@@ -875,7 +1129,7 @@ void gem::hw::GEMHwDevice::writeBlock(std::string const& name, std::vector<uint3
     ++retryCount;
     try {
       hw.getNode(name).writeBlock(values);
-      hw.dispatch();
+      dispatch(hw);
       return;
     } catch (uhal::exception::exception const& err) {
       std::string msgBase = toolbox::toString("Could not write to block '%s' (uHAL)", name.c_str());
@@ -900,6 +1154,7 @@ void gem::hw::GEMHwDevice::writeBlock(std::string const& name, std::vector<uint3
       // XCEPT_RAISE(gem::hw::exception::HardwareProblem, msg);
     }
   }
+  m_stats.recordFailure();
   std::string msg = toolbox::toString("Maximum number of retries reached, unable to write block %s",name.c_str());
   ERROR("GEMHwDevice::" << msg);
   // XCEPT_RAISE(gem::hw::exception::HardwareProblem, msg);
@@ -932,6 +1187,27 @@ void gem::hw::GEMHwDevice::zeroFIFO(std::string const& name)
   return writeReg(name+".FLUSH",0x0);
 }
 
+void gem::hw::GEMHwDevice::flushTransaction()
+{
+  if (p_transaction)
+    p_transaction->dispatch();
+}
+
+void gem::hw::GEMHwDevice::dispatch(uhal::HwInterface& hw)
+{
+  // recorded also when the dispatch throws, a timed out transaction is the interesting one
+  std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+  try {
+    hw.dispatch();
+  } catch (...) {
+    m_stats.recordDispatch(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::steady_clock::now() - start).count());
+    throw;
+  }
+  m_stats.recordDispatch(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now() - start).count());
+}
+
 bool gem::hw::GEMHwDevice::knownErrorCode(std::string const& errCode) const {
   return ((errCode.find("amount of data")              != std::string::npos) ||
           (errCode.find("INFO CODE = 0x4L")            != std::string::npos) ||
@@ -945,6 +1221,7 @@ bool gem::hw::GEMHwDevice::knownErrorCode(std::string const& errCode) const {
 
 
 void gem::hw::GEMHwDevice::updateErrorCounters(std::string const& errCode) {
+  m_stats.recordRetry();
   if (errCode.find("amount of data")    != std::string::npos)
     ++m_ipBusErrs.BadHeader;
   if (errCode.find("INFO CODE = 0x4L")  != std::string::npos)
@@ -963,7 +1240,7 @@ void gem::hw::GEMHwDevice::updateErrorCounters(std::string const& errCode) {
 
 void gem::hw::GEMHwDevice::zeroBlock(std::string const& name)
 {
-  gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_hwLock);
+  TimedLockGuard guardedLock(*this);
   uhal::HwInterface& hw = getGEMHwInterface();
   size_t numWords = hw.getNode(name).getSize();
   std::vector<uint32_t> zeros(numWords, 0);
@@ -0,0 +1,77 @@
+/**
+ * class: GEMHwDeviceStats
+ * description: lock free statistics of the IPBus accesses of a GEMHwDevice
+ */
+
+#include "gem/hw/GEMHwDeviceStats.h"
+
+namespace {
+  thread_local gem::hw::GEMHwDeviceStats::AccessCategory threadCategory = gem::hw::GEMHwDeviceStats::CONTROL;
+}
+
+std::string gem::hw::GEMHwDeviceStats::categoryName(AccessCategory const& category)
+{
+  switch (category) {
+  case CONTROL:
+    return "CONTROL";
+  case MONITORING:
+    return "MONITORING";
+  case READOUT:
+    return "READOUT";
+  default:
+    return "UNKNOWN";
+  }
+}
+
+gem::hw::GEMHwDeviceStats::ScopedCategory::ScopedCategory(AccessCategory const& category) :
+  m_previous(threadCategory)
+{
+  threadCategory = category;
+}
+
+gem::hw::GEMHwDeviceStats::ScopedCategory::~ScopedCategory()
+{
+  threadCategory = m_previous;
+}
+
+gem::hw::GEMHwDeviceStats::AccessCategory gem::hw::GEMHwDeviceStats::currentCategory()
+{
+  return threadCategory;
+}
+
+gem::hw::GEMHwDeviceStats::CategoryStats::CategoryStats() :
+  retries(0),
+  failures(0)
+{
+}
+
+gem::hw::GEMHwDeviceStats::GEMHwDeviceStats()
+{
+}
+
+void gem::hw::GEMHwDeviceStats::writeJSON(std::ostream& out) const
+{
+  out << "{";
+  for (unsigned c = 0; c < N_CATEGORIES; ++c) {
+    CategoryStats const& stats = m_categories[c];
+    out << (c ? ", " : "") << "\"" << categoryName(static_cast<AccessCategory>(c)) << "\": {"
+        << "\"retries\": "  << stats.retries.load(std::memory_order_relaxed)
+        << ", \"failures\": " << stats.failures.load(std::memory_order_relaxed)
+        << ", \"dispatch\": ";
+    stats.dispatch.writeJSON(out);
+    out << ", \"lock_wait\": ";
+    stats.lockWait.writeJSON(out);
+    out << "}";
+  }
+  out << "}";
+}
+
+void gem::hw::GEMHwDeviceStats::reset()
+{
+  for (unsigned c = 0; c < N_CATEGORIES; ++c) {
+    m_categories[c].dispatch.reset();
+    m_categories[c].lockWait.reset();
+    m_categories[c].retries.store(0, std::memory_order_relaxed);
+    m_categories[c].failures.store(0, std::memory_order_relaxed);
+  }
+}
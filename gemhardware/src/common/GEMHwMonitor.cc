@@ -0,0 +1,225 @@
+/**
+ * class: GEMHwMonitor
+ * description: Common monitor for uHAL devices, the register monitorables are resolved
+ *              once and each set is refreshed with a single IPbus dispatch and
+ *              a single update of each info space
+ *              structure borrowed from TCDS core, with nods to HCAL and EMU code
+ */
+
+#include "gem/hw/GEMHwMonitor.h"
+
+typedef gem::base::utils::GEMInfoSpaceToolBox::UpdateType GEMUpdateType;
+
+namespace {
+  // per caller category, in the order they are published
+  const char* const IPBUS_STATS_ITEMS[] = {"DISPATCHES", "DISPATCH_P50_US", "DISPATCH_P99_US", "DISPATCH_MAX_US",
+                                           "RETRIES", "FAILURES", "LOCK_WAIT_P99_US", "LOCK_WAIT_TOTAL_US"};
+  const size_t N_IPBUS_STATS_ITEMS = sizeof(IPBUS_STATS_ITEMS)/sizeof(IPBUS_STATS_ITEMS[0]);
+
+  std::string ipBusStatsItemName(gem::hw::GEMHwDeviceStats::AccessCategory const& category, size_t const& item)
+  {
+    return "IPBUS_" + gem::hw::GEMHwDeviceStats::categoryName(category) + "_" + IPBUS_STATS_ITEMS[item];
+  }
+}
+
+gem::hw::GEMHwMonitor::GEMHwMonitor(std::shared_ptr<GEMHwDevice> device,
+                                    log4cplus::Logger& logger,
+                                    xdaq::Application* xdaqApp,
+                                    int const& index) :
+  GEMMonitor(logger, xdaqApp, index),
+  p_hwDevice(device)
+{
+}
+
+gem::hw::GEMHwMonitor::~GEMHwMonitor()
+{
+}
+
+bool gem::hw::GEMHwMonitor::addRegister(std::string const& regName, masked_register_pair_list& registers)
+{
+  // shares the device's handle cache, recompiling does not look the registers up again
+  GEMHwDevice::RegisterHandle const& reg = p_hwDevice->getRegisterHandle(regName);
+  if (!reg.valid) {
+    WARN("GEMHwMonitor::compileMonitorables unable to resolve register " << regName
+         << ", it will not be monitored");
+    return false;
+  }
+  registers.push_back(std::make_pair(std::make_pair(reg.address, reg.mask), 0x0));
+  return true;
+}
+
+void gem::hw::GEMHwMonitor::compileMonitorables()
+{
+  DEBUG("GEMHwMonitor::compileMonitorables");
+  m_compiledSetsMap.clear();
+
+  std::string const baseNode = p_hwDevice->getDeviceBaseNode();
+  for (auto monlist = m_monitorableSetsMap.begin(); monlist != m_monitorableSetsMap.end(); ++monlist) {
+    GEMHwMonitorableSet monset;
+    monset.monitorables.reserve(monlist->second.size());
+    monset.registers.reserve(monlist->second.size());
+
+    for (auto monitem = monlist->second.begin(); monitem != monlist->second.end(); ++monitem) {
+      GEMUpdateType const utype = monitem->second.updatetype;
+      if (utype == GEMUpdateType::NOUPDATE || monitem->second.regname.empty())
+        continue;
+
+      GEMHwMonitorable hwitem;
+      hwitem.name       = monitem->first;
+      hwitem.infoSpace  = monitem->second.infoSpace;
+      hwitem.updatetype = utype;
+      hwitem.regIndex   = monset.registers.size();
+
+      std::string const regName = baseNode + "." + monitem->second.regname;
+      bool resolved = false;
+      if (utype == GEMUpdateType::HW8  || utype == GEMUpdateType::HW16 ||
+          utype == GEMUpdateType::HW24 || utype == GEMUpdateType::HW32 ||
+          utype == GEMUpdateType::PROCESS || utype == GEMUpdateType::TRACKER) {
+        resolved = addRegister(regName, monset.registers);
+      } else if (utype == GEMUpdateType::HW64) {
+        resolved = addRegister(regName+".LOWER", monset.registers) &&
+          addRegister(regName+".UPPER", monset.registers);
+      } else if (utype == GEMUpdateType::I2CSTAT) {
+        resolved = addRegister(regName+".Strobe."+monitem->first, monset.registers) &&
+          addRegister(regName+".Ack."+monitem->first, monset.registers);
+      } else {
+        ERROR("GEMHwMonitor: Unknown update type encountered for " << monitem->first);
+      }
+
+      if (resolved)
+        resolved = addUpdate(hwitem, monset);
+
+      if (resolved) {
+        monset.monitorables.push_back(hwitem);
+      } else {
+        // drop a partially resolved pair
+        monset.registers.resize(hwitem.regIndex);
+      }
+    }  // end loop over items in list
+
+    DEBUG("GEMHwMonitor::compileMonitorables set " << monlist->first << " has "
+          << monset.monitorables.size() << " monitorables in "
+          << monset.registers.size() << " registers");
+    if (!monset.monitorables.empty())
+      m_compiledSetsMap.insert(std::make_pair(monlist->first, monset));
+  }  // end loop over monitorableSets
+}
+
+bool gem::hw::GEMHwMonitor::addUpdate(GEMHwMonitorable& hwitem, GEMHwMonitorableSet& monset)
+{
+  auto list = monset.updates.begin();
+  for (; list != monset.updates.end(); ++list)
+    if (list->first == hwitem.infoSpace)
+      break;
+  if (list == monset.updates.end())
+    list = monset.updates.insert(monset.updates.end(),
+                                 std::make_pair(hwitem.infoSpace,
+                                                gem::base::utils::GEMInfoSpaceToolBox::ItemUpdateList()));
+
+  hwitem.updateList  = list - monset.updates.begin();
+  hwitem.updateIndex = list->second.size();
+  if (hwitem.updatetype == GEMUpdateType::HW64 || hwitem.updatetype == GEMUpdateType::I2CSTAT)
+    return hwitem.infoSpace->addUInt64Update(hwitem.name, list->second);
+  else
+    return hwitem.infoSpace->addUInt32Update(hwitem.name, list->second);
+}
+
+void gem::hw::GEMHwMonitor::clearCompiledMonitorables()
+{
+  m_compiledSetsMap.clear();
+  m_ipBusStatsUpdates = infospace_update_list();
+  clearJSONItems();
+}
+
+void gem::hw::GEMHwMonitor::addIPBusStatsMonitorables(std::string const& infoSpaceName)
+{
+  auto is = m_infoSpaceMap.find(infoSpaceName);
+  if (is == m_infoSpaceMap.end()) {
+    ERROR("GEMHwMonitor::addIPBusStatsMonitorables infoSpace '" << infoSpaceName << "' does not exist in monitor!");
+    return;
+  }
+  std::shared_ptr<gem::base::utils::GEMInfoSpaceToolBox> infoSpace = is->second.first;
+
+  // not read from registers, NOUPDATE keeps them out of the compiled register sets
+  addMonitorableSet("IPBus Statistics", infoSpaceName);
+  m_ipBusStatsUpdates = std::make_pair(infoSpace, gem::base::utils::GEMInfoSpaceToolBox::ItemUpdateList());
+  for (unsigned c = 0; c < GEMHwDeviceStats::N_CATEGORIES; ++c) {
+    GEMHwDeviceStats::AccessCategory const category = static_cast<GEMHwDeviceStats::AccessCategory>(c);
+    for (size_t item = 0; item < N_IPBUS_STATS_ITEMS; ++item) {
+      std::string const name = ipBusStatsItemName(category, item);
+      // the items survive a reset of the monitor, only the monitorables are added again
+      if (!infoSpace->find(name))
+        infoSpace->createUInt64(name, 0, NULL, GEMUpdateType::NOUPDATE,
+                                "IPBus access statistics of the " + GEMHwDeviceStats::categoryName(category)
+                                + " callers", "dec");
+      addMonitorable("IPBus Statistics", infoSpaceName, std::make_pair(name, ""), GEMUpdateType::NOUPDATE, "dec");
+      if (!infoSpace->addUInt64Update(name, m_ipBusStatsUpdates.second)) {
+        ERROR("GEMHwMonitor::addIPBusStatsMonitorables unable to add " << name << ", no statistics will be published");
+        m_ipBusStatsUpdates = infospace_update_list();
+        return;
+      }
+    }
+  }
+}
+
+void gem::hw::GEMHwMonitor::updateMonitorables()
+{
+  DEBUG("GEMHwMonitor: Updating monitorables");
+  GEMHwDeviceStats::ScopedCategory monitoring(GEMHwDeviceStats::MONITORING);
+  for (auto monset = m_compiledSetsMap.begin(); monset != m_compiledSetsMap.end(); ++monset) {
+    DEBUG("GEMHwMonitor: Updating monitorables in set " << monset->first);
+    masked_register_pair_list& registers = monset->second.registers;
+    // queue the reads for the whole set, uhal splits them into packets but a single dispatch is made
+    if (!p_hwDevice->readRegs(registers, -1)) {
+      WARN("GEMHwMonitor: Block read of set " << monset->first << " failed, reading "
+           << registers.size() << " registers individually");
+      for (auto reg = registers.begin(); reg != registers.end(); ++reg)
+        reg->second = p_hwDevice->readReg(reg->first.first, reg->first.second);
+    }
+    publishSet(monset->second);
+  }
+  publishIPBusStats();
+}
+
+void gem::hw::GEMHwMonitor::publishSet(GEMHwMonitorableSet& monset)
+{
+  masked_register_pair_list const& registers = monset.registers;
+  for (auto monitem = monset.monitorables.begin(); monitem != monset.monitorables.end(); ++monitem) {
+    uint32_t const first = registers.at(monitem->regIndex).second;
+    gem::base::utils::GEMInfoSpaceToolBox::ItemUpdateList& updates = monset.updates.at(monitem->updateList).second;
+    if (monitem->updatetype == GEMUpdateType::HW64 || monitem->updatetype == GEMUpdateType::I2CSTAT) {
+      // HW64 is (LOWER, UPPER), I2CSTAT is (Strobe, Ack)
+      uint64_t const second = registers.at(monitem->regIndex+1).second;
+      updates.setUInt64(monitem->updateIndex, (second << 32) + first);
+    } else {
+      updates.setUInt32(monitem->updateIndex, first);
+    }
+  }
+
+  for (auto list = monset.updates.begin(); list != monset.updates.end(); ++list)
+    list->first->setItems(list->second);
+}
+
+void gem::hw::GEMHwMonitor::publishIPBusStats()
+{
+  if (!m_ipBusStatsUpdates.first)
+    return;
+
+  GEMHwDeviceStats const& stats = p_hwDevice->getStats();
+  gem::base::utils::GEMInfoSpaceToolBox::ItemUpdateList& updates = m_ipBusStatsUpdates.second;
+  size_t index = 0;
+  for (unsigned c = 0; c < GEMHwDeviceStats::N_CATEGORIES; ++c) {
+    GEMHwDeviceStats::CategoryStats const& category =
+      stats.getCategory(static_cast<GEMHwDeviceStats::AccessCategory>(c));
+    // same order as IPBUS_STATS_ITEMS
+    updates.setUInt64(index++, category.dispatch.count());
+    updates.setUInt64(index++, category.dispatch.percentileUS(0.50));
+    updates.setUInt64(index++, category.dispatch.percentileUS(0.99));
+    updates.setUInt64(index++, category.dispatch.maxNs()/1000);
+    updates.setUInt64(index++, category.retries.load(std::memory_order_relaxed));
+    updates.setUInt64(index++, category.failures.load(std::memory_order_relaxed));
+    updates.setUInt64(index++, category.lockWait.percentileUS(0.99));
+    updates.setUInt64(index++, category.lockWait.totalNs()/1000);
+  }
+  m_ipBusStatsUpdates.first->setItems(updates);
+}
@@ -0,0 +1,177 @@
+/**
+ * class: GEMHwTransaction
+ * description: Scoped batch of register operations on a GEMHwDevice, dispatched together
+ */
+
+#include "gem/hw/GEMHwTransaction.h"
+
+#include <algorithm>
+
+gem::hw::GEMHwTransaction::GEMHwTransaction(GEMHwDevice& device, size_t const& dispatchSize) :
+  m_gemLogger(device.m_gemLogger),
+  m_device(device),
+  m_hwLockGuard(device),  // held until the transaction goes out of scope
+  m_dispatchSize(dispatchSize > 0 ? dispatchSize : 1),
+  p_outer(NULL)
+{
+  m_operations.reserve(m_dispatchSize);
+
+  // an enclosing transaction is sent first, so that the order of the operations is kept,
+  // this one is only installed on the device once nothing else can throw
+  p_outer = m_device.p_transaction;
+  if (p_outer)
+    p_outer->dispatch();
+  m_device.p_transaction = this;
+}
+
+gem::hw::GEMHwTransaction::~GEMHwTransaction()
+{
+  try {
+    dispatch();
+  } catch (...) {
+    // getGEMHwInterface throws if the device is not connected, nothing can be sent
+    ERROR("GEMHwTransaction::~GEMHwTransaction unable to dispatch " << m_operations.size() << " operations");
+  }
+  m_device.p_transaction = p_outer;
+}
+
+gem::hw::GEMHwTransaction::Value gem::hw::GEMHwTransaction::read(GEMHwDevice::RegisterHandle const& reg)
+{
+  Value val;
+  if (!reg.valid) {
+    ERROR("GEMHwTransaction::Unable to read unresolved register " << reg.name);
+    return val;
+  }
+  val.p_result = std::make_shared<Value::Result>();
+  Operation op = {true, reg.address, reg.mask, 0x0, &reg.name, val.p_result};
+  m_operations.push_back(op);
+  return val;
+}
+
+gem::hw::GEMHwTransaction::Value gem::hw::GEMHwTransaction::read(std::string const& regName)
+{
+  return read(m_device.getRegisterHandle(regName));
+}
+
+gem::hw::GEMHwTransaction::Value gem::hw::GEMHwTransaction::read(uint32_t const& address, uint32_t const& mask)
+{
+  Value val;
+  val.p_result = std::make_shared<Value::Result>();
+  Operation op = {true, address, mask, 0x0, NULL, val.p_result};
+  m_operations.push_back(op);
+  return val;
+}
+
+void gem::hw::GEMHwTransaction::write(GEMHwDevice::RegisterHandle const& reg, uint32_t const val)
+{
+  if (!reg.valid) {
+    ERROR("GEMHwTransaction::Unable to write to unresolved register " << reg.name);
+    return;
+  }
+  Operation op = {false, reg.address, reg.mask, val, &reg.name, nullptr};
+  m_operations.push_back(op);
+}
+
+void gem::hw::GEMHwTransaction::write(std::string const& regName, uint32_t const val)
+{
+  write(m_device.getRegisterHandle(regName), val);
+}
+
+void gem::hw::GEMHwTransaction::write(uint32_t const& address, uint32_t const val, uint32_t const& mask)
+{
+  Operation op = {false, address, mask, val, NULL, nullptr};
+  m_operations.push_back(op);
+}
+
+bool gem::hw::GEMHwTransaction::dispatch()
+{
+  if (m_operations.empty())
+    return true;
+
+  uhal::HwInterface& hw = m_device.getGEMHwInterface();
+
+  // a failed group is not retried beyond the IPBus retries, the groups after it are still sent
+  bool success = true;
+  int  nGroups = 0;
+  for (size_t first = 0; first < m_operations.size(); first += m_dispatchSize, ++nGroups) {
+    size_t const last = std::min(first + m_dispatchSize, m_operations.size());
+    if (!dispatchGroup(hw, first, last))
+      success = false;
+  }
+  DEBUG("GEMHwTransaction::dispatch sent " << m_operations.size() << " operations in "
+        << nGroups << " dispatch calls");
+  m_operations.clear();
+  return success;
+}
+
+bool gem::hw::GEMHwTransaction::dispatchGroup(uhal::HwInterface& hw, size_t const& first, size_t const& last)
+{
+  uhal::ClientInterface& client = hw.getClient();
+  std::vector<uhal::ValWord<uint32_t> > vals;
+  vals.reserve(last - first);
+
+  unsigned retryCount = 0;
+  while (retryCount < GEMHwDevice::MAX_IPBUS_RETRIES) {
+    ++retryCount;
+    try {
+      // everything is queued again on a retry, the values of a failed dispatch are not valid
+      vals.clear();
+      for (size_t i = first; i < last; ++i) {
+        Operation const& op = m_operations[i];
+        if (op.isRead)
+          vals.push_back(client.read(op.address, op.mask));
+        else if (op.mask == 0xffffffff)
+          client.write(op.address, op.value);
+        else
+          client.write(op.address, op.value, op.mask);
+      }
+      m_device.dispatch(hw);
+
+      auto val = vals.begin();
+      for (size_t i = first; i < last; ++i) {
+        Operation const& op = m_operations[i];
+        if (op.isRead) {
+          op.result->value = val->value();
+          op.result->valid = true;
+          ++val;
+        }
+      }
+      TRACE("GEMHwTransaction::Successfully dispatched " << (last - first) << " operations"
+            << " retry count is " << retryCount);
+      return true;
+    } catch (uhal::exception::exception const& err) {
+      std::string msgBase = toolbox::toString("Could not dispatch %d operations starting at '%s' (uHAL)",
+                                              int(last - first), operationName(m_operations[first]).c_str());
+      std::string msg     = toolbox::toString("%s: %s.", msgBase.c_str(), err.what());
+      std::string errCode = toolbox::toString("%s",err.what());
+      if (m_device.knownErrorCode(errCode)) {
+        ++retryCount;
+        if (retryCount > (GEMHwDevice::MAX_IPBUS_RETRIES-1))
+          DEBUG("GEMHwTransaction::Failed to dispatch " << (last - first) << " operations"
+                << ". retryCount("<<retryCount<<")"
+                << std::endl);
+        m_device.updateErrorCounters(errCode);
+        continue;
+      } else {
+        ERROR("GEMHwTransaction::" << msg);
+      }
+    } catch (std::exception const& err) {
+      std::string msgBase = toolbox::toString("Could not dispatch %d operations starting at '%s' (std)",
+                                              int(last - first), operationName(m_operations[first]).c_str());
+      std::string msg     = toolbox::toString("%s: %s.", msgBase.c_str(), err.what());
+      ERROR("GEMHwTransaction::" << msg);
+    }
+  }
+  m_device.m_stats.recordFailure();
+  std::string msg = toolbox::toString("Maximum number of retries reached, unable to dispatch %d operations",
+                                      int(last - first));
+  ERROR("GEMHwTransaction::" << msg);
+  return false;
+}
+
+std::string gem::hw::GEMHwTransaction::operationName(Operation const& op) const
+{
+  if (op.name)
+    return *op.name;
+  return toolbox::toString("0x%08x", op.address);
+}
@@ -1,4 +1,5 @@
 #include "gem/hw/HwGenericAMC.h"
+#include "gem/hw/GEMHwTransaction.h"
 
 #include <iomanip>
 
@@ -280,17 +281,50 @@ gem::hw::GEMHwDevice::OpticalLinkStatus gem::hw::HwGenericAMC::LinkStatus(uint8_
   INFO("LinkStatus:: m_links 0x" << std::hex <<std::setw(8) << std::setfill('0')
        << m_links << std::dec);
   if (linkCheck(gtx, "Link status")) {
-    linkStatus.GTX_TRK_Errors   = readReg(getDeviceBaseNode(),toolbox::toString("OH_LINKS.OH%d.TRACK_LINK_ERROR_CNT", gtx));
-    linkStatus.GTX_TRG_Errors   = readReg(getDeviceBaseNode(),toolbox::toString("TRIGGER.OH%d.LINK0_MISSED_COMMA_CNT",gtx));
-    linkStatus.GTX_Data_Packets = readReg(getDeviceBaseNode(),toolbox::toString("OH_LINKS.OH%d.VFAT_BLOCK_CNT",       gtx));
-    linkStatus.GBT_TRK_Errors   = readReg(getDeviceBaseNode(),toolbox::toString("OH_LINKS.OH%d.TRACK_LINK_ERROR_CNT", gtx));
-    linkStatus.GBT_Data_Packets = readReg(getDeviceBaseNode(),toolbox::toString("OH_LINKS.OH%d.VFAT_BLOCK_CNT",       gtx));
+    AMCLinkRegisters const& regs = linkRegisters(gtx);
+    linkStatus.GTX_TRK_Errors   = readReg(*regs.trackLinkErrors);
+    linkStatus.GTX_TRG_Errors   = readReg(*regs.triggerMissedComma);
+    linkStatus.GTX_Data_Packets = readReg(*regs.vfatBlocks);
+    linkStatus.GBT_TRK_Errors   = readReg(*regs.trackLinkErrors);
+    linkStatus.GBT_Data_Packets = readReg(*regs.vfatBlocks);
   }
   INFO("LinkStatus:: m_links 0x" << std::hex <<std::setw(8) << std::setfill('0')
        << m_links << std::dec);
   return linkStatus;
 }
 
+gem::hw::HwGenericAMC::AMCLinkRegisters const& gem::hw::HwGenericAMC::linkRegisters(uint8_t const& gtx)
+{
+  if (gtx >= N_GTX) {
+    std::string msg = toolbox::toString("Register handles requested for gtx (%d): outside expectation (0-%d)",
+                                        gtx, N_GTX-1);
+    ERROR(msg);
+    XCEPT_RAISE(gem::hw::exception::ValueError,msg);
+  }
+
+  AMCLinkRegisters& regs = m_linkRegisters[gtx];
+  if (!regs.resolved) {
+    std::string const base = getDeviceBaseNode();
+    regs.trackLinkErrors    = &getRegisterHandle(base,toolbox::toString("OH_LINKS.OH%d.TRACK_LINK_ERROR_CNT", gtx));
+    regs.triggerMissedComma = &getRegisterHandle(base,toolbox::toString("TRIGGER.OH%d.LINK0_MISSED_COMMA_CNT",gtx));
+    regs.vfatBlocks         = &getRegisterHandle(base,toolbox::toString("OH_LINKS.OH%d.VFAT_BLOCK_CNT",       gtx));
+    regs.ohStrobe           = &getRegisterHandle(base,toolbox::toString("COUNTERS.IPBus.Strobe.OptoHybrid_%d",gtx));
+    regs.ohAck              = &getRegisterHandle(base,toolbox::toString("COUNTERS.IPBus.Ack.OptoHybrid_%d",   gtx));
+    regs.counterStrobe      = &getRegisterHandle(base,"COUNTERS.IPBus.Strobe.Counters");
+    regs.counterAck         = &getRegisterHandle(base,"COUNTERS.IPBus.Ack.Counters");
+    regs.resolved = true;
+  }
+  return regs;
+}
+
+void gem::hw::HwGenericAMC::clearRegisterHandles()
+{
+  gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_hwLock);
+  for (unsigned gtx = 0; gtx < N_GTX; ++gtx)
+    m_linkRegisters[gtx] = AMCLinkRegisters();
+  gem::hw::GEMHwDevice::clearRegisterHandles();
+}
+
 void gem::hw::HwGenericAMC::LinkReset(uint8_t const& gtx, uint8_t const& resets)
 {
 
@@ -311,18 +345,19 @@ gem::hw::HwGenericAMC::AMCIPBusCounters gem::hw::HwGenericAMC::getIPBusCounters(
 {
 
   if (linkCheck(gtx, "IPBus counter")) {
+    AMCLinkRegisters const& regs = linkRegisters(gtx);
     if (mode&0x01)
-      m_ipBusCounters.at(gtx).OptoHybridStrobe = readReg(getDeviceBaseNode(),toolbox::toString("COUNTERS.IPBus.Strobe.OptoHybrid_%d",gtx));
+      m_ipBusCounters.at(gtx).OptoHybridStrobe = readReg(*regs.ohStrobe);
     if (mode&0x02)
-      m_ipBusCounters.at(gtx).OptoHybridAck    = readReg(getDeviceBaseNode(),toolbox::toString("COUNTERS.IPBus.Ack.OptoHybrid_%d",gtx));
+      m_ipBusCounters.at(gtx).OptoHybridAck    = readReg(*regs.ohAck);
     if (mode&0x04)
-      m_ipBusCounters.at(gtx).TrackingStrobe   = readReg(getDeviceBaseNode(),toolbox::toString("COUNTERS.IPBus.Strobe.OptoHybrid_%d",gtx));
+      m_ipBusCounters.at(gtx).TrackingStrobe   = readReg(*regs.ohStrobe);
     if (mode&0x08)
-      m_ipBusCounters.at(gtx).TrackingAck      = readReg(getDeviceBaseNode(),toolbox::toString("COUNTERS.IPBus.Ack.OptoHybrid_%d",gtx));
+      m_ipBusCounters.at(gtx).TrackingAck      = readReg(*regs.ohAck);
     if (mode&0x10)
-      m_ipBusCounters.at(gtx).CounterStrobe    = readReg(getDeviceBaseNode(),toolbox::toString("COUNTERS.IPBus.Strobe.Counters"));
+      m_ipBusCounters.at(gtx).CounterStrobe    = readReg(*regs.counterStrobe);
     if (mode&0x20)
-      m_ipBusCounters.at(gtx).CounterAck       = readReg(getDeviceBaseNode(),toolbox::toString("COUNTERS.IPBus.Ack.Counters"));
+      m_ipBusCounters.at(gtx).CounterAck       = readReg(*regs.counterAck);
   }
   return m_ipBusCounters.at(gtx);
 }
@@ -357,7 +392,7 @@ void gem::hw::HwGenericAMC::flushTriggerFIFO(uint8_t const& gtx)
   return;
 }
 
-/** obsolete in generic AMC firmware **
+/** tracking data FIFO **/
 uint32_t gem::hw::HwGenericAMC::getFIFOOccupancy(uint8_t const& gtx)
 {
   uint32_t fifocc = 0;
@@ -418,10 +453,8 @@ uint32_t gem::hw::HwGenericAMC::getTrackingData(uint8_t const& gtx, uint32_t* da
 
   std::stringstream regName;
   regName << getDeviceBaseNode() << ".TRK_DATA.OptoHybrid_" << (int)gtx << ".FIFO";
-  // best way to read a real block? make getTrackingData ask for N blocks?
-  // can we return the memory another way, rather than a vector?
-  // readBlock(regName.str(),7*nBlocks);
-  return nBlocks;
+  // number of complete VFAT blocks read
+  return readBlock(regName.str(),data,7*nBlocks)/7;
 }
 
 uint32_t gem::hw::HwGenericAMC::getTrackingData(uint8_t const& gtx, std::vector<toolbox::mem::Reference*>& data,
@@ -433,10 +466,7 @@ uint32_t gem::hw::HwGenericAMC::getTrackingData(uint8_t const& gtx, std::vector<
 
   std::stringstream regName;
   regName << getDeviceBaseNode() << ".TRK_DATA.OptoHybrid_" << (int)gtx << ".FIFO";
-  // best way to read a real block? make getTrackingData ask for N blocks?
-  // can we return the memory another way, rather than a vector?
-  // readBlock(regName.str(),7*nBlocks);
-  return nBlocks;
+  return readBlock(regName.str(),data,7*nBlocks)/7;
 }
 
 void gem::hw::HwGenericAMC::flushFIFO(uint8_t const& gtx)
@@ -455,7 +485,6 @@ void gem::hw::HwGenericAMC::flushFIFO(uint8_t const& gtx)
          << " Depth   0x" << std::hex << getFIFOOccupancy(gtx) << std::dec);
   }
 }
-**/
 
 /** DAQ link module functions **/
 void gem::hw::HwGenericAMC::enableDAQLink(uint32_t const& enableMask)
@@ -715,37 +744,22 @@ void gem::hw::HwGenericAMC::ttcMMCMPhaseShift(bool shiftOutOfLockFirst, bool use
   INFO("HwGenericAMC::ttcMMCMPhaseShift: starting phase shifting procedure");
   // writeReg(getDeviceBaseNode(), "TTC.CTRL.MMCM_PHASE_SHIFT", 0x1);
 
-  /*
-  // FIXME block these into one transaction, handicapped by CTP7
-  register_pair_list regList = {
-    {"GEM_AMC.TTC.CTRL.DISABLE_PHASE_ALIGNMENT",       0x1},
-    {"GEM_AMC.TTC.CTRL.PA_DISABLE_GTH_PHASE_TRACKING", 0x1},
-    {"GEM_AMC.TTC.CTRL.PA_MANUAL_OVERRIDE",            0x1},
-    {"GEM_AMC.TTC.CTRL.PA_MANUAL_SHIFT_DIR",           0x1},
-    {"GEM_AMC.TTC.CTRL.PA_GTH_MANUAL_OVERRIDE",        0x1},
-    {"GEM_AMC.TTC.CTRL.PA_GTH_MANUAL_SHIFT_DIR",       0x0},
-    {"GEM_AMC.TTC.CTRL.PA_GTH_MANUAL_SHIFT_STEP",      0x1},
-    {"GEM_AMC.TTC.CTRL.PA_GTH_MANUAL_SEL_OVERRIDE",    0x1},
-    {"GEM_AMC.TTC.CTRL.PA_GTH_MANUAL_COMBINED",        0x1},
-    {"GEM_AMC.TTC.CTRL.GTH_TXDLYBYPASS",               0x1},
-    {"GEM_AMC.TTC.CTRL.PA_MANUAL_PLL_RESET",           0x1},
-    {"GEM_AMC.TTC.CTRL.CNT_RESET",                     0x1}
-  };
-  writeRegs(regList);
-  */
-  // FIXME clean up with multiple dispatch
-  writeReg(getDeviceBaseNode(), "TTC.CTRL.DISABLE_PHASE_ALIGNMENT",       0x1);
-  writeReg(getDeviceBaseNode(), "TTC.CTRL.PA_DISABLE_GTH_PHASE_TRACKING", 0x1);
-  writeReg(getDeviceBaseNode(), "TTC.CTRL.PA_MANUAL_OVERRIDE",            0x1);
-  writeReg(getDeviceBaseNode(), "TTC.CTRL.PA_MANUAL_SHIFT_DIR",           0x1);
-  writeReg(getDeviceBaseNode(), "TTC.CTRL.PA_GTH_MANUAL_OVERRIDE",        0x1);
-  writeReg(getDeviceBaseNode(), "TTC.CTRL.PA_GTH_MANUAL_SHIFT_DIR",       0x0);
-  writeReg(getDeviceBaseNode(), "TTC.CTRL.PA_GTH_MANUAL_SHIFT_STEP",      0x1);
-  writeReg(getDeviceBaseNode(), "TTC.CTRL.PA_GTH_MANUAL_SEL_OVERRIDE",    0x1);
-  writeReg(getDeviceBaseNode(), "TTC.CTRL.PA_GTH_MANUAL_COMBINED",        0x1);
-  writeReg(getDeviceBaseNode(), "TTC.CTRL.GTH_TXDLYBYPASS",               0x1);
-  writeReg(getDeviceBaseNode(), "TTC.CTRL.PA_MANUAL_PLL_RESET",           0x1);
-  writeReg(getDeviceBaseNode(), "TTC.CTRL.CNT_RESET",                     0x1);
+  {
+    // one dispatch for the whole sequence
+    GEMHwTransaction batch(*this);
+    writeReg(getDeviceBaseNode(), "TTC.CTRL.DISABLE_PHASE_ALIGNMENT",       0x1);
+    writeReg(getDeviceBaseNode(), "TTC.CTRL.PA_DISABLE_GTH_PHASE_TRACKING", 0x1);
+    writeReg(getDeviceBaseNode(), "TTC.CTRL.PA_MANUAL_OVERRIDE",            0x1);
+    writeReg(getDeviceBaseNode(), "TTC.CTRL.PA_MANUAL_SHIFT_DIR",           0x1);
+    writeReg(getDeviceBaseNode(), "TTC.CTRL.PA_GTH_MANUAL_OVERRIDE",        0x1);
+    writeReg(getDeviceBaseNode(), "TTC.CTRL.PA_GTH_MANUAL_SHIFT_DIR",       0x0);
+    writeReg(getDeviceBaseNode(), "TTC.CTRL.PA_GTH_MANUAL_SHIFT_STEP",      0x1);
+    writeReg(getDeviceBaseNode(), "TTC.CTRL.PA_GTH_MANUAL_SEL_OVERRIDE",    0x1);
+    writeReg(getDeviceBaseNode(), "TTC.CTRL.PA_GTH_MANUAL_COMBINED",        0x1);
+    writeReg(getDeviceBaseNode(), "TTC.CTRL.GTH_TXDLYBYPASS",               0x1);
+    writeReg(getDeviceBaseNode(), "TTC.CTRL.PA_MANUAL_PLL_RESET",           0x1);
+    writeReg(getDeviceBaseNode(), "TTC.CTRL.CNT_RESET",                     0x1);
+  }
 
   // add readback of aforementioned registers
 
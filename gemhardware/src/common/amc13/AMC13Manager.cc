@@ -6,6 +6,8 @@
  * date:
  */
 
+#include <algorithm>
+
 #include "amc13/AMC13.hh"
 #include "amc13/Status.hh"
 
@@ -13,11 +15,16 @@
 #include "gem/hw/amc13/AMC13Manager.h"
 
 // #include "gem/hw/amc13/exception/Exception.h"
+#include "toolbox/task/WorkLoopFactory.h"
+
 #include "gem/utils/soap/GEMSOAPToolBox.h"
 #include "gem/utils/exception/Exception.h"
 
 XDAQ_INSTANTIATOR_IMPL(gem::hw::amc13::AMC13Manager);
 
+constexpr double gem::hw::amc13::AMC13Manager::MIN_SCAN_POLL_INTERVAL;
+constexpr double gem::hw::amc13::AMC13Manager::MAX_SCAN_POLL_INTERVAL;
+
 gem::hw::amc13::AMC13Manager::BGOInfo::BGOInfo()
 {
   channel  = -1;  // want this to somehow automatically get the position in the struct
@@ -169,8 +176,14 @@ gem::hw::amc13::AMC13Manager::AMC13Manager(xdaq::ApplicationStub* stub)
   xoap::bind(this, &gem::hw::amc13::AMC13Manager::disableTriggers, "disableTriggers",  XDAQ_NS_URI );
 
   p_timer = toolbox::task::getTimerFactory()->createTimer("AMC13ScanTriggerCounter");
-
-  m_updatedL1ACount = 0;
+  m_endScanPointSig = toolbox::task::bind(this, &AMC13Manager::sendEndScanPoint, "sendEndScanPoint");
+
+  m_updatedL1ACount  = 0;
+  m_scanBursts       = false;
+  m_scanPointDone    = true;
+  m_scanTriggersSent = 0;
+  m_scanLastSeen     = 0;
+  m_scanPollInterval = MIN_SCAN_POLL_INTERVAL;
 }
 
 gem::hw::amc13::AMC13Manager::~AMC13Manager() {
@@ -432,6 +445,11 @@ void gem::hw::amc13::AMC13Manager::startAction()
 {
   DEBUG("AMC13Manager::Entering AMC13Manager::startAction()");
   // gem::base::GEMFSMApplication::enable();
+  if (m_scanType.value_ == 2 || m_scanType.value_ == 3) {
+    // outside of the lock, stopping the timer waits for a running timeExpired
+    stopScanPointTimer();
+  }
+
   gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_amc13Lock);
 
   // reset the T1?
@@ -459,7 +477,9 @@ void gem::hw::amc13::AMC13Manager::startAction()
     p_amc13->sendBGO();
   }
 
-  if (m_enableLocalL1A) {
+  if (m_scanType.value_ == 2 || m_scanType.value_ == 3) {
+    // the triggers of each scan point are enabled and counted by startScanPoint
+  } else if (m_enableLocalL1A) {
     if (m_enableLEMO) {
       DEBUG("AMC13Manager::startAction enabling LEMO trigger " << m_enableLEMO);
       p_amc13->write(::amc13::AMC13::T1,"CONF.TTC.T3_TRIG",0x1);
@@ -475,7 +495,7 @@ void gem::hw::amc13::AMC13Manager::startAction()
   }
 
   if (m_scanType.value_ == 2 || m_scanType.value_ == 3) {
-    DEBUG("AMC13Manager::startAction Sending continuous triggers for ScanRoutines ");
+    DEBUG("AMC13Manager::startAction Sending triggers for ScanRoutines ");
     // p_amc13->enableLocalL1A(m_enableLocalL1A);
 
     // if (m_enableLocalL1A) {
@@ -488,16 +508,8 @@ void gem::hw::amc13::AMC13Manager::startAction()
     //   p_amc13->configureLocalL1A(m_enableLocalL1A, m_L1Amode, m_L1Aburst, m_internalPeriodicPeriod, m_L1Arules);
     // }
 
-    try {
-      p_timer->stop();
-    } catch (toolbox::task::exception::NotActive const& ex) {
-      WARN("AMC13Manager::start could not stop timer " << ex.what());
-    }
     p_timer->start();
-    toolbox::TimeInterval interval(0.1,0);  // period of 0.1 secs
-    toolbox::TimeVal start;
-    start = toolbox::TimeVal::gettimeofday();
-    p_timer->scheduleAtFixedRate(start, this, interval, 0, "" );
+    startScanPoint();
   }  // end scan type
   INFO("AMC13Manager::startAction end");
 }
@@ -508,6 +520,9 @@ void gem::hw::amc13::AMC13Manager::pauseAction()
   // if local triggers are enabled, do we have a separate trigger application?
   // we can just disable them here maybe?
   if (m_scanType.value_ == 2 || m_scanType.value_ == 3) {
+    // the timer keeps running, the supervisor pauses on the EndScanPoint of a check
+    DEBUG("AMC13Manager::pauseAction ending the scan point");
+    abortScanPoint();
     INFO("AMC13Manager::pauseAction disabling triggers for scan, triggers seen this point = "
 	 << p_amc13->read(::amc13::AMC13::T1,"STATUS.GENERAL.L1A_COUNT_LO") - m_updatedL1ACount);
     m_updatedL1ACount = p_amc13->read(::amc13::AMC13::T1,"STATUS.GENERAL.L1A_COUNT_LO");
@@ -562,7 +577,10 @@ void gem::hw::amc13::AMC13Manager::resumeAction()
       p_amc13->sendBGO();
   }
 
-  if (m_enableLocalL1A) {
+  if (m_scanType.value_ == 2 || m_scanType.value_ == 3) {
+    // the other applications have moved to the next point during the pause
+    startScanPoint();
+  } else if (m_enableLocalL1A) {
     p_amc13->configureLocalL1A(m_enableLocalL1A, m_L1Amode, m_L1Aburst, m_internalPeriodicPeriod, m_L1Arules);
     p_amc13->enableLocalL1A(m_enableLocalL1A);
 
@@ -601,13 +619,13 @@ void gem::hw::amc13::AMC13Manager::stopAction()
 {
   DEBUG("AMC13Manager::Entering AMC13Manager::stopAction()");
   // gem::base::GEMFSMApplication::disable();
-  gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_amc13Lock);
-
   if (m_scanType.value_ == 2 || m_scanType.value_ == 3) {
-    DEBUG("AMC13Manager::stopAction Sending continuous triggers for ScanRoutines ");
-    p_timer->stop();
+    DEBUG("AMC13Manager::stopAction stopping the scan point trigger counter");
+    stopScanPointTimer();
   }
 
+  gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_amc13Lock);
+
   if (m_enableLocalL1A) {
     // p_amc13->enableLocalL1A(false);
 
@@ -809,33 +827,115 @@ xoap::MessageReference gem::hw::amc13::AMC13Manager::disableTriggers(xoap::Messa
   XCEPT_RAISE(xoap::exception::Exception,"command not found");
 }
 
+void gem::hw::amc13::AMC13Manager::startScanPoint()
+{
+  gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_amc13Lock);
+
+  m_updatedL1ACount  = p_amc13->read(::amc13::AMC13::T1,"STATUS.GENERAL.L1A_COUNT_LO");
+  m_scanBursts       = m_enableLocalL1A && !m_enableLEMO;
+  m_scanPointDone    = false;
+  m_scanTriggersSent = 0;
+  m_scanLastSeen     = 0;
+  m_scanLastCheck    = std::chrono::steady_clock::now();
+  m_scanPollInterval = MIN_SCAN_POLL_INTERVAL;
+
+  if (m_scanBursts && m_nScanTriggers.value_ > 0) {
+    uint32_t const burst = std::min<uint64_t>(m_nScanTriggers.value_, MAX_L1A_BURST);
+    p_amc13->configureLocalL1A(true, m_L1Amode, burst, m_internalPeriodicPeriod, m_L1Arules);
+    p_amc13->enableLocalL1A(true);
+    p_amc13->sendL1ABurst();
+    m_scanTriggersSent = burst;
+  } else if (m_enableLocalL1A) {
+    p_amc13->write(::amc13::AMC13::T1,"CONF.TTC.T3_TRIG",0x1);
+  }
+  // external triggers are enabled upstream of the AMC13
+
+  INFO("AMC13Manager::startScanPoint NTriggerRequested = " << m_nScanTriggers.value_
+       << (m_scanBursts ? " as local L1A bursts" : " counted") << ", starting from " << m_updatedL1ACount);
+  scheduleScanPointCheck(m_scanPollInterval);
+}
+
+void gem::hw::amc13::AMC13Manager::scheduleScanPointCheck(double const& seconds)
+{
+  toolbox::TimeInterval delay(0, static_cast<long>(seconds*1000000));
+  toolbox::TimeVal start = toolbox::TimeVal::gettimeofday() + delay;
+  p_timer->schedule(this, start, 0, "");
+}
+
+void gem::hw::amc13::AMC13Manager::abortScanPoint()
+{
+  // a check already running sees the point as done once it has the lock, and neither
+  // ends the point nor schedules another check
+  gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_amc13Lock);
+  m_scanPointDone = true;
+}
+
+void gem::hw::amc13::AMC13Manager::stopScanPointTimer()
+{
+  abortScanPoint();
+
+  // outside of the lock, stopping the timer waits for a running timeExpired
+  try {
+    p_timer->stop();
+  } catch (toolbox::task::exception::NotActive const& ex) {
+    DEBUG("AMC13Manager::stopScanPointTimer timer not active " << ex.what());
+  }
+}
+
 void gem::hw::amc13::AMC13Manager::timeExpired(toolbox::task::TimerEvent& event)
 {
-  uint64_t currentTrigger = p_amc13->read(::amc13::AMC13::T1,"STATUS.GENERAL.L1A_COUNT_LO") - m_updatedL1ACount;
+  if (m_scanPointDone)
+    return;
 
-  DEBUG("AMC13Manager::timeExpried, NTriggerRequested = " << m_nScanTriggers.value_
-        << " currentT = " << currentTrigger << " triggercounter final =  " << m_updatedL1ACount );
+  uint64_t const requested = m_nScanTriggers.value_;
+  uint64_t currentTrigger  = 0;
+  bool pointDone = false;
+  {
+    gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_amc13Lock);
+    // stopped or paused since this check was scheduled
+    if (m_scanPointDone)
+      return;
+
+    // the counter is 32 bits wide, the difference is taken modulo 2^32 in case it wraps during the point
+    uint32_t const counter = p_amc13->read(::amc13::AMC13::T1,"STATUS.GENERAL.L1A_COUNT_LO");
+    currentTrigger = static_cast<uint32_t>(counter - static_cast<uint32_t>(m_updatedL1ACount));
+
+    DEBUG("AMC13Manager::timeExpired, NTriggerRequested = " << requested
+          << " currentT = " << currentTrigger << " sent = " << m_scanTriggersSent);
+
+    if (currentTrigger >= requested) {
+      // bursts stop by themselves, only the LEMO trigger has to be disabled
+      if (m_enableLocalL1A && m_enableLEMO)
+        p_amc13->write(::amc13::AMC13::T1,"CONF.TTC.T3_TRIG",0);
+      // external triggers should be stopped upstream of the AMC13
+      m_scanPointDone = true;
+      pointDone       = true;
+    } else if (m_scanBursts && currentTrigger >= m_scanTriggersSent) {
+      // the previous burst is complete, more than MAX_L1A_BURST triggers were requested
+      uint32_t const burst = std::min<uint64_t>(requested - m_scanTriggersSent, MAX_L1A_BURST);
+      p_amc13->configureLocalL1A(true, m_L1Amode, burst, m_internalPeriodicPeriod, m_L1Arules);
+      p_amc13->sendL1ABurst();
+      m_scanTriggersSent += burst;
+    }
 
-  if (currentTrigger >=  m_nScanTriggers.value_){
-    if (m_enableLocalL1A) {
-      if (m_enableLEMO) {
-	p_amc13->write(::amc13::AMC13::T1,"CONF.TTC.T3_TRIG",0);
-      } else {
-	p_amc13->stopContinuousL1A();
-      }
-    } else {
-      /*
-      // HACK
-      // when using external triggers, they should be stopped upstream of the AMC13 with a stop
-      // how do I hate thee? let me count the ways...
-      p_amc13->configureLocalL1A(true, m_L1Amode, m_L1Aburst, m_internalPeriodicPeriod, m_L1Arules);
-      p_amc13->enableLocalL1A(true);  // is this fine to switch to local L1A as a way to fake turning off upstream?
-      */
+    if (!pointDone) {
+      // the next check is aimed at the end of the point, from the trigger rate seen since the previous one,
+      // scheduled under the lock so that it cannot be scheduled after stopScanPointTimer
+      std::chrono::steady_clock::time_point const now = std::chrono::steady_clock::now();
+      double const elapsed = std::chrono::duration<double>(now - m_scanLastCheck).count();
+      if (currentTrigger > m_scanLastSeen && elapsed > 0)
+        m_scanPollInterval = (requested - currentTrigger)*elapsed/(currentTrigger - m_scanLastSeen);
+      else
+        m_scanPollInterval *= 2;
+      m_scanPollInterval = std::max(MIN_SCAN_POLL_INTERVAL, std::min(MAX_SCAN_POLL_INTERVAL, m_scanPollInterval));
+      m_scanLastSeen  = currentTrigger;
+      m_scanLastCheck = now;
+      scheduleScanPointCheck(m_scanPollInterval);
     }
-    INFO("AMC13Manager::timeExpried, triggers seen this point = "
-	 << p_amc13->read(::amc13::AMC13::T1,"STATUS.GENERAL.L1A_COUNT_LO") - m_updatedL1ACount);
-    // m_updatedL1ACount = p_amc13->read(::amc13::AMC13::T1,"STATUS.GENERAL.L1A_COUNT_LO");
-    // INFO("AMC13Manager::timeExpried, total triggers seen = " << m_updatedL1ACount);
+  }
+
+  if (pointDone) {
+    INFO("AMC13Manager::timeExpired, triggers seen this point = " << currentTrigger);
     endScanPoint();
   }
 }
@@ -843,7 +943,25 @@ void gem::hw::amc13::AMC13Manager::timeExpired(toolbox::task::TimerEvent& event)
 void gem::hw::amc13::AMC13Manager::endScanPoint()
 {
   INFO("AMC13Manager::endScanPoint");
-  gem::utils::soap::GEMSOAPToolBox::sendCommand("EndScanPoint",
-                                                p_appContext,p_appDescriptor,//getApplicationContext(),this->getApplicationDescriptor(),
-                                                const_cast<xdaq::ApplicationDescriptor*>(p_appZone->getApplicationDescriptor("gem::supervisor::GEMSupervisor", 0)));  // this should not be hard coded
+  try {
+    toolbox::task::WorkLoopFactory* wlf  = toolbox::task::WorkLoopFactory::getInstance();
+    toolbox::task::WorkLoop*        loop = wlf->getWorkLoop(workLoopName+":scan", "waiting");
+    if (!loop->isActive()) loop->activate();
+    loop->submit(m_endScanPointSig);
+  } catch (xcept::Exception& e) {
+    ERROR("AMC13Manager::endScanPoint unable to queue the EndScanPoint command: " << e.what());
+  }
+}
+
+bool gem::hw::amc13::AMC13Manager::sendEndScanPoint(toolbox::task::WorkLoop* wl)
+{
+  DEBUG("AMC13Manager::sendEndScanPoint");
+  try {
+    gem::utils::soap::GEMSOAPToolBox::sendCommand("EndScanPoint",
+                                                  p_appContext,p_appDescriptor,//getApplicationContext(),this->getApplicationDescriptor(),
+                                                  const_cast<xdaq::ApplicationDescriptor*>(p_appZone->getApplicationDescriptor("gem::supervisor::GEMSupervisor", 0)));  // this should not be hard coded
+  } catch (xcept::Exception& e) {
+    ERROR("AMC13Manager::sendEndScanPoint unable to send EndScanPoint: " << e.what());
+  }
+  return false;
 }
@@ -8,31 +8,61 @@
 #include "amc13/AMC13.hh"
 #include "amc13/Exception.hh"
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <unistd.h>
+
+#include "toolbox/mem/Buffer.h"
+
 #include <gem/hw/amc13/AMC13Readout.h>
 #include <gem/utils/soap/GEMSOAPToolBox.h>
 #include <gem/readout/exception/Exception.h>
 
 XDAQ_INSTANTIATOR_IMPL(gem::hw::amc13::AMC13Readout);
 
+// the memory in flight is bounded by the readout pool, not by the queue
+const uint32_t gem::hw::amc13::AMC13Readout::kQUEUESIZE = 1024;
+// 64 frames in the readout pool
+const uint32_t gem::hw::amc13::AMC13Readout::kFRAMESIZE = 256*1024;
+
 gem::hw::amc13::AMC13Readout::AMC13Readout(xdaq::ApplicationStub* stub)
   throw (xdaq::exception::Exception) :
   gem::readout::GEMReadoutApplication(stub),
   m_cardName("CardName"),
   m_crateID(0),
-  m_slot(0)
+  m_slot(0),
+  m_chunkSizeMB(512),
+  m_chunkSeconds(30),
+  m_chunkQueue(kQUEUESIZE),
+  p_frame(NULL),
+  m_writerExit(false),
+  m_writerDone(false),
+  m_running(false),
+  m_runIndex(0),
+  m_writerRunIndex(0),
+  m_chunkIndex(0),
+  m_chunkBytes(0)
 {
   DEBUG("AMC13Readout ctor begin");
   p_appInfoSpace->fireItemAvailable("CardName",       &m_cardName);
   p_appInfoSpace->fireItemAvailable("crateID",        &m_crateID );
   p_appInfoSpace->fireItemAvailable("slot",           &m_slot    );
+  p_appInfoSpace->fireItemAvailable("chunkSizeMB",    &m_chunkSizeMB );
+  p_appInfoSpace->fireItemAvailable("chunkSeconds",   &m_chunkSeconds);
 
   p_appInfoSpace->addItemRetrieveListener("CardName", this);
   p_appInfoSpace->addItemRetrieveListener("crateID",  this);
   p_appInfoSpace->addItemRetrieveListener("slot",     this);
+  p_appInfoSpace->addItemRetrieveListener("chunkSizeMB",  this);
+  p_appInfoSpace->addItemRetrieveListener("chunkSeconds", this);
 
   p_appInfoSpace->addItemChangedListener( "CardName", this);
   p_appInfoSpace->addItemChangedListener( "crateID",  this);
   p_appInfoSpace->addItemChangedListener( "slot",     this);
+  p_appInfoSpace->addItemChangedListener( "chunkSizeMB",  this);
+  p_appInfoSpace->addItemChangedListener( "chunkSeconds", this);
 
   DEBUG("AMC13Readout::AMC13Readout() "                        << std::endl
         << " m_cardName:"       << m_cardName.toString()       << std::endl
@@ -42,13 +72,26 @@ gem::hw::amc13::AMC13Readout::AMC13Readout(xdaq::ApplicationStub* stub)
         << " m_crateID:"        << m_crateID.toString()        << std::endl
         << " m_slot:"           << m_slot.toString()           << std::endl
         );
-  cnt = 0;
-  nwrote_global = 0;
   DEBUG("AMC13Readout ctor end");
 }
 
 gem::hw::amc13::AMC13Readout::~AMC13Readout()
 {
+  // the writer task closes the current chunk and returns, it must be gone before the members are
+  m_writerExit = true;
+  if (m_writerTask) {
+    std::unique_lock<std::mutex> lock(m_writerMutex);
+    m_writerFinished.wait(lock, [this]() { return m_writerDone; });
+  }
+
+  // frames the writer did not get to go back to the pool
+  while (!m_chunkQueue.empty()) {
+    m_chunkQueue.front().frame->release();
+    m_chunkQueue.pop();
+  }
+  if (p_frame)
+    p_frame->release();
+  closeChunk();
 }
 
 void gem::hw::amc13::AMC13Readout::actionPerformed(xdata::Event& event)
@@ -65,6 +108,8 @@ void gem::hw::amc13::AMC13Readout::actionPerformed(xdata::Event& event)
         << " m_eventsReadout:"  << m_eventsReadout.toString()  << std::endl
         << " m_crateID:"        << m_crateID.toString()        << std::endl
         << " m_slot:"           << m_slot.toString()           << std::endl
+        << " m_chunkSizeMB:"    << m_chunkSizeMB.toString()    << std::endl
+        << " m_chunkSeconds:"   << m_chunkSeconds.toString()   << std::endl
         );
   // update monitoring variables
   gem::readout::GEMReadoutApplication::actionPerformed(event);
@@ -105,6 +150,11 @@ void gem::hw::amc13::AMC13Readout::initializeAction()
   DEBUG("AMC13Readout::initializeAction connected");
 
   gem::readout::GEMReadoutApplication::initializeAction();
+
+  if (!m_writerTask) {
+    m_writerTask = std::make_shared<AMC13ChunkWriterTask>(this);
+    m_writerTask->activate();
+  }
 }
 
 void gem::hw::amc13::AMC13Readout::configureAction()
@@ -120,9 +170,13 @@ void gem::hw::amc13::AMC13Readout::startAction()
   throw (gem::hw::amc13::exception::Exception)
 {
   DEBUG("AMC13Readout::startAction begin");
-  cnt = 0;
-  nwrote_global = 0;
   gem::readout::GEMReadoutApplication::startAction();
+  {
+    std::lock_guard<std::mutex> guard(m_chunkMutex);
+    m_chunkBaseName = m_outFileName.substr(0,m_outFileName.length()-4);
+  }
+  ++m_runIndex;
+  m_running = true;
 }
 
 void gem::hw::amc13::AMC13Readout::pauseAction()
@@ -143,6 +197,7 @@ void gem::hw::amc13::AMC13Readout::stopAction()
   throw (gem::hw::amc13::exception::Exception)
 {
   DEBUG("AMC13Readout::stopAction begin");
+  m_running = false;
   gem::readout::GEMReadoutApplication::stopAction();
 }
 
@@ -150,6 +205,7 @@ void gem::hw::amc13::AMC13Readout::haltAction()
   throw (gem::hw::amc13::exception::Exception)
 {
   DEBUG("AMC13Readout::haltAction begin");
+  m_running = false;
   gem::readout::GEMReadoutApplication::haltAction();
 }
 
@@ -193,12 +249,10 @@ int gem::hw::amc13::AMC13Readout::dumpData()
   int rc;
   uint64_t* pEvt;
 
-  //FILE *fp;
-  //fp = fopen(m_outFileName.c_str(), "a");
   int nwrote = 0;
+  bool poolExhausted = false;
 
-  DEBUG("File for output open");
-  while (true) {
+  while (!poolExhausted) {
     DEBUG("Get number of events in the buffer");
     int nevt = 0;
     try {
@@ -220,58 +274,192 @@ int gem::hw::amc13::AMC13Readout::dumpData()
       XCEPT_RAISE(gem::hw::amc13::exception::ReadoutProblem,msg.str());
     }
     DEBUG("Trying to read " << std::dec << nevt << " events" << std::endl);
-    if (nevt) {
-      std::stringstream chunkfilename;
-      chunkfilename << m_outFileName.substr(0,m_outFileName.length()-4)
-                    << "_chunk_" << cnt << ".dat";
-      std::ofstream outf(chunkfilename.str().c_str(),std::ios_base::app | std::ios::binary);
-
-      for (int i = 0; i < nevt; i++) {
-        if ( (i % 100) == 0)
-          DEBUG("calling readEvent " << std::dec << i << "..." << std::endl);
-        try {
-          pEvt = p_amc13->readEvent(siz, rc);
-        } catch (amc13Exception const& e) {
-          std::stringstream msg;
-          msg << "AMC13Readout::readout error " << e.what();
-          ERROR(msg.str());
-          XCEPT_RAISE(gem::hw::amc13::exception::ReadoutProblem,msg.str());
-        } catch (std::exception const& e) {
-          std::stringstream msg;
-          msg << "AMC13Readout::readout error" << e.what();
-          ERROR(msg.str());
-          XCEPT_RAISE(gem::hw::amc13::exception::ReadoutProblem,msg.str());
-        } catch (...) {
-          std::stringstream msg;
-          msg << "AMC13Readout::readout error (unknown exception)";
-          ERROR(msg.str());
-          XCEPT_RAISE(gem::hw::amc13::exception::ReadoutProblem,msg.str());
-        }
-        if (rc == 0 && siz > 0 && pEvt != NULL) {
-          // fwrite(pEvt, sizeof(uint64_t), siz, fp);
-          outf.write((char*)pEvt, siz*sizeof(uint64_t));
-          ++nwrote;
-          ++nwrote_global;
-        } else {
-          DEBUG("No more events" << std::endl);
+    if (nevt == 0) {
+      DEBUG("Monitor buffer empty" << std::endl);
+      break;
+    }
+
+    for (int i = 0; i < nevt; i++) {
+      // only take an event out of the monitor buffer once there is a frame to put it in
+      if (!p_frame) {
+        p_frame = getFrame(kFRAMESIZE);
+        if (!p_frame) {
+          DEBUG("AMC13Readout::dumpData readout pool exhausted, leaving events in the monitor buffer");
+          poolExhausted = true;
           break;
         }
+        p_frame->setDataSize(0);
+      }
+
+      if ( (i % 100) == 0)
+        DEBUG("calling readEvent " << std::dec << i << "..." << std::endl);
+      metrics_clock::time_point const readStart = metrics_clock::now();
+      try {
+        pEvt = p_amc13->readEvent(siz, rc);
+      } catch (amc13Exception const& e) {
+        std::stringstream msg;
+        msg << "AMC13Readout::readout error " << e.what();
+        ERROR(msg.str());
+        XCEPT_RAISE(gem::hw::amc13::exception::ReadoutProblem,msg.str());
+      } catch (std::exception const& e) {
+        std::stringstream msg;
+        msg << "AMC13Readout::readout error" << e.what();
+        ERROR(msg.str());
+        XCEPT_RAISE(gem::hw::amc13::exception::ReadoutProblem,msg.str());
+      } catch (...) {
+        std::stringstream msg;
+        msg << "AMC13Readout::readout error (unknown exception)";
+        ERROR(msg.str());
+        XCEPT_RAISE(gem::hw::amc13::exception::ReadoutProblem,msg.str());
+      }
+      metrics_clock::time_point const readStop = metrics_clock::now();
+      m_readoutMetrics.recordStage(gem::readout::GEMReadoutMetrics::FIFO_DRAIN, readStart, readStop);
+      if (rc != 0 || siz == 0 || pEvt == NULL) {
+        DEBUG("No more events" << std::endl);
         if (pEvt)
           free(pEvt);
+        break;
       }
-      outf.close();
-      m_duration = ( std::clock() - m_start ) / (double) CLOCKS_PER_SEC;
-      if ((nwrote_global/10000 > cnt) || ((cnt > 0) && (m_duration > 30))) {
-        cnt++;
-        m_start = std::clock();
+
+      size_t const nBytes = siz*sizeof(uint64_t);
+      m_readoutMetrics.addBytesRead(nBytes);
+      if (p_frame->getDataSize() + nBytes > p_frame->getBuffer()->getSize()) {
+        queueFrame();
+        // the event is already out of the monitor buffer, wait for the writer to give frames back
+        size_t const frameSize = std::max(static_cast<size_t>(kFRAMESIZE), nBytes);
+        while (!(p_frame = getFrame(frameSize)) && !m_writerExit)
+          usleep(100);
+        if (!p_frame) {
+          WARN("AMC13Readout::dumpData no frame for an event of " << nBytes << " bytes, dropping it");
+          m_readoutMetrics.addEventsDropped(1);
+          free(pEvt);
+          continue;
+        }
+        p_frame->setDataSize(0);
       }
-    }
-    if (nevt == 0) {
-      DEBUG("Monitor buffer empty" << std::endl);
-      break;
+
+      {
+        gem::readout::GEMReadoutMetrics::ScopedStage packing(m_readoutMetrics,
+                                                             gem::readout::GEMReadoutMetrics::EVENT_BUILD);
+        if (p_frame->getDataSize() == 0)
+          m_frameReadTime = readStop;
+        char* location = static_cast<char*>(p_frame->getDataLocation()) + p_frame->getDataSize();
+        std::memcpy(location, pEvt, nBytes);
+        p_frame->setDataSize(p_frame->getDataSize() + nBytes);
+        free(pEvt);
+      }
+      ++nwrote;
     }
   }
-  DEBUG("Closing file" << std::endl);
-  // fclose(fp);
+
+  // hand the partially filled frame to the writer, so that low rates are not held back
+  queueFrame();
   return nwrote;
 }
+
+void gem::hw::amc13::AMC13Readout::queueFrame()
+{
+  if (!p_frame)
+    return;
+
+  if (p_frame->getDataSize() == 0) {
+    p_frame->release();
+  } else {
+    // single producer, the queue holds more frames than the pool so this only waits if the writer is gone
+    QueuedFrame const queued = {p_frame, m_frameReadTime};
+    while (!m_chunkQueue.push(&queued, 1) && !m_writerExit)
+      usleep(100);
+    m_readoutMetrics.recordQueueDepth(m_chunkQueue.size());
+  }
+  p_frame = NULL;
+}
+
+int gem::hw::amc13::AMC13Readout::writerTask()
+{
+  while (!m_writerExit) {
+    if (m_chunkQueue.empty()) {
+      // close the chunk once the run is over and everything has been written,
+      // or once it has been open for too long, the next frame starts a new chunk
+      if (m_chunkFile.is_open()) {
+        uint32_t const maxSeconds = m_chunkSeconds.value_;
+        if (!m_running ||
+            (maxSeconds && std::chrono::steady_clock::now() - m_chunkOpened > std::chrono::seconds(maxSeconds)))
+          closeChunk();
+      }
+      usleep(1000);
+      continue;
+    }
+
+    QueuedFrame const queued = m_chunkQueue.front();
+    m_chunkQueue.pop();
+    {
+      gem::readout::GEMReadoutMetrics::ScopedStage writing(m_readoutMetrics,
+                                                           gem::readout::GEMReadoutMetrics::WRITE);
+      writeFrame(queued.frame);
+    }
+    m_readoutMetrics.recordReadToWrite(queued.readTime);
+    m_readoutMetrics.addBytesWritten(queued.frame->getDataSize());
+    queued.frame->release();
+  }
+  closeChunk();
+
+  {
+    std::lock_guard<std::mutex> guard(m_writerMutex);
+    m_writerDone = true;
+  }
+  m_writerFinished.notify_all();
+  return 0;
+}
+
+void gem::hw::amc13::AMC13Readout::writeFrame(toolbox::mem::Reference* frame)
+{
+  if (m_chunkFile.is_open()) {
+    uint64_t const maxBytes   = 1024*1024*static_cast<uint64_t>(m_chunkSizeMB.value_);
+    uint32_t const maxSeconds = m_chunkSeconds.value_;
+    if (m_writerRunIndex != m_runIndex ||
+        (maxBytes && m_chunkBytes >= maxBytes) ||
+        (maxSeconds && std::chrono::steady_clock::now() - m_chunkOpened > std::chrono::seconds(maxSeconds)))
+      closeChunk();
+  }
+
+  if (!m_chunkFile.is_open())
+    openChunk();
+
+  m_chunkFile.write(static_cast<char const*>(frame->getDataLocation()), frame->getDataSize());
+  m_chunkBytes += frame->getDataSize();
+  if (!m_chunkFile.good())
+    ERROR("AMC13Readout::writeFrame error writing " << frame->getDataSize() << " bytes to chunk " << m_chunkIndex);
+}
+
+void gem::hw::amc13::AMC13Readout::openChunk()
+{
+  std::string baseName;
+  {
+    std::lock_guard<std::mutex> guard(m_chunkMutex);
+    baseName = m_chunkBaseName;
+  }
+  if (m_writerRunIndex != m_runIndex) {
+    m_writerRunIndex = m_runIndex;
+    m_chunkIndex     = 0;
+  }
+
+  std::stringstream chunkfilename;
+  chunkfilename << baseName << "_chunk_" << m_chunkIndex << ".dat";
+  m_chunkFile.clear();
+  m_chunkFile.open(chunkfilename.str().c_str(), std::ios_base::app | std::ios::binary);
+  if (!m_chunkFile.is_open())
+    ERROR("AMC13Readout::openChunk unable to open " << chunkfilename.str());
+  else
+    DEBUG("AMC13Readout::openChunk opened " << chunkfilename.str());
+  m_chunkBytes  = 0;
+  m_chunkOpened = std::chrono::steady_clock::now();
+}
+
+void gem::hw::amc13::AMC13Readout::closeChunk()
+{
+  if (!m_chunkFile.is_open())
+    return;
+  m_chunkFile.close();
+  DEBUG("AMC13Readout::closeChunk closed chunk " << m_chunkIndex << " after " << m_chunkBytes << " bytes");
+  ++m_chunkIndex;
+}
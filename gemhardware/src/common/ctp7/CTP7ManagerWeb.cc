@@ -194,13 +194,16 @@ void gem::hw::ctp7::CTP7ManagerWeb::jsonUpdate(xgi::Input* in, xgi::Output* out)
   throw (xgi::exception::Exception)
 {
   DEBUG("CTP7ManagerWeb::jsonUpdate");
+  uint32_t const since    = jsonSince(in);
+  // taken before the items are refreshed, the changes seen while writing are sent again next time
+  uint32_t const sequence = gem::base::GEMMonitor::jsonSequence();
   out->getHTTPResponseHeader().addHeader("Content-Type", "application/json");
   *out << " { " << std::endl;
   for (unsigned int i = 0; i < gem::base::GEMFSMApplication::MAX_AMCS_PER_CRATE; ++i) {
     *out << "\"ctp7" << std::setw(2) << std::setfill('0') << (i+1) << "\"  : { " << std::endl;
     auto card = dynamic_cast<gem::hw::ctp7::CTP7Manager*>(p_gemFSMApp)->m_ctp7Monitors[i];
     if (card) {
-      card->jsonUpdateItemSets(out);
+      card->jsonUpdateItemSets(out, since);
     }
     // can't have a trailing comma for the last entry...
     if (i == (gem::base::GEMFSMApplication::MAX_AMCS_PER_CRATE-1))
@@ -208,6 +211,7 @@ void gem::hw::ctp7::CTP7ManagerWeb::jsonUpdate(xgi::Input* in, xgi::Output* out)
     else
       *out << " }," << std::endl;
   }
+  *out << ",\"sequence\" : " << sequence << std::endl;
   *out << " } " << std::endl;
 }
 
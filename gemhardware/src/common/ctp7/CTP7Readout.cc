@@ -14,6 +14,7 @@
 #include <boost/utility/binary.hpp>
 #include <bitset>
 
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
@@ -27,6 +28,10 @@ XDAQ_INSTANTIATOR_IMPL(gem::hw::ctp7::CTP7Readout);
 
 const uint32_t gem::hw::ctp7::CTP7Readout::kUPDATE  = 5000;
 const uint32_t gem::hw::ctp7::CTP7Readout::kUPDATE7 = 7;
+// the memory in flight is bounded by the readout pool, not by the queue
+const uint32_t gem::hw::ctp7::CTP7Readout::kQUEUESIZE = 1024;
+// 28kB frames
+const uint32_t gem::hw::ctp7::CTP7Readout::kFRAMEBLOCKS = 1024;
 
 gem::hw::ctp7::CTP7Readout::CTP7Readout(xdaq::ApplicationStub* stub) :
   GEMReadoutApplication(stub),
@@ -35,8 +40,11 @@ gem::hw::ctp7::CTP7Readout::CTP7Readout(xdaq::ApplicationStub* stub) :
   m_ESexp(-1),
   m_isFirst(true),
   m_contvfats(0),
-  m_queueLock(toolbox::BSem::FULL, true)
+  m_dataque(kQUEUESIZE),
+  m_batchIndex(0),
+  m_queuedWords(0)
 {
+  m_batch.reserve(kFRAMEBLOCKS);
   xoap::bind(this,&CTP7Readout::updateScanParameters,"UpdateScanParameter","urn:CTP7Readout-soap:1");
   //xoap::bind(this,&CTP7Readout::queueDepth,          "QueueDepth",         "urn:CTP7Readout-soap:1");
   p_appInfoSpace->fireItemAvailable("QueueDepth", &m_queueDepth);
@@ -45,6 +53,7 @@ gem::hw::ctp7::CTP7Readout::CTP7Readout(xdaq::ApplicationStub* stub) :
 gem::hw::ctp7::CTP7Readout::~CTP7Readout()
 {
   DEBUG("CTP7Readout::destructor called");
+  releaseFrames();
 }
 
 void gem::hw::ctp7::CTP7Readout::actionPerformed(xdata::Event& event)
@@ -74,6 +83,7 @@ void gem::hw::ctp7::CTP7Readout::initializeAction()
     XCEPT_RAISE(gem::hw::ctp7::exception::Exception, "initializeAction failed");
   }
   DEBUG("CTP7Readout::initializeAction connected");
+  createReadoutPool();
 }
 
 
@@ -90,12 +100,22 @@ void gem::hw::ctp7::CTP7Readout::configureAction()
   m_vfat = 0;
   m_event = 0;
   m_sumVFAT = 0;
+  releaseFrames();
 }
 
 void gem::hw::ctp7::CTP7Readout::startAction()
   throw (gem::hw::ctp7::exception::Exception)
 {
   INFO("CTP7Readout::startAction begin");
+  try {
+    p_dataWriter = createEventWriter();
+    p_dataWriter->open(m_outFileName);
+    p_errWriter  = createEventWriter();
+    p_errWriter->open(m_errFileName);
+  } catch (gem::readout::exception::Exception const& ex) {
+    ERROR("CTP7Readout::startAction caught exception " << ex.what());
+    XCEPT_RAISE(gem::hw::ctp7::exception::Exception, "startAction failed");
+  }
 }
 
 void gem::hw::ctp7::CTP7Readout::pauseAction()
@@ -114,12 +134,20 @@ void gem::hw::ctp7::CTP7Readout::stopAction()
   throw (gem::hw::ctp7::exception::Exception)
 {
   INFO("CTP7Readout::stopAction begin");
+  if (p_dataWriter)
+    p_dataWriter->close();
+  if (p_errWriter)
+    p_errWriter->close();
 }
 
 void gem::hw::ctp7::CTP7Readout::haltAction()
   throw (gem::hw::ctp7::exception::Exception)
 {
   INFO("CTP7Readout::haltAction begin");
+  if (p_dataWriter)
+    p_dataWriter->close();
+  if (p_errWriter)
+    p_errWriter->close();
 }
 
 void gem::hw::ctp7::CTP7Readout::resetAction()
@@ -153,29 +181,40 @@ uint32_t* gem::hw::ctp7::CTP7Readout::getCTP7Data(uint8_t const& gtx, uint32_t c
         << p_ctp7->getFIFOOccupancy(gtx)
         );
   while ( p_ctp7->getFIFOVFATBlockOccupancy(gtx) ) {
+    // each read goes straight into a pool frame, which is decoded in place by the event builder
+    if (m_dataque.available() == 0) {
+      DEBUG(" ::getCTP7Data data queue full (" << m_dataque.size() << " frames), leaving data in the FIFO");
+      break;
+    }
+    uint32_t nBlocks = std::min(p_ctp7->getFIFOVFATBlockOccupancy(gtx), kFRAMEBLOCKS);
+    toolbox::mem::Reference* frame = getFrame(nBlocks*kUPDATE7*sizeof(uint32_t));
+    if (!frame) {
+      // bounded memory, the rest stay in the hardware FIFO until the event builder releases frames
+      DEBUG(" ::getCTP7Data readout pool exhausted, leaving data in the FIFO");
+      break;
+    }
     DEBUG("CTP7Readout::getCTP7Data initiating call to getTrackingData(gtx,"
-          << p_ctp7->getFIFOVFATBlockOccupancy(gtx) << ")");
-    std::vector<uint32_t> data = p_ctp7->getTrackingData(gtx, p_ctp7->getFIFOVFATBlockOccupancy(gtx));
+          << nBlocks << ")");
+    uint32_t nRead = p_ctp7->getTrackingData(gtx, static_cast<uint32_t*>(frame->getDataLocation()), nBlocks);
     DEBUG("CTP7Readout::getCTP7Data"
           << std::endl << "FIFO VFAT block depth 0x" << std::hex
           << p_ctp7->getFIFOVFATBlockOccupancy(gtx)
           << std::endl << "FIFO depth 0x" << std::hex
           << p_ctp7->getFIFOOccupancy(gtx)
           );
-
-    uint32_t contqueue = 0;
-    for (auto iword = data.begin(); iword != data.end(); ++iword) {
-      contqueue++;
-      //gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_queueLock);
-      DEBUG(" ::getCTP7Data pushing into queue 0x"
-            << std::setfill('0') << std::setw(8) << std::hex << *iword << std::dec );
-      m_dataque.push(*iword);
-      if (contqueue%kUPDATE7 == 0 &&  contqueue != 0) {
-        m_contvfats++;
-        DEBUG(" ::getCTP7Data counter " << contqueue << " contvfats " << m_contvfats
-              << " m_dataque.size " << m_dataque.size());
-      }
+    if (nRead == 0) {
+      WARN(" ::getCTP7Data no data read from the FIFO, " << nBlocks << " blocks expected");
+      frame->release();
+      break;
     }
+
+    frame->setDataSize(nRead*kUPDATE7*sizeof(uint32_t));
+    // single producer, the space was checked above
+    m_queuedWords += nRead*kUPDATE7;
+    m_dataque.push(&frame, 1);
+    m_contvfats += nRead;
+    DEBUG(" ::getCTP7Data pushed " << nRead << " blocks, contvfats " << m_contvfats
+          << " queued words " << m_queuedWords.load());
     DEBUG(" ::getCTP7Data end of while loop do we go again?" << std::endl
           << " FIFO VFAT block occupancy  0x" << std::hex << p_ctp7->getFIFOVFATBlockOccupancy(gtx)
           << std::endl
@@ -216,24 +255,19 @@ uint32_t* gem::hw::ctp7::CTP7Readout::GEMEventMaker(uint32_t counter[5])
   //int islot = -1;
 
   // Booking FIFO variables
-  uint64_t msVFAT, lsVFAT;
   uint32_t ES;
 
   DEBUG("CTP7Readout::GEMEventMaker  " << std::hex << point );
-  if (m_dataque.empty()) return point;
-  DEBUG(" ::GEMEventMaker m_dataque.size " << m_dataque.size() );
-
-  this->readVFATblock(m_dataque);
-
-  uint64_t data1  = dat10 | dat11;
-  uint64_t data2  = dat20 | dat21;
-  uint64_t data3  = dat30 | dat31;
-  uint64_t data4  = dat40 | dat41;
+  if (!this->readVFATblock(vfat)) return point;
 
   m_vfat++;
 
   //islot = slotInfo->GEBslotIndex( (uint32_t)chipid);
 
+  uint16_t const evn    = gem::readout::GEMVFATDecoder::evn(vfat.EC);
+  uint16_t const bcn    = gem::readout::GEMVFATDecoder::bcn(vfat.BC);
+  uint16_t const chipid = gem::readout::GEMVFATDecoder::chipID(vfat.ChipID);
+
   // GEM Event selector
   ES = ( evn << 12 ) | bcn;
   DEBUG(" ::GEMEventMaker ES 0x" << std::hex << ES << " evn 0x"<< evn
@@ -243,17 +277,6 @@ uint32_t* gem::hw::ctp7::CTP7Readout::GEMEventMaker(uint32_t counter[5])
         //" slot number " << islot <<
         " m_isFirst " << m_isFirst << " event " << m_event);
 
-  lsVFAT = (data3 << 32) | (data4);
-  msVFAT = (data1 << 32) | (data2);
-
-  vfat.BC     = ( b1010 << 12 ) | (bcn);                // 1010     | bcn:12
-  vfat.EC     = ( b1100 << 12 ) | (evn << 4) | (flags); // 1100     | EC:8      | Flag:4
-  vfat.ChipID = ( b1110 << 12 ) | (chipid);             // 1110     | ChipID:12
-  vfat.lsData = lsVFAT;                                 // lsData:64
-  vfat.msData = msVFAT;                                 // msData:64
-  vfat.BXfrOH = BX;                                     // BXfrOH:32
-  vfat.crc    = vfatcrc;                                // crc:16
-
   if ( ES == m_ESexp ) {
     m_isFirst = false;
   } else {
@@ -281,7 +304,7 @@ uint32_t* gem::hw::ctp7::CTP7Readout::GEMEventMaker(uint32_t counter[5])
   DEBUG(" ::GEMEventMaker m_event " << m_event << " m_vfats.size " << m_vfats.size() << std::hex << " ES 0x" << ES << std::dec );
   //}//end of event selection
 
-  m_queueDepth = m_dataque.size();
+  m_queueDepth = m_queuedWords.load();
   p_appInfoSpace->fireItemValueRetrieve("QueueDepth");
   p_appInfoSpace->fireItemValueChanged("QueueDepth");
 
@@ -333,7 +356,7 @@ void gem::hw::ctp7::CTP7Readout::GEMevSelector(const  uint32_t& ES)
           // GEM Event Writing
           DEBUG(" ::GEMEventMaker writing...  geb.vfats.size " << int(geb.vfats.size()) );
           TypeDataFlag = "PayLoad";
-          if(int(geb.vfats.size()) != 0) writeGEMevent(m_outFileName, false, TypeDataFlag,
+          if(int(geb.vfats.size()) != 0) writeGEMevent(*p_dataWriter, false, TypeDataFlag,
                                                        gem, geb, vfat);
           // update online histograms
 	  //          p_gemOnlineDQM->Update(geb);
@@ -369,7 +392,7 @@ void gem::hw::ctp7::CTP7Readout::GEMevSelector(const  uint32_t& ES)
         GEMfillTrailers(gem, geb);
         // GEM ERRORS Event Writing
         TypeDataFlag = "Errors";
-        if(int(geb.vfats.size()) != 0) writeGEMevent(m_errFileName, false, TypeDataFlag,
+        if(int(geb.vfats.size()) != 0) writeGEMevent(*p_errWriter, false, TypeDataFlag,
                                                      gem, geb, vfat);
         geb.vfats.clear();
       }// if localErr
@@ -419,7 +442,7 @@ bool gem::hw::ctp7::CTP7Readout::VFATfillData(/*int const& islot, */AMCGEBData&
 }// end VFATfillData
 
 
-void gem::hw::ctp7::CTP7Readout::writeGEMevent(std::string  outFile, bool const&  OKprint,
+void gem::hw::ctp7::CTP7Readout::writeGEMevent(gem::readout::GEMEventWriter& writer, bool const&  OKprint,
                                                std::string const& TypeDataFlag,
                                                AMCGEMData&  gem, AMCGEBData&  geb, AMCVFATData& vfat)
 {
@@ -427,49 +450,9 @@ void gem::hw::ctp7::CTP7Readout::writeGEMevent(std::string  outFile, bool const&
     DEBUG(" ::writeGEMevent m_vfat " << m_vfat << " event " << m_event << " sumVFAT " << (0x000000000fffffff & geb.header) <<
           " geb.vfats.size " << int(geb.vfats.size()) );
   }
-  // GEM Chamber's Data
-  if (m_outputType == "Hex") {
-    gem::readout::GEMDataAMCformat::writeGEMhd1 (outFile, m_event, gem);
-    gem::readout::GEMDataAMCformat::writeGEMhd2 (outFile, m_event, gem);
-    gem::readout::GEMDataAMCformat::writeGEMhd3 (outFile, m_event, gem);
-  } else {
-    gem::readout::GEMDataAMCformat::writeGEMhd1Binary (outFile, m_event, gem);
-    gem::readout::GEMDataAMCformat::writeGEMhd2Binary (outFile, m_event, gem);
-    gem::readout::GEMDataAMCformat::writeGEMhd3Binary (outFile, m_event, gem);
-  }
-  //  GEB Headers Data
-  if (m_outputType == "Hex") {
-    gem::readout::GEMDataAMCformat::writeGEBheader (outFile, m_event, geb);
-    gem::readout::GEMDataAMCformat::writeGEBrunhed (outFile, m_event, geb);
-  } else {
-    gem::readout::GEMDataAMCformat::writeGEBheaderBinary (outFile, m_event, geb);
-    //gem::readout::GEMDataAMCformat::writeGEBrunhedBinary (outFile, m_event, geb);
-  } // gem::readout::GEMDataAMCformat::printGEBheader (m_event, geb);
-  //  GEB PayLoad Data
-  int nChip=0;
-  for (auto iVFAT=geb.vfats.begin(); iVFAT != geb.vfats.end(); ++iVFAT) {
-    nChip++;
-
-    if (m_outputType == "Hex") {
-      gem::readout::GEMDataAMCformat::writeVFATdata (outFile, nChip, *iVFAT);
-    } else {
-      gem::readout::GEMDataAMCformat::writeVFATdataBinary (outFile, nChip, *iVFAT);
-    };
-  }//end of GEB PayLoad Data
-  //  GEB Trailers Data
-  if (m_outputType == "Hex") {
-    gem::readout::GEMDataAMCformat::writeGEBtrailer (outFile, m_event, geb);
-  } else {
-    gem::readout::GEMDataAMCformat::writeGEBtrailerBinary (outFile, m_event, geb);
-  }
-  //  GEM Trailers Data
-  if (m_outputType == "Hex") {
-    gem::readout::GEMDataAMCformat::writeGEMtr2 (outFile, m_event, gem);
-    gem::readout::GEMDataAMCformat::writeGEMtr1 (outFile, m_event, gem);
-  } else {
-    gem::readout::GEMDataAMCformat::writeGEMtr2Binary (outFile, m_event, gem);
-    gem::readout::GEMDataAMCformat::writeGEMtr1Binary (outFile, m_event, gem);
-  }
+  // whole event is serialized into the writer buffer, file is kept open for the run
+  if (!writer.writeGEMevent(gem, geb))
+    WARN(" ::writeGEMevent " << TypeDataFlag << " output file is not open, dropping event " << m_event);
 }
 
 void gem::hw::ctp7::CTP7Readout::GEMfillHeaders(uint32_t const& event, uint32_t const& DAVCount_,
@@ -571,69 +554,47 @@ void gem::hw::ctp7::CTP7Readout::GEMfillTrailers(AMCGEMData&  gem,AMCGEBData&  g
   DEBUG(" OHcrc 0x" << std::hex << OHcrc << " OHwCount " << OHwCount << " ChamStatus " << ChamStatus << std::dec);
 }
 
-void gem::hw::ctp7::CTP7Readout::readVFATblock(std::queue<uint32_t>& dataque)
+bool gem::hw::ctp7::CTP7Readout::readVFATblock(AMCVFATData& vfat)
 {
-  uint32_t datafront = 0;
-  for (int iQue = 0; iQue < 7; iQue++){
-    datafront = dataque.front();
-    DEBUG(" ::GEMEventMaker iQue " << iQue << " 0x"
-          << std::setfill('0') << std::setw(8) << std::hex << datafront << std::dec );
-    //this never seems to get reset? maybe iQue%7 to read the words after the first block?
-    if ((iQue%7) == 5 ) {
-      dat41   = ((0xffff0000 & datafront) >> 16 );
-      vfatcrc = (0x0000ffff & datafront);
-    } else if ( (iQue%7) == 4 ) {
-      dat40   = ((0x0000ffff & datafront) << 16 );
-      dat31   = ((0xffff0000 & datafront) >> 16 );
-    } else if ( (iQue%7) == 3 ) {
-      dat21   = ((0xffff0000 & datafront) >> 16 );
-      dat30   = ((0x0000ffff & datafront) << 16 );
-    } else if ( (iQue%7) == 2 ) {
-      dat11   = ((0xffff0000 & datafront) >> 16 );
-      dat20   = ((0x0000ffff & datafront) << 16 );
-    } else if ( (iQue%7) == 1 ) {
-      b1110   = ((0xf0000000 & datafront) >> 28 );
-      chipid  = ((0x0fff0000 & datafront) >> 16 );
-      dat10   = ((0x0000ffff & datafront) << 16 );
-    } else if ( (iQue%7) == 0 ) {
-      b1010   = ((0xf0000000 & datafront) >> 28 );
-      b1100   = ((0x0000f000 & datafront) >> 12 );
-      bcn     = ((0x0fff0000 & datafront) >> 16 );
-      evn     = ((0x00000ff0 & datafront) >>  4 );
-      flags   = (0x0000000f & datafront);
-
-      if (!(b1010 == 0xa && b1100 == 0xc)) {
-        bool misAligned_ = true;
-        while ((misAligned_) && (dataque.size()>7)){
-          /* we have a misaligned word, increment misalignment counter, pop queue,
-             push bad value into some form of storage for later analysis?
-             then continue with the loop, but without incrementing iQue so we hopefully
-             eventually align again
-
-             Do not go through all the loop with condition statements
-             since iQue stays the same and we removed 7 blocks
-             -MD
-          */
-          INFO(" ::GEMEventMaker found misaligned word 0x"
-               << std::setfill('0') << std::hex << datafront << std::dec
-               << " queue m_dataque.size " << dataque.size() );
-          dataque.pop();
-          datafront = dataque.front();
-          b1010   = ((0xf0000000 & datafront) >> 28 );
-          b1100   = ((0x0000f000 & datafront) >> 12 );
-          bcn     = ((0x0fff0000 & datafront) >> 16 );
-          evn     = ((0x00000ff0 & datafront) >>  4 );
-          flags   = (0x0000000f & datafront);
-          if ((b1010 == 0xa && b1100 == 0xc)) { misAligned_ = false;}
-        }// end of while misaligned
-      }
-    } else if ( (iQue%7) == 6 ) {
-      BX      = datafront;
+  while (m_batchIndex >= m_batch.size()) {
+    if (m_dataque.empty())
+      return false;
+
+    // the whole frame is decoded in one pass, so it can go back to the pool straight away
+    toolbox::mem::Reference* frame = m_dataque.front();
+    m_dataque.pop();
+    size_t const nWords = frame->getDataSize()/sizeof(uint32_t);
+    size_t nSkipped = 0;
+    m_batch.clear();
+    m_batchIndex = 0;
+    gem::readout::GEMVFATDecoder::decodeBuffer(static_cast<uint32_t const*>(frame->getDataLocation()),
+                                               nWords, m_batch, nSkipped);
+    frame->release();
+
+    if (nSkipped > 0) {
+      /* we have misaligned words, increment misalignment counter,
+         push bad values into some form of storage for later analysis?
+      */
+      INFO(" ::GEMEventMaker dropped " << nSkipped << " misaligned words out of " << nWords);
+      m_queuedWords -= nSkipped;
     }
-    DEBUG(" ::GEMEventMaker (pre pop) m_dataque.size " << dataque.size() );
-    dataque.pop();
-    DEBUG(" ::GEMEventMaker (post pop)  m_dataque.size " << dataque.size() );
-  }// end queue
+  }
+
+  m_batch.get(m_batchIndex++, vfat);
+  m_queuedWords -= kUPDATE7;
+  DEBUG(" ::GEMEventMaker (post pop) queued words " << m_queuedWords.load() );
+  return true;
+}
+
+void gem::hw::ctp7::CTP7Readout::releaseFrames()
+{
+  while (!m_dataque.empty()) {
+    m_dataque.front()->release();
+    m_dataque.pop();
+  }
+  m_batch.clear();
+  m_batchIndex  = 0;
+  m_queuedWords = 0;
 }
 
 
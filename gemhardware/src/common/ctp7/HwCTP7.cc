@@ -97,6 +97,7 @@ gem::hw::ctp7::HwCTP7::HwCTP7(const int& crate, const int& slot) :
   // p_gemConnectionManager.reset(new uhal::ConnectionManager("file://../data/connections_ch.xml"));
   INFO("getting HwInterface " << getDeviceID() << " pointer from ConnectionManager");
   p_gemHW.reset(new uhal::HwInterface(p_gemConnectionManager->getDevice(this->getDeviceID())));
+  clearRegisterHandles();
   INFO("setting the device base node");
   setDeviceBaseNode("CTP7");
   // gem::hw::ctp7::HwCTP7::initDevice();
@@ -136,6 +137,7 @@ bool gem::hw::ctp7::HwCTP7::isHwConnected()
         b_links[gtx] = true;
         DEBUG("gtx" << gtx << " present(" << this->getFirmwareVer() << ")");
         tmp_activeLinks.push_back(std::make_pair(gtx,this->LinkStatus(gtx)));
+        this->trackingRegisters(gtx);
       } else {
         b_links[gtx] = false;
         INFO("gtx" << gtx << " not reachable (unable to find 2 or 5 or 201 in the firmware string, "
@@ -530,11 +532,9 @@ uint32_t gem::hw::ctp7::HwCTP7::getFIFOOccupancy(uint8_t const& gtx)
 {
   uint32_t fifocc = 0;
   if (linkCheck(gtx, "FIFO occupancy")) {
-    std::stringstream regName;
-    regName << "TRK_DATA.OptoHybrid_" << (int)gtx;
-    fifocc = readReg(getDeviceBaseNode(),regName.str()+".DEPTH");
-    DEBUG(toolbox::toString("getFIFOOccupancy(%d) %s.%s%s:: %d", gtx, getDeviceBaseNode().c_str(),
-                            regName.str().c_str(), ".DEPTH", fifocc));
+    RegisterHandle const& depth = *trackingRegisters(gtx).depth;
+    fifocc = readReg(depth);
+    DEBUG(toolbox::toString("getFIFOOccupancy(%d) %s:: %d", gtx, depth.name.c_str(), fifocc));
   }
   // the fifo occupancy is in number of 32 bit words
   return fifocc;
@@ -550,9 +550,7 @@ bool gem::hw::ctp7::HwCTP7::hasTrackingData(uint8_t const& gtx)
 {
   bool hasData = false;
   if (linkCheck(gtx, "Tracking data")) {
-    std::stringstream regName;
-    regName << "TRK_DATA.OptoHybrid_" << (int)gtx << ".ISEMPTY";
-    hasData = !readReg(getDeviceBaseNode(),regName.str());
+    hasData = !readReg(*trackingRegisters(gtx).isEmpty);
   }
   // if the FIFO is fragmented, this will return true but we won't read a full block
   // what to do in this case?
@@ -567,11 +565,11 @@ std::vector<uint32_t> gem::hw::ctp7::HwCTP7::getTrackingData(uint8_t const& gtx,
     return data;
   }
 
-  std::stringstream regName;
-  regName << getDeviceBaseNode() << ".TRK_DATA.OptoHybrid_" << (int)gtx << ".FIFO";
   // best way to read a real block? make getTrackingData ask for N blocks?
   // can we return the memory another way, rather than a vector?
-  return readBlock(regName.str(),7*nBlocks);
+  std::vector<uint32_t> data(7*nBlocks,0x0);
+  data.resize(readBlock(*trackingRegisters(gtx).fifo,data.data(),data.size()));
+  return data;
 }
 
 uint32_t gem::hw::ctp7::HwCTP7::getTrackingData(uint8_t const& gtx, uint32_t* data, size_t const& nBlocks)
@@ -584,12 +582,7 @@ uint32_t gem::hw::ctp7::HwCTP7::getTrackingData(uint8_t const& gtx, uint32_t* da
     return 0;
   }
 
-  std::stringstream regName;
-  regName << getDeviceBaseNode() << ".TRK_DATA.OptoHybrid_" << (int)gtx << ".FIFO";
-  // best way to read a real block? make getTrackingData ask for N blocks?
-  // can we return the memory another way, rather than a vector?
-  // readBlock(regName.str(),7*nBlocks);
-  return nBlocks;
+  return readBlock(*trackingRegisters(gtx).fifo,data,7*nBlocks)/7;
 }
 
 uint32_t gem::hw::ctp7::HwCTP7::getTrackingData(uint8_t const& gtx, std::vector<toolbox::mem::Reference*>& data,
@@ -599,12 +592,35 @@ uint32_t gem::hw::ctp7::HwCTP7::getTrackingData(uint8_t const& gtx, std::vector<
     return 0;
   }
 
-  std::stringstream regName;
-  regName << getDeviceBaseNode() << ".TRK_DATA.OptoHybrid_" << (int)gtx << ".FIFO";
-  // best way to read a real block? make getTrackingData ask for N blocks?
-  // can we return the memory another way, rather than a vector?
-  // readBlock(regName.str(),7*nBlocks);
-  return nBlocks;
+  return readBlock(*trackingRegisters(gtx).fifo,data,7*nBlocks)/7;
+}
+
+gem::hw::ctp7::HwCTP7::TrackingFIFORegisters const& gem::hw::ctp7::HwCTP7::trackingRegisters(uint8_t const& gtx)
+{
+  if (gtx >= N_GTX) {
+    std::string msg = toolbox::toString("Tracking FIFO requested for gtx (%d): outside expectation (0-%d)",
+                                        gtx, N_GTX-1);
+    ERROR(msg);
+    XCEPT_RAISE(gem::hw::ctp7::exception::InvalidLink,msg);
+  }
+
+  TrackingFIFORegisters& regs = m_trackingRegisters[gtx];
+  if (!regs.resolved) {
+    std::string const fifoName = toolbox::toString("TRK_DATA.OptoHybrid_%d", gtx);
+    regs.depth   = &getRegisterHandle(getDeviceBaseNode(),fifoName+".DEPTH");
+    regs.isEmpty = &getRegisterHandle(getDeviceBaseNode(),fifoName+".ISEMPTY");
+    regs.fifo    = &getRegisterHandle(getDeviceBaseNode(),fifoName+".FIFO");
+    regs.resolved = true;
+  }
+  return regs;
+}
+
+void gem::hw::ctp7::HwCTP7::clearRegisterHandles()
+{
+  gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_hwLock);
+  for (unsigned gtx = 0; gtx < N_GTX; ++gtx)
+    m_trackingRegisters[gtx] = TrackingFIFORegisters();
+  gem::hw::HwGenericAMC::clearRegisterHandles();
 }
 
 void gem::hw::ctp7::HwCTP7::flushFIFO(uint8_t const& gtx)
@@ -0,0 +1,594 @@
+/**
+ * class: GEMHwEmulatorModel
+ * description: Register space and firmware behaviour of an emulated AMC, OptoHybrid and VFAT2 stack
+ */
+
+#include "gem/hw/emulator/GEMHwEmulatorModel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+
+#include "uhal/uhal.hpp"
+
+#include "gem/datachecker/GEMDataChecker.h"
+
+namespace {
+  const uint32_t BX_PER_ORBIT = 3564;
+  const uint64_t NS_PER_BX    = 25;
+
+  const char* const T1_SIGNALS[] = {"L1A", "CalPulse", "Resync", "BC0"};
+  const char* const T1_SOURCES[] = {"GTX_TTC", "INTERNAL", "EXTERNAL", "LOOPBACK", "SENT", "GBT_TTC"};
+
+  bool endsWith(std::string const& path, std::string const& suffix)
+  {
+    return path.size() >= suffix.size() && path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+  }
+
+  /**
+   * @returns the number at the end of name, e.g., 3 for GEM_AMC.OH.OH3, -1 if there is none
+   */
+  int trailingNumber(std::string const& name)
+  {
+    size_t const pos = name.find_last_not_of("0123456789");
+    if (pos == std::string::npos || pos + 1 == name.size())
+      return -1;
+    return std::atoi(name.c_str() + pos + 1);
+  }
+
+  std::string vfatName(uint32_t const& vfat)
+  {
+    std::stringstream name;
+    name << "VFAT" << vfat;
+    return name.str();
+  }
+}
+
+const uint32_t gem::hw::emulator::GEMHwEmulatorModel::N_VFATS;
+const uint32_t gem::hw::emulator::GEMHwEmulatorModel::BLOCK_WORDS;
+
+gem::hw::emulator::GEMHwEmulatorModel::Config::Config() :
+  vfatsPerOH(24),
+  l1aRate(0.),
+  fifoDepth(7*8192),
+  scanPointTime(0),
+  occupancyBits(4),
+  seed(0x5eed)
+{
+}
+
+gem::hw::emulator::GEMHwEmulatorModel::TrackingFIFO::TrackingFIFO() :
+  dropped(0)
+{
+}
+
+gem::hw::emulator::GEMHwEmulatorModel::ScanModule::ScanModule() :
+  end(Clock::now())
+{
+}
+
+gem::hw::emulator::GEMHwEmulatorModel::T1Generator::T1Generator() :
+  running(false),
+  start(Clock::now()),
+  type(0),
+  number(0),
+  interval(1),
+  sent(0)
+{
+}
+
+gem::hw::emulator::GEMHwEmulatorModel::OptoHybrid::OptoHybrid() :
+  index(0),
+  externalL1As(0),
+  eventCounter(0)
+{
+  chipIDs.fill(0);
+}
+
+gem::hw::emulator::GEMHwEmulatorModel::GEMHwEmulatorModel(Config const& config, log4cplus::Logger const& logger) :
+  m_gemLogger(logger),
+  m_config(config),
+  m_startTime(Clock::now()),
+  m_random(config.seed ? config.seed : 1)
+{
+  m_config.vfatsPerOH = std::min(m_config.vfatsPerOH, N_VFATS);
+}
+
+void gem::hw::emulator::GEMHwEmulatorModel::addAddressTable(std::string const& addressTable)
+{
+  // the interface is only used to parse the table, it never sends a packet
+  uhal::HwInterface hw = uhal::ConnectionManager::getDevice("gemHwEmulator", "ipbusudp-2.0://127.0.0.1:50001",
+                                                             addressTable);
+  uhal::Node const& top = hw.getNode();
+  size_t const before = m_nodes.size();
+  for (uhal::Node::const_iterator node = top.begin(); node != top.end(); ++node) {
+    if (node->getPath().empty())
+      continue;
+    addNode(node->getPath(), node->getAddress(), node->getMask(), node->getMode() == uhal::defs::NON_INCREMENTAL);
+  }
+  INFO("GEMHwEmulatorModel::addAddressTable " << addressTable << ": " << m_nodes.size() - before << " registers");
+  bind();
+}
+
+void gem::hw::emulator::GEMHwEmulatorModel::addNode(std::string const& path, uint32_t const& address,
+                                                    uint32_t const& mask, bool const& port)
+{
+  Node reg = {address, mask ? mask : 0xffffffff, port};
+  if (m_nodes.insert(std::make_pair(path, reg)).second)
+    m_unbound.push_back(path);
+}
+
+void gem::hw::emulator::GEMHwEmulatorModel::bind()
+{
+  for (auto path = m_unbound.begin(); path != m_unbound.end(); ++path) {
+    std::string const& name = *path;
+    if (endsWith(name, ".GEB.Broadcast.Mask") || endsWith(name, ".T1Controller.TOGGLE")) {
+      std::string const prefix = name.substr(0, name.find(endsWith(name, ".GEB.Broadcast.Mask") ?
+                                                          ".GEB.Broadcast.Mask" : ".T1Controller.TOGGLE"));
+      bool known = false;
+      for (auto oh = m_optohybrids.begin(); oh != m_optohybrids.end(); ++oh)
+        known |= oh->second->prefix == prefix;
+      if (!known) {
+        int const index = trailingNumber(prefix);
+        bindOptoHybrid(prefix, index >= 0 ? index : m_optohybrids.size());
+      }
+    } else if (endsWith(name, ".FIFO") && name.find(".TRK_DATA.OptoHybrid_") != std::string::npos) {
+      std::string const prefix = name.substr(0, name.size() - 5);
+      int const index = trailingNumber(prefix);
+      if (index >= 0)
+        bindTrackingFIFO(prefix, index);
+    }
+  }
+  m_unbound.clear();
+  INFO("GEMHwEmulatorModel::bind " << m_nodes.size() << " registers, "
+       << m_optohybrids.size() << " OptoHybrids, " << m_fifos.size() << " tracking data FIFOs");
+}
+
+gem::hw::emulator::GEMHwEmulatorModel::Node const*
+gem::hw::emulator::GEMHwEmulatorModel::node(std::string const& path) const
+{
+  auto reg = m_nodes.find(path);
+  return reg == m_nodes.end() ? NULL : &reg->second;
+}
+
+uint32_t gem::hw::emulator::GEMHwEmulatorModel::getField(std::string const& path) const
+{
+  Node const* reg = node(path);
+  if (!reg)
+    return 0;
+  auto word = m_memory.find(reg->address);
+  if (word == m_memory.end())
+    return 0;
+  return (word->second & reg->mask) >> __builtin_ctz(reg->mask);
+}
+
+void gem::hw::emulator::GEMHwEmulatorModel::setField(std::string const& path, uint32_t const& value)
+{
+  Node const* reg = node(path);
+  if (!reg)
+    return;
+  uint32_t& word = m_memory[reg->address];
+  word = (word & ~reg->mask) | ((value << __builtin_ctz(reg->mask)) & reg->mask);
+}
+
+void gem::hw::emulator::GEMHwEmulatorModel::onRead(std::string const& path, Hook const& hook)
+{
+  if (Node const* reg = node(path))
+    m_readHooks[reg->address].push_back(hook);
+}
+
+void gem::hw::emulator::GEMHwEmulatorModel::onWrite(std::string const& path, Hook const& hook)
+{
+  if (Node const* reg = node(path))
+    m_writeHooks[reg->address].push_back(hook);
+}
+
+void gem::hw::emulator::GEMHwEmulatorModel::onPortRead(std::string const& path,
+                                                       std::function<uint32_t()> const& source)
+{
+  if (Node const* reg = node(path))
+    m_ports[reg->address] = source;
+}
+
+void gem::hw::emulator::GEMHwEmulatorModel::bindOptoHybrid(std::string const& prefix, uint32_t const& index)
+{
+  std::shared_ptr<OptoHybrid> oh = std::make_shared<OptoHybrid>();
+  oh->prefix = prefix;
+  oh->index  = index;
+  m_optohybrids[index] = oh;
+  OptoHybrid& ohRef = *oh;
+
+  // chip IDs that do not collide between OptoHybrids, readable through the VFAT registers
+  for (uint32_t vfat = 0; vfat < N_VFATS; ++vfat) {
+    oh->chipIDs[vfat] = ((index << 5) | vfat) & 0xfff;
+    std::string const base = prefix + ".GEB.VFATS." + vfatName(vfat);
+    setField(base + ".ChipID0", oh->chipIDs[vfat] & 0xff);
+    setField(base + ".ChipID1", oh->chipIDs[vfat] >> 8);
+  }
+
+  // GEB broadcast, a read of a request register reads the register of all selected VFATs,
+  // a write writes it, the transaction completes immediately
+  std::string const request = prefix + ".GEB.Broadcast.Request.";
+  for (auto reg = m_nodes.lower_bound(request);
+       reg != m_nodes.end() && reg->first.compare(0, request.size(), request) == 0; ++reg) {
+    std::string const name = reg->first.substr(request.size());
+    onRead(reg->first,  [this, &ohRef, name]() { broadcast(ohRef, name, false); });
+    onWrite(reg->first, [this, &ohRef, name]() { broadcast(ohRef, name, true);  });
+  }
+  std::string const reset = prefix + ".GEB.Broadcast.Reset";
+  onWrite(reset, [this, &ohRef, reset]() {
+      if (!getField(reset))
+        return;
+      ohRef.broadcastResults.clear();
+      setField(reset, 0);
+    });
+  setField(prefix + ".GEB.Broadcast.Running", 0);
+  onPortRead(prefix + ".GEB.Broadcast.Results", [&ohRef]() {
+      if (ohRef.broadcastResults.empty())
+        return static_cast<uint32_t>(0);
+      uint32_t const result = ohRef.broadcastResults.front();
+      ohRef.broadcastResults.pop_front();
+      return result;
+    });
+
+  bindScanModule(ohRef, ohRef.thlat, prefix + ".ScanController.THLAT", false);
+  bindScanModule(ohRef, ohRef.ultra, prefix + ".ScanController.ULTRA", true);
+
+  // T1 generator
+  std::string const t1 = prefix + ".T1Controller";
+  onWrite(t1 + ".TOGGLE", [this, &ohRef, t1]() {
+      if (!getField(t1 + ".TOGGLE"))
+        return;
+      setField(t1 + ".TOGGLE", 0);
+      update(ohRef);
+      T1Generator& gen = ohRef.t1;
+      if (gen.running) {
+        gen.running = false;
+        return;
+      }
+      gen          = T1Generator();
+      gen.running  = true;
+      // only the single signal mode is emulated, the sequence modes send L1As
+      gen.type     = getField(t1 + ".MODE") == 0 ? getField(t1 + ".TYPE") & 0x3 : 0;
+      gen.number   = getField(t1 + ".NUMBER");
+      gen.interval = std::max(getField(t1 + ".INTERVAL"), static_cast<uint32_t>(1));
+      DEBUG("GEMHwEmulatorModel T1 generator of " << ohRef.prefix << " started, type " << gen.type
+            << ", " << gen.number << " signals every " << gen.interval << " BX");
+    });
+  onWrite(t1 + ".RESET", [this, &ohRef, t1]() {
+      if (!getField(t1 + ".RESET"))
+        return;
+      setField(t1 + ".RESET", 0);
+      ohRef.t1 = T1Generator();
+    });
+  onRead(t1 + ".MONITOR", [this, &ohRef, t1]() {
+      update(ohRef);
+      setField(t1 + ".MONITOR", ohRef.t1.running);
+    });
+
+  for (size_t source = 0; source < sizeof(T1_SOURCES)/sizeof(T1_SOURCES[0]); ++source) {
+    for (size_t signal = 0; signal < sizeof(T1_SIGNALS)/sizeof(T1_SIGNALS[0]); ++signal) {
+      std::string const counter = prefix + ".COUNTERS.T1." + T1_SOURCES[source] + "." + T1_SIGNALS[signal];
+      onRead(counter, [this, &ohRef]() { update(ohRef); });
+      onWrite(counter + ".Reset", [this, counter]() {
+          if (!getField(counter + ".Reset"))
+            return;
+          setField(counter + ".Reset", 0);
+          setField(counter, 0);
+        });
+    }
+  }
+
+  DEBUG("GEMHwEmulatorModel::bindOptoHybrid " << prefix << " as OptoHybrid " << index);
+}
+
+void gem::hw::emulator::GEMHwEmulatorModel::bindTrackingFIFO(std::string const& prefix, uint32_t const& index)
+{
+  std::shared_ptr<TrackingFIFO> fifo = std::make_shared<TrackingFIFO>();
+  m_fifos[index] = fifo;
+  TrackingFIFO& fifoRef = *fifo;
+
+  // the FIFO is filled with the L1As of the OptoHybrid with the same index, if any
+  auto refresh = [this, index, prefix, &fifoRef]() {
+    auto oh = m_optohybrids.find(index);
+    if (oh != m_optohybrids.end())
+      update(*oh->second);
+    setField(prefix + ".DEPTH",   fifoRef.words.size());
+    setField(prefix + ".ISEMPTY", fifoRef.words.empty());
+    setField(prefix + ".ISFULL",  fifoRef.words.size() + BLOCK_WORDS > m_config.fifoDepth);
+  };
+  onRead(prefix + ".DEPTH",   refresh);
+  onRead(prefix + ".ISEMPTY", refresh);
+  onRead(prefix + ".ISFULL",  refresh);
+  onRead(prefix + ".FIFO",    refresh);
+  onWrite(prefix + ".FLUSH", [this, prefix, &fifoRef]() {
+      if (!getField(prefix + ".FLUSH"))
+        return;
+      setField(prefix + ".FLUSH", 0);
+      fifoRef.words.clear();
+    });
+  onPortRead(prefix + ".FIFO", [&fifoRef]() {
+      if (fifoRef.words.empty())
+        return static_cast<uint32_t>(0);
+      uint32_t const word = fifoRef.words.front();
+      fifoRef.words.pop_front();
+      return word;
+    });
+
+  DEBUG("GEMHwEmulatorModel::bindTrackingFIFO " << prefix << " for OptoHybrid " << index);
+}
+
+void gem::hw::emulator::GEMHwEmulatorModel::bindScanModule(OptoHybrid& oh, ScanModule& scan,
+                                                           std::string const& base, bool const& ultra)
+{
+  onWrite(base + ".START", [this, &oh, &scan, base, ultra]() {
+      if (!getField(base + ".START"))
+        return;
+      setField(base + ".START", 0);
+      startScan(oh, scan, base, ultra);
+    });
+  onWrite(base + ".RESET", [this, &scan, base]() {
+      if (!getField(base + ".RESET"))
+        return;
+      setField(base + ".RESET", 0);
+      scan = ScanModule();
+    });
+  onRead(base + ".MONITOR.STATUS", [this, &scan, base]() {
+      setField(base + ".MONITOR.STATUS", Clock::now() < scan.end);
+    });
+
+  auto pop = [](std::deque<uint32_t>& results) {
+    if (results.empty())
+      return static_cast<uint32_t>(0);
+    uint32_t const result = results.front();
+    results.pop_front();
+    return result;
+  };
+  if (ultra) {
+    for (uint32_t vfat = 0; vfat < N_VFATS; ++vfat)
+      onPortRead(base + ".RESULTS." + vfatName(vfat), [&scan, vfat, pop]() { return pop(scan.vfatResults[vfat]); });
+  } else {
+    onPortRead(base + ".RESULTS", [&scan, pop]() { return pop(scan.results); });
+  }
+}
+
+void gem::hw::emulator::GEMHwEmulatorModel::broadcast(OptoHybrid& oh, std::string const& name, bool const& write)
+{
+  uint32_t const mask  = getField(oh.prefix + ".GEB.Broadcast.Mask");
+  uint32_t const value = getField(oh.prefix + ".GEB.Broadcast.Request." + name) & 0xff;
+  for (uint32_t vfat = 0; vfat < N_VFATS; ++vfat) {
+    if ((mask >> vfat) & 0x1)
+      continue;
+    if (vfat >= m_config.vfatsPerOH) {
+      // no chip in the slot, the transaction is flagged as not valid
+      oh.broadcastResults.push_back((0x3 << 16) | (vfat << 8));
+      continue;
+    }
+    std::string const reg = oh.prefix + ".GEB.VFATS." + vfatName(vfat) + "." + name;
+    if (write)
+      setField(reg, value);
+    oh.broadcastResults.push_back((vfat << 8) | (getField(reg) & 0xff));
+  }
+}
+
+void gem::hw::emulator::GEMHwEmulatorModel::startScan(OptoHybrid& oh, ScanModule& scan,
+                                                      std::string const& base, bool const& ultra)
+{
+  uint32_t const mode      = getField(base + ".CONF.MODE");
+  uint32_t const min       = getField(base + ".CONF.MIN");
+  uint32_t const max       = getField(base + ".CONF.MAX");
+  uint32_t const step      = std::max(getField(base + ".CONF.STEP"), static_cast<uint32_t>(1));
+  uint32_t const nTriggers = getField(base + ".CONF.NTRIGS");
+  uint32_t const channel   = getField(base + ".CONF.CHAN");
+  uint32_t const vfatMask  = ultra ? getField(base + ".CONF.MASK") : ~(0x1u << (getField(base + ".CONF.CHIP") & 0x1f));
+
+  scan = ScanModule();
+  uint32_t nPoints = 0;
+  for (uint32_t value = min; value <= max && value <= 0xff; value += step, ++nPoints) {
+    for (uint32_t vfat = 0; vfat < N_VFATS; ++vfat) {
+      if ((vfatMask >> vfat) & 0x1)
+        continue;
+      uint32_t const count = vfat < m_config.vfatsPerOH ? scanCount(mode, vfat, channel, value, nTriggers) : 0;
+      uint32_t const word  = (value << 24) | (count & 0xffffff);
+      if (ultra)
+        scan.vfatResults[vfat].push_back(word);
+      else
+        scan.results.push_back(word);
+    }
+  }
+  scan.end = Clock::now() + std::chrono::microseconds(static_cast<uint64_t>(nPoints)*m_config.scanPointTime);
+  DEBUG("GEMHwEmulatorModel::startScan " << base << " mode " << mode << ", " << nPoints << " points");
+}
+
+uint32_t gem::hw::emulator::GEMHwEmulatorModel::scanCount(uint32_t const& mode, uint32_t const& vfat,
+                                                          uint32_t const& channel, uint32_t const& value,
+                                                          uint32_t const& nTriggers) const
+{
+  // smooth, chip dependent curves, enough to exercise the analysis of the results
+  double fraction = 0.5;
+  switch (mode) {
+  case 0:  // threshold, trigger data
+  case 1:  // threshold, tracking data of one channel
+    fraction = 1./(1. + std::exp((static_cast<double>(value) - (40. + vfat))/4.));
+    break;
+  case 2:  // latency, the signal arrives in two consecutive BX
+    fraction = (value == 12 || value == 13) ? 1. : 0.02;
+    break;
+  case 3:  // S-curve of one channel
+    fraction = 1./(1. + std::exp(-(static_cast<double>(value) - (100. + channel%16))/3.));
+    break;
+  default:
+    break;
+  }
+  return static_cast<uint32_t>(std::lround(fraction*nTriggers));
+}
+
+void gem::hw::emulator::GEMHwEmulatorModel::update(OptoHybrid& oh)
+{
+  Clock::time_point const now = Clock::now();
+
+  T1Generator& gen = oh.t1;
+  if (gen.running) {
+    uint64_t const bx  = std::chrono::duration_cast<std::chrono::nanoseconds>(now - gen.start).count()/NS_PER_BX;
+    uint64_t       due = bx/gen.interval + 1;
+    if (gen.number && due >= gen.number) {
+      due         = gen.number;
+      gen.running = false;
+    }
+    if (due > gen.sent) {
+      sendT1(oh, gen.type, "INTERNAL", due - gen.sent);
+      gen.sent = due;
+    }
+  }
+
+  if (m_config.l1aRate > 0) {
+    double const seconds = std::chrono::duration<double>(now - m_startTime).count();
+    uint64_t const due   = static_cast<uint64_t>(seconds*m_config.l1aRate);
+    if (due > oh.externalL1As) {
+      sendT1(oh, 0, "GTX_TTC", due - oh.externalL1As);
+      oh.externalL1As = due;
+    }
+  }
+}
+
+void gem::hw::emulator::GEMHwEmulatorModel::sendT1(OptoHybrid& oh, uint32_t const& type,
+                                                   std::string const& source, uint64_t const& n)
+{
+  std::string const counter = oh.prefix + ".COUNTERS.T1." + source + "." + T1_SIGNALS[type];
+  setField(counter, getField(counter) + n);
+  if (source == "INTERNAL") {
+    std::string const sent = oh.prefix + ".COUNTERS.T1.SENT." + T1_SIGNALS[type];
+    setField(sent, getField(sent) + n);
+  }
+
+  if (type != 0 || m_config.vfatsPerOH == 0)
+    return;
+  auto fifo = m_fifos.find(oh.index);
+  if (fifo == m_fifos.end()) {
+    oh.eventCounter += n;
+    return;
+  }
+
+  // each L1A is read out from all VFATs, the events that do not fit in the FIFO are lost
+  TrackingFIFO& words = *fifo->second;
+  uint64_t const eventWords = BLOCK_WORDS*m_config.vfatsPerOH;
+  uint64_t const room   = words.words.size() < m_config.fifoDepth ?
+    (m_config.fifoDepth - words.words.size())/eventWords : 0;
+  uint64_t const pushed = std::min(n, room);
+  uint32_t const bx     = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    Clock::now() - m_startTime).count()/NS_PER_BX;
+  for (uint64_t event = 0; event < pushed; ++event)
+    pushEvent(oh, (bx + event) % BX_PER_ORBIT);
+  oh.eventCounter += n - pushed;
+
+  if (pushed < n) {
+    if (words.dropped == 0)
+      WARN("GEMHwEmulatorModel tracking data FIFO " << oh.index << " is full, dropping events");
+    words.dropped += (n - pushed)*m_config.vfatsPerOH;
+  }
+}
+
+void gem::hw::emulator::GEMHwEmulatorModel::pushEvent(OptoHybrid& oh, uint32_t const& bx)
+{
+  std::deque<uint32_t>& words = m_fifos[oh.index]->words;
+  uint32_t const ec = oh.eventCounter++ & 0xff;
+  for (uint32_t vfat = 0; vfat < m_config.vfatsPerOH; ++vfat) {
+    gem::readout::GEMDataAMCformat::VFATData block;
+    block.BC     = 0xa000 | (bx & 0xfff);
+    block.EC     = 0xc000 | (ec << 4);
+    block.ChipID = 0xe000 | oh.chipIDs[vfat];
+    block.msData = randomHits();
+    block.lsData = randomHits();
+    block.BXfrOH = bx;
+    block.crc    = gem::datachecker::GEMDataChecker::checkCRC(block);
+
+    // same layout as decoded by gem::readout::GEMVFATDecoder
+    words.push_back((static_cast<uint32_t>(block.BC) << 16) | block.EC);
+    words.push_back((static_cast<uint32_t>(block.ChipID) << 16) | static_cast<uint32_t>(block.msData >> 48));
+    words.push_back(static_cast<uint32_t>(block.msData >> 16));
+    words.push_back(static_cast<uint32_t>(block.msData << 16) | static_cast<uint32_t>(block.lsData >> 48));
+    words.push_back(static_cast<uint32_t>(block.lsData >> 16));
+    words.push_back(static_cast<uint32_t>(block.lsData << 16) | block.crc);
+    words.push_back(block.BXfrOH);
+  }
+}
+
+uint64_t gem::hw::emulator::GEMHwEmulatorModel::randomHits()
+{
+  if (m_config.occupancyBits == 0)
+    return 0;
+
+  // xorshift64*, each extra AND halves the probability of a channel to fire
+  uint64_t hits = ~0ull;
+  for (uint32_t i = 0; i < m_config.occupancyBits; ++i) {
+    m_random ^= m_random >> 12;
+    m_random ^= m_random << 25;
+    m_random ^= m_random >> 27;
+    hits &= m_random*0x2545f4914f6cdd1dull;
+  }
+  return hits;
+}
+
+uint32_t gem::hw::emulator::GEMHwEmulatorModel::read(uint32_t const& address)
+{
+  auto hooks = m_readHooks.find(address);
+  if (hooks != m_readHooks.end())
+    for (auto hook = hooks->second.begin(); hook != hooks->second.end(); ++hook)
+      (*hook)();
+  auto word = m_memory.find(address);
+  return word == m_memory.end() ? 0 : word->second;
+}
+
+void gem::hw::emulator::GEMHwEmulatorModel::write(uint32_t const& address, uint32_t const& value)
+{
+  m_memory[address] = value;
+  auto hooks = m_writeHooks.find(address);
+  if (hooks != m_writeHooks.end())
+    for (auto hook = hooks->second.begin(); hook != hooks->second.end(); ++hook)
+      (*hook)();
+}
+
+void gem::hw::emulator::GEMHwEmulatorModel::readBlock(uint32_t const& address, uint32_t const& nWords,
+                                                      bool const& incremental, uint32_t* values)
+{
+  if (incremental) {
+    for (uint32_t i = 0; i < nWords; ++i)
+      values[i] = read(address + i);
+    return;
+  }
+
+  auto port = m_ports.find(address);
+  if (port == m_ports.end()) {
+    uint32_t const value = read(address);
+    std::fill(values, values + nWords, value);
+    return;
+  }
+  // the read hooks bring the port up to date once for the whole block
+  read(address);
+  for (uint32_t i = 0; i < nWords; ++i)
+    values[i] = port->second();
+}
+
+void gem::hw::emulator::GEMHwEmulatorModel::writeBlock(uint32_t const& address, uint32_t const& nWords,
+                                                       bool const& incremental, uint32_t const* values)
+{
+  for (uint32_t i = 0; i < nWords; ++i)
+    write(incremental ? address + i : address, values[i]);
+}
+
+uint32_t gem::hw::emulator::GEMHwEmulatorModel::readModifyWriteBits(uint32_t const& address,
+                                                                    uint32_t const& andTerm,
+                                                                    uint32_t const& orTerm)
+{
+  uint32_t const value = read(address);
+  write(address, (value & andTerm) | orTerm);
+  return value;
+}
+
+uint32_t gem::hw::emulator::GEMHwEmulatorModel::readModifyWriteSum(uint32_t const& address, uint32_t const& addend)
+{
+  uint32_t const value = read(address);
+  write(address, value + addend);
+  return value;
+}
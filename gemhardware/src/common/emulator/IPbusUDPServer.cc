@@ -0,0 +1,297 @@
+/**
+ * class: IPbusUDPServer
+ * description: IPbus 2.0 over UDP target for the hardware emulator
+ */
+
+#include "gem/hw/emulator/IPbusUDPServer.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include "toolbox/string.h"
+
+#include "gem/hw/exception/Exception.h"
+
+namespace {
+  const uint32_t IPBUS_VERSION = 2;
+
+  // packet types
+  const uint32_t CONTROL_PACKET = 0x0;
+  const uint32_t STATUS_PACKET  = 0x1;
+  const uint32_t RESEND_PACKET  = 0x2;
+
+  // transaction types
+  const uint32_t READ             = 0x0;
+  const uint32_t WRITE            = 0x1;
+  const uint32_t NI_READ          = 0x2;
+  const uint32_t NI_WRITE         = 0x3;
+  const uint32_t RMW_BITS         = 0x4;
+  const uint32_t RMW_SUM          = 0x5;
+  const uint32_t CONFIG_READ      = 0x6;
+  const uint32_t CONFIG_WRITE     = 0x7;
+
+  // transaction info codes
+  const uint32_t INFO_SUCCESS     = 0x0;
+  const uint32_t INFO_BAD_HEADER  = 0x1;
+  const uint32_t INFO_REQUEST     = 0xf;
+
+  bool isPacketHeader(uint32_t const& word)
+  {
+    return (word >> 28) == IPBUS_VERSION && ((word >> 4) & 0xf) == 0xf;
+  }
+}
+
+const uint32_t gem::hw::emulator::IPbusUDPServer::MTU_BYTES;
+const uint32_t gem::hw::emulator::IPbusUDPServer::N_REPLY_BUFFERS;
+
+gem::hw::emulator::IPbusUDPServer::Latency::Latency() :
+  packet(0),
+  transaction(0),
+  word(0)
+{
+}
+
+gem::hw::emulator::IPbusUDPServer::IPbusUDPServer(GEMHwEmulatorModel& model, uint16_t const& port,
+                                                  Latency const& latency, log4cplus::Logger const& logger) :
+  m_gemLogger(logger),
+  m_model(model),
+  m_latency(latency),
+  m_socket(-1),
+  m_port(port),
+  m_stop(false),
+  m_nextPacketID(1),
+  m_nPackets(0),
+  m_nTransactions(0)
+{
+  m_socket = socket(AF_INET, SOCK_DGRAM, 0);
+  if (m_socket < 0) {
+    std::string msg = toolbox::toString("IPbusUDPServer unable to create a socket: %s", std::strerror(errno));
+    ERROR(msg);
+    XCEPT_RAISE(gem::hw::exception::SoftwareProblem, msg);
+  }
+
+  int const reuse = 1;
+  setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  // uHAL sends several packets before waiting for the replies
+  int const bufferSize = 4*1024*1024;
+  setsockopt(m_socket, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+  struct timeval timeout = {0, 100000};
+  setsockopt(m_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  struct sockaddr_in address;
+  std::memset(&address, 0, sizeof(address));
+  address.sin_family      = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port        = htons(port);
+  socklen_t length = sizeof(address);
+  if (bind(m_socket, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0 ||
+      getsockname(m_socket, reinterpret_cast<struct sockaddr*>(&address), &length) != 0) {
+    std::string msg = toolbox::toString("IPbusUDPServer unable to bind UDP port %d: %s", port, std::strerror(errno));
+    ::close(m_socket);
+    m_socket = -1;
+    ERROR(msg);
+    XCEPT_RAISE(gem::hw::exception::SoftwareProblem, msg);
+  }
+  m_port = ntohs(address.sin_port);
+  INFO("IPbusUDPServer listening on UDP port " << m_port);
+}
+
+gem::hw::emulator::IPbusUDPServer::~IPbusUDPServer()
+{
+  if (m_socket >= 0)
+    ::close(m_socket);
+}
+
+void gem::hw::emulator::IPbusUDPServer::run()
+{
+  std::vector<uint32_t> packet(16384);
+  std::vector<uint32_t> in;
+  std::vector<uint32_t> reply;
+
+  while (!m_stop) {
+    struct sockaddr_in from;
+    socklen_t fromLength = sizeof(from);
+    ssize_t const nBytes = recvfrom(m_socket, packet.data(), packet.size()*sizeof(uint32_t), 0,
+                                    reinterpret_cast<struct sockaddr*>(&from), &fromLength);
+    if (nBytes < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+        continue;
+      ERROR("IPbusUDPServer::run receive failed: " << std::strerror(errno));
+      break;
+    }
+    if (nBytes < 4 || nBytes % 4)
+      continue;
+
+    // uHAL sends the words in network byte order, the byte order qualifier of the header tells
+    in.assign(packet.begin(), packet.begin() + nBytes/4);
+    bool swap = false;
+    if (!isPacketHeader(in[0])) {
+      if (!isPacketHeader(__builtin_bswap32(in[0]))) {
+        DEBUG("IPbusUDPServer::run dropping a packet with header 0x" << std::hex << in[0] << std::dec);
+        continue;
+      }
+      swap = true;
+      for (auto word = in.begin(); word != in.end(); ++word)
+        *word = __builtin_bswap32(*word);
+    }
+
+    uint32_t const header   = in[0];
+    uint16_t const packetID = (header >> 8) & 0xffff;
+    reply.clear();
+    switch (header & 0xf) {
+    case STATUS_PACKET:
+      status(reply);
+      break;
+    case RESEND_PACKET: {
+      auto stored = m_replies.find(packetID);
+      if (stored == m_replies.end()) {
+        DEBUG("IPbusUDPServer::run resend of unknown packet " << packetID);
+        continue;
+      }
+      reply = stored->second;
+      break;
+    }
+    case CONTROL_PACKET: {
+      if (packetID != 0 && packetID != m_nextPacketID) {
+        // a duplicate gets the same reply again, anything else is out of sequence and dropped
+        auto stored = m_replies.find(packetID);
+        if (stored == m_replies.end()) {
+          DEBUG("IPbusUDPServer::run dropping packet " << packetID << ", expecting " << m_nextPacketID);
+          continue;
+        }
+        reply = stored->second;
+        break;
+      }
+
+      uint64_t nWords = 0;
+      uint32_t const nTransactions = control(in, reply, nWords);
+      ++m_nPackets;
+      m_nTransactions += nTransactions;
+
+      if (packetID != 0) {
+        m_nextPacketID = packetID == 0xffff ? 1 : packetID + 1;
+        if (m_replyOrder.size() >= N_REPLY_BUFFERS) {
+          m_replies.erase(m_replyOrder.front());
+          m_replyOrder.erase(m_replyOrder.begin());
+        }
+        m_replies[packetID] = reply;
+        m_replyOrder.push_back(packetID);
+      }
+
+      uint64_t const delay = m_latency.packet + nTransactions*static_cast<uint64_t>(m_latency.transaction) +
+        nWords*m_latency.word/1000;
+      if (delay)
+        std::this_thread::sleep_for(std::chrono::microseconds(delay));
+      break;
+    }
+    default:
+      continue;
+    }
+
+    if (swap)
+      for (auto word = reply.begin(); word != reply.end(); ++word)
+        *word = __builtin_bswap32(*word);
+    if (sendto(m_socket, reply.data(), reply.size()*sizeof(uint32_t), 0,
+               reinterpret_cast<struct sockaddr*>(&from), fromLength) < 0)
+      WARN("IPbusUDPServer::run send failed: " << std::strerror(errno));
+  }
+  INFO("IPbusUDPServer::run stopped after " << m_nPackets << " packets, " << m_nTransactions << " transactions");
+}
+
+uint32_t gem::hw::emulator::IPbusUDPServer::control(std::vector<uint32_t> const& in, std::vector<uint32_t>& out,
+                                                    uint64_t& nWords)
+{
+  out.push_back(in[0]);
+  uint32_t nTransactions = 0;
+  std::vector<uint32_t> values;
+
+  size_t pos = 1;
+  while (pos < in.size()) {
+    uint32_t const header = in[pos];
+    uint32_t const words  = (header >> 8) & 0xff;
+    uint32_t const type   = (header >> 4) & 0xf;
+    uint32_t const reply  = (header & 0xfffffff0) | INFO_SUCCESS;
+    if ((header >> 28) != IPBUS_VERSION || (header & 0xf) != INFO_REQUEST || pos + 2 > in.size()) {
+      out.push_back((header & 0xfffffff0) | INFO_BAD_HEADER);
+      break;
+    }
+    uint32_t const address = in[pos + 1];
+
+    switch (type) {
+    case READ:
+    case NI_READ:
+      values.resize(words);
+      m_model.readBlock(address, words, type == READ, values.data());
+      out.push_back(reply);
+      out.insert(out.end(), values.begin(), values.end());
+      pos += 2;
+      nWords += words;
+      break;
+    case WRITE:
+    case NI_WRITE:
+      if (pos + 2 + words > in.size()) {
+        out.push_back((header & 0xfffffff0) | INFO_BAD_HEADER);
+        return nTransactions;
+      }
+      m_model.writeBlock(address, words, type == WRITE, &in[pos + 2]);
+      out.push_back(reply);
+      pos += 2 + words;
+      nWords += words;
+      break;
+    case RMW_BITS:
+      if (pos + 4 > in.size()) {
+        out.push_back((header & 0xfffffff0) | INFO_BAD_HEADER);
+        return nTransactions;
+      }
+      out.push_back(reply);
+      out.push_back(m_model.readModifyWriteBits(address, in[pos + 2], in[pos + 3]));
+      pos += 4;
+      nWords += 1;
+      break;
+    case RMW_SUM:
+      if (pos + 3 > in.size()) {
+        out.push_back((header & 0xfffffff0) | INFO_BAD_HEADER);
+        return nTransactions;
+      }
+      out.push_back(reply);
+      out.push_back(m_model.readModifyWriteSum(address, in[pos + 2]));
+      pos += 3;
+      nWords += 1;
+      break;
+    case CONFIG_READ:
+      // no configuration space
+      out.push_back(reply);
+      out.insert(out.end(), words, 0);
+      pos += 2;
+      break;
+    case CONFIG_WRITE:
+      out.push_back(reply);
+      pos += 2 + words;
+      break;
+    default:
+      out.push_back((header & 0xfffffff0) | INFO_BAD_HEADER);
+      return nTransactions;
+    }
+    ++nTransactions;
+  }
+  return nTransactions;
+}
+
+void gem::hw::emulator::IPbusUDPServer::status(std::vector<uint32_t>& out) const
+{
+  // header, MTU, number of reply buffers, next expected packet header, traffic history (zeroed)
+  out.assign(16, 0);
+  out[0] = (IPBUS_VERSION << 28) | 0xf0 | STATUS_PACKET;
+  out[1] = MTU_BYTES;
+  out[2] = N_REPLY_BUFFERS;
+  out[3] = (IPBUS_VERSION << 28) | (static_cast<uint32_t>(m_nextPacketID) << 8) | 0xf0;
+}
@@ -0,0 +1,119 @@
+/**
+ * gemHwEmulator
+ * description: software emulation of an AMC with its OptoHybrids and VFAT2s, served over IPbus 2.0/UDP
+ *
+ * usage: gemHwEmulator [-p port] [-n VFATs per OH] [-r L1A rate in Hz] [-d FIFO depth in words]
+ *                      [-S scan point time in us] [-o occupancy bits] [-l packet latency in us]
+ *                      [-t transaction latency in us] [-w word latency in ns] [-s seed] address_table...
+ * The address tables are the ones of the connection file, e.g., file://${GEM_ADDRESS_TABLE_PATH}/uhal_gem_amc_glib.xml,
+ * the device uri is then replaced by ipbusudp-2.0://<host>:<port> to run the devices against the emulator.
+ */
+
+#include <signal.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "log4cplus/configurator.h"
+
+#include "xcept/Exception.h"
+
+#include "gem/hw/emulator/GEMHwEmulatorModel.h"
+#include "gem/hw/emulator/IPbusUDPServer.h"
+
+namespace {
+  gem::hw::emulator::IPbusUDPServer* p_server = NULL;
+
+  void stopServer(int)
+  {
+    if (p_server)
+      p_server->stop();
+  }
+
+  void usage()
+  {
+    std::cerr << "usage: gemHwEmulator [-p port] [-n VFATs per OH] [-r L1A rate in Hz] [-d FIFO depth in words]"
+              << std::endl
+              << "                     [-S scan point time in us] [-o occupancy bits] [-l packet latency in us]"
+              << std::endl
+              << "                     [-t transaction latency in us] [-w word latency in ns] [-s seed]"
+              << " address_table..." << std::endl;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  log4cplus::BasicConfigurator logConfig;
+  logConfig.configure();
+  log4cplus::Logger logger = log4cplus::Logger::getInstance("gemHwEmulator");
+
+  uint16_t port = 50001;
+  gem::hw::emulator::GEMHwEmulatorModel::Config config;
+  gem::hw::emulator::IPbusUDPServer::Latency latency;
+
+  int option;
+  while ((option = getopt(argc, argv, "p:n:r:d:S:o:l:t:w:s:h")) != -1) {
+    switch (option) {
+    case 'p':
+      port = std::strtoul(optarg, NULL, 10);
+      break;
+    case 'n':
+      config.vfatsPerOH = std::strtoul(optarg, NULL, 10);
+      break;
+    case 'r':
+      config.l1aRate = std::strtod(optarg, NULL);
+      break;
+    case 'd':
+      config.fifoDepth = std::strtoul(optarg, NULL, 0);
+      break;
+    case 'S':
+      config.scanPointTime = std::strtoul(optarg, NULL, 10);
+      break;
+    case 'o':
+      config.occupancyBits = std::strtoul(optarg, NULL, 10);
+      break;
+    case 'l':
+      latency.packet = std::strtoul(optarg, NULL, 10);
+      break;
+    case 't':
+      latency.transaction = std::strtoul(optarg, NULL, 10);
+      break;
+    case 'w':
+      latency.word = std::strtoul(optarg, NULL, 10);
+      break;
+    case 's':
+      config.seed = std::strtoul(optarg, NULL, 0);
+      break;
+    default:
+      usage();
+      return 1;
+    }
+  }
+  if (optind >= argc) {
+    usage();
+    return 1;
+  }
+
+  try {
+    gem::hw::emulator::GEMHwEmulatorModel model(config, logger);
+    for (int arg = optind; arg < argc; ++arg)
+      model.addAddressTable(argv[arg]);
+    std::cout << "gemHwEmulator: " << model.nRegisters() << " registers, " << model.nOptoHybrids()
+              << " OptoHybrids, " << model.nFIFOs() << " tracking data FIFOs" << std::endl;
+
+    gem::hw::emulator::IPbusUDPServer server(model, port, latency, logger);
+    p_server = &server;
+    signal(SIGINT,  stopServer);
+    signal(SIGTERM, stopServer);
+    std::cout << "gemHwEmulator: listening on ipbusudp-2.0://localhost:" << server.port() << std::endl;
+    server.run();
+    p_server = NULL;
+  } catch (xcept::Exception const& e) {
+    std::cerr << "gemHwEmulator: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
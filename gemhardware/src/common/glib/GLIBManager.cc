@@ -8,15 +8,22 @@
 
 #include "gem/hw/glib/GLIBManager.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
 #include <iterator>
 
 #include "gem/hw/glib/HwGLIB.h"
+#include "gem/hw/GEMHwTransaction.h"
 #include "gem/hw/glib/GLIBMonitor.h"
 #include "gem/hw/glib/GLIBManagerWeb.h"
 
 #include "gem/hw/glib/exception/Exception.h"
 
 #include "gem/hw/utils/GEMCrateUtils.h"
+#include "gem/hw/utils/GEMSlotTasks.h"
+
+#include "gem/utils/LockGuard.h"
 
 #include "xoap/MessageReference.h"
 #include "xoap/MessageFactory.h"
@@ -53,9 +60,11 @@ void gem::hw::glib::GLIBManager::GLIBInfo::registerFields(xdata::Bag<gem::hw::gl
 gem::hw::glib::GLIBManager::GLIBManager(xdaq::ApplicationStub* stub) :
   gem::base::GEMFSMApplication(stub),
   m_amcEnableMask(0),
+  m_confChambersLock(toolbox::BSem::FULL, true),
   m_uhalPhaseShift(false),
   m_bc0LockPhaseShift(false),
-  m_relockPhase(true)
+  m_relockPhase(true),
+  m_maxSlotWorkers(gem::hw::utils::GEMSlotTasks::DEFAULT_MAX_WORKERS)
 {
   m_glibInfo.setSize(MAX_AMCS_PER_CRATE);
 
@@ -65,6 +74,7 @@ gem::hw::glib::GLIBManager::GLIBManager(xdaq::ApplicationStub* stub) :
   p_appInfoSpace->fireItemAvailable("UHALPhaseShift",    &m_uhalPhaseShift);
   p_appInfoSpace->fireItemAvailable("BC0LockPhaseShift", &m_bc0LockPhaseShift);
   p_appInfoSpace->fireItemAvailable("RelockPhase",       &m_relockPhase);
+  p_appInfoSpace->fireItemAvailable("MaxSlotWorkers",    &m_maxSlotWorkers);
 
   p_appInfoSpace->addItemRetrieveListener("AllGLIBsInfo",      this);
   p_appInfoSpace->addItemRetrieveListener("AMCSlots",          this);
@@ -72,14 +82,17 @@ gem::hw::glib::GLIBManager::GLIBManager(xdaq::ApplicationStub* stub) :
   p_appInfoSpace->addItemRetrieveListener("UHALPhaseShift",    this);
   p_appInfoSpace->addItemRetrieveListener("BC0LockPhaseShift", this);
   p_appInfoSpace->addItemRetrieveListener("RelockPhase",       this);
+  p_appInfoSpace->addItemRetrieveListener("MaxSlotWorkers",    this);
   p_appInfoSpace->addItemChangedListener( "AllGLIBsInfo",      this);
   p_appInfoSpace->addItemChangedListener( "AMCSlots",          this);
   p_appInfoSpace->addItemChangedListener( "ConnectionFile",    this);
   p_appInfoSpace->addItemChangedListener( "UHALPhaseShift",    this);
   p_appInfoSpace->addItemChangedListener( "BC0LockPhaseShift", this);
   p_appInfoSpace->addItemChangedListener( "RelockPhase",       this);
+  p_appInfoSpace->addItemChangedListener( "MaxSlotWorkers",    this);
 
   xgi::bind(this, &GLIBManager::dumpGLIBFIFO, "dumpGLIBFIFO");
+  xgi::bind(this, &GLIBManager::ipBusStats,   "ipBusStats");
 
   // initialize the GLIB application objects
   DEBUG("GLIBManager::Connecting to the GLIBManagerWeb interface");
@@ -311,47 +324,48 @@ void gem::hw::glib::GLIBManager::configureAction()
 {
   DEBUG("GLIBManager::configureAction");
 
-  // FIXME make me more streamlined
+  // the slots are independent, each one is configured by its own task
+  gem::hw::utils::GEMSlotTasks tasks(m_maxSlotWorkers.value_);
   for (unsigned slot = 0; slot < MAX_AMCS_PER_CRATE; ++slot) {
-    // usleep(10); // just for testing the timing of different applications
     GLIBInfo& info = m_glibInfo[slot].bag;
 
     if (!info.present)
       continue;
 
-    glib_shared_ptr amc = m_glibs.at(slot);
-    if (amc->isHwConnected()) {
-      if (m_glibMonitors.at(slot))
-        m_glibMonitors.at(slot)->pauseMonitoring();
+    tasks.add(toolbox::toString("AMC%02d", slot+1), std::bind(&GLIBManager::configureAMC, this, slot));
+  }
+
+  bool const success = tasks.run();
+  INFO("GLIBManager::configureAction slot tasks:" << std::endl << tasks.summary());
+  if (!success) {
+    std::stringstream msg;
+    msg << "GLIBManager::configureAction failed for" << std::endl << tasks.errors();
+    ERROR(msg.str());
+    XCEPT_RAISE(gem::hw::glib::exception::ConfigurationProblem, msg.str());
+  }
 
+  INFO("GLIBManager::configureAction end");
+}
+
+void gem::hw::glib::GLIBManager::configureAMC(unsigned const& slot)
+{
+  glib_shared_ptr amc = m_glibs.at(slot);
+  if (amc->isHwConnected()) {
+    if (m_glibMonitors.at(slot))
+      m_glibMonitors.at(slot)->pauseMonitoring();
+
+    {
+      // queued and sent with a single dispatch, reads in these calls flush the queue first
+      gem::hw::GEMHwTransaction batch(*amc);
       amc->scaHardResetEnable(false);
       amc->resetL1ACount();
       amc->resetCalPulseCount();
+    }
 
-      if (m_uhalPhaseShift.value_) {
-        amc->ttcMMCMPhaseShift(m_relockPhase.value_, m_bc0LockPhaseShift.value_);
-      } else {
-        std::stringstream pashiftcmd;
-        // FIXME hard coded for now, but super hacky garbage (only works at P5)
-        pashiftcmd << "ssh -Tq texas@" << info.birdName.toString()
-                   << " \"sh -lic '/mnt/persistent/texas/apps/reg_interface/test_phase_shifting.py";
-        if (m_bc0LockPhaseShift.value_)
-          pashiftcmd << " --useBC0";
-        if (m_relockPhase.value_)
-          pashiftcmd << " --relock";
-        pashiftcmd << "'\"";
-        INFO("GLIBManager::configureAction executing " << pashiftcmd.str());
-        int retval = std::system(pashiftcmd.str().c_str());
-        if (retval) {
-          std::stringstream msg;
-          msg << "GLIBManager::configureAction unable to shift phases: " << retval;
-          ERROR(msg.str());
-          // fireEvent("Fail");
-          // XCEPT_RAISE(gem::hw::glib::exception::Exception, msg.str());
-          XCEPT_RAISE(gem::hw::glib::exception::ConfigurationProblem, msg.str());
-        }
-      }
+    amc->ttcMMCMPhaseShift(m_relockPhase.value_, m_bc0LockPhaseShift.value_);
 
+    {
+      gem::hw::GEMHwTransaction batch(*amc);
       // reset the DAQ (could move this to HwGenericAMC and eventually  a corresponding RPC module
       amc->setL1AEnable(false);
       amc->disableDAQLink();
@@ -362,81 +376,67 @@ void gem::hw::glib::GLIBManager::configureAction()
       amc->setDAQLinkRunParameters(0xfaac);
 
       if (m_scanType.value_ == 2) {
-	INFO("GLIBManager::configureAction: FIRST  " << m_scanMin.value_);
+        INFO("GLIBManager::configureAMC: FIRST  " << m_scanMin.value_);
 
-	amc->setDAQLinkRunType(0x2);
-	amc->setDAQLinkRunParameter(0x1,m_scanMin.value_);
-	// amc->setDAQLinkRunParameter(0x2,VT1);  // set these at start so DQM has them?
-	// amc->setDAQLinkRunParameter(0x3,VT2);  // set these at start so DQM has them?
+        amc->setDAQLinkRunType(0x2);
+        amc->setDAQLinkRunParameter(0x1,m_scanMin.value_);
+        // amc->setDAQLinkRunParameter(0x2,VT1);  // set these at start so DQM has them?
+        // amc->setDAQLinkRunParameter(0x3,VT2);  // set these at start so DQM has them?
       } else if (m_scanType.value_ == 3) {
-	uint32_t initialVT1 = m_scanMin.value_;
-	uint32_t initialVT2 = 0;  // std::max(0,(uint32_t)m_scanMax.value_);
-	INFO("GLIBManager::configureAction FIRST VT1 " << initialVT1 << " VT2 " << initialVT2);
-
-	amc->setDAQLinkRunType(0x3);
-	// amc->setDAQLinkRunParameter(0x1,latency);  // set this at start so DQM has it?
-	amc->setDAQLinkRunParameter(0x2,initialVT1);
-	amc->setDAQLinkRunParameter(0x3,initialVT2);
+        uint32_t initialVT1 = m_scanMin.value_;
+        uint32_t initialVT2 = 0;  // std::max(0,(uint32_t)m_scanMax.value_);
+        INFO("GLIBManager::configureAMC FIRST VT1 " << initialVT1 << " VT2 " << initialVT2);
+
+        amc->setDAQLinkRunType(0x3);
+        // amc->setDAQLinkRunParameter(0x1,latency);  // set this at start so DQM has it?
+        amc->setDAQLinkRunParameter(0x2,initialVT1);
+        amc->setDAQLinkRunParameter(0x3,initialVT2);
       } else {
-	amc->setDAQLinkRunType(0x1);
-	amc->setDAQLinkRunParameters(0xfaac);
+        amc->setDAQLinkRunType(0x1);
+        amc->setDAQLinkRunParameters(0xfaac);
       }
+    }
 
-      // what else is required for configuring the GLIB?
-      // need to reset optical links?
-      // reset counters?
-      // setup run mode?
-      // setup DAQ mode?
-
-      // temp workaround, call confAllChambers python script?
-      // if P5 config?
-      // if (m_setupLocation.toString().rfind("P5") != std::string::npos) {
-      INFO("GLIBManager::configureAction running confAllChambers for P5 setup");
-      std::stringstream confcmd;
-      // FIXME hard coded for now, but super hacky garbage
-      confcmd << "confAllChambers.py -s" << (slot+1)
-              << " --shelf="   << info.crateID.toString()
-              << " --ztrim="   << 4.0
-              << " --vt1bump=" << 10
-              << " --config --run";
-      INFO("GLIBManager::configureAction executing " << confcmd.str());
-      int retval = std::system(confcmd.str().c_str());
-      if (retval) {
-        std::stringstream msg;
-        msg << "GLIBManager::configureAction unable to configure chambers: " << retval;
-        WARN(msg.str());
-        // fireEvent("Fail");
-        // XCEPT_RAISE(gem::hw::glib::exception::Exception, msg.str());
-        // XCEPT_RAISE(gem::hw::glib::exception::ConfigurationProblem, msg.str());
-      }
-      // }
-      std::stringstream statuscmd;
-      // FIXME hard coded for now, but super hacky garbage
-      statuscmd << "amc_info_uhal.py -s" << (slot+1)
-                << " --shelf="           << info.crateID.toString();
-      INFO("GLIBManager::configureAction running " << statuscmd.str() << " after configuring");
-      retval = std::system(statuscmd.str().c_str());
-      if (retval) {
-        std::stringstream msg;
-        msg << "GLIBManager::configureAction unable to check AMC status: " << retval;
-        WARN(msg.str());
-        // fireEvent("Fail");
-        // XCEPT_RAISE(gem::hw::glib::exception::Exception, msg.str());
-        // XCEPT_RAISE(gem::hw::glib::exception::ConfigurationProblem, msg.str());
-      }
+    // what else is required for configuring the GLIB?
+    // need to reset optical links?
+    // reset counters?
+    // setup run mode?
+    // setup DAQ mode?
 
-      if (m_glibMonitors.at(slot))
-        m_glibMonitors.at(slot)->resumeMonitoring();
-    } else {
+    // temp workaround, call confAllChambers python script?
+    // keeps the per-chamber tuned VFAT settings until they can be loaded natively
+    GLIBInfo& info = m_glibInfo[slot].bag;
+    INFO("GLIBManager::configureAMC running confAllChambers for P5 setup");
+    std::stringstream confcmd;
+    confcmd << "confAllChambers.py -s" << (slot+1)
+            << " --shelf="   << info.crateID.toString()
+            << " --ztrim="   << 4.0
+            << " --vt1bump=" << 10
+            << " --config --run";
+    int retval = 0;
+    {
+      // the slot tasks configure several AMCs at once, the script is not safe to run concurrently
+      gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_confChambersLock);
+      INFO("GLIBManager::configureAMC executing " << confcmd.str());
+      retval = std::system(confcmd.str().c_str());
+    }
+    if (retval) {
       std::stringstream msg;
-      msg << "GLIBManager::configureAction GLIB in slot " << (slot+1) << " is not connected";
-      ERROR(msg.str());
-      // fireEvent("Fail");
-      XCEPT_RAISE(gem::hw::glib::exception::Exception, msg.str());
+      msg << "GLIBManager::configureAMC unable to configure chambers: " << retval;
+      WARN(msg.str());
     }
-  }
 
-  INFO("GLIBManager::configureAction end");
+    logAMCStatus(slot, "configureAMC");
+
+    if (m_glibMonitors.at(slot))
+      m_glibMonitors.at(slot)->resumeMonitoring();
+  } else {
+    std::stringstream msg;
+    msg << "GLIBManager::configureAMC GLIB in slot " << (slot+1) << " is not connected";
+    ERROR(msg.str());
+    // fireEvent("Fail");
+    XCEPT_RAISE(gem::hw::glib::exception::Exception, msg.str());
+  }
 }
 
 void gem::hw::glib::GLIBManager::startAction()
@@ -454,62 +454,61 @@ void gem::hw::glib::GLIBManager::startAction()
 
   INFO("GLIBManager::startAction begin");
   // what is required for starting the GLIB?
-  // FIXME make me more streamlined
+  gem::hw::utils::GEMSlotTasks tasks(m_maxSlotWorkers.value_);
   for (unsigned slot = 0; slot < MAX_AMCS_PER_CRATE; ++slot) {
-    // usleep(10);
     DEBUG("GLIBManager::looping over slots(" << (slot+1) << ") and finding infospace items");
     GLIBInfo& info = m_glibInfo[slot].bag;
 
     if (!info.present)
       continue;
 
-    glib_shared_ptr amc = m_glibs.at(slot);
-    if (amc->isHwConnected()) {
-      if (m_glibMonitors.at(slot))
-        m_glibMonitors.at(slot)->pauseMonitoring();
+    tasks.add(toolbox::toString("AMC%02d", slot+1), std::bind(&GLIBManager::startAMC, this, slot));
+  }
 
-      DEBUG("connected a card in slot " << (slot+1));
-      // enable the DAQ
-      amc->ttcReset();
-      amc->enableDAQLink(0x4);  // FIXME
-      amc->resetDAQLink();
-      amc->enableZeroSuppression(0x1);
-      amc->setL1AEnable(true);
-      usleep(10); // just for testing the timing of different applications
-
-      std::stringstream statuscmd;
-      // FIXME hard coded for now, but super hacky garbage
-      statuscmd << "amc_info_uhal.py -s" << (slot+1)
-                << " --shelf="           << info.crateID.toString();
-      INFO("GLIBManager::startAction running " << statuscmd.str() << " after starting");
-      int retval = std::system(statuscmd.str().c_str());
-      if (retval) {
-        std::stringstream msg;
-        msg << "GLIBManager::startAction unable to check AMC status: " << retval;
-        WARN(msg.str());
-        // fireEvent("Fail");
-        // XCEPT_RAISE(gem::hw::glib::exception::Exception, msg.str());
-        // XCEPT_RAISE(gem::hw::glib::exception::ConfigurationProblem, msg.str());
-      }
+  bool const success = tasks.run();
+  INFO("GLIBManager::startAction slot tasks:" << std::endl << tasks.summary());
+  if (!success) {
+    std::stringstream msg;
+    msg << "GLIBManager::startAction failed for" << std::endl << tasks.errors();
+    ERROR(msg.str());
+    XCEPT_RAISE(gem::hw::glib::exception::Exception, msg.str());
+  }
+  INFO("GLIBManager::startAction end");
+}
 
-      if (m_glibMonitors.at(slot))
-        m_glibMonitors.at(slot)->resumeMonitoring();
-    } else {
-      std::stringstream msg;
-      msg << "GLIBManager::startAction GLIB in slot " << (slot+1) << " is not connected";
-      ERROR(msg.str());
-      // fireEvent("Fail");
-      XCEPT_RAISE(gem::hw::glib::exception::Exception, msg.str());
-    }
+void gem::hw::glib::GLIBManager::startAMC(unsigned const& slot)
+{
+  glib_shared_ptr amc = m_glibs.at(slot);
+  if (amc->isHwConnected()) {
+    if (m_glibMonitors.at(slot))
+      m_glibMonitors.at(slot)->pauseMonitoring();
+
+    DEBUG("connected a card in slot " << (slot+1));
+    // enable the DAQ
+    amc->ttcReset();
+    amc->enableDAQLink(0x4);  // FIXME
+    amc->resetDAQLink();
+    amc->enableZeroSuppression(0x1);
+    amc->setL1AEnable(true);
+    usleep(10); // just for testing the timing of different applications
+
+    logAMCStatus(slot, "startAMC");
 
-    /*
-    // reset the hw monitor, this was in release-v2 but not in integrated-application-framework, may have forgotten something
     if (m_glibMonitors.at(slot))
-    m_glibMonitors.at(slot)->reset();
-    */
+      m_glibMonitors.at(slot)->resumeMonitoring();
+  } else {
+    std::stringstream msg;
+    msg << "GLIBManager::startAMC GLIB in slot " << (slot+1) << " is not connected";
+    ERROR(msg.str());
+    // fireEvent("Fail");
+    XCEPT_RAISE(gem::hw::glib::exception::Exception, msg.str());
   }
-  // usleep(10);
-  INFO("GLIBManager::startAction end");
+
+  /*
+  // reset the hw monitor, this was in release-v2 but not in integrated-application-framework, may have forgotten something
+  if (m_glibMonitors.at(slot))
+  m_glibMonitors.at(slot)->reset();
+  */
 }
 
 void gem::hw::glib::GLIBManager::pauseAction()
@@ -619,20 +618,7 @@ void gem::hw::glib::GLIBManager::stopAction()
       amc->disableDAQLink();
       amc->resetDAQLink();
 
-      std::stringstream statuscmd;
-      // FIXME hard coded for now, but super hacky garbage
-      statuscmd << "amc_info_uhal.py -s" << (slot+1)
-                << " --shelf="           << info.crateID.toString();
-      INFO("GLIBManager::stopAction running " << statuscmd.str() << " after configuration");
-      int retval = std::system(statuscmd.str().c_str());
-      if (retval) {
-        std::stringstream msg;
-        msg << "GLIBManager::stopAction unable to check AMC status: " << retval;
-        WARN(msg.str());
-        // fireEvent("Fail");
-        // XCEPT_RAISE(gem::hw::glib::exception::Exception, msg.str());
-        // XCEPT_RAISE(gem::hw::glib::exception::ConfigurationProblem, msg.str());
-      }
+      logAMCStatus(slot, "stopAction");
 
       if (m_glibMonitors.at(slot))
         m_glibMonitors.at(slot)->resumeMonitoring();
@@ -665,20 +651,7 @@ void gem::hw::glib::GLIBManager::haltAction()
       amc->setL1AEnable(false);
       amc->writeReg("GEM_AMC.DAQ.CONTROL.INPUT_ENABLE_MASK", 0x0);
 
-      std::stringstream statuscmd;
-      // FIXME hard coded for now, but super hacky garbage
-      statuscmd << "amc_info_uhal.py -s" << (slot+1)
-                << " --shelf="           << info.crateID.toString();
-      INFO("GLIBManager::haltAction running " << statuscmd.str() << " after halting");
-      int retval = std::system(statuscmd.str().c_str());
-      if (retval) {
-        std::stringstream msg;
-        msg << "GLIBManager::haltAction unable to check AMC status: " << retval;
-        WARN(msg.str());
-        // fireEvent("Fail");
-        // XCEPT_RAISE(gem::hw::glib::exception::Exception, msg.str());
-        // XCEPT_RAISE(gem::hw::glib::exception::ConfigurationProblem, msg.str());
-      }
+      logAMCStatus(slot, "haltAction");
 
       if (m_glibMonitors.at(slot))
         m_glibMonitors.at(slot)->resumeMonitoring();
@@ -687,6 +660,34 @@ void gem::hw::glib::GLIBManager::haltAction()
   INFO("GLIBManager::haltAction end");
 }
 
+void gem::hw::glib::GLIBManager::logAMCStatus(unsigned const& slot, std::string const& transition)
+{
+  glib_shared_ptr amc = m_glibs.at(slot);
+  try {
+    std::stringstream status;
+    status << "GLIBManager::" << transition << " AMC" << (slot+1) << " status" << std::endl
+           << "  firmware      " << amc->getFirmwareVer() << " (" << amc->getFirmwareDate() << ")" << std::endl
+           << std::hex
+           << "  TTC status    0x" << amc->getTTCStatus()       << std::endl
+           << "  DAQ control   0x" << amc->getDAQLinkControl()  << std::endl
+           << "  DAQ status    0x" << amc->getDAQLinkStatus()   << std::endl
+           << std::dec
+           << "  DAQ link ready " << amc->daqLinkReady()
+           << " clock locked "    << amc->daqClockLocked()
+           << " TTC ready "       << amc->daqTTCReady()
+           << " TTS state 0x"     << std::hex << static_cast<unsigned>(amc->daqTTSState()) << std::dec
+           << " almost full "     << amc->daqAlmostFull() << std::endl
+           << "  L1A ID " << amc->getDAQLinkL1AID() << " events sent " << amc->getDAQLinkEventsSent() << std::endl;
+    uint32_t const nLinks = std::min(amc->getSupportedOptoHybrids(), static_cast<uint32_t>(HwGLIB::N_GTX));
+    for (uint8_t gtx = 0; gtx < nLinks; ++gtx)
+      status << "  GTX" << static_cast<unsigned>(gtx) << " DAQ status 0x"
+             << std::hex << amc->getDAQLinkStatus(gtx) << std::dec << std::endl;
+    INFO(status.str());
+  } catch (std::exception const& e) {
+    WARN("GLIBManager::" << transition << " unable to check AMC" << (slot+1) << " status: " << e.what());
+  }
+}
+
 void gem::hw::glib::GLIBManager::resetAction()
   throw (gem::hw::glib::exception::Exception)
 {
@@ -713,20 +714,7 @@ void gem::hw::glib::GLIBManager::resetAction()
       amc->setL1AEnable(false);
       amc->writeReg("GEM_AMC.DAQ.CONTROL.INPUT_ENABLE_MASK", 0x0);
 
-      std::stringstream statuscmd;
-      // FIXME hard coded for now, but super hacky garbage
-      statuscmd << "amc_info_uhal.py -s" << (slot+1)
-                << " --shelf="           << info.crateID.toString();
-      INFO("GLIBManager::resetAction running " << statuscmd.str() << " after resetting");
-      int retval = std::system(statuscmd.str().c_str());
-      if (retval) {
-        std::stringstream msg;
-        msg << "GLIBManager::resetAction unable to check AMC status: " << retval;
-        WARN(msg.str());
-        // fireEvent("Fail");
-        // XCEPT_RAISE(gem::hw::glib::exception::Exception, msg.str());
-        // XCEPT_RAISE(gem::hw::glib::exception::ConfigurationProblem, msg.str());
-      }
+      logAMCStatus(slot, "resetAction");
     }
     // reset the hw monitor
     if (m_glibMonitors.at(slot))
@@ -906,3 +894,8 @@ void gem::hw::glib::GLIBManager::dumpGLIBFIFO(xgi::Input* in, xgi::Output* out)
 {
   dynamic_cast<GLIBManagerWeb*>(p_gemWebInterface)->dumpGLIBFIFO(in, out);
 }
+
+void gem::hw::glib::GLIBManager::ipBusStats(xgi::Input* in, xgi::Output* out)
+{
+  dynamic_cast<GLIBManagerWeb*>(p_gemWebInterface)->ipBusStats(in, out);
+}
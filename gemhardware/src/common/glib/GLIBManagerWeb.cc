@@ -197,13 +197,16 @@ void gem::hw::glib::GLIBManagerWeb::jsonUpdate(xgi::Input* in, xgi::Output* out)
   throw (xgi::exception::Exception)
 {
   DEBUG("GLIBManagerWeb::jsonUpdate");
+  uint32_t const since    = jsonSince(in);
+  // taken before the items are refreshed, the changes seen while writing are sent again next time
+  uint32_t const sequence = gem::base::GEMMonitor::jsonSequence();
   out->getHTTPResponseHeader().addHeader("Content-Type", "application/json");
   *out << " { " << std::endl;
   for (unsigned int i = 0; i < gem::base::GEMFSMApplication::MAX_AMCS_PER_CRATE; ++i) {
     *out << "\"glib" << std::setw(2) << std::setfill('0') << (i+1) << "\"  : { " << std::endl;
     auto card = dynamic_cast<gem::hw::glib::GLIBManager*>(p_gemFSMApp)->m_glibMonitors.at(i);
     if (card) {
-      card->jsonUpdateItemSets(out);
+      card->jsonUpdateItemSets(out, since);
     }
     // can't have a trailing comma for the last entry...
     if (i == (gem::base::GEMFSMApplication::MAX_AMCS_PER_CRATE-1))
@@ -211,6 +214,7 @@ void gem::hw::glib::GLIBManagerWeb::jsonUpdate(xgi::Input* in, xgi::Output* out)
     else
       *out << " }," << std::endl;
   }
+  *out << ",\"sequence\" : " << sequence << std::endl;
   *out << " } " << std::endl;
 }
 
@@ -240,3 +244,25 @@ void gem::hw::glib::GLIBManagerWeb::dumpGLIBFIFO(xgi::Input* in, xgi::Output* ou
   }
   *out << " } " << std::endl;
 }
+
+void gem::hw::glib::GLIBManagerWeb::ipBusStats(xgi::Input* in, xgi::Output* out)
+  throw (xgi::exception::Exception)
+{
+  DEBUG("GLIBManagerWeb::ipBusStats");
+  out->getHTTPResponseHeader().addHeader("Content-Type", "application/json");
+  *out << " { " << std::endl;
+  for (unsigned int i = 0; i < gem::base::GEMFSMApplication::MAX_AMCS_PER_CRATE; ++i) {
+    *out << "\"glib" << std::setw(2) << std::setfill('0') << (i+1) << "\" : ";
+    auto card = dynamic_cast<gem::hw::glib::GLIBManager*>(p_gemFSMApp)->m_glibs.at(i);
+    if (card)
+      card->getStats().writeJSON(*out);
+    else
+      *out << "{}";
+    // can't have a trailing comma for the last entry...
+    if (i == (gem::base::GEMFSMApplication::MAX_AMCS_PER_CRATE-1))
+      *out << std::endl;
+    else
+      *out << "," << std::endl;
+  }
+  *out << " } " << std::endl;
+}
@@ -16,7 +16,7 @@
 typedef gem::base::utils::GEMInfoSpaceToolBox::UpdateType GEMUpdateType;
 
 gem::hw::glib::GLIBMonitor::GLIBMonitor(std::shared_ptr<HwGLIB> glib, GLIBManager* glibManager, int const& index) :
-  GEMMonitor(glibManager->getApplicationLogger(), static_cast<xdaq::Application*>(glibManager), index),
+  GEMHwMonitor(glib, glibManager->getApplicationLogger(), static_cast<xdaq::Application*>(glibManager), index),
   p_glib(glib)
 {
   // application info space is added in the base class constructor
@@ -356,6 +356,10 @@ void gem::hw::glib::GLIBMonitor::setupHwMonitoring()
                      GEMUpdateType::HW32, "hex");
     }
   }
+  addIPBusStatsMonitorables("HWMonitoring");
+
+  // resolve all register addresses once, rather than on every update
+  compileMonitorables();
   updateMonitorables();
 }
 
@@ -364,62 +368,6 @@ gem::hw::glib::GLIBMonitor::~GLIBMonitor()
 
 }
 
-void gem::hw::glib::GLIBMonitor::updateMonitorables()
-{
-  // define how to update the desired values
-  // get SYSTEM monitorables
-  // can this be split into two loops, one just to do a list read, the second to fill the InfoSpace with the returned values
-  DEBUG("GLIBMonitor: Updating monitorables");
-  for (auto monlist = m_monitorableSetsMap.begin(); monlist != m_monitorableSetsMap.end(); ++monlist) {
-    DEBUG("GLIBMonitor: Updating monitorables in set " << monlist->first);
-    for (auto monitem = monlist->second.begin(); monitem != monlist->second.end(); ++monitem) {
-      DEBUG("GLIBMonitor: Updating monitorable " << monitem->first);
-      std::stringstream regName;
-      regName << p_glib->getDeviceBaseNode() << "." << monitem->second.regname;
-      uint32_t address = p_glib->getGEMHwInterface().getNode(regName.str()).getAddress();
-      uint32_t mask    = p_glib->getGEMHwInterface().getNode(regName.str()).getMask();
-      if (monitem->second.updatetype == GEMUpdateType::HW8) {
-        (monitem->second.infoSpace)->setUInt32(monitem->first,p_glib->readReg(address,mask));
-      } else if (monitem->second.updatetype == GEMUpdateType::HW16) {
-        (monitem->second.infoSpace)->setUInt32(monitem->first,p_glib->readReg(address,mask));
-      } else if (monitem->second.updatetype == GEMUpdateType::HW24) {
-        (monitem->second.infoSpace)->setUInt32(monitem->first,p_glib->readReg(address,mask));
-      } else if (monitem->second.updatetype == GEMUpdateType::HW32) {
-        (monitem->second.infoSpace)->setUInt32(monitem->first,p_glib->readReg(address,mask));
-      } else if (monitem->second.updatetype == GEMUpdateType::HW64) {
-        address = p_glib->getGEMHwInterface().getNode(regName.str()+".LOWER").getAddress();
-        mask    = p_glib->getGEMHwInterface().getNode(regName.str()+".LOWER").getMask();
-        uint32_t lower = p_glib->readReg(address,mask);
-        address = p_glib->getGEMHwInterface().getNode(regName.str()+".UPPER").getAddress();
-        mask    = p_glib->getGEMHwInterface().getNode(regName.str()+".UPPER").getMask();
-        uint32_t upper = p_glib->readReg(address,mask);
-        (monitem->second.infoSpace)->setUInt64(monitem->first, (((uint64_t)upper) << 32) + lower);
-      } else if (monitem->second.updatetype == GEMUpdateType::I2CSTAT) {
-        std::stringstream strobeReg;
-        strobeReg << regName.str() << ".Strobe." << monitem->first;
-        address = p_glib->getGEMHwInterface().getNode(strobeReg.str()).getAddress();
-        mask    = p_glib->getGEMHwInterface().getNode(strobeReg.str()).getMask();
-        uint32_t strobe = p_glib->readReg(address,mask);
-        std::stringstream ackReg;
-        ackReg << regName.str() << ".Ack." << monitem->first;
-        address = p_glib->getGEMHwInterface().getNode(ackReg.str()).getAddress();
-        mask    = p_glib->getGEMHwInterface().getNode(ackReg.str()).getMask();
-        uint32_t ack = p_glib->readReg(address,mask);
-        (monitem->second.infoSpace)->setUInt64(monitem->first, (((uint64_t)ack) << 32) + strobe);
-      } else if (monitem->second.updatetype == GEMUpdateType::PROCESS) {
-        (monitem->second.infoSpace)->setUInt32(monitem->first,p_glib->readReg(address,mask));
-      } else if (monitem->second.updatetype == GEMUpdateType::TRACKER) {
-        (monitem->second.infoSpace)->setUInt32(monitem->first,p_glib->readReg(address,mask));
-      } else if (monitem->second.updatetype == GEMUpdateType::NOUPDATE) {
-        continue;
-      } else {
-        ERROR("GLIBMonitor: Unknown update type encountered");
-        continue;
-      }
-    } // end loop over items in list
-  } // end loop over monitorableSets
-}
-
 void gem::hw::glib::GLIBMonitor::buildMonitorPage(xgi::Output* out)
 {
   DEBUG("GLIBMonitor::buildMonitorPage");
@@ -765,4 +713,5 @@ void gem::hw::glib::GLIBMonitor::reset()
   m_infoSpaceMonitorableSetMap.clear();
   m_monitorableSetInfoSpaceMap.clear();
   m_monitorableSetsMap.clear();
+  clearCompiledMonitorables();
 }
@@ -8,6 +8,7 @@
 
 #include "gem/hw/glib/GLIBReadout.h"
 
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
@@ -21,11 +22,16 @@
 #include "gem/hw/glib/HwGLIB.h"
 #include "gem/utils/soap/GEMSOAPToolBox.h"
 #include "gem/readout/exception/Exception.h"
+#include "gem/datachecker/GEMDataChecker.h"
 
 XDAQ_INSTANTIATOR_IMPL(gem::hw::glib::GLIBReadout);
 
 const uint32_t gem::hw::glib::GLIBReadout::kUPDATE  = 5000;
 const uint32_t gem::hw::glib::GLIBReadout::kUPDATE7 = 7;
+// the memory in flight is bounded by the readout pool, not by the queue
+const uint32_t gem::hw::glib::GLIBReadout::kQUEUESIZE = 1024;
+// 28kB frames
+const uint32_t gem::hw::glib::GLIBReadout::kFRAMEBLOCKS = 1024;
 
 gem::hw::glib::GLIBReadout::GLIBReadout(xdaq::ApplicationStub* stub) :
   GEMReadoutApplication(stub),
@@ -34,8 +40,11 @@ gem::hw::glib::GLIBReadout::GLIBReadout(xdaq::ApplicationStub* stub) :
   m_ESexp(-1),
   m_isFirst(true),
   m_contvfats(0),
-  m_queueLock(toolbox::BSem::FULL, true)
+  m_dataque(kQUEUESIZE),
+  m_batchIndex(0),
+  m_queuedWords(0)
 {
+  m_batch.reserve(kFRAMEBLOCKS);
   xoap::bind(this,&GLIBReadout::updateScanParameters,"UpdateScanParameter","urn:GLIBReadout-soap:1");
   //xoap::bind(this,&GLIBReadout::queueDepth,          "QueueDepth",         "urn:GLIBReadout-soap:1");
   p_appInfoSpace->fireItemAvailable("QueueDepth", &m_queueDepth);
@@ -44,6 +53,7 @@ gem::hw::glib::GLIBReadout::GLIBReadout(xdaq::ApplicationStub* stub) :
 gem::hw::glib::GLIBReadout::~GLIBReadout()
 {
   DEBUG("GLIBReadout::destructor called");
+  releaseFrames();
 }
 
 void gem::hw::glib::GLIBReadout::actionPerformed(xdata::Event& event)
@@ -74,6 +84,8 @@ void gem::hw::glib::GLIBReadout::initializeAction()
   }
   DEBUG("GLIBReadout::initializeAction connected");
 
+  // creates the readout pool and starts the readout task
+  gem::readout::GEMReadoutApplication::initializeAction();
 }
 
 
@@ -90,42 +102,93 @@ void gem::hw::glib::GLIBReadout::configureAction()
   m_vfat = 0;
   m_event = 0;
   m_sumVFAT = 0;
+  releaseFrames();
+  gem::readout::GEMReadoutApplication::configureAction();
 }
 
 void gem::hw::glib::GLIBReadout::startAction()
   throw (gem::hw::glib::exception::Exception)
 {
   INFO("GLIBReadout::startAction begin");
+  // builds the run file name and starts the readout task, which waits for the writers below
+  gem::readout::GEMReadoutApplication::startAction();
+  std::lock_guard<std::mutex> guard(m_writerMutex);
+  m_outFileName = m_readoutSettings.bag.fileName.toString();
+  m_errFileName = m_outFileName + "_ERR";
+  try {
+    p_dataWriter = createEventWriter();
+    p_dataWriter->open(m_outFileName);
+    p_errWriter  = createEventWriter();
+    p_errWriter->open(m_errFileName);
+  } catch (gem::readout::exception::Exception const& ex) {
+    ERROR("GLIBReadout::startAction caught exception " << ex.what());
+    XCEPT_RAISE(gem::hw::glib::exception::Exception, "startAction failed");
+  }
 }
 
 void gem::hw::glib::GLIBReadout::pauseAction()
   throw (gem::hw::glib::exception::Exception)
 {
   INFO("GLIBReadout::pauseAction begin");
+  gem::readout::GEMReadoutApplication::pauseAction();
 }
 
 void gem::hw::glib::GLIBReadout::resumeAction()
   throw (gem::hw::glib::exception::Exception)
 {
   INFO("GLIBReadout::resumeAction begin");
+  gem::readout::GEMReadoutApplication::resumeAction();
 }
 
 void gem::hw::glib::GLIBReadout::stopAction()
   throw (gem::hw::glib::exception::Exception)
 {
   INFO("GLIBReadout::stopAction begin");
+  gem::readout::GEMReadoutApplication::stopAction();
+  // waits for a readout in progress to finish writing
+  std::lock_guard<std::mutex> guard(m_writerMutex);
+  if (p_dataWriter)
+    p_dataWriter->close();
+  if (p_errWriter)
+    p_errWriter->close();
 }
 
 void gem::hw::glib::GLIBReadout::haltAction()
   throw (gem::hw::glib::exception::Exception)
 {
   INFO("GLIBReadout::haltAction begin");
+  gem::readout::GEMReadoutApplication::haltAction();
+  std::lock_guard<std::mutex> guard(m_writerMutex);
+  if (p_dataWriter)
+    p_dataWriter->close();
+  if (p_errWriter)
+    p_errWriter->close();
 }
 
 void gem::hw::glib::GLIBReadout::resetAction()
   throw (gem::hw::glib::exception::Exception)
 {
   INFO("GLIBReadout::resetAction begin");
+  gem::readout::GEMReadoutApplication::resetAction();
+}
+
+int gem::hw::glib::GLIBReadout::readout(unsigned int expected,
+                                        unsigned int* eventNumbers,
+                                        std::vector< ::toolbox::mem::Reference* >& data)
+{
+  // the frames are decoded in place and go back to the pool here, none are handed to the readout task
+  std::lock_guard<std::mutex> guard(m_writerMutex);
+  if (!p_dataWriter || !p_dataWriter->isOpen() || !p_errWriter || !p_errWriter->isOpen())
+    return 0;
+
+  uint64_t const firstEvent = m_event;
+  uint32_t const nLinks = p_glib->getSupportedOptoHybrids();
+  for (uint8_t gtx = 0; gtx < nLinks; ++gtx) {
+    getGLIBData(gtx, m_counter);
+    while (m_batchIndex < m_batch.size() || !m_dataque.empty())
+      GEMEventMaker(m_counter);
+  }
+  return static_cast<int>(m_event - firstEvent);
 }
 
 uint32_t* gem::hw::glib::GLIBReadout::dumpData(uint8_t const& readout_mask)
@@ -145,6 +208,8 @@ uint32_t* gem::hw::glib::GLIBReadout::dumpData(uint8_t const& readout_mask)
 
 uint32_t* gem::hw::glib::GLIBReadout::getGLIBData(uint8_t const& gtx, uint32_t counter[5])
 {
+  // the FIFO reads show up as READOUT in the IPBus statistics of the GLIB
+  gem::hw::GEMHwDeviceStats::ScopedCategory readoutAccess(gem::hw::GEMHwDeviceStats::READOUT);
   uint32_t *point = &counter[0];
 
   DEBUG("GLIBReadout::getGLIBData Starting while loop readout "
@@ -154,29 +219,46 @@ uint32_t* gem::hw::glib::GLIBReadout::getGLIBData(uint8_t const& gtx, uint32_t c
         << p_glib->getFIFOOccupancy(gtx)
         );
   while ( p_glib->getFIFOVFATBlockOccupancy(gtx) ) {
+    // each read goes straight into a pool frame, which is decoded in place by the event builder
+    if (m_dataque.available() == 0) {
+      DEBUG(" ::getGLIBData data queue full (" << m_dataque.size() << " frames), leaving data in the FIFO");
+      break;
+    }
+    uint32_t nBlocks = std::min(p_glib->getFIFOVFATBlockOccupancy(gtx), kFRAMEBLOCKS);
+    toolbox::mem::Reference* frame = getFrame(nBlocks*kUPDATE7*sizeof(uint32_t));
+    if (!frame) {
+      // bounded memory, the rest stay in the hardware FIFO until the event builder releases frames
+      DEBUG(" ::getGLIBData readout pool exhausted, leaving data in the FIFO");
+      break;
+    }
     DEBUG("GLIBReadout::getGLIBData initiating call to getTrackingData(gtx,"
-          << p_glib->getFIFOVFATBlockOccupancy(gtx) << ")");
-    std::vector<uint32_t> data = p_glib->getTrackingData(gtx, p_glib->getFIFOVFATBlockOccupancy(gtx));
+          << nBlocks << ")");
+    uint32_t nRead = 0;
+    {
+      gem::readout::GEMReadoutMetrics::ScopedStage drain(m_readoutMetrics, gem::readout::GEMReadoutMetrics::FIFO_DRAIN);
+      nRead = p_glib->getTrackingData(gtx, static_cast<uint32_t*>(frame->getDataLocation()), nBlocks);
+    }
     DEBUG("GLIBReadout::getGLIBData"
           << std::endl << "FIFO VFAT block depth 0x" << std::hex
           << p_glib->getFIFOVFATBlockOccupancy(gtx)
           << std::endl << "FIFO depth 0x" << std::hex
           << p_glib->getFIFOOccupancy(gtx)
           );
-
-    uint32_t contqueue = 0;
-    for (auto iword = data.begin(); iword != data.end(); ++iword) {
-      contqueue++;
-      //gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_queueLock);
-      DEBUG(" ::getGLIBData pushing into queue 0x"
-            << std::setfill('0') << std::setw(8) << std::hex << *iword << std::dec );
-      m_dataque.push(*iword);
-      if (contqueue%kUPDATE7 == 0 &&  contqueue != 0) {
-        m_contvfats++;
-        DEBUG(" ::getGLIBData counter " << contqueue << " contvfats " << m_contvfats
-              << " m_dataque.size " << m_dataque.size());
-      }
+    if (nRead == 0) {
+      WARN(" ::getGLIBData no data read from the FIFO, " << nBlocks << " blocks expected");
+      frame->release();
+      break;
     }
+
+    frame->setDataSize(nRead*kUPDATE7*sizeof(uint32_t));
+    // single producer, the space was checked above
+    m_queuedWords += nRead*kUPDATE7;
+    m_dataque.push(&frame, 1);
+    m_readoutMetrics.addBytesRead(frame->getDataSize());
+    m_readoutMetrics.recordQueueDepth(m_dataque.size());
+    m_contvfats += nRead;
+    DEBUG(" ::getGLIBData pushed " << nRead << " blocks, contvfats " << m_contvfats
+          << " queued words " << m_queuedWords.load());
     DEBUG(" ::getGLIBData end of while loop do we go again?" << std::endl
           << " FIFO VFAT block occupancy  0x" << std::hex << p_glib->getFIFOVFATBlockOccupancy(gtx)
           << std::endl
@@ -217,24 +299,19 @@ uint32_t* gem::hw::glib::GLIBReadout::GEMEventMaker(uint32_t counter[5])
   //int islot = -1;
 
   // Booking FIFO variables
-  uint64_t msVFAT, lsVFAT;
   uint32_t ES;
 
   DEBUG("GLIBReadout::GEMEventMaker  " << std::hex << point );
-  if (m_dataque.empty()) return point;
-  DEBUG(" ::GEMEventMaker m_dataque.size " << m_dataque.size() );
-
-  this->readVFATblock(m_dataque);
-
-  uint64_t data1  = dat10 | dat11;
-  uint64_t data2  = dat20 | dat21;
-  uint64_t data3  = dat30 | dat31;
-  uint64_t data4  = dat40 | dat41;
+  if (!this->readVFATblock(vfat)) return point;
 
   m_vfat++;
 
   //islot = slotInfo->GEBslotIndex( (uint32_t)chipid);
 
+  uint16_t const evn    = gem::readout::GEMVFATDecoder::evn(vfat.EC);
+  uint16_t const bcn    = gem::readout::GEMVFATDecoder::bcn(vfat.BC);
+  uint16_t const chipid = gem::readout::GEMVFATDecoder::chipID(vfat.ChipID);
+
   // GEM Event selector
   ES = ( evn << 12 ) | bcn;
   DEBUG(" ::GEMEventMaker ES 0x" << std::hex << ES << " evn 0x"<< evn
@@ -244,17 +321,6 @@ uint32_t* gem::hw::glib::GLIBReadout::GEMEventMaker(uint32_t counter[5])
         //" slot number " << islot <<
         " m_isFirst " << m_isFirst << " event " << m_event);
 
-  lsVFAT = (data3 << 32) | (data4);
-  msVFAT = (data1 << 32) | (data2);
-
-  vfat.BC     = ( b1010 << 12 ) | (bcn);                // 1010     | bcn:12
-  vfat.EC     = ( b1100 << 12 ) | (evn << 4) | (flags); // 1100     | EC:8      | Flag:4
-  vfat.ChipID = ( b1110 << 12 ) | (chipid);             // 1110     | ChipID:12
-  vfat.lsData = lsVFAT;                                 // lsData:64
-  vfat.msData = msVFAT;                                 // msData:64
-  vfat.BXfrOH = BX;                                     // BXfrOH:32
-  vfat.crc    = vfatcrc;                                // crc:16
-
   if ( ES == m_ESexp ) {
     m_isFirst = false;
   } else {
@@ -276,13 +342,25 @@ uint32_t* gem::hw::glib::GLIBReadout::GEMEventMaker(uint32_t counter[5])
   //  if ( int(m_erros.size()) <MaxERRS ) m_erros.push_back(vfat);
   //  DEBUG(" ::GEMEventMaker warning !!! islot is undefined " << islot << " m_erros.size " << int(m_erros.size()) );
   //} else {
-  // VFATs Pay Load
-  if ( int(m_vfats.size()) <= MaxVFATS )
-    m_vfats.push_back(vfat);
-  DEBUG(" ::GEMEventMaker m_event " << m_event << " m_vfats.size " << m_vfats.size() << std::hex << " ES 0x" << ES << std::dec );
+  {
+    // only the CRC check and the placement of the block in the event
+    gem::readout::GEMReadoutMetrics::ScopedStage build(m_readoutMetrics, gem::readout::GEMReadoutMetrics::EVENT_BUILD);
+    if (!gem::datachecker::GEMDataChecker::isCRCGood(vfat)) {
+      if ( int(m_erros.size()) < MaxERRS )
+        m_erros.push_back(vfat);
+      DEBUG(" ::GEMEventMaker bad CRC 0x" << std::hex << vfat.crc << " computed 0x"
+            << gem::datachecker::GEMDataChecker::checkCRC(vfat) << std::dec
+            << " m_erros.size " << m_erros.size() );
+    } else {
+      // VFATs Pay Load
+      if ( int(m_vfats.size()) <= MaxVFATS )
+        m_vfats.push_back(vfat);
+      DEBUG(" ::GEMEventMaker m_event " << m_event << " m_vfats.size " << m_vfats.size() << std::hex << " ES 0x" << ES << std::dec );
+    }
+  }
   //}//end of event selection
 
-  m_queueDepth = m_dataque.size();
+  m_queueDepth = m_queuedWords.load();
   p_appInfoSpace->fireItemValueRetrieve("QueueDepth");
   p_appInfoSpace->fireItemValueChanged("QueueDepth");
 
@@ -334,7 +412,7 @@ void gem::hw::glib::GLIBReadout::GEMevSelector(const  uint32_t& ES)
           // GEM Event Writing
           DEBUG(" ::GEMEventMaker writing...  geb.vfats.size " << int(geb.vfats.size()) );
           TypeDataFlag = "PayLoad";
-          if(int(geb.vfats.size()) != 0) writeGEMevent(m_outFileName, false, TypeDataFlag,
+          if(int(geb.vfats.size()) != 0) writeGEMevent(*p_dataWriter, false, TypeDataFlag,
                                                        gem, geb, vfat);
           // update online histograms
 	  //          p_gemOnlineDQM->Update(geb);
@@ -370,7 +448,7 @@ void gem::hw::glib::GLIBReadout::GEMevSelector(const  uint32_t& ES)
         GEMfillTrailers(gem, geb);
         // GEM ERRORS Event Writing
         TypeDataFlag = "Errors";
-        if(int(geb.vfats.size()) != 0) writeGEMevent(m_errFileName, false, TypeDataFlag,
+        if(int(geb.vfats.size()) != 0) writeGEMevent(*p_errWriter, false, TypeDataFlag,
                                                      gem, geb, vfat);
         geb.vfats.clear();
       }// if localErr
@@ -420,7 +498,7 @@ bool gem::hw::glib::GLIBReadout::VFATfillData(/*int const& islot, */AMCGEBData&
 }// end VFATfillData
 
 
-void gem::hw::glib::GLIBReadout::writeGEMevent(std::string  outFile, bool const&  OKprint,
+void gem::hw::glib::GLIBReadout::writeGEMevent(gem::readout::GEMEventWriter& writer, bool const&  OKprint,
                                                std::string const& TypeDataFlag,
                                                AMCGEMData&  gem, AMCGEBData&  geb, AMCVFATData& vfat)
 {
@@ -428,49 +506,15 @@ void gem::hw::glib::GLIBReadout::writeGEMevent(std::string  outFile, bool const&
     DEBUG(" ::writeGEMevent m_vfat " << m_vfat << " event " << m_event << " sumVFAT " << (0x000000000fffffff & geb.header) <<
           " geb.vfats.size " << int(geb.vfats.size()) );
   }
-  // GEM Chamber's Data
-  if (m_outputType == "Hex") {
-    gem::readout::GEMDataAMCformat::writeGEMhd1 (outFile, m_event, gem);
-    gem::readout::GEMDataAMCformat::writeGEMhd2 (outFile, m_event, gem);
-    gem::readout::GEMDataAMCformat::writeGEMhd3 (outFile, m_event, gem);
-  } else {
-    gem::readout::GEMDataAMCformat::writeGEMhd1Binary (outFile, m_event, gem);
-    gem::readout::GEMDataAMCformat::writeGEMhd2Binary (outFile, m_event, gem);
-    gem::readout::GEMDataAMCformat::writeGEMhd3Binary (outFile, m_event, gem);
-  }
-  //  GEB Headers Data
-  if (m_outputType == "Hex") {
-    gem::readout::GEMDataAMCformat::writeGEBheader (outFile, m_event, geb);
-    gem::readout::GEMDataAMCformat::writeGEBrunhed (outFile, m_event, geb);
-  } else {
-    gem::readout::GEMDataAMCformat::writeGEBheaderBinary (outFile, m_event, geb);
-    //gem::readout::GEMDataAMCformat::writeGEBrunhedBinary (outFile, m_event, geb);
-  } // gem::readout::GEMDataAMCformat::printGEBheader (m_event, geb);
-  //  GEB PayLoad Data
-  int nChip=0;
-  for (auto iVFAT=geb.vfats.begin(); iVFAT != geb.vfats.end(); ++iVFAT) {
-    nChip++;
-
-    if (m_outputType == "Hex") {
-      gem::readout::GEMDataAMCformat::writeVFATdata (outFile, nChip, *iVFAT);
-    } else {
-      gem::readout::GEMDataAMCformat::writeVFATdataBinary (outFile, nChip, *iVFAT);
-    };
-  }//end of GEB PayLoad Data
-  //  GEB Trailers Data
-  if (m_outputType == "Hex") {
-    gem::readout::GEMDataAMCformat::writeGEBtrailer (outFile, m_event, geb);
-  } else {
-    gem::readout::GEMDataAMCformat::writeGEBtrailerBinary (outFile, m_event, geb);
-  }
-  //  GEM Trailers Data
-  if (m_outputType == "Hex") {
-    gem::readout::GEMDataAMCformat::writeGEMtr2 (outFile, m_event, gem);
-    gem::readout::GEMDataAMCformat::writeGEMtr1 (outFile, m_event, gem);
-  } else {
-    gem::readout::GEMDataAMCformat::writeGEMtr2Binary (outFile, m_event, gem);
-    gem::readout::GEMDataAMCformat::writeGEMtr1Binary (outFile, m_event, gem);
+  // whole event is serialized into the writer buffer, file is kept open for the run
+  gem::readout::GEMReadoutMetrics::ScopedStage write(m_readoutMetrics, gem::readout::GEMReadoutMetrics::WRITE);
+  uint64_t const bytesBefore = writer.getBytesWritten();
+  if (!writer.writeGEMevent(gem, geb)) {
+    WARN(" ::writeGEMevent " << TypeDataFlag << " output file is not open, dropping event " << m_event);
+    m_readoutMetrics.addEventsDropped(1);
   }
+  // only the flushed bytes, the writer buffers the events
+  m_readoutMetrics.addBytesWritten(writer.getBytesWritten() - bytesBefore);
 }
 
 void gem::hw::glib::GLIBReadout::GEMfillHeaders(uint32_t const& event, uint32_t const& DAVCount_,
@@ -572,69 +616,50 @@ void gem::hw::glib::GLIBReadout::GEMfillTrailers(AMCGEMData&  gem,AMCGEBData&  g
   DEBUG(" OHcrc 0x" << std::hex << OHcrc << " OHwCount " << OHwCount << " ChamStatus " << ChamStatus << std::dec);
 }
 
-void gem::hw::glib::GLIBReadout::readVFATblock(std::queue<uint32_t>& dataque)
+bool gem::hw::glib::GLIBReadout::readVFATblock(AMCVFATData& vfat)
 {
-  uint32_t datafront = 0;
-  for (int iQue = 0; iQue < 7; iQue++){
-    datafront = dataque.front();
-    DEBUG(" ::GEMEventMaker iQue " << iQue << " 0x"
-          << std::setfill('0') << std::setw(8) << std::hex << datafront << std::dec );
-    //this never seems to get reset? maybe iQue%7 to read the words after the first block?
-    if ((iQue%7) == 5 ) {
-      dat41   = ((0xffff0000 & datafront) >> 16 );
-      vfatcrc = (0x0000ffff & datafront);
-    } else if ( (iQue%7) == 4 ) {
-      dat40   = ((0x0000ffff & datafront) << 16 );
-      dat31   = ((0xffff0000 & datafront) >> 16 );
-    } else if ( (iQue%7) == 3 ) {
-      dat21   = ((0xffff0000 & datafront) >> 16 );
-      dat30   = ((0x0000ffff & datafront) << 16 );
-    } else if ( (iQue%7) == 2 ) {
-      dat11   = ((0xffff0000 & datafront) >> 16 );
-      dat20   = ((0x0000ffff & datafront) << 16 );
-    } else if ( (iQue%7) == 1 ) {
-      b1110   = ((0xf0000000 & datafront) >> 28 );
-      chipid  = ((0x0fff0000 & datafront) >> 16 );
-      dat10   = ((0x0000ffff & datafront) << 16 );
-    } else if ( (iQue%7) == 0 ) {
-      b1010   = ((0xf0000000 & datafront) >> 28 );
-      b1100   = ((0x0000f000 & datafront) >> 12 );
-      bcn     = ((0x0fff0000 & datafront) >> 16 );
-      evn     = ((0x00000ff0 & datafront) >>  4 );
-      flags   = (0x0000000f & datafront);
-
-      if (!(b1010 == 0xa && b1100 == 0xc)) {
-        bool misAligned_ = true;
-        while ((misAligned_) && (dataque.size()>7)){
-          /* we have a misaligned word, increment misalignment counter, pop queue,
-             push bad value into some form of storage for later analysis?
-             then continue with the loop, but without incrementing iQue so we hopefully
-             eventually align again
-
-             Do not go through all the loop with condition statements
-             since iQue stays the same and we removed 7 blocks
-             -MD
-          */
-          INFO(" ::GEMEventMaker found misaligned word 0x"
-               << std::setfill('0') << std::hex << datafront << std::dec
-               << " queue m_dataque.size " << dataque.size() );
-          dataque.pop();
-          datafront = dataque.front();
-          b1010   = ((0xf0000000 & datafront) >> 28 );
-          b1100   = ((0x0000f000 & datafront) >> 12 );
-          bcn     = ((0x0fff0000 & datafront) >> 16 );
-          evn     = ((0x00000ff0 & datafront) >>  4 );
-          flags   = (0x0000000f & datafront);
-          if ((b1010 == 0xa && b1100 == 0xc)) { misAligned_ = false;}
-        }// end of while misaligned
-      }
-    } else if ( (iQue%7) == 6 ) {
-      BX      = datafront;
+  while (m_batchIndex >= m_batch.size()) {
+    if (m_dataque.empty())
+      return false;
+
+    // the whole frame is decoded in one pass, so it can go back to the pool straight away
+    toolbox::mem::Reference* frame = m_dataque.front();
+    m_dataque.pop();
+    size_t const nWords = frame->getDataSize()/sizeof(uint32_t);
+    size_t nSkipped = 0;
+    m_batch.clear();
+    m_batchIndex = 0;
+    {
+      gem::readout::GEMReadoutMetrics::ScopedStage decode(m_readoutMetrics, gem::readout::GEMReadoutMetrics::DECODE);
+      gem::readout::GEMVFATDecoder::decodeBuffer(static_cast<uint32_t const*>(frame->getDataLocation()),
+                                                 nWords, m_batch, nSkipped);
     }
-    DEBUG(" ::GEMEventMaker (pre pop) m_dataque.size " << dataque.size() );
-    dataque.pop();
-    DEBUG(" ::GEMEventMaker (post pop)  m_dataque.size " << dataque.size() );
-  }// end queue
+    frame->release();
+
+    if (nSkipped > 0) {
+      /* we have misaligned words, increment misalignment counter,
+         push bad values into some form of storage for later analysis?
+      */
+      INFO(" ::GEMEventMaker dropped " << nSkipped << " misaligned words out of " << nWords);
+      m_queuedWords -= nSkipped;
+    }
+  }
+
+  m_batch.get(m_batchIndex++, vfat);
+  m_queuedWords -= kUPDATE7;
+  DEBUG(" ::GEMEventMaker (post pop) queued words " << m_queuedWords.load() );
+  return true;
+}
+
+void gem::hw::glib::GLIBReadout::releaseFrames()
+{
+  while (!m_dataque.empty()) {
+    m_dataque.front()->release();
+    m_dataque.pop();
+  }
+  m_batch.clear();
+  m_batchIndex  = 0;
+  m_queuedWords = 0;
 }
 
 
@@ -296,40 +296,39 @@ bool gem::hw::glib::HwGLIB::CDCELockStatus()
   return static_cast<bool>(readReg(getDeviceBaseNode(),regName.str()));
 }
 
-/** only for compatibility with some functions, will be removed **/
+/** the GLIB runs the generic AMC tracking data FIFO **/
 uint32_t gem::hw::glib::HwGLIB::getFIFOOccupancy(uint8_t const& gtx)
 {
-  return 0x0;
+  return gem::hw::HwGenericAMC::getFIFOOccupancy(gtx);
 }
 
 uint32_t gem::hw::glib::HwGLIB::getFIFOVFATBlockOccupancy(uint8_t const& gtx)
 {
-  return 0x0;
+  return gem::hw::HwGenericAMC::getFIFOVFATBlockOccupancy(gtx);
 }
 
 bool gem::hw::glib::HwGLIB::hasTrackingData(uint8_t const& gtx)
 {
-  return false;
+  return gem::hw::HwGenericAMC::hasTrackingData(gtx);
 }
 
 std::vector<uint32_t> gem::hw::glib::HwGLIB::getTrackingData(uint8_t const& gtx, size_t const& nBlocks)
 {
-  std::vector<uint32_t> res;
-  return res;
+  return gem::hw::HwGenericAMC::getTrackingData(gtx, nBlocks);
 }
 
 uint32_t gem::hw::glib::HwGLIB::getTrackingData(uint8_t const& gtx, uint32_t* data, size_t const& nBlocks)
 {
-  return 0x0;
+  return gem::hw::HwGenericAMC::getTrackingData(gtx, data, nBlocks);
 }
 
 uint32_t gem::hw::glib::HwGLIB::getTrackingData(uint8_t const& gtx, std::vector<toolbox::mem::Reference*>& data,
                                                 size_t const& nBlocks)
 {
-  return 0x0;
+  return gem::hw::HwGenericAMC::getTrackingData(gtx, data, nBlocks);
 }
 
 void gem::hw::glib::HwGLIB::flushFIFO(uint8_t const& gtx)
 {
-  return;
+  gem::hw::HwGenericAMC::flushFIFO(gtx);
 }
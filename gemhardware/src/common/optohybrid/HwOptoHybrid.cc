@@ -5,6 +5,7 @@
 #include <functional>
 
 #include "gem/hw/optohybrid/HwOptoHybrid.h"
+#include "gem/hw/GEMHwTransaction.h"
 
 // gem::hw::optohybrid::HwOptoHybrid::HwOptoHybrid() :
 //   gem::hw::GEMHwDevice::GEMHwDevice("HwOptoHybrid"),
@@ -85,6 +86,7 @@ gem::hw::optohybrid::HwOptoHybrid::HwOptoHybrid(gem::hw::glib::HwGLIB const& gli
   //uhal::ConnectionManager manager ( "file://${GEM_ADDRESS_TABLE_PATH}/connections.xml" );
   p_gemConnectionManager.reset(new uhal::ConnectionManager("file://${GEM_ADDRESS_TABLE_PATH}/connections.xml"));
   p_gemHW.reset(new uhal::HwInterface(p_gemConnectionManager->getDevice(this->getDeviceID())));
+  clearRegisterHandles();
   //p_gemConnectionManager = std::shared_ptr<uhal::ConnectionManager>(uhal::ConnectionManager("file://${GEM_ADDRESS_TABLE_PATH}/connections.xml"));
   //p_gemHW = std::shared_ptr<uhal::HwInterface>(p_gemConnectionManager->getDevice(this->getDeviceID()));
   std::stringstream basenode;
@@ -217,12 +219,22 @@ std::vector<uint32_t> gem::hw::optohybrid::HwOptoHybrid::broadcastRead(std::stri
                                                                        bool               reset)
 {
   auto t1 = std::chrono::high_resolution_clock::now();
-  if (reset)
-    writeReg(getDeviceBaseNode(),toolbox::toString("GEB.Broadcast.Reset"),0x1);
-  writeReg(getDeviceBaseNode(),toolbox::toString("GEB.Broadcast.Mask"),mask);
-  readReg(getDeviceBaseNode(),toolbox::toString("GEB.Broadcast.Request.%s", name.c_str()));
+  RegisterHandle const& running = getRegisterHandle(getDeviceBaseNode(),"GEB.Broadcast.Running");
+  GEMHwTransaction::Value isRunning;
+  {
+    // the request and the first status check go out with a single dispatch
+    GEMHwTransaction batch(*this);
+    if (reset)
+      writeReg(getDeviceBaseNode(),"GEB.Broadcast.Reset",0x1);
+    writeReg(getDeviceBaseNode(),"GEB.Broadcast.Mask",mask);
+    batch.read(getRegisterHandle(getDeviceBaseNode(),"GEB.Broadcast.Request."+name));
+    isRunning = batch.read(running);
+  }
+  // the chips were written behind the back of their HwVFAT2 objects
+  gem::hw::vfat::HwVFAT2::invalidateAllShadows();
 
-  while (readReg(getDeviceBaseNode(),"GEB.Broadcast.Running")) {
+  bool busy = !isRunning.valid() || isRunning.value();
+  while (busy && readReg(running)) {
     TRACE("HwOptoHybrid::broadcastRead transaction on "
           << name << " is still running...");
     usleep(10);
@@ -243,11 +255,20 @@ void gem::hw::optohybrid::HwOptoHybrid::broadcastWrite(std::string const& name,
                                                        bool reset)
 {
   auto t1 = std::chrono::high_resolution_clock::now();
-  if (reset)
-    writeReg(getDeviceBaseNode(),toolbox::toString("GEB.Broadcast.Reset"),0x1);
-  writeReg(getDeviceBaseNode(),toolbox::toString("GEB.Broadcast.Mask"),mask);
-  writeReg(getDeviceBaseNode(),toolbox::toString("GEB.Broadcast.Request.%s", name.c_str()),value);
-  while (readReg(getDeviceBaseNode(),"GEB.Broadcast.Running")) {
+  RegisterHandle const& running = getRegisterHandle(getDeviceBaseNode(),"GEB.Broadcast.Running");
+  GEMHwTransaction::Value isRunning;
+  {
+    // the request and the first status check go out with a single dispatch
+    GEMHwTransaction batch(*this);
+    if (reset)
+      writeReg(getDeviceBaseNode(),"GEB.Broadcast.Reset",0x1);
+    writeReg(getDeviceBaseNode(),"GEB.Broadcast.Mask",mask);
+    writeReg(getDeviceBaseNode(),"GEB.Broadcast.Request."+name,value);
+    isRunning = batch.read(running);
+  }
+
+  bool busy = !isRunning.valid() || isRunning.value();
+  while (busy && readReg(running)) {
     TRACE("HwOptoHybrid::broadcastWrite transaction on "
           << name << " is still running...");
     usleep(10);
@@ -537,7 +558,7 @@ uint32_t gem::hw::optohybrid::HwOptoHybrid::getVFATDACOutI(uint8_t const& column
 }
 
 //////// Scan Modules \\\\\\\\*
-void gem::hw::optohybrid::HwOptoHybrid::configureScanModule(uint8_t const& mode, uint8_t const& chip, uint8_t const& channel,
+void gem::hw::optohybrid::HwOptoHybrid::configureScanModule(uint8_t const& mode, uint32_t const& chip, uint8_t const& channel,
                                                             uint8_t const& min,  uint8_t const& max,
                                                             uint8_t const& step, uint32_t const& nevts,
                                                             bool useUltra, bool reset)
@@ -618,8 +639,8 @@ uint8_t gem::hw::optohybrid::HwOptoHybrid::getScanStatus(bool useUltra)
 std::vector<uint32_t> gem::hw::optohybrid::HwOptoHybrid::getScanResults(uint32_t const& npoints)
 {
   while (readReg(getDeviceBaseNode(),"ScanController.THLAT.MONITOR.STATUS") > 0) {
-    INFO("Scan still running, not returning results");
-    usleep(10);
+    DEBUG("Scan still running, not returning results");
+    usleep(1000);
   }
   std::stringstream regname;
   regname << getDeviceBaseNode() << ".ScanController.THLAT.RESULTS";
@@ -629,16 +650,28 @@ std::vector<uint32_t> gem::hw::optohybrid::HwOptoHybrid::getScanResults(uint32_t
 std::vector<std::vector<uint32_t> > gem::hw::optohybrid::HwOptoHybrid::getUltraScanResults(uint32_t const& npoints)
 {
   while (readReg(getDeviceBaseNode(),"ScanController.ULTRA.MONITOR.STATUS") > 0) {
-    INFO("Scan still running, not returning results");
-    usleep(10);
+    DEBUG("Scan still running, not returning results");
+    usleep(1000);
   }
+  std::vector<uint32_t> words(24*npoints, 0x0);
+  readUltraScanResults(npoints, words.data());
   std::vector<std::vector<uint32_t> > results;
+  for (int vfat = 0; vfat < 24; ++vfat)
+    results.push_back(std::vector<uint32_t>(words.begin()+vfat*npoints, words.begin()+(vfat+1)*npoints));
+  return results;
+}
+
+uint32_t gem::hw::optohybrid::HwOptoHybrid::readUltraScanResults(uint32_t const& npoints, uint32_t* buffer)
+{
+  // the handles are cached by the device, only the first scan looks them up
+  std::vector<RegisterHandle> blocks;
+  blocks.reserve(24);
   for (int vfat = 0; vfat < 24; ++vfat) {
     std::stringstream regname;
     regname << getDeviceBaseNode() << ".ScanController.ULTRA.RESULTS.VFAT" << vfat;
-    results.push_back(readBlock(regname.str(), npoints));
+    blocks.push_back(getRegisterHandle(regname.str()));
   }
-  return results;
+  return readBlocks(blocks, buffer, npoints);
 }
 
 
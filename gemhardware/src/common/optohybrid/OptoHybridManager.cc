@@ -8,6 +8,8 @@
 
 #include "gem/hw/optohybrid/OptoHybridManager.h"
 
+#include <functional>
+
 #include "gem/hw/optohybrid/HwOptoHybrid.h"
 #include "gem/hw/optohybrid/OptoHybridMonitor.h"
 #include "gem/hw/optohybrid/OptoHybridManagerWeb.h"
@@ -16,6 +18,7 @@
 
 #include "gem/hw/vfat/HwVFAT2.h"
 #include "gem/hw/utils/GEMCrateUtils.h"
+#include "gem/hw/utils/GEMSlotTasks.h"
 
 #include "xoap/MessageReference.h"
 #include "xoap/MessageFactory.h"
@@ -133,20 +136,24 @@ void gem::hw::optohybrid::OptoHybridManager::CommonVFATSettings::registerFields(
 }
 
 gem::hw::optohybrid::OptoHybridManager::OptoHybridManager(xdaq::ApplicationStub* stub) :
-  gem::base::GEMFSMApplication(stub)
+  gem::base::GEMFSMApplication(stub),
+  m_maxSlotWorkers(gem::hw::utils::GEMSlotTasks::DEFAULT_MAX_WORKERS)
 {
   m_optohybridInfo.setSize(MAX_OPTOHYBRIDS_PER_AMC*MAX_AMCS_PER_CRATE);
 
   p_appInfoSpace->fireItemAvailable("AllOptoHybridsInfo", &m_optohybridInfo);
   // p_appInfoSpace->fireItemAvailable("AMCSlots",           &m_amcSlots);
   p_appInfoSpace->fireItemAvailable("ConnectionFile",     &m_connectionFile);
+  p_appInfoSpace->fireItemAvailable("MaxSlotWorkers",     &m_maxSlotWorkers);
 
   p_appInfoSpace->addItemRetrieveListener("AllOptoHybridsInfo", this);
   // p_appInfoSpace->addItemRetrieveListener("AMCSlots",           this);
   p_appInfoSpace->addItemRetrieveListener("ConnectionFile",     this);
+  p_appInfoSpace->addItemRetrieveListener("MaxSlotWorkers",     this);
   p_appInfoSpace->addItemChangedListener( "AllOptoHybridsInfo", this);
   // p_appInfoSpace->addItemChangedListener( "AMCSlots",           this);
   p_appInfoSpace->addItemChangedListener( "ConnectionFile",     this);
+  p_appInfoSpace->addItemChangedListener( "MaxSlotWorkers",     this);
 
   // initialize the OptoHybrid application objects
   DEBUG("OptoHybridManager::Connecting to the OptoHybridManagerWeb interface");
@@ -204,9 +211,14 @@ void gem::hw::optohybrid::OptoHybridManager::initializeAction()
   throw (gem::hw::optohybrid::exception::Exception)
 {
   DEBUG("OptoHybridManager::initializeAction begin");
-  // FIXME make me more streamlined
+
+  // the InfoSpaces are created here, the hardware is connected by one task per AMC slot,
+  // the InfoSpace items and monitors are created once all slots are connected
+  std::array<std::array<std::string, MAX_OPTOHYBRIDS_PER_AMC>, MAX_AMCS_PER_CRATE> deviceNames;
+  gem::hw::utils::GEMSlotTasks tasks(m_maxSlotWorkers.value_);
   for (unsigned slot = 0; slot < MAX_AMCS_PER_CRATE; ++slot) {
     DEBUG("OptoHybridManager::initializeAction looping over slots(" << (slot+1) << ") and finding expected cards");
+    bool slotPresent = false;
     for (unsigned link = 0; link < MAX_OPTOHYBRIDS_PER_AMC; ++link) {
       DEBUG("OptoHybridManager::initializeAction looping over links(" << link << ") and finding expected cards");
       unsigned int index = (slot*MAX_OPTOHYBRIDS_PER_AMC)+link;
@@ -221,110 +233,90 @@ void gem::hw::optohybrid::OptoHybridManager::initializeAction()
         continue;
 
       DEBUG("OptoHybridManager::initializeAction: info is: " << info.toString());
-      DEBUG("OptoHybridManager::initializeAction creating pointer to board connected on link "
-            << link << " to AMC in slot " << (slot+1));
       std::string deviceName = info.cardName.toString();
       if (deviceName.empty())
         deviceName = toolbox::toString("gem.shelf%02d.amc%02d.optohybrid%02d",
                                        info.crateID.value_,
                                        info.slotID.value_,
                                        info.linkID.value_);
-      toolbox::net::URN hwCfgURN("urn:gem:hw:"+deviceName);
+      try {
+        toolbox::net::URN hwCfgURN("urn:gem:hw:"+deviceName);
 
-      if (xdata::getInfoSpaceFactory()->hasItem(hwCfgURN.toString())) {
-        DEBUG("OptoHybridManager::initializeAction::infospace " << hwCfgURN.toString() << " already exists, getting");
-        is_optohybrids.at(slot).at(link) = is_toolbox_ptr(new gem::base::utils::GEMInfoSpaceToolBox(this,
-                                                                                                    hwCfgURN.toString(),
-                                                                                                    true));
+        if (xdata::getInfoSpaceFactory()->hasItem(hwCfgURN.toString())) {
+          DEBUG("OptoHybridManager::initializeAction::infospace " << hwCfgURN.toString() << " already exists, getting");
+          is_optohybrids.at(slot).at(link) = is_toolbox_ptr(new gem::base::utils::GEMInfoSpaceToolBox(this,
+                                                                                                      hwCfgURN.toString(),
+                                                                                                      true));
 
-      } else {
-        DEBUG("OptoHybridManager::initializeAction::infospace " << hwCfgURN.toString() << " does not exist, creating");
-        is_optohybrids.at(slot).at(link) = is_toolbox_ptr(new gem::base::utils::GEMInfoSpaceToolBox(this,
-                                                                                                    hwCfgURN.toString(),
-                                                                                                    true));
-      }
-
-      try {
-        DEBUG("OptoHybridManager::initializeAction obtaining pointer to HwOptoHybrid " << deviceName
-              << " (slot " << slot+1 << ")"
-              << " (link " << link   << ")");
-        m_optohybrids.at(slot).at(link) = optohybrid_shared_ptr(new gem::hw::optohybrid::HwOptoHybrid(deviceName,m_connectionFile.toString()));
-      } catch (gem::hw::optohybrid::exception::Exception const& e) {
-        std::stringstream msg;
-        msg << "OptoHybridManager::initializeAction caught exception " << e.what();
-        ERROR(msg.str());
-        XCEPT_RAISE(gem::hw::optohybrid::exception::Exception, msg.str());
+        } else {
+          DEBUG("OptoHybridManager::initializeAction::infospace " << hwCfgURN.toString() << " does not exist, creating");
+          is_optohybrids.at(slot).at(link) = is_toolbox_ptr(new gem::base::utils::GEMInfoSpaceToolBox(this,
+                                                                                                      hwCfgURN.toString(),
+                                                                                                      true));
+        }
       } catch (toolbox::net::exception::MalformedURN const& e) {
         std::stringstream msg;
         msg << "OptoHybridManager::initializeAction caught exception " << e.what();
         ERROR(msg.str());
         XCEPT_RAISE(gem::hw::optohybrid::exception::Exception, msg.str());
-      } catch (std::exception const& e) {
-        std::stringstream msg;
-        msg << "OptoHybridManager::initializeAction caught exception " << e.what();
-        ERROR(msg.str());
-        XCEPT_RAISE(gem::hw::optohybrid::exception::Exception, msg.str());
       }
-      DEBUG("OptoHybridManager::initializeAction connected");
-      // set the web view to be empty or grey
-      // if (!info.present.value_) continue;
-      // p_gemWebInterface->optohybridInSlot(slot);
+      deviceNames.at(slot).at(link) = deviceName;
+      slotPresent = true;
+    }
 
-      DEBUG("OptoHybridManager::initializeAction grabbing pointer to hardware device");
-      optohybrid_shared_ptr optohybrid = m_optohybrids.at(slot).at(link);
-      if (optohybrid->isHwConnected()) {
-        // get connected VFATs
-        m_vfatMapping.at(slot).at(link)   = optohybrid->getConnectedVFATs(true);
-        INFO("OptoHybridManager::initializeAction Obtained vfatMapping");
-        // all the rest of these are related to the first by bitwise logic, can avoid doing the 4 calls
-        m_trackingMask.at(slot).at(link)  = optohybrid->getConnectedVFATMask(true);
-        INFO("OptoHybridManager::initializeAction Obtained trackingMask");
-        m_broadcastList.at(slot).at(link) = m_trackingMask.at(slot).at(link);
-        INFO("OptoHybridManager::initializeAction Obtained broadcastList");
-        m_sbitMask.at(slot).at(link) = m_trackingMask.at(slot).at(link);
-        INFO("OptoHybridManager::initializeAction Obtained sbitMask");
-
-        createOptoHybridInfoSpaceItems(is_optohybrids.at(slot).at(link), optohybrid);
-        INFO("OptoHybridManager::initializeAction looping over created VFAT devices");
-        for (auto mapit = m_vfatMapping.at(slot).at(link).begin();
-             mapit != m_vfatMapping.at(slot).at(link).end(); ++mapit) {
-          INFO("OptoHybridManager::initializeAction VFAT" << (int)mapit->first << " has chipID "
-               << std::hex << (int)mapit->second << std::dec << " (from map)");
-          // gem::hw::vfat::HwVFAT2& vfatDevice = optohybrid->getVFATDevice(mapit->first);
-          // INFO("OptoHybridManager::initializeAction VFAT" << (int)mapit->first << " has chipID "
-          //      << std::hex << (int)vfatDevice.getChipID() << std::dec << " (from HW device) ");
-        }
+    if (slotPresent)
+      tasks.add(toolbox::toString("AMC%02d", slot+1),
+                std::bind(&OptoHybridManager::connectOptoHybrids, this, slot, std::cref(deviceNames.at(slot))));
+  }
 
-        if (!m_disableMonitoring) {
-          m_optohybridMonitors.at(slot).at(link) = std::shared_ptr<OptoHybridMonitor>(new OptoHybridMonitor(optohybrid, this, index));
-          m_optohybridMonitors.at(slot).at(link)->addInfoSpace("HWMonitoring", is_optohybrids.at(slot).at(link));
-          m_optohybridMonitors.at(slot).at(link)->setupHwMonitoring();
-          m_optohybridMonitors.at(slot).at(link)->startMonitoring();
-        }
+  bool const success = tasks.run();
+  INFO("OptoHybridManager::initializeAction slot tasks:" << std::endl << tasks.summary());
+  if (!success) {
+    std::stringstream msg;
+    msg << "OptoHybridManager::initializeAction failed for" << std::endl << tasks.errors();
+    ERROR(msg.str());
+    XCEPT_RAISE(gem::hw::optohybrid::exception::Exception, msg.str());
+  }
 
-        INFO("OptoHybridManager::initializeAction OptoHybrid connected on link "
-             << link << " to AMC in slot " << (slot+1) << std::endl
-             << "Tracking mask: 0x" << std::hex << std::setw(8) << std::setfill('0')
-             << m_trackingMask.at(slot).at(link)
-             << std::dec << std::endl
-             << "Broadcst mask: 0x" << std::hex << std::setw(8) << std::setfill('0')
-             << m_broadcastList.at(slot).at(link)
-             << std::dec << std::endl
-             << "    SBit mask: 0x" << std::hex << std::setw(8) << std::setfill('0')
-             << m_sbitMask.at(slot).at(link)
-             << std::dec << std::endl
-             );
-        optohybrid->setVFATMask(m_trackingMask.at(slot).at(link));
-        optohybrid->setSBitMask(m_sbitMask.at(slot).at(link));
-        // turn off any that are excluded by the additional mask?
-      } else {
-        std::stringstream msg;
-        msg << "OptoHybridManager::initializeAction OptoHybrid connected on link "
-            << link << " to AMC in slot " << (slot+1) << " is not responding";
-        ERROR(msg.str());
-        // fireEvent("Fail");
-        XCEPT_RAISE(gem::hw::optohybrid::exception::Exception, msg.str());
+  for (unsigned slot = 0; slot < MAX_AMCS_PER_CRATE; ++slot) {
+    for (unsigned link = 0; link < MAX_OPTOHYBRIDS_PER_AMC; ++link) {
+      unsigned int index = (slot*MAX_OPTOHYBRIDS_PER_AMC)+link;
+      OptoHybridInfo& info = m_optohybridInfo[index].bag;
+
+      if (!info.present)
+        continue;
+
+      optohybrid_shared_ptr optohybrid = m_optohybrids.at(slot).at(link);
+      createOptoHybridInfoSpaceItems(is_optohybrids.at(slot).at(link), optohybrid);
+      INFO("OptoHybridManager::initializeAction looping over created VFAT devices");
+      for (auto mapit = m_vfatMapping.at(slot).at(link).begin();
+           mapit != m_vfatMapping.at(slot).at(link).end(); ++mapit) {
+        INFO("OptoHybridManager::initializeAction VFAT" << (int)mapit->first << " has chipID "
+             << std::hex << (int)mapit->second << std::dec << " (from map)");
+        // gem::hw::vfat::HwVFAT2& vfatDevice = optohybrid->getVFATDevice(mapit->first);
+        // INFO("OptoHybridManager::initializeAction VFAT" << (int)mapit->first << " has chipID "
+        //      << std::hex << (int)vfatDevice.getChipID() << std::dec << " (from HW device) ");
+      }
+
+      if (!m_disableMonitoring) {
+        m_optohybridMonitors.at(slot).at(link) = std::shared_ptr<OptoHybridMonitor>(new OptoHybridMonitor(optohybrid, this, index));
+        m_optohybridMonitors.at(slot).at(link)->addInfoSpace("HWMonitoring", is_optohybrids.at(slot).at(link));
+        m_optohybridMonitors.at(slot).at(link)->setupHwMonitoring();
+        m_optohybridMonitors.at(slot).at(link)->startMonitoring();
       }
+
+      INFO("OptoHybridManager::initializeAction OptoHybrid connected on link "
+           << link << " to AMC in slot " << (slot+1) << std::endl
+           << "Tracking mask: 0x" << std::hex << std::setw(8) << std::setfill('0')
+           << m_trackingMask.at(slot).at(link)
+           << std::dec << std::endl
+           << "Broadcst mask: 0x" << std::hex << std::setw(8) << std::setfill('0')
+           << m_broadcastList.at(slot).at(link)
+           << std::dec << std::endl
+           << "    SBit mask: 0x" << std::hex << std::setw(8) << std::setfill('0')
+           << m_sbitMask.at(slot).at(link)
+           << std::dec << std::endl
+           );
       // FOR MISHA
       // hardware should be connected, can update ldqm_db for teststand/local runs
     }
@@ -332,6 +324,44 @@ void gem::hw::optohybrid::OptoHybridManager::initializeAction()
   INFO("OptoHybridManager::initializeAction end");
 }
 
+void gem::hw::optohybrid::OptoHybridManager::connectOptoHybrids(unsigned const& slot,
+                                                                std::array<std::string, MAX_OPTOHYBRIDS_PER_AMC> const& deviceNames)
+{
+  for (unsigned link = 0; link < MAX_OPTOHYBRIDS_PER_AMC; ++link) {
+    std::string const& deviceName = deviceNames.at(link);
+    if (deviceName.empty())
+      continue;
+
+    DEBUG("OptoHybridManager::connectOptoHybrids obtaining pointer to HwOptoHybrid " << deviceName
+          << " (slot " << slot+1 << ")"
+          << " (link " << link   << ")");
+    m_optohybrids.at(slot).at(link) = optohybrid_shared_ptr(new gem::hw::optohybrid::HwOptoHybrid(deviceName,m_connectionFile.toString()));
+
+    optohybrid_shared_ptr optohybrid = m_optohybrids.at(slot).at(link);
+    if (optohybrid->isHwConnected()) {
+      // get connected VFATs
+      m_vfatMapping.at(slot).at(link)   = optohybrid->getConnectedVFATs(true);
+      DEBUG("OptoHybridManager::connectOptoHybrids Obtained vfatMapping");
+      // all the rest of these are related to the first by bitwise logic, can avoid doing the 4 calls
+      m_trackingMask.at(slot).at(link)  = optohybrid->getConnectedVFATMask(true);
+      m_broadcastList.at(slot).at(link) = m_trackingMask.at(slot).at(link);
+      m_sbitMask.at(slot).at(link)      = m_trackingMask.at(slot).at(link);
+      DEBUG("OptoHybridManager::connectOptoHybrids Obtained trackingMask, broadcastList and sbitMask");
+
+      optohybrid->setVFATMask(m_trackingMask.at(slot).at(link));
+      optohybrid->setSBitMask(m_sbitMask.at(slot).at(link));
+      // turn off any that are excluded by the additional mask?
+    } else {
+      std::stringstream msg;
+      msg << "OptoHybridManager::connectOptoHybrids OptoHybrid connected on link "
+          << link << " to AMC in slot " << (slot+1) << " is not responding";
+      ERROR(msg.str());
+      // fireEvent("Fail");
+      XCEPT_RAISE(gem::hw::optohybrid::exception::Exception, msg.str());
+    }
+  }
+}
+
 void gem::hw::optohybrid::OptoHybridManager::configureAction()
   throw (gem::hw::optohybrid::exception::Exception)
 {
@@ -94,6 +94,9 @@ void gem::hw::optohybrid::OptoHybridManagerWeb::jsonUpdate(xgi::Input* in, xgi::
   throw (xgi::exception::Exception)
 {
   DEBUG("OptoHybridManagerWeb::jsonUpdate");
+  uint32_t const since    = jsonSince(in);
+  // taken before the items are refreshed, the changes seen while writing are sent again next time
+  uint32_t const sequence = gem::base::GEMMonitor::jsonSequence();
   out->getHTTPResponseHeader().addHeader("Content-Type", "application/json");
   *out << " { " << std::endl;
   for (unsigned int i = 0; i < gem::base::GEMFSMApplication::MAX_AMCS_PER_CRATE; ++i) {
@@ -103,7 +106,7 @@ void gem::hw::optohybrid::OptoHybridManagerWeb::jsonUpdate(xgi::Input* in, xgi::
            << "\"  : { "    << std::endl;
       auto card = dynamic_cast<gem::hw::optohybrid::OptoHybridManager*>(p_gemFSMApp)->m_optohybridMonitors.at(i).at(j);
       if (card) {
-        card->jsonUpdateItemSets(out);
+        card->jsonUpdateItemSets(out, since);
       }
       // can't have a trailing comma for the last entry...
       if (i == (gem::base::GEMFSMApplication::MAX_AMCS_PER_CRATE-1) &&
@@ -113,5 +116,6 @@ void gem::hw::optohybrid::OptoHybridManagerWeb::jsonUpdate(xgi::Input* in, xgi::
         *out << " }," << std::endl;
     }
   }
+  *out << ",\"sequence\" : " << sequence << std::endl;
   *out << " } " << std::endl;
 }
@@ -22,7 +22,7 @@ typedef gem::base::utils::GEMInfoSpaceToolBox::UpdateType GEMUpdateType;
 gem::hw::optohybrid::OptoHybridMonitor::OptoHybridMonitor(std::shared_ptr<HwOptoHybrid> optohybrid,
                                                           OptoHybridManager* optohybridManager,
                                                           int const& index) :
-  GEMMonitor(optohybridManager->getApplicationLogger(), static_cast<xdaq::Application*>(optohybridManager), index),
+  GEMHwMonitor(optohybrid, optohybridManager->getApplicationLogger(), static_cast<xdaq::Application*>(optohybridManager), index),
   p_optohybrid(optohybrid)
 {
   // application info space is added in the base class constructor
@@ -227,6 +227,10 @@ void gem::hw::optohybrid::OptoHybridMonitor::setupHwMonitoring()
     }
   }
 
+  addIPBusStatsMonitorables("HWMonitoring");
+
+  // resolve all register addresses once, rather than on every update
+  compileMonitorables();
   updateMonitorables();
 }
 
@@ -235,62 +239,6 @@ gem::hw::optohybrid::OptoHybridMonitor::~OptoHybridMonitor()
 
 }
 
-void gem::hw::optohybrid::OptoHybridMonitor::updateMonitorables()
-{
-  // define how to update the desired values
-  // get SYSTEM monitorables
-  // can this be split into two loops, one just to do a list read, the second to fill the InfoSpace with the returned values
-  DEBUG("OptoHybridMonitor: Updating monitorables");
-  for (auto monlist = m_monitorableSetsMap.begin(); monlist != m_monitorableSetsMap.end(); ++monlist) {
-    DEBUG("OptoHybridMonitor: Updating monitorables in set " << monlist->first);
-    for (auto monitem = monlist->second.begin(); monitem != monlist->second.end(); ++monitem) {
-      DEBUG("OptoHybridMonitor: Updating monitorable " << monitem->first);
-      std::stringstream regName;
-      regName << p_optohybrid->getDeviceBaseNode() << "." << monitem->second.regname;
-      uint32_t address = p_optohybrid->getGEMHwInterface().getNode(regName.str()).getAddress();
-      uint32_t mask    = p_optohybrid->getGEMHwInterface().getNode(regName.str()).getMask();
-      if (monitem->second.updatetype == GEMUpdateType::HW8) {
-        (monitem->second.infoSpace)->setUInt32(monitem->first,p_optohybrid->readReg(address,mask));
-      } else if (monitem->second.updatetype == GEMUpdateType::HW16) {
-        (monitem->second.infoSpace)->setUInt32(monitem->first,p_optohybrid->readReg(address,mask));
-      } else if (monitem->second.updatetype == GEMUpdateType::HW24) {
-        (monitem->second.infoSpace)->setUInt32(monitem->first,p_optohybrid->readReg(address,mask));
-      } else if (monitem->second.updatetype == GEMUpdateType::HW32) {
-        (monitem->second.infoSpace)->setUInt32(monitem->first,p_optohybrid->readReg(address,mask));
-      } else if (monitem->second.updatetype == GEMUpdateType::HW64) {
-        address = p_optohybrid->getGEMHwInterface().getNode(regName.str()+".LOWER").getAddress();
-        mask    = p_optohybrid->getGEMHwInterface().getNode(regName.str()+".LOWER").getMask();
-        uint32_t lower = p_optohybrid->readReg(address,mask);
-        address = p_optohybrid->getGEMHwInterface().getNode(regName.str()+".UPPER").getAddress();
-        mask    = p_optohybrid->getGEMHwInterface().getNode(regName.str()+".UPPER").getMask();
-        uint32_t upper = p_optohybrid->readReg(address,mask);
-        (monitem->second.infoSpace)->setUInt64(monitem->first, (((uint64_t)upper) << 32) + lower);
-      } else if (monitem->second.updatetype == GEMUpdateType::I2CSTAT) {
-        std::stringstream strobeReg;
-        strobeReg << regName.str() << ".Strobe." << monitem->first;
-        address = p_optohybrid->getGEMHwInterface().getNode(strobeReg.str()).getAddress();
-        mask    = p_optohybrid->getGEMHwInterface().getNode(strobeReg.str()).getMask();
-        uint32_t strobe = p_optohybrid->readReg(address,mask);
-        std::stringstream ackReg;
-        ackReg << regName.str() << ".Ack." << monitem->first;
-        address = p_optohybrid->getGEMHwInterface().getNode(ackReg.str()).getAddress();
-        mask    = p_optohybrid->getGEMHwInterface().getNode(ackReg.str()).getMask();
-        uint32_t ack = p_optohybrid->readReg(address,mask);
-        (monitem->second.infoSpace)->setUInt64(monitem->first, (((uint64_t)ack) << 32) + strobe);
-      } else if (monitem->second.updatetype == GEMUpdateType::PROCESS) {
-        (monitem->second.infoSpace)->setUInt32(monitem->first,p_optohybrid->readReg(address,mask));
-      } else if (monitem->second.updatetype == GEMUpdateType::TRACKER) {
-        (monitem->second.infoSpace)->setUInt32(monitem->first,p_optohybrid->readReg(address,mask));
-      } else if (monitem->second.updatetype == GEMUpdateType::NOUPDATE) {
-        continue;
-      } else {
-        ERROR("OptoHybridMonitor: Unknown update type encountered");
-        continue;
-      }
-    } // end loop over items in list
-  } // end loop over monitorableSets
-}
-
 void gem::hw::optohybrid::OptoHybridMonitor::buildMonitorPage(xgi::Output* out)
 {
   DEBUG("OptoHybridMonitor::buildMonitorPage");
@@ -781,4 +729,5 @@ void gem::hw::optohybrid::OptoHybridMonitor::reset()
   m_infoSpaceMonitorableSetMap.clear();
   m_monitorableSetInfoSpaceMap.clear();
   m_monitorableSetsMap.clear();
+  clearCompiledMonitorables();
 }
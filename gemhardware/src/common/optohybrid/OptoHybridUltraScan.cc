@@ -0,0 +1,194 @@
+/**
+ * class: OptoHybridUltraScan
+ * description: ULTRA scan of all the VFATs of several OptoHybrids in parallel
+ */
+
+#include "gem/hw/optohybrid/OptoHybridUltraScan.h"
+
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+#include "gem/hw/utils/GEMSlotTasks.h"
+
+gem::hw::optohybrid::UltraScanResults::UltraScanResults() :
+  m_mode(0),
+  m_min(0),
+  m_step(1),
+  m_nPoints(0),
+  m_nTriggers(0)
+{
+}
+
+gem::hw::optohybrid::UltraScanResults::UltraScanResults(uint8_t const& mode,
+                                                        uint8_t const& min, uint8_t const& max, uint8_t const& step,
+                                                        uint32_t const& nTriggers,
+                                                        std::vector<uint8_t> const& channels) :
+  m_mode(mode),
+  m_min(min),
+  m_step(step > 0 ? step : 1),
+  m_nPoints(max >= min ? (max - min)/m_step + 1 : 0),
+  m_nTriggers(nTriggers),
+  m_channels(isPerChannel(mode) ? channels : std::vector<uint8_t>(1, 0))
+{
+  m_counts.assign(MAX_VFATS*m_channels.size()*m_nPoints, 0);
+}
+
+int gem::hw::optohybrid::UltraScanResults::channel(size_t const& channelIdx) const
+{
+  if (!isPerChannel(m_mode))
+    return -1;
+  return m_channels.at(channelIdx);
+}
+
+uint32_t gem::hw::optohybrid::UltraScanResults::fill(size_t const& channelIdx, uint32_t const* words)
+{
+  uint32_t dropped = 0;
+  for (uint8_t vfat = 0; vfat < MAX_VFATS; ++vfat) {
+    for (uint32_t word = 0; word < m_nPoints; ++word) {
+      uint32_t const data  = words[vfat*m_nPoints + word];
+      uint32_t const value = (data >> 24) & 0xff;
+      if (value < m_min || (value - m_min) % m_step || (value - m_min)/m_step >= m_nPoints) {
+        ++dropped;
+        continue;
+      }
+      m_counts[index(vfat, channelIdx, (value - m_min)/m_step)] = data & 0xffffff;
+    }
+  }
+  return dropped;
+}
+
+void gem::hw::optohybrid::UltraScanResults::write(std::ostream& out, uint32_t const& vfatMask) const
+{
+  out << "# mode " << static_cast<uint32_t>(m_mode) << std::endl
+      << "# vfat channel value nevents ntriggers" << std::endl;
+  for (uint8_t vfat = 0; vfat < MAX_VFATS; ++vfat) {
+    if ((vfatMask >> vfat) & 0x1)
+      continue;
+    for (size_t ch = 0; ch < m_channels.size(); ++ch)
+      for (uint32_t point = 0; point < m_nPoints; ++point)
+        out << static_cast<uint32_t>(vfat) << " " << channel(ch) << " " << scanValue(point) << " "
+            << count(vfat, ch, point) << " " << m_nTriggers << std::endl;
+  }
+}
+
+gem::hw::optohybrid::OptoHybridUltraScan::ScanConfig::ScanConfig() :
+  mode(0),
+  min(0),
+  max(255),
+  step(1),
+  nTriggers(100),
+  pollInterval(10),
+  timeout(300)
+{
+}
+
+gem::hw::optohybrid::OptoHybridUltraScan::OptoHybridUltraScan(ScanConfig const& config,
+                                                              log4cplus::Logger const& logger) :
+  m_gemLogger(logger),
+  m_config(config)
+{
+}
+
+void gem::hw::optohybrid::OptoHybridUltraScan::addOptoHybrid(std::string const& name,
+                                                             std::shared_ptr<HwOptoHybrid> const& optohybrid,
+                                                             uint32_t const& vfatMask)
+{
+  Target target;
+  target.optohybrid = optohybrid;
+  target.vfatMask   = vfatMask & 0xffffff;
+  target.results    = UltraScanResults(m_config.mode, m_config.min, m_config.max, m_config.step,
+                                       m_config.nTriggers, m_config.channels);
+  m_targets[name] = target;
+}
+
+bool gem::hw::optohybrid::OptoHybridUltraScan::run(size_t const& maxWorkers)
+{
+  if (UltraScanResults::isPerChannel(m_config.mode) && m_config.channels.empty()) {
+    m_errors = "no channels given for a per channel scan";
+    ERROR("OptoHybridUltraScan::run " << m_errors);
+    return false;
+  }
+
+  gem::hw::utils::GEMSlotTasks tasks(maxWorkers);
+  for (auto target = m_targets.begin(); target != m_targets.end(); ++target) {
+    // each task only touches its own entry of the map, the map itself is not modified while running
+    std::string const& name = target->first;
+    Target& scanTarget      = target->second;
+    tasks.add(name, [this, &name, &scanTarget]() { scan(name, scanTarget); });
+  }
+
+  bool const success = tasks.run();
+  m_errors = tasks.errors();
+  INFO("OptoHybridUltraScan::run finished" << std::endl << tasks.summary());
+  if (!success)
+    ERROR("OptoHybridUltraScan::run failed" << std::endl << m_errors);
+  return success;
+}
+
+void gem::hw::optohybrid::OptoHybridUltraScan::scan(std::string const& name, Target& target)
+{
+  HwOptoHybrid& optohybrid = *target.optohybrid;
+  UltraScanResults& results = target.results;
+  std::vector<uint32_t> words(MAX_VFATS*results.nPoints());
+
+  for (size_t ch = 0; ch < results.nChannels(); ++ch) {
+    uint8_t const channel = UltraScanResults::isPerChannel(m_config.mode) ? m_config.channels[ch] : 0;
+    if (m_channelSetup && UltraScanResults::isPerChannel(m_config.mode))
+      m_channelSetup(optohybrid, channel);
+
+    optohybrid.configureScanModule(m_config.mode, target.vfatMask, channel,
+                                   m_config.min, m_config.max, m_config.step,
+                                   m_config.nTriggers, true, true);
+    optohybrid.startScanModule(m_config.nTriggers, true);
+
+    std::chrono::steady_clock::time_point const deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(m_config.timeout);
+    while (optohybrid.getScanStatus(true)) {
+      if (std::chrono::steady_clock::now() > deadline) {
+        optohybrid.stopScanModule(true, true);
+        std::string msg = toolbox::toString("%s: ULTRA scan of channel %d did not finish within %ds",
+                                            name.c_str(), channel, m_config.timeout);
+        XCEPT_RAISE(gem::hw::optohybrid::exception::HardwareProblem, msg);
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(m_config.pollInterval));
+    }
+
+    if (optohybrid.readUltraScanResults(results.nPoints(), words.data()) != words.size()) {
+      std::string msg = toolbox::toString("%s: unable to read the ULTRA scan results of channel %d",
+                                          name.c_str(), channel);
+      XCEPT_RAISE(gem::hw::optohybrid::exception::HardwareProblem, msg);
+    }
+    uint32_t const dropped = results.fill(ch, words.data());
+    if (dropped)
+      WARN("OptoHybridUltraScan::scan " << name << " channel " << static_cast<uint32_t>(channel)
+           << ": " << dropped << " results outside of the scan range");
+    DEBUG("OptoHybridUltraScan::scan " << name << " channel " << static_cast<uint32_t>(channel) << " done");
+  }
+}
+
+gem::hw::optohybrid::UltraScanResults const&
+gem::hw::optohybrid::OptoHybridUltraScan::getResults(std::string const& name) const
+{
+  auto target = m_targets.find(name);
+  if (target == m_targets.end()) {
+    std::string msg = toolbox::toString("OptoHybrid %s is not part of the scan", name.c_str());
+    XCEPT_RAISE(gem::hw::optohybrid::exception::ValueError, msg);
+  }
+  return target->second.results;
+}
+
+void gem::hw::optohybrid::OptoHybridUltraScan::writeResults(std::string const& directory) const
+{
+  for (auto target = m_targets.begin(); target != m_targets.end(); ++target) {
+    std::string const fileName = directory + "/" + target->first + ".txt";
+    std::ofstream out(fileName.c_str());
+    if (!out.is_open()) {
+      std::string msg = toolbox::toString("Unable to open %s", fileName.c_str());
+      XCEPT_RAISE(gem::hw::optohybrid::exception::SoftwareProblem, msg);
+    }
+    target->second.results.write(out, target->second.vfatMask);
+    out.close();
+    INFO("OptoHybridUltraScan::writeResults wrote " << fileName);
+  }
+}
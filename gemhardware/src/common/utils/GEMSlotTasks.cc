@@ -0,0 +1,92 @@
+/**
+ * class: GEMSlotTasks
+ * description: Bounded pool of worker threads for independent per-slot operations
+ */
+
+#include "gem/hw/utils/GEMSlotTasks.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <system_error>
+#include <thread>
+
+gem::hw::utils::GEMSlotTasks::GEMSlotTasks(size_t const& maxWorkers) :
+  m_maxWorkers(maxWorkers > 0 ? maxWorkers : 1),
+  m_next(0)
+{
+}
+
+void gem::hw::utils::GEMSlotTasks::add(std::string const& name, std::function<void()> const& task)
+{
+  Result result = {name, false, "not run", 0.};
+  m_tasks.push_back(task);
+  m_results.push_back(result);
+}
+
+bool gem::hw::utils::GEMSlotTasks::run()
+{
+  m_next = 0;
+  size_t const nThreads = std::min(m_maxWorkers, m_tasks.size()) - (m_tasks.empty() ? 0 : 1);
+
+  std::vector<std::thread> workers;
+  workers.reserve(nThreads);
+  for (size_t i = 0; i < nThreads; ++i) {
+    try {
+      workers.push_back(std::thread(&GEMSlotTasks::work, this));
+    } catch (std::system_error const& e) {
+      // the remaining tasks are taken by the threads already running, or by this one
+      break;
+    }
+  }
+
+  work();
+  for (auto worker = workers.begin(); worker != workers.end(); ++worker)
+    worker->join();
+
+  for (auto result = m_results.begin(); result != m_results.end(); ++result)
+    if (!result->success)
+      return false;
+  return true;
+}
+
+void gem::hw::utils::GEMSlotTasks::work()
+{
+  // each task and its result are touched by a single thread, the one that claimed its index
+  for (size_t task = m_next++; task < m_tasks.size(); task = m_next++) {
+    Result& result = m_results[task];
+    std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+    try {
+      m_tasks[task]();
+      result.success = true;
+      result.error.clear();
+    } catch (std::exception const& e) {
+      // xcept::Exception and the uHAL exceptions are std::exceptions
+      result.success = false;
+      result.error   = e.what();
+    } catch (...) {
+      result.success = false;
+      result.error   = "unknown exception";
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+}
+
+std::string gem::hw::utils::GEMSlotTasks::errors() const
+{
+  std::stringstream msg;
+  for (auto result = m_results.begin(); result != m_results.end(); ++result)
+    if (!result->success)
+      msg << result->name << ": " << result->error << std::endl;
+  return msg.str();
+}
+
+std::string gem::hw::utils::GEMSlotTasks::summary() const
+{
+  std::stringstream msg;
+  for (auto result = m_results.begin(); result != m_results.end(); ++result)
+    msg << result->name << (result->success ? " done" : " FAILED")
+        << " in " << std::fixed << std::setprecision(2) << result->seconds << "s" << std::endl;
+  return msg.str();
+}
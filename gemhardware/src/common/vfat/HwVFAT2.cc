@@ -1,10 +1,18 @@
 #include "gem/hw/vfat/HwVFAT2.h"
 
+#include <algorithm>
+
+#include "gem/hw/GEMHwTransaction.h"
 #include "gem/hw/optohybrid/HwOptoHybrid.h"
 
+std::atomic<unsigned> gem::hw::vfat::HwVFAT2::s_shadowEpoch(0);
+
 gem::hw::vfat::HwVFAT2::HwVFAT2(std::string const& vfatDevice,
                                 std::string const& connectionFile) :
   gem::hw::GEMHwDevice::GEMHwDevice(vfatDevice, connectionFile),
+  m_shadowDeferred(false),
+  m_shadowVerify(false),
+  m_shadowEpoch(s_shadowEpoch.load()),
   m_slot(-1)
 {
   // need to fix the hard coded '0', how to get it in from the constructor in a sensible way? /**JS Oct 8**/
@@ -17,6 +25,9 @@ gem::hw::vfat::HwVFAT2::HwVFAT2(std::string const& vfatDevice,
                                 std::string const& connectionURI,
                                 std::string const& addressTable) :
   gem::hw::GEMHwDevice::GEMHwDevice(vfatDevice, connectionURI, addressTable),
+  m_shadowDeferred(false),
+  m_shadowVerify(false),
+  m_shadowEpoch(s_shadowEpoch.load()),
   m_slot(-1)
 {
   // need to fix the hard coded '0', how to get it in from the constructor in a sensible way? /**JS Oct 8**/
@@ -28,6 +39,9 @@ gem::hw::vfat::HwVFAT2::HwVFAT2(std::string const& vfatDevice,
 gem::hw::vfat::HwVFAT2::HwVFAT2(std::string const& vfatDevice,
                                 uhal::HwInterface& uhalDevice) :
   gem::hw::GEMHwDevice::GEMHwDevice(vfatDevice, uhalDevice),
+  m_shadowDeferred(false),
+  m_shadowVerify(false),
+  m_shadowEpoch(s_shadowEpoch.load()),
   m_slot(-1)
 {
   // need to fix the hard coded '0', how to get it in from the constructor in a sensible way? /**JS Oct 8**/
@@ -40,6 +54,9 @@ gem::hw::vfat::HwVFAT2::HwVFAT2(gem::hw::optohybrid::HwOptoHybrid const& ohDevic
                                 uint8_t const& vfatDevice) :
   gem::hw::GEMHwDevice::GEMHwDevice(toolbox::toString("%s.VFAT%d",(ohDevice.getLoggerName()).c_str(),(int)vfatDevice),
                                     ohDevice.getOptoHybridHwInterface()),
+  m_shadowDeferred(false),
+  m_shadowVerify(false),
+  m_shadowEpoch(s_shadowEpoch.load()),
   m_slot((int)vfatDevice)
 {
   INFO("HwVFAT2 ctor");
@@ -105,6 +122,7 @@ std::string gem::hw::vfat::HwVFAT2::printErrorCounts() const {
             << "Error:      " << m_vfatErrors.Error      << std::endl
             << "Invalid:    " << m_vfatErrors.Invalid    << std::endl
             << "RWMismatch: " << m_vfatErrors.RWMismatch << std::endl
+            << "Readback:   " << m_vfatErrors.Readback   << std::endl
             << gem::hw::GEMHwDevice::printErrorCounts() << std::endl;
   DEBUG(errstream);
   return errstream.str();
@@ -194,6 +212,9 @@ bool gem::hw::vfat::HwVFAT2::isHwConnected()
       uint32_t chipTest = readVFATReg("ChipID0", true);
       INFO("read chipID0 0x" << std::hex << chipTest << std::dec << std::endl);
       b_is_connected = true;
+      channelRegister(1);
+      // the chip may have been reconfigured while the connection was down
+      invalidateShadow();
 
       return true;
     } catch (gem::hw::vfat::exception::TransactionError const& e) {
@@ -215,7 +236,16 @@ bool gem::hw::vfat::HwVFAT2::isHwConnected()
 
 uint8_t gem::hw::vfat::HwVFAT2::readVFATReg(std::string const& regName, bool debug)
 {
-  uint32_t readVal = readReg(getDeviceBaseNode(), regName);
+  return readVFATReg(getRegisterHandle(getDeviceBaseNode(), regName), debug);
+}
+
+uint8_t gem::hw::vfat::HwVFAT2::readVFATReg(RegisterHandle const& reg, bool debug)
+{
+  return checkVFATTransaction(readReg(reg), reg.name);
+}
+
+uint8_t gem::hw::vfat::HwVFAT2::checkVFATTransaction(uint32_t const& readVal, std::string const& regName)
+{
   /**
    * check the transaction status
    * bit 31:27 - unused
@@ -252,11 +282,16 @@ uint8_t gem::hw::vfat::HwVFAT2::readVFATReg(std::string const& regName, bool deb
 }
 
 uint8_t gem::hw::vfat::HwVFAT2::readVFATReg(std::string const& regName)
+{
+  return readVFATReg(getRegisterHandle(getDeviceBaseNode(), regName));
+}
+
+uint8_t gem::hw::vfat::HwVFAT2::readVFATReg(RegisterHandle const& reg)
 {
   // temporary wrapper just to fix a simple bug
   // this will have to change in the future, or the return values have to be made sensible
   try {
-    return readVFATReg(regName, false);
+    return readVFATReg(reg, false);
   } catch (gem::hw::vfat::exception::TransactionError const& e) {
     return 0xff;
   } catch (gem::hw::vfat::exception::InvalidTransaction const& e) {
@@ -292,7 +327,11 @@ void gem::hw::vfat::HwVFAT2::readVFAT2Counters()
 
 void gem::hw::vfat::HwVFAT2::readVFAT2Channel(uint8_t channel)
 {
-  uint8_t chanSettings = getChannelSettings(channel);
+  decodeVFAT2Channel(channel, getChannelSettings(channel));
+}
+
+void gem::hw::vfat::HwVFAT2::decodeVFAT2Channel(uint8_t const& channel, uint8_t const& chanSettings)
+{
   if (channel > 1)
     m_vfatParams.activeChannel = (unsigned)channel;
   m_vfatParams.channels[channel-1].fullChannelReg = chanSettings;
@@ -302,7 +341,7 @@ void gem::hw::vfat::HwVFAT2::readVFAT2Channel(uint8_t channel)
   m_vfatParams.channels[channel-1].calPulse    = ((chanSettings&VFAT2ChannelBitMasks::CHANCAL ) << VFAT2ChannelBitShifts::CHANCAL );
   m_vfatParams.channels[channel-1].mask        = ((chanSettings&VFAT2ChannelBitMasks::ISMASKED) << VFAT2ChannelBitShifts::ISMASKED);
   m_vfatParams.channels[channel-1].trimDAC     = ((chanSettings&VFAT2ChannelBitMasks::TRIMDAC ) << VFAT2ChannelBitShifts::TRIMDAC );
-  DEBUG("readVFAT2Channel " << (unsigned)channel << " - 0x"
+  DEBUG("decodeVFAT2Channel " << (unsigned)channel << " - 0x"
         << std::hex << static_cast<unsigned>(m_vfatParams.channels[channel-1].fullChannelReg) << std::dec << "::<"
         << std::hex << static_cast<unsigned>(m_vfatParams.channels[channel-1].calPulse0     ) << std::dec << ":"
         << std::hex << static_cast<unsigned>(m_vfatParams.channels[channel-1].calPulse      ) << std::dec << ":"
@@ -313,20 +352,25 @@ void gem::hw::vfat::HwVFAT2::readVFAT2Channel(uint8_t channel)
 
 void gem::hw::vfat::HwVFAT2::readVFAT2Channels()
 {
+  // all channel registers in one transaction, the channels that failed are read one by one
+  readShadowRegisters(VFAT2ShadowRegs::CHANREG1, VFAT2ShadowRegs::N_SHADOW_REGS);
   for (uint8_t chan = 1; chan < 129; ++chan) {
-    //readVFAT2Channel(m_vfatParams, chan);
-    readVFAT2Channel(chan);
+    unsigned const reg = VFAT2ShadowRegs::CHANREG1 + chan - 1;
+    if (m_vfatParams.shadow.known[reg])
+      decodeVFAT2Channel(chan, m_vfatParams.shadow.value[reg]);
+    else
+      readVFAT2Channel(chan);
     DEBUG("chan = "<< (unsigned)chan << "; activeChannel = " <<(unsigned)m_vfatParams.activeChannel << std::endl);
   }
 }
 
 void gem::hw::vfat::HwVFAT2::setAllSettings(const gem::hw::vfat::VFAT2ControlParams &params)
 {
-  // want to lock the hardware while performing this operation
-  // when sending all these requests, might it be better to do a single transaction?
-
+  // all in a single transaction, only the registers that differ from the shadow
   // check that the hardware is alive
   // check that the settings are non-empty?
+  gem::hw::GEMHwTransaction batch(*this);
+
   uint8_t cont0 = 0x0;
   uint8_t cont1 = 0x0;
   uint8_t cont2 = 0x0;
@@ -337,23 +381,23 @@ void gem::hw::vfat::HwVFAT2::setAllSettings(const gem::hw::vfat::VFAT2ControlPar
   setMSPolarity(     params.msPol     , cont0);
   setCalPolarity(    params.calPol    , cont0);
   setCalibrationMode(params.calibMode , cont0);
-  writeVFATReg("ContReg0", cont0);
+  writeShadowReg(VFAT2ShadowRegs::CONTREG0, cont0);
 
   setDACMode(          params.dacMode  , cont1);
   setProbeMode(        params.probeMode, cont1);
   setLVDSMode(         params.lvdsMode , cont1);
   setHitCountCycleTime(params.reHitCT  , cont1);
-  writeVFATReg("ContReg1", cont1);
+  writeShadowReg(VFAT2ShadowRegs::CONTREG1, cont1);
 
   setHitCountMode( params.hitCountMode, cont2);
   setMSPulseLength(params.msPulseLen  , cont2);
   setInputPadMode( params.digInSel    , cont2);
-  writeVFATReg("ContReg2", cont2);
+  writeShadowReg(VFAT2ShadowRegs::CONTREG2, cont2);
 
   setTrimDACRange(   params.trimDACRange   , cont3);
   setBandgapPad(     params.padBandGap     , cont3);
   sendTestPattern   (params.sendTestPattern, cont3);
-  writeVFATReg("ContReg3", cont3);
+  writeShadowReg(VFAT2ShadowRegs::CONTREG3, cont3);
 
   setIPreampIn(  params.iPreampIn  );
   setIPreampFeed(params.iPreampFeed);
@@ -374,14 +418,14 @@ void gem::hw::vfat::HwVFAT2::setAllSettings(const gem::hw::vfat::VFAT2ControlPar
   chanReg|=(params.channels[0].mask      << VFAT2ChannelBitShifts::ISMASKED);
   chanReg|=(params.channels[0].calPulse  << VFAT2ChannelBitShifts::CHANCAL );
   chanReg|=(params.channels[0].calPulse0 << VFAT2ChannelBitShifts::CHANCAL0);
-  writeVFATReg("VFATChannels.ChanReg1", chanReg);
+  writeShadowReg(VFAT2ShadowRegs::CHANREG1, chanReg);
 
   for (uint8_t chan = 2; chan < N_VFAT2_CHANNELS+1; ++chan) {
     chanReg = 0x0;
     chanReg|=(params.channels[chan-1].trimDAC  << VFAT2ChannelBitShifts::TRIMDAC );
     chanReg|=(params.channels[chan-1].mask     << VFAT2ChannelBitShifts::ISMASKED);
     chanReg|=(params.channels[chan-1].calPulse << VFAT2ChannelBitShifts::CHANCAL );
-    writeVFATReg(toolbox::toString("VFATChannels.ChanReg%d", (unsigned)chan), (unsigned)chanReg);
+    writeShadowReg(VFAT2ShadowRegs::CHANREG1+chan-1, chanReg);
   }
 }
 
@@ -481,6 +525,217 @@ void gem::hw::vfat::HwVFAT2::getAllSettings()
   DEBUG("done getting all settings in HwVFAT2.cc");
 }
 
+gem::hw::GEMHwDevice::RegisterHandle const& gem::hw::vfat::HwVFAT2::channelRegister(uint8_t const& channel)
+{
+  if ((channel > N_VFAT2_CHANNELS) || (channel < 1)) {
+    std::string msg =
+      toolbox::toString("Channel specified (%d) outside expectation (1-128)", channel);
+    ERROR(msg);
+    XCEPT_RAISE(gem::hw::vfat::exception::NonexistentChannel, msg);
+  }
+
+  return shadowRegister(VFAT2ShadowRegs::CHANREG1 + channel - 1);
+}
+
+gem::hw::GEMHwDevice::RegisterHandle const& gem::hw::vfat::HwVFAT2::shadowRegister(unsigned const& reg)
+{
+  // all registers at once, a scan or configure touches every one of them
+  if (m_shadowRegisters.empty()) {
+    m_shadowRegisters.reserve(VFAT2ShadowRegs::N_SHADOW_REGS);
+    for (unsigned r = 0; r < VFAT2ShadowRegs::N_SHADOW_REGS; ++r)
+      m_shadowRegisters.push_back(&getRegisterHandle(getDeviceBaseNode(), VFAT2RegisterShadow::name(r)));
+  }
+  return *m_shadowRegisters.at(reg);
+}
+
+void gem::hw::vfat::HwVFAT2::clearRegisterHandles()
+{
+  TimedLockGuard guardedLock(*this);
+  m_shadowRegisters.clear();
+  gem::hw::GEMHwDevice::clearRegisterHandles();
+}
+
+uint8_t gem::hw::vfat::HwVFAT2::readShadowReg(unsigned const& reg)
+{
+  TimedLockGuard guardedLock(*this);
+  syncShadowEpoch();
+  VFAT2RegisterShadow& shadow = m_vfatParams.shadow;
+  if (!shadow.known[reg]) {
+    shadow.value[reg] = readVFATReg(shadowRegister(reg), true);
+    shadow.known[reg] = true;
+  }
+  return shadow.value[reg];
+}
+
+void gem::hw::vfat::HwVFAT2::writeShadowReg(unsigned const& reg, uint8_t const& value)
+{
+  TimedLockGuard guardedLock(*this);
+  syncShadowEpoch();
+  VFAT2RegisterShadow& shadow = m_vfatParams.shadow;
+  if (shadow.known[reg] && shadow.value[reg] == value)
+    return;
+
+  shadow.value[reg] = value;
+  shadow.known[reg] = true;
+  if (m_shadowDeferred) {
+    shadow.dirty[reg] = true;
+    return;
+  }
+
+  RegisterHandle const& handle = shadowRegister(reg);
+  writeVFATReg(handle, value);
+  shadow.dirty[reg] = false;
+
+  if (m_shadowVerify) {
+    uint8_t readback = readVFATReg(handle, true);
+    if (readback != value) {
+      ++m_vfatErrors.Readback;
+      ERROR("HwVFAT2::writeShadowReg readback of " << handle.name << " returned 0x" << std::hex
+            << static_cast<unsigned>(readback) << " instead of 0x" << static_cast<unsigned>(value) << std::dec);
+      invalidateShadow(reg);
+    }
+  }
+}
+
+void gem::hw::vfat::HwVFAT2::writeShadowBits(unsigned const& reg, uint8_t const& mask, uint8_t const& bits)
+{
+  try {
+    writeShadowReg(reg, (readShadowReg(reg)&~mask)|(bits&mask));
+  } catch (gem::hw::vfat::exception::TransactionError const& e) {
+    WARN("Problem reading the control registers, transaction error bit set");
+  } catch (gem::hw::vfat::exception::InvalidTransaction const& e) {
+    WARN("Problem reading the control registers, invalid transaction bit set");
+  } catch (gem::hw::vfat::exception::WrongTransaction const& e) {
+    WARN("Problem reading the control registers, wrong transaction bit set");
+  }
+}
+
+unsigned gem::hw::vfat::HwVFAT2::readShadowRegisters(unsigned const& first, unsigned const& last)
+{
+  TimedLockGuard guardedLock(*this);
+  syncShadowEpoch();
+  VFAT2RegisterShadow& shadow = m_vfatParams.shadow;
+  unsigned const end = std::min(last, static_cast<unsigned>(VFAT2ShadowRegs::N_SHADOW_REGS));
+  std::vector<std::pair<unsigned, gem::hw::GEMHwTransaction::Value> > values;
+  values.reserve(end > first ? end - first : 0);
+
+  gem::hw::GEMHwTransaction batch(*this);
+  for (unsigned reg = first; reg < end; ++reg)
+    if (!shadow.dirty[reg])
+      values.push_back(std::make_pair(reg, batch.read(shadowRegister(reg))));
+  batch.dispatch();
+
+  unsigned nRead = 0;
+  for (auto val = values.begin(); val != values.end(); ++val) {
+    unsigned const reg = val->first;
+    shadow.known[reg] = false;
+    if (!val->second.valid())
+      continue;
+    try {
+      shadow.value[reg] = checkVFATTransaction(val->second.value(), shadowRegister(reg).name);
+      shadow.known[reg] = true;
+      ++nRead;
+    } catch (gem::hw::vfat::exception::TransactionError const& e) {
+    } catch (gem::hw::vfat::exception::InvalidTransaction const& e) {
+    } catch (gem::hw::vfat::exception::WrongTransaction const& e) {
+    }
+  }
+  DEBUG("HwVFAT2::readShadowRegisters read " << nRead << " of " << values.size() << " registers");
+  return nRead;
+}
+
+unsigned gem::hw::vfat::HwVFAT2::flushShadowRegisters()
+{
+  VFAT2RegisterShadow& shadow = m_vfatParams.shadow;
+  std::vector<std::pair<unsigned, gem::hw::GEMHwTransaction::Value> > readbacks;
+
+  gem::hw::GEMHwTransaction batch(*this);
+  std::vector<unsigned> written;
+  for (unsigned reg = 0; reg < VFAT2ShadowRegs::N_SHADOW_REGS; ++reg) {
+    if (!shadow.dirty[reg])
+      continue;
+    batch.write(shadowRegister(reg), shadow.value[reg]);
+    written.push_back(reg);
+  }
+  if (written.empty())
+    return 0;
+
+  if (m_shadowVerify)
+    for (auto reg = written.begin(); reg != written.end(); ++reg)
+      readbacks.push_back(std::make_pair(*reg, batch.read(shadowRegister(*reg))));
+
+  if (!batch.dispatch()) {
+    // unknown which of the registers made it, they are read from the chip on next use
+    ERROR("HwVFAT2::flushShadowRegisters unable to write " << written.size() << " registers");
+    for (auto reg = written.begin(); reg != written.end(); ++reg)
+      invalidateShadow(*reg);
+    return 0;
+  }
+
+  for (auto reg = written.begin(); reg != written.end(); ++reg)
+    shadow.dirty[*reg] = false;
+
+  for (auto rb = readbacks.begin(); rb != readbacks.end(); ++rb) {
+    unsigned const reg = rb->first;
+    bool match = false;
+    try {
+      match = rb->second.valid()
+        && checkVFATTransaction(rb->second.value(), shadowRegister(reg).name) == shadow.value[reg];
+    } catch (gem::hw::vfat::exception::TransactionError const& e) {
+    } catch (gem::hw::vfat::exception::InvalidTransaction const& e) {
+    } catch (gem::hw::vfat::exception::WrongTransaction const& e) {
+    }
+    if (!match) {
+      ++m_vfatErrors.Readback;
+      ERROR("HwVFAT2::flushShadowRegisters readback of " << shadowRegister(reg).name << " does not match 0x"
+            << std::hex << static_cast<unsigned>(shadow.value[reg]) << std::dec);
+      invalidateShadow(reg);
+    }
+  }
+  DEBUG("HwVFAT2::flushShadowRegisters wrote " << written.size() << " registers");
+  return written.size();
+}
+
+void gem::hw::vfat::HwVFAT2::invalidateShadow()
+{
+  TimedLockGuard guardedLock(*this);
+  if (m_vfatParams.shadow.nDirty())
+    WARN("HwVFAT2::invalidateShadow dropping " << m_vfatParams.shadow.nDirty() << " staged registers");
+  m_vfatParams.shadow.invalidate();
+}
+
+void gem::hw::vfat::HwVFAT2::invalidateShadow(unsigned const& reg)
+{
+  TimedLockGuard guardedLock(*this);
+  m_vfatParams.shadow.known[reg] = false;
+  m_vfatParams.shadow.dirty[reg] = false;
+}
+
+void gem::hw::vfat::HwVFAT2::markShadowStale()
+{
+  TimedLockGuard guardedLock(*this);
+  VFAT2RegisterShadow& shadow = m_vfatParams.shadow;
+  for (unsigned reg = 0; reg < VFAT2ShadowRegs::N_SHADOW_REGS; ++reg)
+    shadow.known[reg] = shadow.dirty[reg];
+}
+
+void gem::hw::vfat::HwVFAT2::syncShadowEpoch()
+{
+  unsigned const epoch = s_shadowEpoch.load();
+  if (epoch == m_shadowEpoch)
+    return;
+  markShadowStale();
+  m_shadowEpoch = epoch;
+}
+
+void gem::hw::vfat::HwVFAT2::setShadowDeferred(bool deferred)
+{
+  TimedLockGuard guardedLock(*this);
+  m_shadowDeferred = deferred;
+  if (!deferred)
+    flushShadowRegisters();
+}
+
 void gem::hw::vfat::HwVFAT2::enableCalPulseToChannel(uint8_t channel, bool on)
 {
   DEBUG(toolbox::toString("setting cal pulse for channel %d HwVFAT2.cc", (unsigned)channel));
@@ -493,17 +748,15 @@ void gem::hw::vfat::HwVFAT2::enableCalPulseToChannel(uint8_t channel, bool on)
     return;
   }
 
-  std::string registerName = "VFATChannels.ChanReg1";
-  if (channel > 1)
-    registerName = toolbox::toString("VFATChannels.ChanReg%d", (unsigned)channel);
+  unsigned const chanReg = VFAT2ShadowRegs::CHANREG1 + (channel > 1 ? channel : 1) - 1;
 
   try {
-    uint8_t channelSettings = readVFATReg(registerName);
+    uint8_t channelSettings = readShadowReg(chanReg);
 
     if (channel == 0)
-      writeVFATReg(registerName, (channelSettings&~VFAT2ChannelBitMasks::CHANCAL0)|(on ? 0x80 : 0x0));
+      writeShadowReg(chanReg, (channelSettings&~VFAT2ChannelBitMasks::CHANCAL0)|(on ? 0x80 : 0x0));
     else
-      writeVFATReg(registerName, (channelSettings&~VFAT2ChannelBitMasks::CHANCAL)|(on ? 0x40 : 0x0));
+      writeShadowReg(chanReg, (channelSettings&~VFAT2ChannelBitMasks::CHANCAL)|(on ? 0x40 : 0x0));
   } catch (gem::hw::vfat::exception::TransactionError const& e) {
     WARN("Problem reading the control registers, transaction error bit set");
   } catch (gem::hw::vfat::exception::InvalidTransaction const& e) {
@@ -526,9 +779,9 @@ void gem::hw::vfat::HwVFAT2::maskChannel(uint8_t channel, bool on)
     return;
   }
   try {
-    std::string registerName = toolbox::toString("VFATChannels.ChanReg%d", (unsigned)channel);
-    uint8_t channelSettings = (readVFATReg(registerName)&~VFAT2ChannelBitMasks::ISMASKED);
-    writeVFATReg(registerName, channelSettings|(on ? 0x20 : 0x0));
+    unsigned const chanReg = VFAT2ShadowRegs::CHANREG1 + channel - 1;
+    uint8_t channelSettings = (readShadowReg(chanReg)&~VFAT2ChannelBitMasks::ISMASKED);
+    writeShadowReg(chanReg, channelSettings|(on ? 0x20 : 0x0));
   } catch (gem::hw::vfat::exception::TransactionError const& e) {
     WARN("Problem reading the control registers, transaction error bit set");
   } catch (gem::hw::vfat::exception::InvalidTransaction const& e) {
@@ -549,8 +802,7 @@ uint8_t gem::hw::vfat::HwVFAT2::getChannelTrimDAC(uint8_t channel)
     // XCEPT_RAISE(gem::hw::vfat::exception::NonexistentChannel, msg);
     return 0xff;
   }
-  std::string registerName = toolbox::toString("VFATChannels.ChanReg%d", (unsigned)channel);
-  return (readVFATReg(registerName)&VFAT2ChannelBitMasks::TRIMDAC);
+  return (readVFATReg(channelRegister(channel))&VFAT2ChannelBitMasks::TRIMDAC);
 }
 
 void gem::hw::vfat::HwVFAT2::setChannelTrimDAC(uint8_t channel, uint8_t trimDAC)
@@ -564,10 +816,10 @@ void gem::hw::vfat::HwVFAT2::setChannelTrimDAC(uint8_t channel, uint8_t trimDAC)
     // XCEPT_RAISE(gem::hw::vfat::exception::NonexistentChannel, msg);
     return;
   }
-  std::string registerName = toolbox::toString("VFATChannels.ChanReg%d", channel);
+  unsigned const chanReg = VFAT2ShadowRegs::CHANREG1 + channel - 1;
   try {
-    uint8_t channelSettings = (readVFATReg(registerName)&~VFAT2ChannelBitMasks::TRIMDAC)|trimDAC;
-    writeVFATReg(registerName, channelSettings|trimDAC);
+    uint8_t channelSettings = (readShadowReg(chanReg)&~VFAT2ChannelBitMasks::TRIMDAC);
+    writeShadowReg(chanReg, channelSettings|(trimDAC&VFAT2ChannelBitMasks::TRIMDAC));
   } catch (gem::hw::vfat::exception::TransactionError const& e) {
     WARN("Problem reading the control registers, transaction error bit set");
   } catch (gem::hw::vfat::exception::InvalidTransaction const& e) {
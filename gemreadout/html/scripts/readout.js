@@ -0,0 +1,48 @@
+function sendrequest( jsonurl )
+{
+    if (window.jQuery) {
+        // can use jQuery libraries rather than raw javascript
+        $.getJSON(jsonurl)
+            .done(function(data) {
+                    updateReadoutMetrics( data );
+                })
+            .fail(function(data, textStatus, error) {
+                    console.error("sendrequest: getJSON failed, status: " + textStatus + ", error: "+error);
+                });
+    } else {
+        var xmlhttp;
+        if (window.XMLHttpRequest) {// code for IE7+, Firefox, Chrome, Opera, Safari
+            xmlhttp=new XMLHttpRequest();
+        } else {// code for IE6, IE5
+            xmlhttp=new ActiveXObject("Microsoft.XMLHTTP");
+        }
+        xmlhttp.onreadystatechange=function()
+            {
+                if (xmlhttp.readyState==4 && xmlhttp.status==200) {
+                    var res = eval( "(" + xmlhttp.responseText + ")" );
+                    updateReadoutMetrics( res );
+                }
+            };
+        xmlhttp.open("GET", jsonurl, true);
+        xmlhttp.send();
+    }
+};
+
+function updateReadoutMetrics( readoutjson )
+{
+    for ( var monitorset in readoutjson ) {
+        var arr = readoutjson[monitorset];
+        for( var i = 0; i < arr.length; ++i ) {
+            var cell = document.getElementById( arr[i].name );
+            if ( cell )
+                cell.innerHTML = arr[i].value;
+        }
+    }
+};
+
+function startUpdate( jsonurl )
+{
+    // the application publishes the readout metrics once per second while running
+    var interval;
+    interval = setInterval( "sendrequest( \"" + jsonurl + "\" )" , 2000 );
+};
@@ -10,6 +10,8 @@
 #include <sstream>
 #include <vector>
 
+#include "gem/readout/GEMDataAMCformat.h"
+
 namespace gem {
 //  namespace readout {
 //    struct VFATData;
@@ -17,31 +19,165 @@ namespace gem {
 //    struct GEMData;
 //  }
   namespace datachecker {
+    /**
+     * @class GEMDataChecker
+     * @brief Validation of the VFAT2 data blocks
+     *
+     * The VFAT2 CRC is the reflected CRC-16/CCITT (polynomial 0x8408, seed 0xffff) of the
+     * 11 16-bit words of the block, each word fed LSB first.
+     * The CRC is computed with two 256 entry lookup tables, consuming a whole 16-bit word
+     * per step (slice-by-2), rather than 16 iterations of the bit-serial update.
+     */
     class GEMDataChecker {
       public:
+        static const size_t VFAT_CRC_WORDS = 11;  ///< number of 16-bit words covered by the VFAT CRC
 
         GEMDataChecker(){}
         ~GEMDataChecker() {};
 
-        uint16_t checkCRC(uint16_t dataVFAT[11], bool OKprint)
+        /**
+         * @brief computes the CRC of a VFAT block
+         * @param dataVFAT the block words, dataVFAT[11] is the first word (BC) and
+         *        dataVFAT[1] the last data word, dataVFAT[0] (the transmitted CRC) is not used
+         * @param OKprint unused
+         * @returns the computed CRC
+         */
+        uint16_t checkCRC(uint16_t dataVFAT[12], bool OKprint)
         {
           uint16_t crc_fin = 0xffff;
           for (int i = 11; i >= 1; i--)
           {
-            crc_fin = this->crc_calc(crc_fin, dataVFAT[i]);
+            crc_fin = crc_word(crc_fin, dataVFAT[i]);
           }
           return(crc_fin);
         }
 
+        /**
+         * @brief computes the CRC of a VFAT block
+         * @param vfat the VFAT block, the stored crc field is not used
+         * @returns the computed CRC
+         */
+        static uint16_t checkCRC(gem::readout::GEMDataAMCformat::VFATData const& vfat)
+        {
+          uint16_t crc_fin = 0xffff;
+          crc_fin = crc_word(crc_fin, vfat.BC);
+          crc_fin = crc_word(crc_fin, vfat.EC);
+          crc_fin = crc_word(crc_fin, vfat.ChipID);
+          crc_fin = crc_data(crc_fin, vfat.msData);
+          crc_fin = crc_data(crc_fin, vfat.lsData);
+          return(crc_fin);
+        }
+
+        /**
+         * @brief compares the computed CRC of a VFAT block to the transmitted one
+         * @param vfat the VFAT block
+         * @returns true if the CRC matches
+         */
+        static bool isCRCGood(gem::readout::GEMDataAMCformat::VFATData const& vfat)
+        {
+          return checkCRC(vfat) == vfat.crc;
+        }
+
+        /**
+         * @brief validates the CRC of a set of VFAT blocks
+         * Four blocks are processed together, the CRC updates of different blocks being
+         * independent, the table lookups of one block overlap with those of the others
+         * @param vfats the VFAT blocks to check
+         * @param goodMask bitmap filled with the result, bit (i%64) of word (i/64) is set
+         *        if block i has a good CRC
+         * @returns the number of blocks with a bad CRC
+         */
+        static size_t checkCRC(std::vector<gem::readout::GEMDataAMCformat::VFATData> const& vfats,
+                               std::vector<uint64_t>& goodMask)
+        {
+          goodMask.assign((vfats.size()+63)/64, 0x0);
+
+          size_t nBad = 0;
+          size_t i    = 0;
+          for (; i+4 <= vfats.size(); i += 4) {
+            uint16_t crc[4] = {0xffff, 0xffff, 0xffff, 0xffff};
+            for (size_t b = 0; b < 4; ++b)
+              crc[b] = crc_word(crc[b], vfats[i+b].BC);
+            for (size_t b = 0; b < 4; ++b)
+              crc[b] = crc_word(crc[b], vfats[i+b].EC);
+            for (size_t b = 0; b < 4; ++b)
+              crc[b] = crc_word(crc[b], vfats[i+b].ChipID);
+            for (int shift = 48; shift >= 0; shift -= 16)
+              for (size_t b = 0; b < 4; ++b)
+                crc[b] = crc_word(crc[b], (vfats[i+b].msData >> shift) & 0xffff);
+            for (int shift = 48; shift >= 0; shift -= 16)
+              for (size_t b = 0; b < 4; ++b)
+                crc[b] = crc_word(crc[b], (vfats[i+b].lsData >> shift) & 0xffff);
+
+            for (size_t b = 0; b < 4; ++b) {
+              if (crc[b] == vfats[i+b].crc)
+                goodMask[(i+b)/64] |= (0x1ULL << ((i+b)%64));
+              else
+                ++nBad;
+            }
+          }
+
+          for (; i < vfats.size(); ++i) {
+            if (isCRCGood(vfats[i]))
+              goodMask[i/64] |= (0x1ULL << (i%64));
+            else
+              ++nBad;
+          }
+          return nBad;
+        }
+
+        /**
+         * @brief updates the CRC with one 16-bit word
+         * @param crc_in the current CRC value
+         * @param dato the data word
+         * @returns the updated CRC value
+         */
+        static uint16_t crc_word(uint16_t crc_in, uint16_t dato)
+        {
+          uint16_t const* table = crc_table();
+          uint16_t const  x     = crc_in ^ dato;
+          // table[256+i] is table[i] advanced by a further 8 zero bits
+          return table[256 + (x & 0xff)] ^ table[x >> 8];
+        }
+
       private:
+        static uint16_t crc_data(uint16_t crc_in, uint64_t const& data)
+        {
+          crc_in = crc_word(crc_in, (data >> 48) & 0xffff);
+          crc_in = crc_word(crc_in, (data >> 32) & 0xffff);
+          crc_in = crc_word(crc_in, (data >> 16) & 0xffff);
+          return crc_word(crc_in, data & 0xffff);
+        }
+
+        /**
+         * @brief lookup tables for the CRC update, built once from the bit-serial routine
+         * entries [0,256) advance the CRC by one byte, entries [256,512) by two bytes
+         */
+        static uint16_t const* crc_table()
+        {
+          static const std::vector<uint16_t> table = build_crc_table();
+          return table.data();
+        }
+
+        static std::vector<uint16_t> build_crc_table()
+        {
+          std::vector<uint16_t> table(512);
+          for (uint16_t i = 0; i < 256; ++i)
+            table[i] = crc_calc(i, 0x0, 8);
+          for (uint16_t i = 0; i < 256; ++i)
+            table[256+i] = (table[i] >> 8) ^ table[table[i] & 0xff];
+          return table;
+        }
 
-        uint16_t crc_calc(uint16_t crc_in, uint16_t dato)
+        /**
+         * @brief bit-serial CRC update, used as the reference implementation to build the tables
+         */
+        static uint16_t crc_calc(uint16_t crc_in, uint16_t dato, unsigned char datalen=16)
         {
           uint16_t v = 0x0001;
           uint16_t mask = 0x0001;
           bool d=0;
           uint16_t crc_temp = crc_in;
-          unsigned char datalen = 16;
 
           for (int i=0; i<datalen; i++){
             if (dato & v) d = 1;
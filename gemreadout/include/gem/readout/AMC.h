@@ -133,6 +133,7 @@ class GEBdata {
 
 
   void v_add(VFATdata v){vfatd.push_back(v);}
+  std::vector<VFATdata>& vfats(){return vfatd;}
 };
 
 class AMCdata
@@ -0,0 +1,168 @@
+/** @file GEMDQMHistograms.h */
+
+#ifndef GEM_READOUT_GEMDQMHISTOGRAMS_H
+#define GEM_READOUT_GEMDQMHISTOGRAMS_H
+
+#include <stdint.h>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gem/readout/AMC.h"
+#include "gem/readout/GEMDataAMCformat.h"
+#include "gem/readout/GEMslotContents.h"
+
+namespace gem {
+  namespace readout {
+
+    /**
+     * @class GEMDQMHistogram
+     * @brief Fixed binning 1D or 2D event counts, with the bin numbering of ROOT
+     *
+     * Bin 0 is the underflow and bin n+1 the overflow of each axis, so the contents can be
+     * copied bin by bin into a TH1F or TH2F with the same binning.
+     * Not thread safe, each thread fills its own copy and the copies are merged.
+     */
+    class GEMDQMHistogram
+    {
+    public:
+      GEMDQMHistogram(std::string const& name, std::string const& title,
+                      int const& nBinsX, double const& xLow, double const& xHigh,
+                      int const& nBinsY=0, double const& yLow=0., double const& yHigh=0.);
+
+      void fill(double const& x);
+      void fill(double const& x, double const& y);
+
+      /**
+       * @brief adds the contents of a histogram with the same binning
+       */
+      void merge(GEMDQMHistogram const& other);
+
+      std::string const& name()  const { return m_name;  };
+      std::string const& title() const { return m_title; };
+
+      bool   is2D()    const { return m_nBinsY > 0; };
+      int    nBinsX()  const { return m_nBinsX; };
+      int    nBinsY()  const { return m_nBinsY; };
+      double xLow()    const { return m_xLow;   };
+      double xHigh()   const { return m_xHigh;  };
+      double yLow()    const { return m_yLow;   };
+      double yHigh()   const { return m_yHigh;  };
+
+      uint64_t entries() const { return m_entries; };
+
+      uint64_t binContent(int const& binX, int const& binY=0) const {
+        return m_counts[binY*(m_nBinsX + 2) + binX]; };
+
+    private:
+      static int findBin(double const& value, int const& nBins, double const& low, double const& high);
+
+      std::string m_name;
+      std::string m_title;
+      int    m_nBinsX;
+      double m_xLow;
+      double m_xHigh;
+      int    m_nBinsY;
+      double m_yLow;
+      double m_yHigh;
+      uint64_t              m_entries;
+      std::vector<uint64_t> m_counts;
+    };  // class GEMDQMHistogram
+
+    /**
+     * @class GEMDQMStripMap
+     * @brief VFAT channel to readout strip mapping of each GEB slot
+     */
+    class GEMDQMStripMap
+    {
+    public:
+      static const int N_CHANNELS = 128;
+
+      /**
+       * @brief reads the v2b mapping files, as used by gemOnlineDQM
+       * @param directory holds v2b_schema_chips0-1.csv, v2b_schema_chips2-15.csv,
+       *        v2b_schema_chips16-17.csv and v2b_schema_chips18-23.csv
+       * @returns the mapping, with the channels of the missing files left unmapped
+       */
+      static std::shared_ptr<const GEMDQMStripMap> load(std::string const& directory);
+
+      /**
+       * @returns the strip of a channel (0 to 127) of the VFAT in a slot, -1 if the channel is not mapped
+       */
+      int strip(int const& slot, int const& channel) const {
+        return m_strips[slot][channel]; };
+
+    private:
+      GEMDQMStripMap();
+
+      bool readFile(int const& slot, std::string const& fileName);
+
+      std::array<std::array<int, N_CHANNELS>, GEMslotContents::N_SLOTS> m_strips;
+    };  // class GEMDQMStripMap
+
+    /**
+     * @class GEMDQMHistograms
+     * @brief Occupancy, cluster and beam profile histograms of the gemOnlineDQM, without ROOT
+     *
+     * One GEB is filled at a time, the strips fired by all its VFATs are clustered together,
+     * per eta partition.
+     * Not thread safe, each thread fills its own instance and the instances are merged.
+     */
+    class GEMDQMHistograms
+    {
+    public:
+      static const int N_ETA_PARTITIONS = 8;
+      static const int N_STRIPS         = 384;  ///< strips per eta partition
+
+      GEMDQMHistograms(std::shared_ptr<const GEMslotContents> const& slotContents,
+                       std::shared_ptr<const GEMDQMStripMap>  const& stripMap);
+
+      /**
+       * @brief fills the histograms with the VFATs of one GEB of an event
+       */
+      void fill(GEBdata& geb);
+
+      /**
+       * @brief adds the contents of another instance
+       */
+      void merge(GEMDQMHistograms const& other);
+
+      /**
+       * @returns all histograms, in the order of the gemOnlineDQM plots
+       */
+      std::vector<GEMDQMHistogram const*> histograms() const;
+
+      uint64_t vfatBlocks()    const { return m_vfatBlocks;    };
+      uint64_t badVFATBlocks() const { return m_badVFATBlocks; };
+
+      /**
+       * @brief unpacks a VFAT block, checking its control bits and CRC
+       */
+      static VFATdata toVFATdata(AMCVFATData const& vfat, GEMslotContents const& slotContents);
+
+      /**
+       * @brief unpacks a GEB, and its VFAT blocks
+       */
+      static GEBdata toGEBdata(AMCGEBData const& geb, GEMslotContents const& slotContents);
+
+    private:
+      std::shared_ptr<const GEMslotContents> p_slotContents;
+      std::shared_ptr<const GEMDQMStripMap>  p_stripMap;
+
+      GEMDQMHistogram              m_vfatSlot;
+      GEMDQMHistogram              m_clusterMult;
+      GEMDQMHistogram              m_clusterSize;
+      std::vector<GEMDQMHistogram> m_stripsFired;
+      GEMDQMHistogram              m_beamProfile;
+
+      uint64_t m_vfatBlocks;
+      uint64_t m_badVFATBlocks;
+
+      std::array<std::vector<uint8_t>, N_ETA_PARTITIONS> m_firedStrips;  ///< scratch space for the clustering
+    };  // class GEMDQMHistograms
+  }  // namespace gem::readout
+}  // namespace gem
+
+#endif  // GEM_READOUT_GEMDQMHISTOGRAMS_H
@@ -19,8 +19,11 @@
 #include "gem/utils/GEMLogging.h"
 #include "gem/utils/Lock.h"
 #include "gem/utils/LockGuard.h"
+#include "gem/utils/SPSCRingBuffer.h"
 
 #include "gem/readout/GEMDataAMCformat.h"
+#include "gem/readout/GEMEventBuilder.h"
+#include "gem/readout/GEMEventWriter.h"
 
 namespace gem {
   namespace hw {
@@ -49,6 +52,7 @@ namespace gem {
 
       static const uint32_t kUPDATE;
       static const uint32_t kUPDATE7;
+      static const uint32_t kQUEUESIZE;
 
       GEMDataParker        (gem::hw::glib::HwGLIB& glibDevice,
                             std::string const& outFileName,
@@ -67,7 +71,11 @@ namespace gem {
                            );
       uint32_t* GEMEventMaker( uint32_t counter[5]
                              );
-      void GEMevSelector   ( const  uint32_t& ES
+      /**
+       * @brief writes one built event, the good blocks to the data file and the
+       * bad blocks to the error file
+       */
+      void GEMevSelector   ( GEMEventBuilder::Event& event
                            );
       void GEMfillHeaders  ( uint32_t const& BC,
                              uint32_t const& BX,
@@ -80,7 +88,7 @@ namespace gem {
       void GEMfillTrailers ( gem::readout::GEMDataAMCformat::GEMData& gem,
                              gem::readout::GEMDataAMCformat::GEBData& geb
                            );
-      void writeGEMevent   ( std::string outFile,
+      void writeGEMevent   ( GEMEventWriter& writer,
                              bool const& OKprint,
                              std::string const& TypeDataFlag,
                              gem::readout::GEMDataAMCformat::GEMData& gem,
@@ -89,6 +97,13 @@ namespace gem {
                            );
       int queueDepth       () {return m_dataque.size();}
 
+      /**
+       * @brief closes the events still being built and writes any buffered events
+       * to the output files, files stay open until the GEMDataParker is destroyed
+       * Must be called from the thread building the events (i.e., calling selectData)
+       */
+      void flushOutput     ();
+
 
       void ScanRoutines(uint8_t latency, uint8_t VT1, uint8_t VT2);
 
@@ -103,26 +118,58 @@ namespace gem {
 
 
     private:
-      // moved from globals...
-      uint32_t m_ESexp;
-      bool     m_isFirst;
       //uint64_t m_ZSFlag;
       uint32_t m_contvfats;
 
-      void readVFATblock(std::queue<uint32_t>& dataque);
+      /**
+       * @brief words pushed in one go into the data queue, all read from the same link
+       */
+      struct QueuedRun {
+        uint8_t  link;
+        uint32_t nWords;
+      };
+
+      // one entry per push into m_dataque, so that each block is keyed by the link it was read from
+      gem::utils::SPSCRingBuffer<QueuedRun> m_runque;
+      // consumer side, the link of the run at the front of m_dataque and its words not yet taken
+      uint8_t  m_currentLink;
+      uint32_t m_runWordsLeft;
+
+      /**
+       * @brief moves to the next run in m_runque
+       * @returns false if there is none
+       */
+      bool nextRun();
+
+      /**
+       * @brief takes words from the front of the current run, moving to the next run as needed
+       * Must be called by the consumer for every word it pops from m_dataque
+       */
+      void consumeRunWords(size_t nWords);
 
-      uint32_t dat10,dat11, dat20,dat21, dat30,dat31, dat40,dat41;
-      uint32_t BX;
-      uint16_t bcn, evn, chipid, vfatcrc;
-      uint16_t b1010, b1100, b1110;
-      uint8_t  flags;
+      // the events built from the blocks in the data queue, and the last event handed out
+      GEMEventBuilder         m_eventBuilder;
+      GEMEventBuilder::Event  m_builtEvent;
 
-      uint8_t m_latency, m_VT1, m_VT2;
+      /**
+       * @brief writes all events the builder has closed, in order
+       */
+      void writeBuiltEvents();
+
+      /**
+       * @brief decodes the next VFAT block in the queue
+       * Words preceding the next block header are dropped
+       * @param dataque the queue to take the block from
+       * @param vfat the decoded block
+       * @param link set to the link the block was read from
+       * @returns false if no complete block is available yet
+       */
+      bool readVFATblock(gem::utils::SPSCRingBuffer<uint32_t>& dataque, GEMDataAMCformat::VFATData& vfat,
+                         uint8_t& link);
 
-      static const int MaxVFATS = 24; // was 32 ???
-      static const int MaxERRS  = 4095; // should this also be 24? Or we can accomodate full GLIB FIFO of bad blocks belonging to the same event?
+      uint8_t m_latency, m_VT1, m_VT2;
 
-      std::unique_ptr<GEMslotContents> slotInfo;
+      std::shared_ptr<const GEMslotContents> slotInfo;
 
       log4cplus::Logger m_gemLogger;
       gem::hw::glib::HwGLIB* p_glibDevice;
@@ -131,10 +178,12 @@ namespace gem {
       std::string m_errFileName;
       std::string m_outputType;
 
-      // queue safety
-      mutable gem::utils::Lock m_queueLock;
-      // The main data flow
-      std::queue<uint32_t> m_dataque;
+      // output files, opened once on construction
+      std::unique_ptr<GEMEventWriter> p_dataWriter;
+      std::unique_ptr<GEMEventWriter> p_errWriter;
+
+      // The main data flow, filled by the hardware readout and drained by the event builder
+      gem::utils::SPSCRingBuffer<uint32_t> m_dataque;
 
       //type of run
       GEMRunType m_runType;
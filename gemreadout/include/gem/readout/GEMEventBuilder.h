@@ -0,0 +1,163 @@
+/** @file GEMEventBuilder.h */
+
+#ifndef GEM_READOUT_GEMEVENTBUILDER_H
+#define GEM_READOUT_GEMEVENTBUILDER_H
+
+#include <chrono>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include "gem/readout/GEMDataAMCformat.h"
+
+namespace gem {
+  namespace readout {
+
+    /**
+     * @class GEMEventBuilder
+     * @brief Builds events from VFAT blocks that may arrive out of order, from one or more links
+     *
+     * Blocks are grouped by (link, EC, BC), the open events are found through a hash map and
+     * kept in a bounded reorder window in the order their first block arrived.
+     * An event is closed when
+     *  - a good block has been received from every expected slot of its link (full DAV mask)
+     *  - a second block arrives for a slot already present, the EC/BC has wrapped around
+     *  - it has been open for longer than the timeout
+     *  - the window is full and a new event has to be opened, the oldest event is closed
+     * Closed events are handed out in arrival order, an event closed early waits for all
+     * the events opened before it.
+     * Not thread safe, the builder should be used by the thread draining the data queue.
+     */
+    class GEMEventBuilder
+    {
+    public:
+      struct Event {
+        uint8_t  link;
+        uint16_t EC;       // EC:8
+        uint16_t BC;       // BC:12
+        uint32_t davMask;  // slots with a good block
+        bool     complete; // true if closed on a full DAV mask
+        std::vector<GEMDataAMCformat::VFATData> vfats;   // good blocks
+        std::vector<GEMDataAMCformat::VFATData> errors;  // blocks with a bad CRC or unknown slot
+      };
+
+      static const size_t   DEFAULT_WINDOW     = 256;
+      static const uint32_t DEFAULT_TIMEOUT_US = 100000;
+      static const size_t   MAX_SLOTS          = 24;
+      static const size_t   MAX_ERRORS         = 4095;  ///< error blocks kept per event
+
+      /**
+       * GEMEventBuilder constructor
+       * @param window maximum number of events held, open or waiting to be handed out
+       * @param timeoutUS time after which an open event is closed, in microseconds, 0 for no timeout
+       */
+      GEMEventBuilder(size_t const& window=DEFAULT_WINDOW, uint32_t const& timeoutUS=DEFAULT_TIMEOUT_US);
+
+      ~GEMEventBuilder();
+
+      /**
+       * @brief sets the slots expected to send data, for all links without a specific mask
+       * @param mask bit i set if slot i is expected, 0 never closes events on the DAV mask
+       */
+      void setExpectedMask(uint32_t const& mask);
+
+      /**
+       * @brief sets the slots expected to send data on one link
+       */
+      void setExpectedMask(uint8_t const& link, uint32_t const& mask);
+
+      /**
+       * @brief adds a block to its event, opening the event if needed
+       * @param link link the block was read from
+       * @param slot GEB slot of the VFAT, outside [0,23] if unknown
+       * @param good false if the block failed validation, it is stored with the errors
+       * @param vfat the decoded block
+       */
+      void addBlock(uint8_t const& link, int const& slot, bool const& good,
+                    GEMDataAMCformat::VFATData const& vfat);
+
+      /**
+       * @brief closes the events that have been open for longer than the timeout
+       * @returns the number of events closed
+       */
+      size_t expire();
+
+      /**
+       * @brief closes all open events, e.g., at the end of a run
+       */
+      void flush();
+
+      /**
+       * @brief hands out the next closed event, in arrival order
+       * Should be called until it returns false after each addBlock, the window only bounds
+       * the events that have not been handed out
+       * @param event replaced by the next event, its previous contents are discarded
+       * @returns false if the oldest event is still open
+       */
+      bool popEvent(Event& event);
+
+      /**
+       * @brief drops all events, open or closed, and resets the counters
+       */
+      void clear();
+
+      size_t   openEvents()    const { return m_openEvents.size(); };
+      size_t   pendingEvents() const { return m_events.size(); };
+      size_t   pendingBlocks() const { return m_pendingBlocks; };
+      size_t   pendingErrors() const { return m_pendingErrors; };
+
+      uint64_t eventsBuilt()      const { return m_eventsBuilt; };
+      uint64_t eventsComplete()   const { return m_eventsComplete; };
+      uint64_t eventsTimedOut()   const { return m_eventsTimedOut; };
+      uint64_t eventsEvicted()    const { return m_eventsEvicted; };
+      uint64_t eventsSplit()      const { return m_eventsSplit; };
+      uint64_t errorsDropped()    const { return m_errorsDropped; };
+
+    private:
+      typedef std::chrono::steady_clock clock;
+
+      struct PendingEvent {
+        Event             event;
+        uint64_t          sequence;
+        clock::time_point opened;
+        bool              closed;
+      };
+
+      static uint32_t eventKey(uint8_t const& link, uint16_t const& EC, uint16_t const& BC) {
+        return (static_cast<uint32_t>(link) << 20) | ((EC & 0xff) << 12) | (BC & 0xfff);
+      };
+
+      uint32_t expectedMask(uint8_t const& link) const;
+
+      PendingEvent& openEvent(uint32_t const& key, uint8_t const& link,
+                              uint16_t const& EC, uint16_t const& BC);
+
+      void closeEvent(PendingEvent& pending);
+
+      size_t                 m_window;
+      clock::duration        m_timeout;
+      uint32_t               m_defaultMask;
+      std::unordered_map<uint8_t, uint32_t> m_linkMasks;
+
+      // events in arrival order, the front is the next to be handed out
+      std::deque<PendingEvent> m_events;
+      uint64_t                 m_frontSequence;  // sequence number of m_events.front()
+      uint64_t                 m_nextSequence;
+
+      // (link, EC, BC) of each open event to its sequence number
+      std::unordered_map<uint32_t, uint64_t> m_openEvents;
+
+      size_t   m_pendingBlocks;
+      size_t   m_pendingErrors;
+
+      uint64_t m_eventsBuilt;
+      uint64_t m_eventsComplete;
+      uint64_t m_eventsTimedOut;
+      uint64_t m_eventsEvicted;
+      uint64_t m_eventsSplit;
+      uint64_t m_errorsDropped;
+    };  // class GEMEventBuilder
+  }  // namespace gem::readout
+}  // namespace gem
+
+#endif  // GEM_READOUT_GEMEVENTBUILDER_H
@@ -0,0 +1,144 @@
+/** @file GEMEventWriter.h */
+
+#ifndef GEM_READOUT_GEMEVENTWRITER_H
+#define GEM_READOUT_GEMEVENTWRITER_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "gem/utils/GEMLogging.h"
+
+#include "gem/readout/GEMDataAMCformat.h"
+#include "gem/readout/GEMRunFile.h"
+
+namespace gem {
+  namespace readout {
+
+    /**
+     * @class GEMEventWriter
+     * @brief Persistent output file for GEMDataAMCformat events
+     *
+     * The file is opened once (at the start of a run) and closed at the end,
+     * every event is serialized into a user-space buffer, and the buffer is
+     * written to disk in one contiguous block according to the flush policy.
+     * The "Hex" and "Bin" formats are identical to the ones produced by the
+     * GEMDataAMCformat::write* and GEMDataAMCformat::write*Binary helpers,
+     * the "Run" format is the indexed container described in GEMRunFile.
+     * Not thread safe, one writer should be used by one thread only.
+     */
+    class GEMEventWriter
+    {
+    public:
+      /**
+       * @brief when the user-space buffer is written to the file
+       *  - FLUSH_ON_FULL only when the buffer capacity would be exceeded
+       *  - FLUSH_EVERY_EVENT after every event
+       *  - FLUSH_EVERY_N_EVENTS after every N events (or when the buffer is full)
+       */
+      enum FlushPolicy {
+        FLUSH_ON_FULL        = 0x0,
+        FLUSH_EVERY_EVENT    = 0x1,
+        FLUSH_EVERY_N_EVENTS = 0x2
+      };
+
+      static const size_t DEFAULT_BUFFER_SIZE = 4*1024*1024;
+
+      /**
+       * GEMEventWriter constructor
+       * @param outputType "Hex" for the ASCII format, "Run" for the GEMRunFile container,
+       *        anything else for binary
+       * @param bufferSize size in bytes of the user-space buffer
+       * @param policy flush policy to apply
+       * @param flushInterval number of events between flushes for FLUSH_EVERY_N_EVENTS
+       */
+      GEMEventWriter(std::string const& outputType="Bin",
+                     size_t      const& bufferSize=DEFAULT_BUFFER_SIZE,
+                     FlushPolicy const& policy=FLUSH_ON_FULL,
+                     uint32_t    const& flushInterval=0);
+
+      ~GEMEventWriter();
+
+      /**
+       * @brief opens the output file, closing any previously opened file
+       * The "Hex" and "Bin" files are opened in append mode, a "Run" file is truncated
+       * and starts with the GEMRunFile header
+       * @param fileName name of the output file
+       * @throws gem::readout::exception::Exception if the file cannot be opened
+       */
+      void open(std::string const& fileName);
+
+      /**
+       * @brief flushes the buffer and closes the output file, a "Run" file gets its event index
+       */
+      void close();
+
+      bool isOpen() const { return m_outf.is_open(); };
+
+      std::string const& getFileName() const { return m_fileName; };
+
+      /**
+       * @brief changes the format of the following events, a "Run" file can not be mixed with the other formats
+       */
+      void setOutputType(std::string const& outputType);
+      void setFlushPolicy(FlushPolicy const& policy, uint32_t const& flushInterval=0);
+
+      /**
+       * @brief sets the run number stored in the header of the "Run" files opened afterwards
+       */
+      void setRunNumber(uint64_t const& runNumber) { m_runNumber = runNumber; };
+
+      /**
+       * @brief serializes one full event (AMC headers, one GEB and its VFAT blocks, trailers)
+       * @param gem AMC header and trailer words
+       * @param geb chamber header, trailer and VFAT payload
+       * @retval false if the file is not open
+       */
+      bool writeGEMevent(AMCGEMData const& gem, AMCGEBData const& geb);
+
+      /**
+       * @brief writes the contents of the buffer to the file in a single write
+       */
+      void flush();
+
+      uint64_t getEventsWritten() const { return m_eventsWritten; };
+      uint64_t getBytesWritten()  const { return m_bytesWritten;  };
+
+    private:
+      // Prevent copying of GEMEventWriter objects
+      GEMEventWriter(GEMEventWriter const&);
+      GEMEventWriter& operator=(GEMEventWriter const&);
+
+      enum OutputFormat {
+        HEX_FORMAT = 0x0,
+        BIN_FORMAT = 0x1,
+        RUN_FORMAT = 0x2
+      };
+
+      static OutputFormat toOutputFormat(std::string const& outputType);
+
+      void appendWord(uint64_t const& word);
+      void appendBytes(void const* data, size_t const& nBytes);
+
+      log4cplus::Logger m_gemLogger;
+
+      std::ofstream     m_outf;
+      std::string       m_fileName;
+      std::vector<char> m_buffer;
+      size_t            m_bufferSize;
+      OutputFormat      m_format;
+
+      uint64_t              m_runNumber;
+      std::vector<uint64_t> m_eventOffsets;  ///< file offset of each event record of a "Run" file
+
+      FlushPolicy m_flushPolicy;
+      uint32_t    m_flushInterval;
+      uint32_t    m_eventsSinceFlush;
+
+      uint64_t m_eventsWritten;
+      uint64_t m_bytesWritten;
+    };  // class GEMEventWriter
+  }  // namespace gem::readout
+}  // namespace gem
+
+#endif  // GEM_READOUT_GEMEVENTWRITER_H
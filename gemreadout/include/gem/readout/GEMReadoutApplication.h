@@ -3,6 +3,8 @@
 #ifndef GEM_READOUT_GEMREADOUTAPPLICATION_H
 #define GEM_READOUT_GEMREADOUTAPPLICATION_H
 
+#include <list>
+#include <memory>
 #include <string>
 #include <queue>
 
@@ -10,17 +12,25 @@
 
 #include "toolbox/Task.h"
 #include "toolbox/mem/Pool.h"
+#include "toolbox/mem/Reference.h"
 #include "toolbox/SyncQueue.h"
 
 #include "xoap/MessageReference.h"
 #include "xoap/Method.h"
 
+#include "xdata/Double.h"
+#include "xdata/UnsignedInteger32.h"
+#include "xdata/UnsignedInteger64.h"
+
 #include "gem/base/GEMFSMApplication.h"
 
 #include "gem/utils/GEMLogging.h"
 #include "gem/utils/Lock.h"
 #include "gem/utils/LockGuard.h"
 
+#include "gem/readout/GEMEventWriter.h"
+#include "gem/readout/GEMReadoutMetrics.h"
+
 namespace gem {
   namespace readout {
 
@@ -28,6 +38,8 @@ namespace gem {
 
     class GEMReadoutApplication : public gem::base::GEMFSMApplication
       {
+        friend class GEMReadoutWebApplication;
+
       public:
         static const int I2O_READOUT_NOTIFY;
         static const int I2O_READOUT_CONFIRM;
@@ -38,7 +50,8 @@ namespace gem {
             CMD_START  = 2,
             CMD_PAUSE  = 3,
             CMD_RESUME = 4,
-            CMD_EXIT   = 5
+            CMD_EXIT   = 5,
+            CMD_RESET_METRICS = 6  ///< clears m_readoutMetrics, sent before CMD_START
           } ReadoutCommands;
         };
 
@@ -88,6 +101,28 @@ namespace gem {
 
         virtual int readout(unsigned int expected, unsigned int* eventNumbers, std::vector< ::toolbox::mem::Reference* >& data) = 0;
 
+        /**
+         * @brief creates an event writer configured from the readout settings
+         * (outputType, writeBufferSize, flushEvents), the caller opens and closes the file
+         */
+        std::unique_ptr<GEMEventWriter> createEventWriter();
+
+        /**
+         * @brief creates the readout memory pool, backed by READOUT_POOL_SIZE bytes of committed heap
+         * Does nothing if the pool already exists, called from initializeAction
+         */
+        void createReadoutPool();
+
+        /**
+         * @brief takes a frame from the readout memory pool
+         * The frame must be given back with release() once the data have been consumed
+         * @param size minimum size of the frame in bytes
+         * @returns the frame, or NULL if the pool is exhausted (or not yet created)
+         */
+        toolbox::mem::Reference* getFrame(size_t const& size);
+
+        static const size_t READOUT_POOL_SIZE;  ///< bytes committed to the readout memory pool
+
         std::string m_outFileName;
         std::shared_ptr<toolbox::Task> m_task;
         toolbox::mem::Pool*            m_pool;
@@ -105,6 +140,10 @@ namespace gem {
           xdata::String outputType;
           xdata::String outputLocation;
           xdata::String setupLocation;
+
+          // output file buffering
+          xdata::UnsignedInteger32 writeBufferSize;  // size of the write buffer in kB
+          xdata::UnsignedInteger32 flushEvents;      // 0 flush when the buffer is full, N flush every N events
         };
 
         xdata::Bag<GEMReadoutSettings> m_readoutSettings;
@@ -116,8 +155,38 @@ namespace gem {
 
         double m_usecUsed;
 
-      private:
+        /**
+         * Stage timings and flow counters of the readout, filled by the derived application,
+         * cleared at start and published in the info space, both by readoutTask only
+         */
+        GEMReadoutMetrics m_readoutMetrics;
 
+        /**
+         * @brief copies m_readoutMetrics into the info space items, with one change notification,
+         *        only called from readoutTask
+         */
+        void updateReadoutMetrics();
+
+      private:
+        // info space copies of m_readoutMetrics, per stage
+        xdata::UnsignedInteger64 m_stageCalls[GEMReadoutMetrics::N_STAGES];
+        xdata::Double            m_stageMeanUs[GEMReadoutMetrics::N_STAGES];
+        xdata::UnsignedInteger64 m_stageP99Us[GEMReadoutMetrics::N_STAGES];
+        xdata::Double            m_stageBusyFraction[GEMReadoutMetrics::N_STAGES];
+
+        xdata::UnsignedInteger64 m_queueDepthMax;
+        xdata::UnsignedInteger64 m_bytesWritten;
+        xdata::Double            m_bytesPerSecond;  // written, over the last update interval
+        xdata::UnsignedInteger64 m_eventsDropped;
+        xdata::UnsignedInteger64 m_readToWriteP50Us;
+        xdata::UnsignedInteger64 m_readToWriteP99Us;
+        xdata::UnsignedInteger64 m_readToWriteMaxUs;
+
+        std::list<std::string> m_metricsItems;  // names of the items above, for fireItemGroupChanged
+
+        // bytes written at the last update, for the rate
+        GEMReadoutMetrics::clock::time_point m_metricsUpdated;
+        uint64_t                             m_metricsBytes;
       };
 
     class GEMReadoutTask : public toolbox::Task {
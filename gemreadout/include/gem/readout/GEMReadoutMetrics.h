@@ -0,0 +1,120 @@
+/** @file GEMReadoutMetrics.h */
+
+#ifndef GEM_READOUT_GEMREADOUTMETRICS_H
+#define GEM_READOUT_GEMREADOUTMETRICS_H
+
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include "gem/utils/LatencyHistogram.h"
+
+namespace gem {
+  namespace readout {
+
+    /**
+     * @class GEMReadoutMetrics
+     * @brief Stage resolved timing and flow counters of a readout pipeline
+     *
+     * The time spent in each stage (FIFO drain, block decode, event build, write) is histogrammed
+     * per call, so that comparing the busy time of the stages shows which one limits the rate.
+     * The stages may run in different threads, e.g., the readout task and a writer task,
+     * all counters are atomics and recording never takes a lock.
+     */
+    class GEMReadoutMetrics
+    {
+    public:
+      enum Stage {
+        FIFO_DRAIN  = 0,  ///< reading the hardware buffers
+        DECODE      = 1,  ///< unpacking the words read into blocks
+        EVENT_BUILD = 2,  ///< assembling the blocks into events
+        WRITE       = 3,  ///< serializing and writing the events to the output
+        N_STAGES
+      };
+
+      typedef std::chrono::steady_clock clock;
+
+      /**
+       * @returns the name of the stage used for the info space items, e.g., "FIFODrain"
+       */
+      static std::string stageName(Stage const& stage);
+
+      /**
+       * @class ScopedStage
+       * @brief records the time until it goes out of scope in a stage
+       */
+      class ScopedStage
+      {
+      public:
+        ScopedStage(GEMReadoutMetrics& metrics, Stage const& stage) :
+          m_metrics(metrics), m_stage(stage), m_start(clock::now()) {};
+        ~ScopedStage() { m_metrics.recordStage(m_stage, m_start, clock::now()); };
+
+      private:
+        GEMReadoutMetrics& m_metrics;
+        Stage              m_stage;
+        clock::time_point  m_start;
+
+        ScopedStage(ScopedStage const&);
+        ScopedStage& operator=(ScopedStage const&);
+      };
+
+      GEMReadoutMetrics();
+
+      void recordStage(Stage const& stage, clock::time_point const& start, clock::time_point const& stop);
+
+      /**
+       * @brief raises the queue depth high-water mark if depth is above it
+       */
+      void recordQueueDepth(uint64_t const& depth);
+
+      /**
+       * @brief records the time from reading data out of the hardware to writing it to the output
+       * @param readTime when the oldest data being written were read
+       */
+      void recordReadToWrite(clock::time_point const& readTime);
+
+      void addBytesRead(uint64_t const& nBytes)    { m_bytesRead.fetch_add(nBytes, std::memory_order_relaxed); };
+      void addBytesWritten(uint64_t const& nBytes) { m_bytesWritten.fetch_add(nBytes, std::memory_order_relaxed); };
+      void addEventsDropped(uint64_t const& n)     { m_eventsDropped.fetch_add(n, std::memory_order_relaxed); };
+
+      gem::utils::LatencyHistogram const& getStage(Stage const& stage) const { return m_stages[stage]; };
+      gem::utils::LatencyHistogram const& getReadToWrite() const { return m_readToWrite; };
+
+      uint64_t queueDepthMax() const { return m_queueDepthMax.load(std::memory_order_relaxed); };
+      uint64_t bytesRead()     const { return m_bytesRead.load(std::memory_order_relaxed); };
+      uint64_t bytesWritten()  const { return m_bytesWritten.load(std::memory_order_relaxed); };
+      uint64_t eventsDropped() const { return m_eventsDropped.load(std::memory_order_relaxed); };
+
+      /**
+       * @returns the fraction of the wall-clock time since the last reset spent in the stage
+       * Above 1 if the stage runs in several threads at once
+       */
+      double busyFraction(Stage const& stage) const;
+
+      /**
+       * @brief clears all the counters, e.g., at the start of a run
+       * Should not be called while the pipeline is running
+       */
+      void reset();
+
+    private:
+      gem::utils::LatencyHistogram m_stages[N_STAGES];
+      gem::utils::LatencyHistogram m_readToWrite;
+
+      std::atomic<uint64_t> m_queueDepthMax;
+      std::atomic<uint64_t> m_bytesRead;
+      std::atomic<uint64_t> m_bytesWritten;
+      std::atomic<uint64_t> m_eventsDropped;
+
+      clock::time_point m_resetTime;
+
+      GEMReadoutMetrics(GEMReadoutMetrics const&);
+      GEMReadoutMetrics& operator=(GEMReadoutMetrics const&);
+    };  // class GEMReadoutMetrics
+  }  // namespace gem::readout
+}  // namespace gem
+
+#endif  // GEM_READOUT_GEMREADOUTMETRICS_H
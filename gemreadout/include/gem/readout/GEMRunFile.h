@@ -0,0 +1,66 @@
+/** @file GEMRunFile.h */
+
+#ifndef GEM_READOUT_GEMRUNFILE_H
+#define GEM_READOUT_GEMRUNFILE_H
+
+#include <stdint.h>
+
+namespace gem {
+  namespace readout {
+
+    /**
+     * @struct GEMRunFile
+     * @brief Layout of the binary run container written by GEMEventWriter with the "Run" output type
+     *
+     * All fields are little-endian and every record starts on a 64-bit boundary:
+     *  - FileHeader
+     *  - records, each a RecordHeader followed by nWords 64-bit words:
+     *    - EVENT_RECORD, the event words in the order of the ASCII format:
+     *      3 AMC headers, GEB header, GEB run header, 4 words per VFAT (the 3 data words and BXfrOH),
+     *      GEB trailer, AMC trailer 2, AMC trailer 1
+     *    - SYNC_RECORD every syncInterval events, a single word holding the number of events before it,
+     *      used to find the next record and check the event count in a file without index
+     *    - INDEX_RECORD once at the end of the run, the file offset of each EVENT_RECORD header
+     *  - FileTrailer, pointing to the INDEX_RECORD
+     * A file that was not closed has no index nor trailer, the reader rebuilds the index by
+     * walking the records.
+     */
+    struct GEMRunFile {
+      static const uint64_t FILE_MAGIC    = 0x31304e55524d4547;  ///< "GEMRUN01"
+      static const uint64_t TRAILER_MAGIC = 0x5845444e494d4547;  ///< "GEMINDEX"
+      static const uint32_t VERSION       = 1;
+
+      static const uint32_t EVENT_RECORD = 0x544e5645;  ///< "EVNT"
+      static const uint32_t SYNC_RECORD  = 0x434e5953;  ///< "SYNC"
+      static const uint32_t INDEX_RECORD = 0x58444e49;  ///< "INDX"
+
+      static const uint32_t DEFAULT_SYNC_INTERVAL = 1024;
+
+      static const uint32_t EVENT_FIXED_WORDS = 8;  ///< words of an event that do not depend on the number of VFATs
+      static const uint32_t VFAT_WORDS        = 4;  ///< words per VFAT block in an event
+
+      struct FileHeader {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t headerSize;    ///< bytes, offset of the first record
+        uint64_t runNumber;
+        uint64_t startTime;     ///< seconds since the epoch
+        uint32_t syncInterval;  ///< events between two SYNC_RECORDs
+        uint32_t reserved;
+      };
+
+      struct RecordHeader {
+        uint32_t type;
+        uint32_t nWords;  ///< 64-bit words following the header
+      };
+
+      struct FileTrailer {
+        uint64_t indexOffset;  ///< file offset of the INDEX_RECORD header
+        uint64_t nEvents;
+        uint64_t magic;
+      };
+    };  // struct GEMRunFile
+  }  // namespace gem::readout
+}  // namespace gem
+
+#endif  // GEM_READOUT_GEMRUNFILE_H
@@ -0,0 +1,132 @@
+/** @file GEMRunFileReader.h */
+
+#ifndef GEM_READOUT_GEMRUNFILEREADER_H
+#define GEM_READOUT_GEMRUNFILEREADER_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "gem/utils/GEMLogging.h"
+
+#include "gem/readout/GEMDataAMCformat.h"
+#include "gem/readout/GEMRunFile.h"
+
+namespace gem {
+  namespace readout {
+
+    /**
+     * @class GEMRunFileReader
+     * @brief Memory-mapped reader of the GEMRunFile container
+     *
+     * The file is mapped read-only, events are accessed in place through their index,
+     * so any event can be reached directly and the file can be processed in parallel.
+     * If the file has no index, e.g., the run was not stopped cleanly, the index is rebuilt
+     * by walking the records, using the sync records to skip over corrupted data.
+     * Once opened, the reader can be used from several threads at the same time.
+     */
+    class GEMRunFileReader
+    {
+    public:
+      /**
+       * @brief Words of one event, pointing into the mapped file
+       */
+      struct EventView {
+        uint64_t const* words;
+        uint32_t        nWords;
+
+        uint32_t nVFATs() const {
+          return (nWords - GEMRunFile::EVENT_FIXED_WORDS)/GEMRunFile::VFAT_WORDS; };
+      };
+
+      /**
+       * @brief processes the events [first, last)
+       */
+      typedef std::function<void(size_t const& first, size_t const& last)> ChunkTask;
+
+      GEMRunFileReader();
+
+      /**
+       * @brief opens a file, see open()
+       */
+      explicit GEMRunFileReader(std::string const& fileName);
+
+      ~GEMRunFileReader();
+
+      /**
+       * @brief maps a run file and loads its index, closing any previously opened file
+       * @throws gem::readout::exception::Exception if the file can not be mapped or is not a run file
+       */
+      void open(std::string const& fileName);
+
+      void close();
+
+      bool isOpen() const { return p_data != NULL; };
+
+      std::string const& getFileName() const { return m_fileName; };
+
+      GEMRunFile::FileHeader const& header() const { return m_header; };
+
+      size_t nEvents() const { return m_nEvents; };
+
+      /**
+       * @returns true if the file had no index and it was rebuilt from the records
+       */
+      bool indexRecovered() const { return m_indexRecovered; };
+
+      /**
+       * @returns the words of event n, valid until the file is closed
+       * @throws gem::readout::exception::ValueError if there is no event n
+       */
+      EventView event(size_t const& n) const;
+
+      /**
+       * @brief unpacks an event into the GEMDataAMCformat structures
+       * @returns false if the event is too short for the number of VFATs it claims
+       */
+      static bool decode(EventView const& event, AMCGEMData& gem, AMCGEBData& geb);
+
+      /**
+       * @brief runs a task over all events, split into chunks processed by a pool of threads
+       * The chunks are claimed dynamically, so a slow chunk does not hold back the others.
+       * An exception thrown by a task stops the threads from taking new chunks and is rethrown
+       * once all threads have finished.
+       * @param nThreads number of threads, the calling thread included
+       * @param task called once per chunk, concurrently from several threads
+       * @param chunkSize events per chunk, 0 to pick one from the number of events and threads
+       */
+      void forEachChunk(size_t const& nThreads, ChunkTask const& task, size_t const& chunkSize=0) const;
+
+      /**
+       * @brief runs a task over the items [0, nItems) with the chunking of forEachChunk,
+       *        for data that is not in a run file
+       */
+      static void runChunks(size_t const& nItems, size_t const& nThreads, ChunkTask const& task,
+                            size_t const& chunkSize=0);
+
+    private:
+      // Prevent copying of GEMRunFileReader objects
+      GEMRunFileReader(GEMRunFileReader const&);
+      GEMRunFileReader& operator=(GEMRunFileReader const&);
+
+      bool loadIndex();
+      void rebuildIndex();
+
+      log4cplus::Logger m_gemLogger;
+
+      std::string m_fileName;
+      int         m_fd;
+      char const* p_data;
+      size_t      m_size;
+
+      GEMRunFile::FileHeader m_header;
+
+      uint64_t const*       p_offsets;       ///< index of the file, or m_rebuiltIndex
+      size_t                m_nEvents;
+      std::vector<uint64_t> m_rebuiltIndex;
+      bool                  m_indexRecovered;
+    };  // class GEMRunFileReader
+  }  // namespace gem::readout
+}  // namespace gem
+
+#endif  // GEM_READOUT_GEMRUNFILEREADER_H
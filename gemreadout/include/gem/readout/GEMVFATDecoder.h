@@ -0,0 +1,206 @@
+/** @file GEMVFATDecoder.h */
+
+#ifndef GEM_READOUT_GEMVFATDECODER_H
+#define GEM_READOUT_GEMVFATDECODER_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+
+#include "gem/readout/GEMDataAMCformat.h"
+
+namespace gem {
+  namespace readout {
+
+    /**
+     * @struct VFATBlockBatch
+     * @brief Decoded VFAT blocks, stored as a structure of arrays
+     *
+     * Entry i of every array belongs to the same block, the fields have the layout of
+     * GEMDataAMCformat::VFATData, with the control bits kept in BC, EC and ChipID.
+     */
+    struct VFATBlockBatch {
+      std::vector<uint16_t> BC;      // 1010:4,   BC:12
+      std::vector<uint16_t> EC;      // 1100:4,   EC:8,      Flags:4
+      std::vector<uint16_t> ChipID;  // 1110:4,   ChipID:12
+      std::vector<uint64_t> lsData;  // channels from 1to64
+      std::vector<uint64_t> msData;  // channels from 65to128
+      std::vector<uint32_t> BXfrOH;  // :32       BX from OH
+      std::vector<uint16_t> crc;     // :16       CRC
+      std::vector<uint8_t>  valid;   // 1 if the 1010, 1100 and 1110 control bits are all present
+
+      size_t size()  const { return BC.size(); };
+      bool   empty() const { return BC.empty(); };
+
+      void clear() {
+        BC.clear();
+        EC.clear();
+        ChipID.clear();
+        lsData.clear();
+        msData.clear();
+        BXfrOH.clear();
+        crc.clear();
+        valid.clear();
+      };
+
+      void resize(size_t const& n) {
+        BC.resize(n);
+        EC.resize(n);
+        ChipID.resize(n);
+        lsData.resize(n);
+        msData.resize(n);
+        BXfrOH.resize(n);
+        crc.resize(n);
+        valid.resize(n);
+      };
+
+      void reserve(size_t const& n) {
+        BC.reserve(n);
+        EC.reserve(n);
+        ChipID.reserve(n);
+        lsData.reserve(n);
+        msData.reserve(n);
+        BXfrOH.reserve(n);
+        crc.reserve(n);
+        valid.reserve(n);
+      };
+
+      /**
+       * @brief copies block i into the array of structures format used to build the events
+       */
+      void get(size_t const& i, GEMDataAMCformat::VFATData& vfat) const {
+        vfat.BC     = BC[i];
+        vfat.EC     = EC[i];
+        vfat.ChipID = ChipID[i];
+        vfat.lsData = lsData[i];
+        vfat.msData = msData[i];
+        vfat.BXfrOH = BXfrOH[i];
+        vfat.crc    = crc[i];
+      };
+    };
+
+    /**
+     * @class GEMVFATDecoder
+     * @brief Stateless decoder of the raw VFAT blocks read from the tracking data FIFO
+     *
+     * A block is 7 32-bit words:
+     *   - 0: 1010:4 BC:12 1100:4 EC:8 Flags:4
+     *   - 1: 1110:4 ChipID:12 data[127:112]
+     *   - 2: data[111:80]
+     *   - 3: data[79:48]
+     *   - 4: data[47:16]
+     *   - 5: data[15:0] CRC:16
+     *   - 6: BX from the OptoHybrid
+     * Each field is extracted with the same shifts and masks for every block, without branches,
+     * so that contiguous runs of blocks can be decoded in a single pass.
+     */
+    class GEMVFATDecoder {
+    public:
+      static const size_t BLOCK_WORDS = 7;  ///< number of 32-bit words in a VFAT block
+
+      /**
+       * @brief tests the 1010 and 1100 control bits of the first word of a block
+       */
+      static bool isBlockHeader(uint32_t const& word) {
+        return (word & 0xf000f000) == 0xa000c000;
+      };
+
+      static uint16_t bcn(uint16_t const& BC)         { return BC & 0x0fff; };
+      static uint16_t evn(uint16_t const& EC)         { return (EC >> 4) & 0x00ff; };
+      static uint8_t  flags(uint16_t const& EC)       { return EC & 0x000f; };
+      static uint16_t chipID(uint16_t const& ChipID)  { return ChipID & 0x0fff; };
+
+      /**
+       * @brief decodes a single block
+       * @param block the 7 words of the block
+       * @param vfat the decoded block
+       * @returns true if the 1010, 1100 and 1110 control bits are all present
+       */
+      static bool decode(uint32_t const* block, GEMDataAMCformat::VFATData& vfat) {
+        vfat.BC     = block[0] >> 16;
+        vfat.EC     = block[0] & 0xffff;
+        vfat.ChipID = block[1] >> 16;
+        vfat.msData = (static_cast<uint64_t>(block[1] & 0xffff) << 48) |
+          (static_cast<uint64_t>(block[2]) << 16) | (block[3] >> 16);
+        vfat.lsData = (static_cast<uint64_t>(block[3] & 0xffff) << 48) |
+          (static_cast<uint64_t>(block[4]) << 16) | (block[5] >> 16);
+        vfat.crc    = block[5] & 0xffff;
+        vfat.BXfrOH = block[6];
+        return isBlockHeader(block[0]) && (block[1] & 0xf0000000) == 0xe0000000;
+      };
+
+      /**
+       * @brief decodes nBlocks contiguous blocks, appending them to the batch
+       * The words must be aligned on a block header, misaligned blocks are decoded
+       * anyway and flagged through the valid array
+       * @param words the raw data, at least 7*nBlocks words
+       * @param nBlocks the number of blocks to decode
+       * @param batch the batch to append to
+       * @returns the number of blocks with all control bits present
+       */
+      static size_t decode(uint32_t const* words, size_t const& nBlocks, VFATBlockBatch& batch) {
+        size_t const first = batch.size();
+        batch.resize(first + nBlocks);
+
+        uint16_t* BC     = batch.BC.data()     + first;
+        uint16_t* EC     = batch.EC.data()     + first;
+        uint16_t* ChipID = batch.ChipID.data() + first;
+        uint64_t* lsData = batch.lsData.data() + first;
+        uint64_t* msData = batch.msData.data() + first;
+        uint32_t* BXfrOH = batch.BXfrOH.data() + first;
+        uint16_t* crc    = batch.crc.data()    + first;
+        uint8_t*  valid  = batch.valid.data()  + first;
+
+        size_t nValid = 0;
+        for (size_t i = 0; i < nBlocks; ++i) {
+          uint32_t const* block = words + BLOCK_WORDS*i;
+          BC[i]     = block[0] >> 16;
+          EC[i]     = block[0] & 0xffff;
+          ChipID[i] = block[1] >> 16;
+          msData[i] = (static_cast<uint64_t>(block[1] & 0xffff) << 48) |
+            (static_cast<uint64_t>(block[2]) << 16) | (block[3] >> 16);
+          lsData[i] = (static_cast<uint64_t>(block[3] & 0xffff) << 48) |
+            (static_cast<uint64_t>(block[4]) << 16) | (block[5] >> 16);
+          crc[i]    = block[5] & 0xffff;
+          BXfrOH[i] = block[6];
+          valid[i]  = ((block[0] & 0xf000f000) == 0xa000c000) & ((block[1] & 0xf0000000) == 0xe0000000);
+          nValid   += valid[i];
+        }
+        return nValid;
+      };
+
+      /**
+       * @brief decodes all complete blocks in a buffer, appending them to the batch
+       * Words that are not at the start of a block header are skipped, as is a trailing
+       * partial block. Runs of aligned blocks are decoded together
+       * @param words the raw data
+       * @param nWords the number of words in the buffer
+       * @param batch the batch to append to
+       * @param nSkipped set to the number of words that were not decoded
+       * @returns the number of blocks appended
+       */
+      static size_t decodeBuffer(uint32_t const* words, size_t const& nWords, VFATBlockBatch& batch,
+                                 size_t& nSkipped) {
+        size_t const first = batch.size();
+        size_t pos = 0;
+        nSkipped   = 0;
+        while (pos + BLOCK_WORDS <= nWords) {
+          if (!isBlockHeader(words[pos])) {
+            ++pos;
+            ++nSkipped;
+            continue;
+          }
+          size_t run = 1;
+          while (pos + BLOCK_WORDS*(run+1) <= nWords && isBlockHeader(words[pos + BLOCK_WORDS*run]))
+            ++run;
+          decode(words + pos, run, batch);
+          pos += BLOCK_WORDS*run;
+        }
+        nSkipped += nWords - pos;
+        return batch.size() - first;
+      };
+    };  // class GEMVFATDecoder
+  }  // namespace gem::readout
+}  // namespace gem
+
+#endif  // GEM_READOUT_GEMVFATDECODER_H
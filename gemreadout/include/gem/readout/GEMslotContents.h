@@ -7,41 +7,100 @@
 #include <fstream>
 #include <sstream>
 #include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
 namespace gem {
   namespace readout {
 
+    /**
+     * @class GEMslotContents
+     * @brief Map between the GEB slots and the ChipIDs of the VFATs plugged in them
+     *
+     * The contents are immutable once the slot file has been read, the reverse lookup from
+     * ChipID to slot is a direct index into a 4096 entry table.
+     * Use getSlotContents to share a single, loaded-once, instance per slot file, and
+     * reloadSlotContents to pick up a modified slot file (e.g., at configure), holders of
+     * the previous instance keep a consistent map until they release it.
+     */
     class GEMslotContents {
       //struct is a class with all members public by default
     public:
-      GEMslotContents(const std::string& slotFile) {
+      static const int N_SLOTS = 24;
+
+      GEMslotContents(const std::string& slotFile) :
+        slot(N_SLOTS, 0xfff),
+        chipIndex(0x1000, -1)
+      {
         slotFile_ = slotFile;
         getSlotCfg();
       };
+
+      /**
+       * @brief returns the shared slot contents for the given slot file, reading the file on first use
+       * @param slotFile the name of the slot file in $BUILD_HOME/$GEM_OS_PROJECT/gemreadout/data
+       */
+      static std::shared_ptr<const GEMslotContents> getSlotContents(const std::string& slotFile) {
+        std::lock_guard<std::mutex> guard(cacheMutex());
+        std::shared_ptr<const GEMslotContents>& cached = cache()[slotFile];
+        if (!cached)
+          cached = std::make_shared<const GEMslotContents>(slotFile);
+        return cached;
+      };
+
+      /**
+       * @brief re-reads the slot file and replaces the shared slot contents for subsequent getSlotContents calls
+       * @param slotFile the name of the slot file in $BUILD_HOME/$GEM_OS_PROJECT/gemreadout/data
+       */
+      static std::shared_ptr<const GEMslotContents> reloadSlotContents(const std::string& slotFile) {
+        // read the file before taking the lock, readers are never blocked by the file I/O
+        std::shared_ptr<const GEMslotContents> loaded = std::make_shared<const GEMslotContents>(slotFile);
+        std::lock_guard<std::mutex> guard(cacheMutex());
+        cache()[slotFile] = loaded;
+        return loaded;
+      };
+
     private:
-      uint16_t slot[24];
+      std::vector<uint16_t> slot;       // ChipID in each slot, 0xfff if empty
+      std::vector<int8_t>   chipIndex;  // slot of each 12-bit ChipID, -1 if not present
       bool isFileRead;
       std::string slotFile_;
 
+      static std::mutex& cacheMutex() {
+        static std::mutex m;
+        return m;
+      };
+
+      static std::map<std::string, std::shared_ptr<const GEMslotContents> >& cache() {
+        static std::map<std::string, std::shared_ptr<const GEMslotContents> > c;
+        return c;
+      };
+
        void initSlots() {
-        for (int i = 0; i < 24; ++i)
+        for (int i = 0; i < N_SLOTS; ++i)
           slot[i] = 0xfff;
         isFileRead = false;
         return;
       };
 
       void getSlotCfg() {
+        initSlots();
         std::ifstream ifile;
-        std::string build_home     = std::getenv("BUILD_HOME");
-        std::string gem_os_project = std::getenv("GEM_OS_PROJECT");
-        std::string path           = build_home + "/" + gem_os_project;
+        char const* build_home     = std::getenv("BUILD_HOME");
+        char const* gem_os_project = std::getenv("GEM_OS_PROJECT");
+        std::string path = std::string(build_home ? build_home : "") + "/"
+          + std::string(gem_os_project ? gem_os_project : "");
         path += "/gemreadout/data/";
         path += slotFile_;
-        ifile.open(path);
+        ifile.open(path.c_str());
 
         if(!ifile.is_open()) {
-          std::cout << "[GEMslotContents]: The file: " << ifile << " is missing.\n" << std::endl;
+          std::cout << "[GEMslotContents]: The file: " << path << " is missing.\n" << std::endl;
           isFileRead = false;
+          fillChipIndex();
           return;
         };
 
@@ -59,27 +118,35 @@ namespace gem {
         }
         ifile.close();
         isFileRead = true;
+        fillChipIndex();
+      };
+
+      void fillChipIndex() {
+        // the last slot wins if a ChipID appears more than once, as with the previous linear search
+        for (int islot = 0; islot < N_SLOTS; islot++)
+          chipIndex[slot[islot] & 0x0fff] = islot;
       };
 
     public:
       /*
        *  Slot Index converter from Hex ChipID
        */
-      int GEBslotIndex(const uint32_t& GEBChipID) {
-        int indxslot = -1;
-        //std::cout << "\nUsing slot file: " << slotFile_ << std::endl;
-        for (int islot = 0; islot < 24; islot++) {
-          if ( (GEBChipID & 0x0fff ) == slot[islot] ) indxslot = islot;
-        }//end for slot
-
-        return (indxslot);
+      int GEBslotIndex(const uint32_t& GEBChipID) const {
+        return chipIndex[GEBChipID & 0x0fff];
       };
-      uint32_t GEBChipIdFromSlot(int slotindex){
+      uint32_t GEBChipIdFromSlot(int slotindex) const {
             return slot[slotindex];
       };
-      uint32_t GEBNumberOfSlots(){
+      uint32_t GEBslotMask() const {
+        uint32_t mask = 0x0;
+        for (int islot = 0; islot < N_SLOTS; islot++)
+          if (slot[islot] != 0xfff)
+            mask |= (0x1u << islot);
+        return mask;
+      };
+      uint32_t GEBNumberOfSlots() const {
         uint32_t count=0;
-        for (int islot = 0; islot < 24; islot++) {
+        for (int islot = 0; islot < N_SLOTS; islot++) {
             if(slot[islot]==0xfff) continue;
             count++;
         }
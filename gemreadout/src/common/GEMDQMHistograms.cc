@@ -0,0 +1,234 @@
+/**
+ * class: GEMDQMHistograms
+ * description: ROOT-free accumulation of the gemOnlineDQM histograms, mergeable across threads
+ */
+
+#include "gem/readout/GEMDQMHistograms.h"
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+#include "gem/utils/GEMLogging.h"
+
+#include "gem/datachecker/GEMDataChecker.h"
+
+gem::readout::GEMDQMHistogram::GEMDQMHistogram(std::string const& name, std::string const& title,
+                                               int const& nBinsX, double const& xLow, double const& xHigh,
+                                               int const& nBinsY, double const& yLow, double const& yHigh) :
+  m_name(name),
+  m_title(title),
+  m_nBinsX(nBinsX),
+  m_xLow(xLow),
+  m_xHigh(xHigh),
+  m_nBinsY(nBinsY),
+  m_yLow(yLow),
+  m_yHigh(yHigh),
+  m_entries(0),
+  m_counts((nBinsX + 2)*(nBinsY > 0 ? nBinsY + 2 : 1), 0)
+{
+}
+
+int gem::readout::GEMDQMHistogram::findBin(double const& value, int const& nBins,
+                                           double const& low, double const& high)
+{
+  if (std::isnan(value) || value < low)
+    return 0;
+  if (value >= high)
+    return nBins + 1;
+  return 1 + static_cast<int>(nBins*(value - low)/(high - low));
+}
+
+void gem::readout::GEMDQMHistogram::fill(double const& x)
+{
+  ++m_counts[findBin(x, m_nBinsX, m_xLow, m_xHigh)];
+  ++m_entries;
+}
+
+void gem::readout::GEMDQMHistogram::fill(double const& x, double const& y)
+{
+  int const binX = findBin(x, m_nBinsX, m_xLow, m_xHigh);
+  int const binY = findBin(y, m_nBinsY, m_yLow, m_yHigh);
+  ++m_counts[binY*(m_nBinsX + 2) + binX];
+  ++m_entries;
+}
+
+void gem::readout::GEMDQMHistogram::merge(GEMDQMHistogram const& other)
+{
+  // all instances are built by GEMDQMHistograms, so the binning always matches
+  for (size_t bin = 0; bin < m_counts.size() && bin < other.m_counts.size(); ++bin)
+    m_counts[bin] += other.m_counts[bin];
+  m_entries += other.m_entries;
+}
+
+gem::readout::GEMDQMStripMap::GEMDQMStripMap()
+{
+  for (auto slot = m_strips.begin(); slot != m_strips.end(); ++slot)
+    slot->fill(-1);
+}
+
+std::shared_ptr<const gem::readout::GEMDQMStripMap>
+gem::readout::GEMDQMStripMap::load(std::string const& directory)
+{
+  log4cplus::Logger m_gemLogger(log4cplus::Logger::getInstance("GEMDQMStripMap"));
+  std::shared_ptr<GEMDQMStripMap> stripMap(new GEMDQMStripMap());
+  for (int slot = 0; slot < GEMslotContents::N_SLOTS; ++slot) {
+    std::string fileName = directory + "/";
+    if (slot < 2)
+      fileName += "v2b_schema_chips0-1.csv";
+    else if (slot < 16)
+      fileName += "v2b_schema_chips2-15.csv";
+    else if (slot < 18)
+      fileName += "v2b_schema_chips16-17.csv";
+    else
+      fileName += "v2b_schema_chips18-23.csv";
+    if (!stripMap->readFile(slot, fileName))
+      WARN("GEMDQMStripMap::load the file " << fileName << " is missing, slot " << slot << " has no strip map");
+  }
+  return stripMap;
+}
+
+bool gem::readout::GEMDQMStripMap::readFile(int const& slot, std::string const& fileName)
+{
+  std::ifstream file(fileName.c_str());
+  if (!file.is_open())
+    return false;
+
+  // each line is "strip,channel", with the channels numbered from 1
+  std::string line;
+  while (std::getline(file, line)) {
+    std::istringstream iss(line);
+    int  strip = -1, channel = -1;
+    char comma;
+    if (!(iss >> strip >> comma >> channel) || comma != ',')
+      continue;
+    if (channel >= 1 && channel <= N_CHANNELS)
+      m_strips[slot][channel - 1] = strip;
+  }
+  return true;
+}
+
+gem::readout::GEMDQMHistograms::GEMDQMHistograms(std::shared_ptr<const GEMslotContents> const& slotContents,
+                                                 std::shared_ptr<const GEMDQMStripMap>  const& stripMap) :
+  p_slotContents(slotContents),
+  p_stripMap(stripMap),
+  m_vfatSlot("VFATsn", "VFAT slot number", 24, 0., 24.),
+  m_clusterMult("ClusterMult", "Cluster multiplicity", 384, 0, 384),
+  m_clusterSize("ClusterSize", "Cluster size", 384, 0, 384),
+  m_beamProfile("BeamProfile", "Beam Profile", 8, 0, 8, 384, 0, 384),
+  m_vfatBlocks(0),
+  m_badVFATBlocks(0)
+{
+  for (int slot = 0; slot < GEMslotContents::N_SLOTS; ++slot) {
+    std::stringstream name, title;
+    name  << "hiStripsFired_Slot" << slot;
+    title << "Strips fired for VFAT chip Slot" << slot;
+    m_stripsFired.push_back(GEMDQMHistogram(name.str(), title.str(), 20, 0., 20.));
+  }
+  for (auto eta = m_firedStrips.begin(); eta != m_firedStrips.end(); ++eta)
+    eta->assign(N_STRIPS, 0);
+}
+
+void gem::readout::GEMDQMHistograms::fill(GEBdata& geb)
+{
+  bool fired = false;
+  for (auto vfat = geb.vfats().begin(); vfat != geb.vfats().end(); ++vfat) {
+    ++m_vfatBlocks;
+    if (!vfat->isBlockGood())
+      ++m_badVFATBlocks;
+
+    int const slot = vfat->SlotNumber();
+    m_vfatSlot.fill(slot);
+    if (slot < 0 || slot >= GEMslotContents::N_SLOTS)
+      continue;
+
+    // the eta partition is the slot modulo 8, each column of 8 slots covers 128 strips of the partitions
+    int const eta    = slot%8;
+    int const offset = (slot/8)*GEMDQMStripMap::N_CHANNELS;
+    uint64_t const data[2] = {vfat->lsData(), vfat->msData()};
+    for (int half = 0; half < 2; ++half) {
+      for (uint64_t bits = data[half]; bits; bits &= bits - 1) {
+        int const channel = 64*half + __builtin_ctzll(bits);
+        int const strip   = p_stripMap->strip(slot, channel);
+        if (strip < 0)
+          continue;
+        m_stripsFired[slot].fill(strip);
+        m_beamProfile.fill(eta, strip + offset);
+        if (strip + offset < N_STRIPS) {
+          m_firedStrips[eta][strip + offset] = 1;
+          fired = true;
+        }
+      }
+    }
+  }
+
+  // clusters are runs of adjacent fired strips within an eta partition
+  int nClusters = 0;
+  for (auto eta = m_firedStrips.begin(); fired && eta != m_firedStrips.end(); ++eta) {
+    int size = 0;
+    for (int strip = 0; strip <= N_STRIPS; ++strip) {
+      if (strip < N_STRIPS && (*eta)[strip]) {
+        ++size;
+        (*eta)[strip] = 0;
+      } else if (size) {
+        m_clusterSize.fill(size);
+        ++nClusters;
+        size = 0;
+      }
+    }
+  }
+  m_clusterMult.fill(nClusters);
+}
+
+void gem::readout::GEMDQMHistograms::merge(GEMDQMHistograms const& other)
+{
+  m_vfatSlot.merge(other.m_vfatSlot);
+  m_clusterMult.merge(other.m_clusterMult);
+  m_clusterSize.merge(other.m_clusterSize);
+  for (size_t slot = 0; slot < m_stripsFired.size(); ++slot)
+    m_stripsFired[slot].merge(other.m_stripsFired[slot]);
+  m_beamProfile.merge(other.m_beamProfile);
+  m_vfatBlocks    += other.m_vfatBlocks;
+  m_badVFATBlocks += other.m_badVFATBlocks;
+}
+
+std::vector<gem::readout::GEMDQMHistogram const*> gem::readout::GEMDQMHistograms::histograms() const
+{
+  std::vector<GEMDQMHistogram const*> all;
+  all.push_back(&m_vfatSlot);
+  all.push_back(&m_clusterMult);
+  all.push_back(&m_clusterSize);
+  for (auto slot = m_stripsFired.begin(); slot != m_stripsFired.end(); ++slot)
+    all.push_back(&(*slot));
+  all.push_back(&m_beamProfile);
+  return all;
+}
+
+VFATdata gem::readout::GEMDQMHistograms::toVFATdata(AMCVFATData const& vfat, GEMslotContents const& slotContents)
+{
+  uint8_t  const b1010  = (vfat.BC >> 12) & 0xf;
+  uint8_t  const b1100  = (vfat.EC >> 12) & 0xf;
+  uint8_t  const b1110  = (vfat.ChipID >> 12) & 0xf;
+  uint16_t const crcCalc = gem::datachecker::GEMDataChecker::checkCRC(vfat);
+
+  bool const good = b1010 == 0xa && b1100 == 0xc && b1110 == 0xe && vfat.crc == crcCalc;
+  return VFATdata(b1010, vfat.BC & 0xfff, b1100, (vfat.EC >> 4) & 0xff, vfat.EC & 0xf,
+                  b1110, vfat.ChipID & 0xfff, vfat.lsData, vfat.msData, vfat.crc, crcCalc,
+                  slotContents.GEBslotIndex(vfat.ChipID), good);
+}
+
+GEBdata gem::readout::GEMDQMHistograms::toGEBdata(AMCGEBData const& geb, GEMslotContents const& slotContents)
+{
+  GEBdata unpacked(0x00ffffff & (geb.header >> 40),  // ZeroSup
+                   0x1f       & (geb.header >> 35),  // InputID
+                   0x0fff     & (geb.header >> 23),  // Vwh
+                   0x1fff     &  geb.header,         // ErrorC
+                   geb.trailer >> 48,                // OHCRC
+                   0x0fff     & (geb.trailer >> 36), // Vwt
+                   0x0f       & (geb.trailer >> 35), // InFu
+                   0x01       & (geb.trailer >> 34)  // Stuckd
+                   );
+  for (auto vfat = geb.vfats.begin(); vfat != geb.vfats.end(); ++vfat)
+    unpacked.v_add(toVFATdata(*vfat, slotContents));
+  return unpacked;
+}
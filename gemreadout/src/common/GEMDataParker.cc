@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <bitset>
 #include <cstdlib>
 #include <iomanip>
@@ -24,7 +25,9 @@
 
 #include "TStopwatch.h"
 #include "gem/readout/GEMDataParker.h"
+#include "gem/readout/GEMVFATDecoder.h"
 #include "gem/readout/exception/Exception.h"
+#include "gem/datachecker/GEMDataChecker.h"
 #include "gem/hw/glib/HwGLIB.h"
 
 #include "gem/utils/soap/GEMSOAPToolBox.h"
@@ -33,13 +36,11 @@ typedef std::shared_ptr<int*> link_shared_ptr;
 typedef gem::readout::GEMDataAMCformat::GEMData  AMCGEMData;
 typedef gem::readout::GEMDataAMCformat::GEBData  AMCGEBData;
 typedef gem::readout::GEMDataAMCformat::VFATData AMCVFATData;
-//
-//why are these global and not part of the header???
-std::vector<AMCVFATData> vfats;
-std::vector<AMCVFATData> erros;
 
 const uint32_t gem::readout::GEMDataParker::kUPDATE = 5000;
 const uint32_t gem::readout::GEMDataParker::kUPDATE7 = 7;
+// 64k VFAT blocks
+const uint32_t gem::readout::GEMDataParker::kQUEUESIZE = 7*65536;
 
 // I have no idea what this is for
 int rvent_ = 0;
@@ -54,11 +55,12 @@ gem::readout::GEMDataParker::GEMDataParker(gem::hw::glib::HwGLIB& glibDevice,
                                            std::string const& outputType,
                                            std::string const& slotFileName,
                                            GEMRunType  const& runType) :
-  m_ESexp(-1),
-  m_isFirst(true),
   m_contvfats(0),
+  m_runque(kQUEUESIZE/7),
+  m_currentLink(0),
+  m_runWordsLeft(0),
   m_gemLogger(log4cplus::Logger::getInstance(LOG4CPLUS_TEXT("gem:readout:GEMDataParker"))),
-  m_queueLock(toolbox::BSem::FULL, true),
+  m_dataque(kQUEUESIZE),
   m_runType(runType)
 {
   //  these bindings necessitate that the GEMDataParker inherit from some xdaq application stuff
@@ -76,7 +78,22 @@ gem::readout::GEMDataParker::GEMDataParker(gem::hw::glib::HwGLIB& glibDevice,
   m_event = 0;
   rvent_ = 0;
   m_sumVFAT = 0;
-  slotInfo = std::unique_ptr<gem::readout::GEMslotContents>(new gem::readout::GEMslotContents(m_slotFileName));
+  slotInfo = gem::readout::GEMslotContents::getSlotContents(m_slotFileName);
+  // an event is complete once every populated slot has sent a good block
+  m_eventBuilder.setExpectedMask(slotInfo->GEBslotMask());
+
+  p_dataWriter = std::unique_ptr<GEMEventWriter>(new GEMEventWriter(m_outputType));
+  p_dataWriter->open(m_outFileName);
+  p_errWriter  = std::unique_ptr<GEMEventWriter>(new GEMEventWriter(m_outputType));
+  p_errWriter->open(m_errFileName);
+}
+
+void gem::readout::GEMDataParker::flushOutput()
+{
+  m_eventBuilder.flush();
+  writeBuiltEvents();
+  p_dataWriter->flush();
+  p_errWriter->flush();
 }
 
 uint32_t* gem::readout::GEMDataParker::dumpData(uint8_t const& readout_mask)
@@ -165,13 +182,19 @@ uint32_t* gem::readout::GEMDataParker::getGLIBData(uint8_t const& gtx, uint32_t
         << p_glibDevice->getFIFOOccupancy(gtx)
         );
   while ( p_glibDevice->getFIFOVFATBlockOccupancy(gtx) ) {
+    // only take as many blocks as the queue can hold, the rest stay in the hardware FIFO
+    uint32_t nBlocks = std::min(p_glibDevice->getFIFOVFATBlockOccupancy(gtx),
+                                static_cast<uint32_t>(m_dataque.available()/kUPDATE7));
+    if (nBlocks == 0) {
+      DEBUG(" ::getGLIBData data queue full (" << m_dataque.size() << " words), leaving data in the FIFO");
+      break;
+    }
     //timer.Start();
     Float_t getTrackingStart = (Float_t)timer.RealTime();
     DEBUG(" ::getGLIBData initiating call to getTrackingData(gtx,"
-          << p_glibDevice->getFIFOVFATBlockOccupancy(gtx) << ") "
+          << nBlocks << ") "
           << getTrackingStart);
-    std::vector<uint32_t> data = p_glibDevice->getTrackingData(gtx,
-                                                               p_glibDevice->getFIFOVFATBlockOccupancy(gtx));
+    std::vector<uint32_t> data = p_glibDevice->getTrackingData(gtx, nBlocks);
     Float_t getTrackingFinish = (Float_t)timer.RealTime();
     DEBUG(" ::getGLIBData The time for one call of getTrackingData(gtx) " << getTrackingFinish
           << std::endl << "FIFO VFAT block depth 0x" << std::hex
@@ -180,19 +203,19 @@ uint32_t* gem::readout::GEMDataParker::getGLIBData(uint8_t const& gtx, uint32_t
           << p_glibDevice->getFIFOOccupancy(gtx)
           );
 
-    uint32_t contqueue = 0;
-    for (auto iword = data.begin(); iword != data.end(); ++iword) {
-      contqueue++;
-      //gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_queueLock);
-      DEBUG(" ::getGLIBData pushing into queue 0x"
-            << std::setfill('0') << std::setw(8) << std::hex << *iword << std::dec );
-      m_dataque.push(*iword);
-      if (contqueue%kUPDATE7 == 0 &&  contqueue != 0) {
-        m_contvfats++;
-        DEBUG(" ::getGLIBData counter " << contqueue << " contvfats " << m_contvfats
-              << " m_dataque.size " << m_dataque.size());
-      }
+    // single producer, the space was checked above so this only fails on an oversized reply
+    // the run goes in first, so the consumer never sees words without their link
+    if (data.size() <= m_dataque.available() && m_runque.available() > 0) {
+      QueuedRun const run = {gtx, static_cast<uint32_t>(data.size())};
+      m_runque.push(&run, 1);
+      m_dataque.push(data);
+      m_contvfats += data.size()/kUPDATE7;
+    } else {
+      WARN(" ::getGLIBData dropping " << data.size() << " words, only "
+           << m_dataque.available() << " words free in the data queue");
     }
+    DEBUG(" ::getGLIBData pushed " << data.size() << " words, contvfats " << m_contvfats
+          << " m_dataque.size " << m_dataque.size());
     DEBUG(" ::getGLIBData end of while loop do we go again?" << std::endl
           << " FIFO VFAT block occupancy  0x" << std::hex << p_glibDevice->getFIFOVFATBlockOccupancy(gtx)
           << std::endl
@@ -228,182 +251,109 @@ uint32_t* gem::readout::GEMDataParker::GEMEventMaker(uint32_t counter[5])
 {
   uint32_t *point = &counter[0];
 
-  AMCGEMData  gem;
-  AMCGEBData  geb;
   AMCVFATData vfat;
 
   int islot = -1;
 
-  // Booking FIFO variables
-  uint64_t msVFAT, lsVFAT;
-  uint32_t ES;
-
   DEBUG("GEMDataParker::GEMEventMaker  " << std::hex << point );
-  if (m_dataque.empty()) return point;
+  if (m_dataque.size() < kUPDATE7) return point;
   DEBUG(" ::GEMEventMaker m_dataque.size " << m_dataque.size() );
 
-  this->readVFATblock(m_dataque);
-
-  uint64_t data1  = dat10 | dat11;
-  uint64_t data2  = dat20 | dat21;
-  uint64_t data3  = dat30 | dat31;
-  uint64_t data4  = dat40 | dat41;
+  uint8_t link = 0;
+  if (!this->readVFATblock(m_dataque, vfat, link)) return point;
 
   m_vfat++;
 
-  islot = slotInfo->GEBslotIndex( (uint32_t)chipid);
+  uint16_t const evn    = GEMVFATDecoder::evn(vfat.EC);
+  uint16_t const bcn    = GEMVFATDecoder::bcn(vfat.BC);
+  uint16_t const chipid = GEMVFATDecoder::chipID(vfat.ChipID);
 
-  // GEM Event selector
-  ES = ( evn << 12 ) | bcn;
-  DEBUG(" ::GEMEventMaker ES 0x" << std::hex << ES << " evn 0x"<< evn <<
-        " bcn 0x" << std::hex << bcn << std::dec << " vftas.size " <<
-        vfats.size() << " erros.size " << erros.size() << " chip ID 0x" <<
-        std::hex << (int)chipid << std::dec <<
-        " slot number " << islot << " m_isFirst " << m_isFirst << " event " << m_event);
-
-  lsVFAT = (data3 << 32) | (data4);
-  msVFAT = (data1 << 32) | (data2);
-
-  vfat.BC     = ( b1010 << 12 ) | (bcn);                // 1010     | bcn:12
-  vfat.EC     = ( b1100 << 12 ) | (evn << 4) | (flags); // 1100     | EC:8      | Flag:4
-  vfat.ChipID = ( b1110 << 12 ) | (chipid);             // 1110     | ChipID:12
-  vfat.lsData = lsVFAT;                                 // lsData:64
-  vfat.msData = msVFAT;                                 // msData:64
-  vfat.BXfrOH = BX;                                     // BXfrOH:32
-  vfat.crc    = vfatcrc;                                // crc:16
-
-  if ( ES == m_ESexp ) {
-    m_isFirst = false;
-  } else {
-    m_isFirst = true;
+  islot = slotInfo->GEBslotIndex( (uint32_t)chipid);
 
-    if ( vfats.size() != 0 || erros.size() != 0 ) {
-      DEBUG(" ::GEMEventMaker m_isFirst GEMevSelector ");
-      gem::readout::GEMDataParker::GEMevSelector(m_ESexp);
-    }
+  DEBUG(" ::GEMEventMaker evn 0x"<< std::hex << evn << " bcn 0x" << bcn << " chip ID 0x"
+        << (int)chipid << std::dec << " slot number " << islot << " event " << m_event);
 
-    m_event++;
-    // VFATS dimensions have limits
-    vfats.reserve(MaxVFATS);
-    erros.reserve(MaxERRS);
-    m_ESexp = ES;
-  }
-  DEBUG(" ::GEMEventMaker ES 0x" << std::hex << ES << std::dec << " bool " << m_isFirst );
+  bool good = true;
   if (islot < 0 || islot > 23) {
-    if ( int(erros.size()) <MaxERRS ) erros.push_back(vfat);
-    DEBUG(" ::GEMEventMaker warning !!! islot is undefined " << islot << " erros.size " << int(erros.size()) );
-  } else {
-    // VFATs Pay Load
-    if ( int(vfats.size()) <= MaxVFATS ) vfats.push_back(vfat);
-    DEBUG(" ::GEMEventMaker m_event " << m_event << " vfats.size " << vfats.size() << std::hex << " ES 0x" << ES << std::dec );
-  }//end of event selection
+    good = false;
+    DEBUG(" ::GEMEventMaker warning !!! islot is undefined " << islot);
+  } else if (!gem::datachecker::GEMDataChecker::isCRCGood(vfat)) {
+    good = false;
+    DEBUG(" ::GEMEventMaker bad CRC 0x" << std::hex << vfat.crc << " computed 0x"
+          << gem::datachecker::GEMDataChecker::checkCRC(vfat) << std::dec);
+  }
+
+  // blocks of one event need not be contiguous, the builder keeps it open until it is complete
+  m_eventBuilder.addBlock(link, islot, good, vfat);
+  writeBuiltEvents();
 
   counter[0] = m_vfat;
   counter[1] = m_event;
-  counter[2] = vfats.size() + erros.size();
-  counter[3] = vfats.size();
-  counter[4] = erros.size();
+  counter[2] = m_eventBuilder.pendingBlocks() + m_eventBuilder.pendingErrors();
+  counter[3] = m_eventBuilder.pendingBlocks();
+  counter[4] = m_eventBuilder.pendingErrors();
 
   return point;
 }
 
-void gem::readout::GEMDataParker::GEMevSelector(const  uint32_t& ES)
+void gem::readout::GEMDataParker::writeBuiltEvents()
+{
+  while (m_eventBuilder.popEvent(m_builtEvent))
+    gem::readout::GEMDataParker::GEMevSelector(m_builtEvent);
+}
+
+void gem::readout::GEMDataParker::GEMevSelector(GEMEventBuilder::Event& event)
 {
   //  GEM Event Data Format definition
   AMCGEMData  gem;
   AMCGEBData  geb;
   AMCVFATData vfat;
 
-  DEBUG(" ::GEMEventMaker vfats.size " << int(vfats.size()) << " rvent_ " << rvent_ << " event " << m_event);
+  ++m_event;
+  DEBUG(" ::GEMevSelector event " << m_event << " link " << (int)event.link
+        << std::hex << " EC 0x" << event.EC << " BC 0x" << event.BC << " DAV 0x" << event.davMask
+        << std::dec << " vfats.size " << event.vfats.size() << " errors.size " << event.errors.size());
+  if (!event.complete && event.davMask)
+    DEBUG(" ::GEMevSelector event " << m_event << " closed without a full DAV mask");
 
-  uint32_t locEvent = 0;
-  uint32_t locError = 0;
   std::string TypeDataFlag = "PayLoad";
+  if (!event.vfats.empty()) {
+    // VFATs Pay Load, the builder's storage is swapped in and out to avoid copying the blocks
+    geb.vfats.swap(event.vfats);
+    int islot = slotInfo->GEBslotIndex((uint32_t)geb.vfats.front().ChipID);
+    gem::readout::GEMDataParker::VFATfillData(islot, geb);
+    gem::readout::GEMDataParker::GEMfillHeaders(m_event, 1, gem, geb);
+    gem::readout::GEMDataParker::GEMfillTrailers(gem, geb);
+    // GEM Event Writing
+    DEBUG(" ::GEMevSelector writing...  geb.vfats.size " << int(geb.vfats.size()) );
+    gem::readout::GEMDataParker::writeGEMevent(*p_dataWriter, false, TypeDataFlag, gem, geb, vfat);
+    geb.vfats.swap(event.vfats);
+  }
 
-  // contents all local events (one buffer, all links):
-  locEvent++;
-  uint32_t nChip = 0;
-  for (auto iVFAT=vfats.begin(); iVFAT != vfats.end(); ++iVFAT) {//try auto
-
-    uint8_t ECff = ( (0x0ff0 & (*iVFAT).EC ) >> 4);
-    uint32_t localEvent = ( ECff << 12 ) | ( 0x0fff & (*iVFAT).BC );
-
-    DEBUG(" ::GEMEventMaker vfats ES 0x" << std::hex << ( 0x00ffffff & ES) << " and from vfat 0x" <<
-          ( 0x00ffffff & localEvent ) << " EC 0x" << (int)ECff << " BC 0x" << ( 0x0fff & (*iVFAT).BC ) << std::dec );
-
-    if ( ES == localEvent ) {
-      nChip++;
-      // VFATs Pay Load
-      geb.vfats.push_back(*iVFAT);
-      int islot = slotInfo->GEBslotIndex((uint32_t)(*iVFAT).ChipID);
-      DEBUG(" ::GEMevSelector slot number " << islot );
-
-      if ( gem::readout::GEMDataParker::VFATfillData( islot, geb) ) {
-        if ( vfats.size() == nChip ) {
-
-          gem::readout::GEMDataParker::GEMfillHeaders(m_event, 1, gem, geb);
-          gem::readout::GEMDataParker::GEMfillTrailers(gem, geb);
-          // GEM Event Writing
-          DEBUG(" ::GEMEventMaker writing...  geb.vfats.size " << int(geb.vfats.size()) );
-          TypeDataFlag = "PayLoad";
-          if(int(geb.vfats.size()) != 0) gem::readout::GEMDataParker::writeGEMevent(m_outFileName, false, TypeDataFlag,
-                                                                                    gem, geb, vfat);
-          geb.vfats.clear();
-        }// end of writing event
-      }// if slot correct
-    }// if localEvent
-  }// end of GEB PayLoad Data
-
-  geb.vfats.clear();
-  TypeDataFlag = "Errors";
-
-  // contents all local events (one buffer, all links):
-  DEBUG(" ::GEMEventMaker END ES 0x" << std::hex << ES << std::dec << " errES " <<  erros.size() <<
-        " rvent_ " << rvent_ );
-
-  uint32_t nErro = 0;
-  for (auto iErr=erros.begin(); iErr != erros.end(); ++iErr) {
-
-    uint8_t ECff = ( (0x0ff0 & (*iErr).EC ) >> 4);
-    uint32_t localErr = ( ECff << 12 ) | ( 0x0fff & (*iErr).BC );
-    DEBUG(" ::GEMEventMaker ERROR vfats ES 0x" << ES << " EC " << localErr );
-
-    if( ES == localErr ) {
-      nErro++;
-      DEBUG(" ::GEMEventMaker " << " nErro " << nErro << " ES 0x" << std::hex << ES << std::dec );
-      // VFATs Errors
-      geb.vfats.push_back(*iErr);
-      if ( erros.size() == nErro ) {
-        // GEMDataAMCformat::printVFATdataBits(nErro, vfat);
-        int islot = -1;
-        gem::readout::GEMDataParker::VFATfillData( islot, geb);
-        gem::readout::GEMDataParker::GEMfillHeaders(rvent_, nErro, gem, geb);
-        gem::readout::GEMDataParker::GEMfillTrailers(gem, geb);
-        // GEM ERRORS Event Writing
-        TypeDataFlag = "Errors";
-        if(int(geb.vfats.size()) != 0) gem::readout::GEMDataParker::writeGEMevent(m_errFileName, false, TypeDataFlag,
-                                                                                  gem, geb, vfat);
-        geb.vfats.clear();
-      }// if localErr
-    }// if localErr
-  }// end of GEB PayLoad Data
-
-  geb.vfats.clear();
+  if (!event.errors.empty()) {
+    // VFATs Errors
+    TypeDataFlag = "Errors";
+    geb.vfats.swap(event.errors);
+    int islot = -1;
+    gem::readout::GEMDataParker::VFATfillData(islot, geb);
+    gem::readout::GEMDataParker::GEMfillHeaders(rvent_, geb.vfats.size(), gem, geb);
+    gem::readout::GEMDataParker::GEMfillTrailers(gem, geb);
+    // GEM ERRORS Event Writing
+    gem::readout::GEMDataParker::writeGEMevent(*p_errWriter, false, TypeDataFlag, gem, geb, vfat);
+    geb.vfats.swap(event.errors);
+  }
 
   if (m_event%kUPDATE == 0 &&  m_event != 0) {
-    DEBUG(" ::GEMEventMaker vfats.size " << std::setfill(' ') << std::setw(7) << int(vfats.size()) <<
-          " erros.size " << std::setfill(' ') << std::setw(3) << int(erros.size()) <<
-          " locEvent   " << std::setfill(' ') << std::setw(6) << locEvent <<
-          " locError   " << std::setfill(' ') << std::setw(3) << locError << " event " << m_event
+    DEBUG(" ::GEMevSelector event " << m_event
+          << " built "          << m_eventBuilder.eventsBuilt()
+          << " complete "       << m_eventBuilder.eventsComplete()
+          << " timed out "      << m_eventBuilder.eventsTimedOut()
+          << " evicted "        << m_eventBuilder.eventsEvicted()
+          << " split "          << m_eventBuilder.eventsSplit()
+          << " errors dropped " << m_eventBuilder.errorsDropped()
+          << " open "           << m_eventBuilder.openEvents()
           );
   }
-
-  locEvent = 0;
-
-  vfats.clear();
-  erros.clear();
-  // reset event logic
-  m_isFirst = true;
 }
 
 bool gem::readout::GEMDataParker::VFATfillData(int const& islot, AMCGEBData&  geb)
@@ -428,7 +378,7 @@ bool gem::readout::GEMDataParker::VFATfillData(int const& islot, AMCGEBData&  ge
 }// end VFATfillData
 
 
-void gem::readout::GEMDataParker::writeGEMevent(std::string  outFile, bool const&  OKprint,
+void gem::readout::GEMDataParker::writeGEMevent(GEMEventWriter& writer, bool const&  OKprint,
                                                 std::string const& TypeDataFlag,
                                                 AMCGEMData&  gem, AMCGEBData&  geb, AMCVFATData& vfat)
 {
@@ -436,49 +386,9 @@ void gem::readout::GEMDataParker::writeGEMevent(std::string  outFile, bool const
     DEBUG(" ::writeGEMevent m_vfat " << m_vfat << " event " << m_event << " sumVFAT " << (0x000000000fffffff & geb.header) <<
           " geb.vfats.size " << int(geb.vfats.size()) );
   }
-  // GEM Chamber's Data
-  if (m_outputType == "Hex") {
-    GEMDataAMCformat::writeGEMhd1 (outFile, m_event, gem);
-    GEMDataAMCformat::writeGEMhd2 (outFile, m_event, gem);
-    GEMDataAMCformat::writeGEMhd3 (outFile, m_event, gem);
-  } else {
-    GEMDataAMCformat::writeGEMhd1Binary (outFile, m_event, gem);
-    GEMDataAMCformat::writeGEMhd2Binary (outFile, m_event, gem);
-    GEMDataAMCformat::writeGEMhd3Binary (outFile, m_event, gem);
-  }
-  //  GEB Headers Data
-  if (m_outputType == "Hex") {
-    GEMDataAMCformat::writeGEBheader (outFile, m_event, geb);
-    GEMDataAMCformat::writeGEBrunhed (outFile, m_event, geb);
-  } else {
-    GEMDataAMCformat::writeGEBheaderBinary (outFile, m_event, geb);
-    //GEMDataAMCformat::writeGEBrunhedBinary (outFile, m_event, geb);
-  } // GEMDataAMCformat::printGEBheader (m_event, geb);
-  //  GEB PayLoad Data
-  int nChip=0;
-  for (auto iVFAT=geb.vfats.begin(); iVFAT != geb.vfats.end(); ++iVFAT) {
-    nChip++;
-
-    if (m_outputType == "Hex") {
-      GEMDataAMCformat::writeVFATdata (outFile, nChip, *iVFAT);
-    } else {
-      GEMDataAMCformat::writeVFATdataBinary (outFile, nChip, *iVFAT);
-    };
-  }//end of GEB PayLoad Data
-  //  GEB Trailers Data
-  if (m_outputType == "Hex") {
-    GEMDataAMCformat::writeGEBtrailer (outFile, m_event, geb);
-  } else {
-    GEMDataAMCformat::writeGEBtrailerBinary (outFile, m_event, geb);
-  }
-  //  GEM Trailers Data
-  if (m_outputType == "Hex") {
-    GEMDataAMCformat::writeGEMtr2 (outFile, m_event, gem);
-    GEMDataAMCformat::writeGEMtr1 (outFile, m_event, gem);
-  } else {
-    GEMDataAMCformat::writeGEMtr2Binary (outFile, m_event, gem);
-    GEMDataAMCformat::writeGEMtr1Binary (outFile, m_event, gem);
-  }
+  // whole event is serialized into the writer buffer, file is kept open for the run
+  if (!writer.writeGEMevent(gem, geb))
+    WARN(" ::writeGEMevent " << TypeDataFlag << " output file is not open, dropping event " << m_event);
 }
 
 void gem::readout::GEMDataParker::GEMfillHeaders(uint32_t const& event, uint32_t const& DAVCount_,
@@ -578,69 +488,65 @@ void gem::readout::GEMDataParker::GEMfillTrailers(AMCGEMData&  gem,AMCGEBData&
   DEBUG(" OHcrc 0x" << std::hex << OHcrc << " OHwCount " << OHwCount << " ChamStatus " << ChamStatus << std::dec);
 }
 
-void gem::readout::GEMDataParker::readVFATblock(std::queue<uint32_t>& dataque)
+bool gem::readout::GEMDataParker::nextRun()
 {
-  uint32_t datafront = 0;
-  for (int iQue = 0; iQue < 7; iQue++){
-    datafront = dataque.front();
-    DEBUG(" ::GEMEventMaker iQue " << iQue << " 0x"
-          << std::setfill('0') << std::setw(8) << std::hex << datafront << std::dec );
-    //this never seems to get reset? maybe iQue%7 to read the words after the first block?
-    if ((iQue%7) == 5 ) {
-      dat41   = ((0xffff0000 & datafront) >> 16 );
-      vfatcrc = (0x0000ffff & datafront);
-    } else if ( (iQue%7) == 4 ) {
-      dat40   = ((0x0000ffff & datafront) << 16 );
-      dat31   = ((0xffff0000 & datafront) >> 16 );
-    } else if ( (iQue%7) == 3 ) {
-      dat21   = ((0xffff0000 & datafront) >> 16 );
-      dat30   = ((0x0000ffff & datafront) << 16 );
-    } else if ( (iQue%7) == 2 ) {
-      dat11   = ((0xffff0000 & datafront) >> 16 );
-      dat20   = ((0x0000ffff & datafront) << 16 );
-    } else if ( (iQue%7) == 1 ) {
-      b1110   = ((0xf0000000 & datafront) >> 28 );
-      chipid  = ((0x0fff0000 & datafront) >> 16 );
-      dat10   = ((0x0000ffff & datafront) << 16 );
-    } else if ( (iQue%7) == 0 ) {
-      b1010   = ((0xf0000000 & datafront) >> 28 );
-      b1100   = ((0x0000f000 & datafront) >> 12 );
-      bcn     = ((0x0fff0000 & datafront) >> 16 );
-      evn     = ((0x00000ff0 & datafront) >>  4 );
-      flags   = (0x0000000f & datafront);
-
-      if (!(b1010 == 0xa && b1100 == 0xc)) {
-        bool misAligned_ = true;
-        while ((misAligned_) && (dataque.size()>7)){
-          /* we have a misaligned word, increment misalignment counter, pop queue,
-             push bad value into some form of storage for later analysis?
-             then continue with the loop, but without incrementing iQue so we hopefully
-             eventually align again
-
-             Do not go through all the loop with condition statements
-             since iQue stays the same and we removed 7 blocks
-             -MD
-          */
-          INFO(" ::GEMEventMaker found misaligned word 0x"
-               << std::setfill('0') << std::hex << datafront << std::dec
-               << " queue m_dataque.size " << dataque.size() );
-          dataque.pop();
-          datafront = dataque.front();
-          b1010   = ((0xf0000000 & datafront) >> 28 );
-          b1100   = ((0x0000f000 & datafront) >> 12 );
-          bcn     = ((0x0fff0000 & datafront) >> 16 );
-          evn     = ((0x00000ff0 & datafront) >>  4 );
-          flags   = (0x0000000f & datafront);
-          if ((b1010 == 0xa && b1100 == 0xc)) { misAligned_ = false;}
-        }// end of while misaligned
-      }
-    } else if ( (iQue%7) == 6 ) {
-      BX      = datafront;
+  if (m_runque.empty())
+    return false;
+  m_currentLink  = m_runque.front().link;
+  m_runWordsLeft = m_runque.front().nWords;
+  m_runque.pop();
+  return true;
+}
+
+void gem::readout::GEMDataParker::consumeRunWords(size_t nWords)
+{
+  while (nWords > 0) {
+    if (m_runWordsLeft == 0) {
+      if (!nextRun())
+        return;
+      continue;
     }
-    DEBUG(" ::GEMEventMaker (pre pop) m_dataque.size " << dataque.size() );
+    uint32_t const taken = std::min(static_cast<size_t>(m_runWordsLeft), nWords);
+    m_runWordsLeft -= taken;
+    nWords         -= taken;
+  }
+}
+
+bool gem::readout::GEMDataParker::readVFATblock(gem::utils::SPSCRingBuffer<uint32_t>& dataque,
+                                                 AMCVFATData& vfat, uint8_t& link)
+{
+  // drop words until the queue is aligned on a block header (1010 and 1100 control bits)
+  while (dataque.size() >= kUPDATE7) {
+    uint32_t const datafront = dataque.front();
+    if (GEMVFATDecoder::isBlockHeader(datafront))
+      break;
+    /* we have a misaligned word, increment misalignment counter, pop queue,
+       push bad value into some form of storage for later analysis?
+    */
+    INFO(" ::GEMEventMaker found misaligned word 0x"
+         << std::setfill('0') << std::hex << datafront << std::dec
+         << " queue m_dataque.size " << dataque.size() );
     dataque.pop();
-    DEBUG(" ::GEMEventMaker (post pop)  m_dataque.size " << dataque.size() );
-  }// end queue
+    consumeRunWords(1);
+  }
+
+  gem::utils::SPSCRingBuffer<uint32_t>::Span span = dataque.peek(kUPDATE7);
+  if (span.empty())
+    return false;
+
+  // the block may wrap around the end of the queue storage
+  uint32_t block[GEMVFATDecoder::BLOCK_WORDS];
+  for (size_t iQue = 0; iQue < GEMVFATDecoder::BLOCK_WORDS; ++iQue)
+    block[iQue] = span[iQue];
+  GEMVFATDecoder::decode(block, vfat);
+  // the block belongs to the run of its header word
+  while (m_runWordsLeft == 0 && nextRun())
+    ;
+  link = m_currentLink;
+  dataque.pop(kUPDATE7);
+  consumeRunWords(kUPDATE7);
+  DEBUG(" ::GEMEventMaker (post pop)  m_dataque.size " << dataque.size() );
+  return true;
 }
 
 
@@ -0,0 +1,195 @@
+/**
+ * class: GEMEventBuilder
+ * description: Builds GEM events from VFAT blocks keyed on (link, EC, BC), with a bounded
+ *              reorder window so that blocks from interleaved links end up in the same event
+ */
+
+#include "gem/readout/GEMEventBuilder.h"
+
+#include <utility>
+
+const size_t   gem::readout::GEMEventBuilder::DEFAULT_WINDOW;
+const uint32_t gem::readout::GEMEventBuilder::DEFAULT_TIMEOUT_US;
+const size_t   gem::readout::GEMEventBuilder::MAX_SLOTS;
+const size_t   gem::readout::GEMEventBuilder::MAX_ERRORS;
+
+gem::readout::GEMEventBuilder::GEMEventBuilder(size_t const& window, uint32_t const& timeoutUS) :
+  m_window(window > 0 ? window : 1),
+  m_timeout(std::chrono::duration_cast<clock::duration>(std::chrono::microseconds(timeoutUS))),
+  m_defaultMask(0x0),
+  m_frontSequence(0),
+  m_nextSequence(0),
+  m_pendingBlocks(0),
+  m_pendingErrors(0),
+  m_eventsBuilt(0),
+  m_eventsComplete(0),
+  m_eventsTimedOut(0),
+  m_eventsEvicted(0),
+  m_eventsSplit(0),
+  m_errorsDropped(0)
+{
+  m_openEvents.reserve(2*m_window);
+}
+
+gem::readout::GEMEventBuilder::~GEMEventBuilder()
+{
+}
+
+void gem::readout::GEMEventBuilder::setExpectedMask(uint32_t const& mask)
+{
+  m_defaultMask = mask;
+}
+
+void gem::readout::GEMEventBuilder::setExpectedMask(uint8_t const& link, uint32_t const& mask)
+{
+  m_linkMasks[link] = mask;
+}
+
+uint32_t gem::readout::GEMEventBuilder::expectedMask(uint8_t const& link) const
+{
+  auto mask = m_linkMasks.find(link);
+  return (mask == m_linkMasks.end()) ? m_defaultMask : mask->second;
+}
+
+void gem::readout::GEMEventBuilder::addBlock(uint8_t const& link, int const& slot, bool const& good,
+                                             GEMDataAMCformat::VFATData const& vfat)
+{
+  uint16_t const EC  = (vfat.EC >> 4) & 0xff;
+  uint16_t const BC  = vfat.BC & 0xfff;
+  uint32_t const key = eventKey(link, EC, BC);
+  bool const validSlot = slot >= 0 && slot < static_cast<int>(MAX_SLOTS);
+  uint32_t const slotBit = validSlot ? (0x1u << slot) : 0x0;
+
+  PendingEvent* pending = NULL;
+  auto open = m_openEvents.find(key);
+  if (open != m_openEvents.end())
+    pending = &m_events[open->second - m_frontSequence];
+
+  if (pending && good && (pending->event.davMask & slotBit)) {
+    // a second block from the same slot, the EC/BC has wrapped around
+    ++m_eventsSplit;
+    closeEvent(*pending);
+    pending = NULL;
+  }
+
+  if (!pending)
+    pending = &openEvent(key, link, EC, BC);
+
+  Event& event = pending->event;
+  if (good && validSlot) {
+    event.vfats.push_back(vfat);
+    event.davMask |= slotBit;
+    ++m_pendingBlocks;
+
+    uint32_t const expected = expectedMask(link);
+    if (expected && (event.davMask & expected) == expected) {
+      event.complete = true;
+      ++m_eventsComplete;
+      closeEvent(*pending);
+    }
+  } else if (event.errors.size() < MAX_ERRORS) {
+    event.errors.push_back(vfat);
+    ++m_pendingErrors;
+  } else {
+    ++m_errorsDropped;
+  }
+
+  expire();
+}
+
+gem::readout::GEMEventBuilder::PendingEvent& gem::readout::GEMEventBuilder::openEvent(uint32_t const& key,
+                                                                                    uint8_t  const& link,
+                                                                                    uint16_t const& EC,
+                                                                                    uint16_t const& BC)
+{
+  // make room in the window, the oldest open event is closed as it is
+  if (m_events.size() >= m_window) {
+    for (auto oldest = m_events.begin(); oldest != m_events.end(); ++oldest) {
+      if (!oldest->closed) {
+        ++m_eventsEvicted;
+        closeEvent(*oldest);
+        break;
+      }
+    }
+  }
+
+  // deque::push_back keeps references to the other events valid
+  m_events.push_back(PendingEvent());
+  PendingEvent& pending = m_events.back();
+  pending.sequence       = m_nextSequence++;
+  pending.opened         = clock::now();
+  pending.closed         = false;
+  pending.event.link     = link;
+  pending.event.EC       = EC;
+  pending.event.BC       = BC;
+  pending.event.davMask  = 0x0;
+  pending.event.complete = false;
+  pending.event.vfats.reserve(MAX_SLOTS);
+
+  m_openEvents[key] = pending.sequence;
+  return pending;
+}
+
+void gem::readout::GEMEventBuilder::closeEvent(PendingEvent& pending)
+{
+  if (pending.closed)
+    return;
+  pending.closed = true;
+  m_openEvents.erase(eventKey(pending.event.link, pending.event.EC, pending.event.BC));
+}
+
+size_t gem::readout::GEMEventBuilder::expire()
+{
+  if (m_timeout == clock::duration::zero() || m_openEvents.empty())
+    return 0;
+
+  // events are opened in sequence order, stop at the first one still within the timeout
+  clock::time_point const now = clock::now();
+  size_t nExpired = 0;
+  for (auto pending = m_events.begin(); pending != m_events.end(); ++pending) {
+    if (pending->closed)
+      continue;
+    if (now - pending->opened < m_timeout)
+      break;
+    ++m_eventsTimedOut;
+    ++nExpired;
+    closeEvent(*pending);
+  }
+  return nExpired;
+}
+
+void gem::readout::GEMEventBuilder::flush()
+{
+  for (auto pending = m_events.begin(); pending != m_events.end(); ++pending)
+    closeEvent(*pending);
+}
+
+bool gem::readout::GEMEventBuilder::popEvent(Event& event)
+{
+  if (m_events.empty() || !m_events.front().closed)
+    return false;
+
+  std::swap(event, m_events.front().event);
+  m_pendingBlocks -= event.vfats.size();
+  m_pendingErrors -= event.errors.size();
+  ++m_eventsBuilt;
+
+  m_events.pop_front();
+  ++m_frontSequence;
+  return true;
+}
+
+void gem::readout::GEMEventBuilder::clear()
+{
+  m_events.clear();
+  m_openEvents.clear();
+  m_frontSequence  = m_nextSequence;
+  m_pendingBlocks  = 0;
+  m_pendingErrors  = 0;
+  m_eventsBuilt    = 0;
+  m_eventsComplete = 0;
+  m_eventsTimedOut = 0;
+  m_eventsEvicted  = 0;
+  m_eventsSplit    = 0;
+  m_errorsDropped  = 0;
+}
@@ -0,0 +1,263 @@
+/**
+ * class: GEMEventWriter
+ * description: Buffered writer for GEMDataAMCformat events, keeps the output
+ *              file open for the duration of a run and writes whole buffers
+ *              rather than a single word per open/close
+ */
+
+#include "gem/readout/GEMEventWriter.h"
+
+#include <cstdio>
+#include <ctime>
+
+#include "toolbox/string.h"
+
+#include "gem/readout/exception/Exception.h"
+
+namespace {
+  // placeholder CDF/AMC13 words wrapped around each binary event,
+  // as written by GEMDataAMCformat::writeGEMhd1Binary/writeGEMtr1Binary
+  const uint64_t CDF_HEADER    = 0x5fffffffffffffff;
+  const uint64_t AMC13_HEADER1 = 0xff1ffffffffffff0;
+  const uint64_t AMC13_HEADER2 = 0xffffffffffffffff;
+  const uint64_t AMC13_TRAILER = 0xbadc0ffeebadcafe;
+  const uint64_t CDF_TRAILER   = 0xafffffffffffffff;
+
+  // 16 hex digits and a newline
+  const size_t HEX_WORD_SIZE = 17;
+}
+
+const size_t gem::readout::GEMEventWriter::DEFAULT_BUFFER_SIZE;
+
+gem::readout::GEMEventWriter::GEMEventWriter(std::string const& outputType,
+                                             size_t      const& bufferSize,
+                                             FlushPolicy const& policy,
+                                             uint32_t    const& flushInterval) :
+  m_gemLogger(log4cplus::Logger::getInstance(LOG4CPLUS_TEXT("gem:readout:GEMEventWriter"))),
+  m_fileName(""),
+  m_bufferSize(bufferSize),
+  m_format(toOutputFormat(outputType)),
+  m_runNumber(0),
+  m_flushPolicy(policy),
+  m_flushInterval(flushInterval),
+  m_eventsSinceFlush(0),
+  m_eventsWritten(0),
+  m_bytesWritten(0)
+{
+  m_buffer.reserve(m_bufferSize);
+}
+
+gem::readout::GEMEventWriter::~GEMEventWriter()
+{
+  close();
+}
+
+void gem::readout::GEMEventWriter::open(std::string const& fileName)
+{
+  if (m_outf.is_open())
+    close();
+
+  // the user-space buffer is the only buffering layer, avoid a second copy in the filebuf
+  m_outf.rdbuf()->pubsetbuf(0, 0);
+  // the offsets of the index of a run file are only valid in a file of its own
+  if (m_format == RUN_FORMAT)
+    m_outf.open(fileName.c_str(), std::ios_base::trunc | std::ios::binary);
+  else
+    m_outf.open(fileName.c_str(), std::ios_base::app | std::ios::binary);
+  if (!m_outf.is_open()) {
+    std::string msg = toolbox::toString("GEMEventWriter::open unable to open output file %s",
+                                        fileName.c_str());
+    ERROR(msg);
+    XCEPT_RAISE(gem::readout::exception::Exception, msg);
+  }
+
+  m_fileName         = fileName;
+  m_eventsSinceFlush = 0;
+  m_eventsWritten    = 0;
+  m_bytesWritten     = 0;
+  m_buffer.clear();
+  m_eventOffsets.clear();
+
+  if (m_format == RUN_FORMAT) {
+    GEMRunFile::FileHeader header;
+    header.magic        = GEMRunFile::FILE_MAGIC;
+    header.version      = GEMRunFile::VERSION;
+    header.headerSize   = sizeof(header);
+    header.runNumber    = m_runNumber;
+    header.startTime    = static_cast<uint64_t>(std::time(0));
+    header.syncInterval = GEMRunFile::DEFAULT_SYNC_INTERVAL;
+    header.reserved     = 0;
+    appendBytes(&header, sizeof(header));
+  }
+
+  INFO("GEMEventWriter::open opened " << m_fileName << " (format " << m_format
+       << ", buffer " << m_bufferSize << " bytes, flush policy " << m_flushPolicy << ")");
+}
+
+void gem::readout::GEMEventWriter::close()
+{
+  if (!m_outf.is_open())
+    return;
+
+  if (m_format == RUN_FORMAT) {
+    flush();
+    GEMRunFile::FileTrailer trailer;
+    trailer.indexOffset = m_bytesWritten;
+    trailer.nEvents     = m_eventOffsets.size();
+    trailer.magic       = GEMRunFile::TRAILER_MAGIC;
+
+    GEMRunFile::RecordHeader record = {GEMRunFile::INDEX_RECORD, static_cast<uint32_t>(m_eventOffsets.size())};
+    appendBytes(&record, sizeof(record));
+    if (!m_eventOffsets.empty())
+      appendBytes(&m_eventOffsets[0], m_eventOffsets.size()*sizeof(uint64_t));
+    appendBytes(&trailer, sizeof(trailer));
+  }
+
+  flush();
+  m_outf.close();
+  INFO("GEMEventWriter::close closed " << m_fileName << " after "
+       << m_eventsWritten << " events, " << m_bytesWritten << " bytes");
+}
+
+void gem::readout::GEMEventWriter::setOutputType(std::string const& outputType)
+{
+  OutputFormat const format = toOutputFormat(outputType);
+  if (m_outf.is_open() && format != m_format && (format == RUN_FORMAT || m_format == RUN_FORMAT)) {
+    ERROR("GEMEventWriter::setOutputType unable to switch " << m_fileName << " to " << outputType
+          << ", a run file can not contain other formats");
+    return;
+  }
+
+  // don't mix formats inside one buffer
+  flush();
+  m_format = format;
+}
+
+gem::readout::GEMEventWriter::OutputFormat gem::readout::GEMEventWriter::toOutputFormat(std::string const& outputType)
+{
+  if (outputType == "Hex")
+    return HEX_FORMAT;
+  else if (outputType == "Run")
+    return RUN_FORMAT;
+  return BIN_FORMAT;
+}
+
+void gem::readout::GEMEventWriter::setFlushPolicy(FlushPolicy const& policy, uint32_t const& flushInterval)
+{
+  m_flushPolicy   = policy;
+  m_flushInterval = flushInterval;
+}
+
+void gem::readout::GEMEventWriter::appendWord(uint64_t const& word)
+{
+  if (m_format == HEX_FORMAT) {
+    char line[HEX_WORD_SIZE+1];
+    snprintf(line, sizeof(line), "%016llx\n", static_cast<unsigned long long>(word));
+    m_buffer.insert(m_buffer.end(), line, line+HEX_WORD_SIZE);
+  } else {
+    appendBytes(&word, sizeof(word));
+  }
+}
+
+void gem::readout::GEMEventWriter::appendBytes(void const* data, size_t const& nBytes)
+{
+  char const* bytes = static_cast<char const*>(data);
+  m_buffer.insert(m_buffer.end(), bytes, bytes+nBytes);
+}
+
+bool gem::readout::GEMEventWriter::writeGEMevent(AMCGEMData const& gem, AMCGEBData const& geb)
+{
+  if (!m_outf.is_open())
+    return false;
+
+  bool const isHex = (m_format == HEX_FORMAT);
+  bool const isRun = (m_format == RUN_FORMAT);
+
+  // hex: 3 AMC headers, 2 GEB headers, 4 lines per VFAT, 1 GEB trailer, 2 AMC trailers
+  // bin: 3 fake CDF/AMC13 headers, 3 AMC headers, 1 GEB header, 3 words per VFAT, 1 GEB trailer,
+  //      2 AMC trailers, 2 fake AMC13/CDF trailers
+  // run: the words of the hex format behind a record header, and a sync record every syncInterval events
+  size_t const nWords = (isHex || isRun) ? (GEMRunFile::EVENT_FIXED_WORDS + GEMRunFile::VFAT_WORDS*geb.vfats.size())
+                                         : (12 + 3*geb.vfats.size());
+  size_t const nBytes = isHex ? nWords*HEX_WORD_SIZE
+                              : (nWords + (isRun ? 3 : 0))*sizeof(uint64_t);
+  if (!m_buffer.empty() && (m_buffer.size() + nBytes) > m_bufferSize)
+    flush();
+
+  if (isRun) {
+    if (!m_eventOffsets.empty() && (m_eventOffsets.size() % GEMRunFile::DEFAULT_SYNC_INTERVAL) == 0) {
+      GEMRunFile::RecordHeader sync = {GEMRunFile::SYNC_RECORD, 1};
+      appendBytes(&sync, sizeof(sync));
+      appendWord(m_eventOffsets.size());
+    }
+    m_eventOffsets.push_back(m_bytesWritten + m_buffer.size());
+    GEMRunFile::RecordHeader record = {GEMRunFile::EVENT_RECORD, static_cast<uint32_t>(nWords)};
+    appendBytes(&record, sizeof(record));
+  } else if (!isHex) {
+    appendWord(CDF_HEADER);
+    appendWord(AMC13_HEADER1);
+    appendWord(AMC13_HEADER2);
+  }
+
+  // GEM Chamber's Data
+  appendWord(gem.header1);
+  appendWord(gem.header2);
+  appendWord(gem.header3);
+
+  // GEB Headers Data, the run header is not in the binary format
+  appendWord(geb.header);
+  if (isHex || isRun)
+    appendWord(geb.runhed);
+
+  // GEB PayLoad Data
+  for (auto iVFAT = geb.vfats.begin(); iVFAT != geb.vfats.end(); ++iVFAT) {
+    uint64_t bc = iVFAT->BC;
+    uint64_t ec = iVFAT->EC;
+    uint64_t ci = iVFAT->ChipID;
+    appendWord((bc << 48) | (ec << 32) | (ci << 16) | (iVFAT->msData >> 48));
+    appendWord((iVFAT->msData << 16) | (iVFAT->lsData >> 48));
+    appendWord((iVFAT->lsData << 16) | (iVFAT->crc));
+    if (isHex || isRun)
+      appendWord(iVFAT->BXfrOH);
+  }
+
+  // GEB Trailers Data
+  appendWord(geb.trailer);
+
+  // GEM Trailers Data
+  appendWord(gem.trailer2);
+  appendWord(gem.trailer1);
+  if (!isHex && !isRun) {
+    appendWord(AMC13_TRAILER);
+    appendWord(CDF_TRAILER);
+  }
+
+  ++m_eventsWritten;
+  ++m_eventsSinceFlush;
+
+  if (m_flushPolicy == FLUSH_EVERY_EVENT ||
+      (m_flushPolicy == FLUSH_EVERY_N_EVENTS && m_flushInterval > 0 && m_eventsSinceFlush >= m_flushInterval) ||
+      m_buffer.size() >= m_bufferSize)
+    flush();
+
+  return true;
+}
+
+void gem::readout::GEMEventWriter::flush()
+{
+  m_eventsSinceFlush = 0;
+  if (m_buffer.empty() || !m_outf.is_open())
+    return;
+
+  m_outf.write(&m_buffer[0], m_buffer.size());
+  if (m_outf.fail()) {
+    ERROR("GEMEventWriter::flush failed to write " << m_buffer.size() << " bytes to " << m_fileName);
+    m_outf.clear();
+    // the events of the lost buffer are not in the file, the following ones take their place
+    while (!m_eventOffsets.empty() && m_eventOffsets.back() >= m_bytesWritten)
+      m_eventOffsets.pop_back();
+  } else {
+    m_bytesWritten += m_buffer.size();
+  }
+  m_buffer.clear();
+}
@@ -13,11 +13,15 @@
 #include "toolbox/mem/Pool.h"
 #include "toolbox/mem/MemoryPoolFactory.h"
 #include "toolbox/mem/CommittedHeapAllocator.h"
+#include "toolbox/mem/exception/Exception.h"
+#include "toolbox/net/URN.h"
 
 #include "gem/readout/GEMReadoutWebApplication.h"
 
 const int gem::readout::GEMReadoutApplication::I2O_READOUT_NOTIFY=0x84;
 const int gem::readout::GEMReadoutApplication::I2O_READOUT_CONFIRM=0x85;
+// 4k events at the average size
+const size_t gem::readout::GEMReadoutApplication::READOUT_POOL_SIZE=4096*4096;
 
 /*
   namespace gem {
@@ -42,6 +46,9 @@ gem::readout::GEMReadoutApplication::GEMReadoutSettings::GEMReadoutSettings() {
   outputType     = "Bin";
   outputLocation = "/tmp";
   setupLocation  = "";
+
+  writeBufferSize = GEMEventWriter::DEFAULT_BUFFER_SIZE/1024;
+  flushEvents     = 0;
 }
 
 void gem::readout::GEMReadoutApplication::GEMReadoutSettings::registerFields(xdata::Bag<gem::readout::GEMReadoutApplication::GEMReadoutSettings>* bag) {
@@ -51,6 +58,9 @@ void gem::readout::GEMReadoutApplication::GEMReadoutSettings::registerFields(xda
   bag->addField("outputType",     &outputType);
   bag->addField("outputLocation", &outputLocation);
   bag->addField("setupLocation",  &setupLocation);
+
+  bag->addField("writeBufferSize", &writeBufferSize);
+  bag->addField("flushEvents",     &flushEvents);
 }
 
 
@@ -58,11 +68,21 @@ gem::readout::GEMReadoutApplication::GEMReadoutApplication(xdaq::ApplicationStub
   throw (xdaq::exception::Exception) :
   gem::base::GEMFSMApplication(stub),
   m_outFileName(""),
+  m_pool(NULL),
   m_connectionFile("ConnectionFile"),
   m_deviceName("ReadoutDevice"),
   m_eventsReadout(0),
   m_usecPerEvent(0.0),
-  m_usecUsed(0.0)
+  m_usecUsed(0.0),
+  m_queueDepthMax(0),
+  m_bytesWritten(0),
+  m_bytesPerSecond(0.0),
+  m_eventsDropped(0),
+  m_readToWriteP50Us(0),
+  m_readToWriteP99Us(0),
+  m_readToWriteMaxUs(0),
+  m_metricsUpdated(GEMReadoutMetrics::clock::now()),
+  m_metricsBytes(0)
 {
   DEBUG("GEMReadoutApplication ctor begin");
   //i2o::bind(this,&ReadoutApplication::onReadoutNotify,I2O_READOUT_NOTIFY,XDAQ_ORGANIZATION_ID);
@@ -85,6 +105,37 @@ gem::readout::GEMReadoutApplication::GEMReadoutApplication(xdaq::ApplicationStub
   p_appInfoSpace->addItemChangedListener( "EventsReadout",   this);
   p_appInfoSpace->addItemChangedListener( "uSecPerEvent",    this);
 
+  // readout pipeline metrics, published by readoutTask
+  for (unsigned s = 0; s < GEMReadoutMetrics::N_STAGES; ++s) {
+    std::string const stage = GEMReadoutMetrics::stageName(static_cast<GEMReadoutMetrics::Stage>(s));
+    m_stageCalls[s]        = 0;
+    m_stageMeanUs[s]       = 0.0;
+    m_stageP99Us[s]        = 0;
+    m_stageBusyFraction[s] = 0.0;
+    p_appInfoSpace->fireItemAvailable(stage+"Calls",        &m_stageCalls[s]);
+    p_appInfoSpace->fireItemAvailable(stage+"MeanUs",       &m_stageMeanUs[s]);
+    p_appInfoSpace->fireItemAvailable(stage+"P99Us",        &m_stageP99Us[s]);
+    p_appInfoSpace->fireItemAvailable(stage+"BusyFraction", &m_stageBusyFraction[s]);
+    m_metricsItems.push_back(stage+"Calls");
+    m_metricsItems.push_back(stage+"MeanUs");
+    m_metricsItems.push_back(stage+"P99Us");
+    m_metricsItems.push_back(stage+"BusyFraction");
+  }
+  p_appInfoSpace->fireItemAvailable("QueueDepthMax",    &m_queueDepthMax);
+  p_appInfoSpace->fireItemAvailable("BytesWritten",     &m_bytesWritten);
+  p_appInfoSpace->fireItemAvailable("BytesPerSecond",   &m_bytesPerSecond);
+  p_appInfoSpace->fireItemAvailable("EventsDropped",    &m_eventsDropped);
+  p_appInfoSpace->fireItemAvailable("ReadToWriteP50Us", &m_readToWriteP50Us);
+  p_appInfoSpace->fireItemAvailable("ReadToWriteP99Us", &m_readToWriteP99Us);
+  p_appInfoSpace->fireItemAvailable("ReadToWriteMaxUs", &m_readToWriteMaxUs);
+  m_metricsItems.push_back("QueueDepthMax");
+  m_metricsItems.push_back("BytesWritten");
+  m_metricsItems.push_back("BytesPerSecond");
+  m_metricsItems.push_back("EventsDropped");
+  m_metricsItems.push_back("ReadToWriteP50Us");
+  m_metricsItems.push_back("ReadToWriteP99Us");
+  m_metricsItems.push_back("ReadToWriteMaxUs");
+
   p_gemWebInterface = new gem::readout::GEMReadoutWebApplication(this);
 
   ////set up the info hwCfgInfoSpace
@@ -133,21 +184,8 @@ void gem::readout::GEMReadoutApplication::initializeAction()
     m_cmdQueue.push(ReadoutCommands::CMD_STOP);
   }
 
-  /*
-  // create a pool
-  if (!m_pool) {
-    char poolname[128];
-    snprintf(poolname,128,"GEMReadoutPool-%s-%d",getApplicationDescriptor()->getClassName().c_str(),(int)getApplicationDescriptor()->getInstance());
-    try {
-      // 4k events at the average size
-      toolbox::mem::CommittedHeapAllocator* alloc = new toolbox::mem::CommittedHeapAllocator(4096*4096);
-      toolbox::net::URN urn("toolbox-mem-pool",poolname);
-      m_pool = toolbox::mem::getMemoryPoolFactory()->createPool(urn,alloc);
-    } catch (xcept::Exception& e) {
-      XCEPT_RETHROW(gem::base::exception::Exception,"Unable to create readout memory pool",e);
-    }
-  }
-  */
+  createReadoutPool();
+
   m_eventsReadout.value_ = 0;
   m_usecPerEvent.value_  = 0;
   m_usecUsed = 0;
@@ -193,6 +231,8 @@ void gem::readout::GEMReadoutApplication::startAction()
 
   m_outFileName  = m_readoutSettings.bag.fileName.toString();
 
+  // the metrics are cleared and published by the readout task, before it starts reading
+  m_cmdQueue.push(ReadoutCommands::CMD_RESET_METRICS);
   m_cmdQueue.push(ReadoutCommands::CMD_START);
 }
 
@@ -231,6 +271,58 @@ void gem::readout::GEMReadoutApplication::resetAction()
   DEBUG("gem::readout::GEMReadoutApplication::resetAction begin");
 }
 
+std::unique_ptr<gem::readout::GEMEventWriter> gem::readout::GEMReadoutApplication::createEventWriter()
+{
+  uint32_t flushEvents = m_readoutSettings.bag.flushEvents.value_;
+  GEMEventWriter::FlushPolicy policy = GEMEventWriter::FLUSH_ON_FULL;
+  if (flushEvents == 1)
+    policy = GEMEventWriter::FLUSH_EVERY_EVENT;
+  else if (flushEvents > 1)
+    policy = GEMEventWriter::FLUSH_EVERY_N_EVENTS;
+
+  size_t bufferSize = 1024*static_cast<size_t>(m_readoutSettings.bag.writeBufferSize.value_);
+  if (bufferSize == 0)
+    bufferSize = GEMEventWriter::DEFAULT_BUFFER_SIZE;
+
+  std::unique_ptr<GEMEventWriter> writer(new GEMEventWriter(m_readoutSettings.bag.outputType.toString(),
+                                                            bufferSize, policy, flushEvents));
+  writer->setRunNumber(m_runNumber.value_);
+  return writer;
+}
+
+void gem::readout::GEMReadoutApplication::createReadoutPool()
+{
+  if (m_pool)
+    return;
+
+  char poolname[128];
+  snprintf(poolname,128,"GEMReadoutPool-%s-%d",getApplicationDescriptor()->getClassName().c_str(),(int)getApplicationDescriptor()->getInstance());
+  try {
+    // the whole pool is committed up front, readout never allocates from the heap
+    toolbox::mem::CommittedHeapAllocator* alloc = new toolbox::mem::CommittedHeapAllocator(READOUT_POOL_SIZE);
+    toolbox::net::URN urn("toolbox-mem-pool",poolname);
+    m_pool = toolbox::mem::getMemoryPoolFactory()->createPool(urn,alloc);
+  } catch (xcept::Exception& e) {
+    XCEPT_RETHROW(gem::base::exception::Exception,"Unable to create readout memory pool",e);
+  }
+  DEBUG("GEMReadoutApplication::createReadoutPool created " << poolname
+        << " with " << READOUT_POOL_SIZE << " bytes");
+}
+
+toolbox::mem::Reference* gem::readout::GEMReadoutApplication::getFrame(size_t const& size)
+{
+  if (!m_pool)
+    return NULL;
+
+  try {
+    return toolbox::mem::getMemoryPoolFactory()->getFrame(m_pool, size);
+  } catch (toolbox::mem::exception::Exception const& e) {
+    // pool exhausted, the caller leaves the data in the hardware until frames are released
+    DEBUG("GEMReadoutApplication::getFrame unable to get a frame of " << size << " bytes: " << e.what());
+  }
+  return NULL;
+}
+
 void gem::readout::GEMReadoutApplication::failAction(toolbox::Event::Reference e)
   throw (toolbox::fsm::exception::Exception)
 {
@@ -243,10 +335,49 @@ void gem::readout::GEMReadoutApplication::resetAction(toolbox::Event::Reference
   // close open file pointers
 }
 
+void gem::readout::GEMReadoutApplication::updateReadoutMetrics()
+{
+  GEMReadoutMetrics::clock::time_point const now = GEMReadoutMetrics::clock::now();
+  uint64_t const bytesWritten = m_readoutMetrics.bytesWritten();
+  double const interval = std::chrono::duration<double>(now - m_metricsUpdated).count();
+
+  p_appInfoSpace->lock();
+  for (unsigned s = 0; s < GEMReadoutMetrics::N_STAGES; ++s) {
+    GEMReadoutMetrics::Stage const stage = static_cast<GEMReadoutMetrics::Stage>(s);
+    gem::utils::LatencyHistogram const& hist = m_readoutMetrics.getStage(stage);
+    uint64_t const calls = hist.count();
+    m_stageCalls[s]        = calls;
+    m_stageMeanUs[s]       = calls ? hist.totalNs()/(1000.*calls) : 0.;
+    m_stageP99Us[s]        = hist.percentileUS(0.99);
+    m_stageBusyFraction[s] = m_readoutMetrics.busyFraction(stage);
+  }
+  gem::utils::LatencyHistogram const& readToWrite = m_readoutMetrics.getReadToWrite();
+  m_queueDepthMax    = m_readoutMetrics.queueDepthMax();
+  m_bytesWritten     = bytesWritten;
+  if (interval > 0 && bytesWritten >= m_metricsBytes)
+    m_bytesPerSecond = (bytesWritten - m_metricsBytes)/interval;
+  m_eventsDropped    = m_readoutMetrics.eventsDropped();
+  m_readToWriteP50Us = readToWrite.percentileUS(0.50);
+  m_readToWriteP99Us = readToWrite.percentileUS(0.99);
+  m_readToWriteMaxUs = readToWrite.maxNs()/1000;
+  p_appInfoSpace->unlock();
+
+  m_metricsUpdated = now;
+  m_metricsBytes   = bytesWritten;
+
+  try {
+    p_appInfoSpace->fireItemGroupChanged(m_metricsItems, this);
+  } catch (xcept::Exception& e) {
+    WARN("GEMReadoutApplication::updateReadoutMetrics unable to notify the info space listeners: "
+         << e.what());
+  }
+}
+
 int gem::readout::GEMReadoutApplication::readoutTask()
 {
   bool isRunning(false), isDone(false);
   int nevtsRead(0);
+  GEMReadoutMetrics::clock::time_point lastUpdate = GEMReadoutMetrics::clock::now();
   // may at some point want to actually pass the memory
   std::vector<toolbox::mem::Reference* > data;
 
@@ -270,7 +401,17 @@ int gem::readout::GEMReadoutApplication::readoutTask()
         isDone    = true;
         isRunning = false;
         break;
+      case(ReadoutCommands::CMD_RESET_METRICS) :
+        // the counters are atomic, a frame still being written from the previous run
+        // is at worst counted in the new one
+        m_readoutMetrics.reset();
+        m_metricsUpdated = GEMReadoutMetrics::clock::now();
+        m_metricsBytes   = 0;
+        break;
       }
+      // final values of a stopped or paused run, or the cleared ones
+      updateReadoutMetrics();
+      lastUpdate = GEMReadoutMetrics::clock::now();
     }
 
     if (isRunning) {
@@ -303,12 +444,11 @@ int gem::readout::GEMReadoutApplication::readoutTask()
       }
 
       DEBUG("GEMReadoutApplication::readoutTask read " << nevtsRead << " events");
-      /*
-      for (int i = 0; i < nevtsRead; i++) {
-        DEBUG("GEMReadoutApplication::readoutTask releaseing data[" << i << "]");
-        data[i]->release();
-      }
-      */
+      // give any frames handed back by readout to the pool
+      for (auto frame = data.begin(); frame != data.end(); ++frame)
+        if (*frame)
+          (*frame)->release();
+      data.clear();
       if (nevtsRead > 0) {
         gettimeofday(&stop,0);
         m_eventsReadout.value_ = m_eventsReadout.value_ + nevtsRead;
@@ -316,6 +456,11 @@ int gem::readout::GEMReadoutApplication::readoutTask()
         m_usecUsed += deltaU;
         m_usecPerEvent.value_ = m_usecUsed/(m_eventsReadout.value_);
       }
+
+      if (GEMReadoutMetrics::clock::now() - lastUpdate > std::chrono::seconds(1)) {
+        updateReadoutMetrics();
+        lastUpdate = GEMReadoutMetrics::clock::now();
+      }
     }
   }
   return 0;
@@ -0,0 +1,64 @@
+/**
+ * class: GEMReadoutMetrics
+ * description: stage resolved timing and flow counters of a readout pipeline
+ */
+
+#include "gem/readout/GEMReadoutMetrics.h"
+
+std::string gem::readout::GEMReadoutMetrics::stageName(Stage const& stage)
+{
+  switch (stage) {
+  case FIFO_DRAIN:
+    return "FIFODrain";
+  case DECODE:
+    return "Decode";
+  case EVENT_BUILD:
+    return "EventBuild";
+  case WRITE:
+    return "Write";
+  default:
+    return "Unknown";
+  }
+}
+
+gem::readout::GEMReadoutMetrics::GEMReadoutMetrics()
+{
+  reset();
+}
+
+void gem::readout::GEMReadoutMetrics::recordStage(Stage const& stage,
+                                                 clock::time_point const& start,
+                                                 clock::time_point const& stop)
+{
+  m_stages[stage].record(std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count());
+}
+
+void gem::readout::GEMReadoutMetrics::recordQueueDepth(uint64_t const& depth)
+{
+  uint64_t max = m_queueDepthMax.load(std::memory_order_relaxed);
+  while (depth > max && !m_queueDepthMax.compare_exchange_weak(max, depth, std::memory_order_relaxed))
+    ;
+}
+
+void gem::readout::GEMReadoutMetrics::recordReadToWrite(clock::time_point const& readTime)
+{
+  m_readToWrite.record(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - readTime).count());
+}
+
+double gem::readout::GEMReadoutMetrics::busyFraction(Stage const& stage) const
+{
+  double const elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - m_resetTime).count();
+  return elapsed > 0 ? m_stages[stage].totalNs()/elapsed : 0.;
+}
+
+void gem::readout::GEMReadoutMetrics::reset()
+{
+  for (unsigned s = 0; s < N_STAGES; ++s)
+    m_stages[s].reset();
+  m_readToWrite.reset();
+  m_queueDepthMax.store(0, std::memory_order_relaxed);
+  m_bytesRead.store(0, std::memory_order_relaxed);
+  m_bytesWritten.store(0, std::memory_order_relaxed);
+  m_eventsDropped.store(0, std::memory_order_relaxed);
+  m_resetTime = clock::now();
+}
@@ -2,7 +2,9 @@
 
 #include "gem/readout/GEMReadoutWebApplication.h"
 
+#include <iomanip>
 #include <memory>
+#include <sstream>
 
 #include "xcept/tools.h"
 
@@ -33,11 +35,61 @@ void gem::readout::GEMReadoutWebApplication::webDefault(xgi::Input* in, xgi::Out
   GEMWebApplication::webDefault(in, out);
 }
 
-/*To be filled in with the monitor page code*/
 void gem::readout::GEMReadoutWebApplication::monitorPage(xgi::Input* in, xgi::Output* out)
   throw (xgi::exception::Exception)
 {
   DEBUG("GEMReadoutWebApplication::monitorPage");
+
+  // the cells are filled by readout.js from jsonUpdate
+  *out << "    <div class=\"xdaq-tab-wrapper\">" << std::endl;
+  *out << "      <div class=\"xdaq-tab\" title=\"Readout Pipeline\" >"  << std::endl;
+
+  *out << "      <table class=\"xdaq-table\">" << std::endl
+       << cgicc::thead() << std::endl
+       << cgicc::tr()    << std::endl
+       << cgicc::th() << "Stage"      << cgicc::th() << std::endl
+       << cgicc::th() << "Calls"      << cgicc::th() << std::endl
+       << cgicc::th() << "Mean (us)"  << cgicc::th() << std::endl
+       << cgicc::th() << "p99 (us)"   << cgicc::th() << std::endl
+       << cgicc::th() << "Busy (%)"   << cgicc::th() << std::endl
+       << cgicc::tr()    << std::endl
+       << cgicc::thead() << std::endl
+       << "        <tbody>" << std::endl;
+  for (unsigned s = 0; s < GEMReadoutMetrics::N_STAGES; ++s) {
+    std::string const stage = GEMReadoutMetrics::stageName(static_cast<GEMReadoutMetrics::Stage>(s));
+    *out << "          <tr>" << std::endl
+         << "            <td>" << stage << "</td>" << std::endl
+         << "            <td id=\"readout-" << stage << "Calls\"></td>"        << std::endl
+         << "            <td id=\"readout-" << stage << "MeanUs\"></td>"       << std::endl
+         << "            <td id=\"readout-" << stage << "P99Us\"></td>"        << std::endl
+         << "            <td id=\"readout-" << stage << "BusyFraction\"></td>" << std::endl
+         << "          </tr>" << std::endl;
+  }
+  *out << "        </tbody>" << std::endl
+       << "      </table>" << std::endl;
+
+  static char const* const pipelineItems[][2] = {
+    {"QueueDepthMax",    "Queue depth high-water mark"},
+    {"BytesPerSecond",   "Bytes written per second"},
+    {"BytesWritten",     "Bytes written"},
+    {"EventsDropped",    "Events dropped"},
+    {"ReadToWriteP50Us", "Read to write p50 (us)"},
+    {"ReadToWriteP99Us", "Read to write p99 (us)"},
+    {"ReadToWriteMaxUs", "Read to write max (us)"}
+  };
+  *out << "      <table class=\"xdaq-table\">" << std::endl
+       << "        <tbody>" << std::endl;
+  for (auto const& item : pipelineItems) {
+    *out << "          <tr>" << std::endl
+         << "            <td>" << item[1] << "</td>" << std::endl
+         << "            <td id=\"readout-" << item[0] << "\"></td>" << std::endl
+         << "          </tr>" << std::endl;
+  }
+  *out << "        </tbody>" << std::endl
+       << "      </table>" << std::endl;
+
+  *out << "      </div>" << std::endl;
+  *out << "    </div>" << std::endl;
 }
 
 /*To be filled in with the expert page code*/
@@ -60,7 +112,41 @@ void gem::readout::GEMReadoutWebApplication::jsonUpdate(xgi::Input* in, xgi::Out
   throw (xgi::exception::Exception)
 {
   DEBUG("GEMReadoutWebApplication::jsonUpdate");
+  GEMReadoutApplication* readoutApp = dynamic_cast<GEMReadoutApplication*>(p_gemFSMApp);
   out->getHTTPResponseHeader().addHeader("Content-Type", "application/json");
   *out << " { " << std::endl;
+  if (readoutApp) {
+    // a handful of values, always sent in full
+    std::stringstream items;
+    items << std::fixed << std::setprecision(1);
+    readoutApp->p_appInfoSpace->lock();
+    for (unsigned s = 0; s < GEMReadoutMetrics::N_STAGES; ++s) {
+      std::string const stage = GEMReadoutMetrics::stageName(static_cast<GEMReadoutMetrics::Stage>(s));
+      items << "{ \"name\":\"readout-" << stage << "Calls\", \"value\":\""
+            << readoutApp->m_stageCalls[s].value_ << "\" }," << std::endl
+            << "{ \"name\":\"readout-" << stage << "MeanUs\", \"value\":\""
+            << readoutApp->m_stageMeanUs[s].value_ << "\" }," << std::endl
+            << "{ \"name\":\"readout-" << stage << "P99Us\", \"value\":\""
+            << readoutApp->m_stageP99Us[s].value_ << "\" }," << std::endl
+            << "{ \"name\":\"readout-" << stage << "BusyFraction\", \"value\":\""
+            << 100*readoutApp->m_stageBusyFraction[s].value_ << "\" }," << std::endl;
+    }
+    items << "{ \"name\":\"readout-QueueDepthMax\", \"value\":\""
+          << readoutApp->m_queueDepthMax.value_    << "\" }," << std::endl
+          << "{ \"name\":\"readout-BytesPerSecond\", \"value\":\""
+          << readoutApp->m_bytesPerSecond.value_   << "\" }," << std::endl
+          << "{ \"name\":\"readout-BytesWritten\", \"value\":\""
+          << readoutApp->m_bytesWritten.value_     << "\" }," << std::endl
+          << "{ \"name\":\"readout-EventsDropped\", \"value\":\""
+          << readoutApp->m_eventsDropped.value_    << "\" }," << std::endl
+          << "{ \"name\":\"readout-ReadToWriteP50Us\", \"value\":\""
+          << readoutApp->m_readToWriteP50Us.value_ << "\" }," << std::endl
+          << "{ \"name\":\"readout-ReadToWriteP99Us\", \"value\":\""
+          << readoutApp->m_readToWriteP99Us.value_ << "\" }," << std::endl
+          << "{ \"name\":\"readout-ReadToWriteMaxUs\", \"value\":\""
+          << readoutApp->m_readToWriteMaxUs.value_ << "\" }"  << std::endl;
+    readoutApp->p_appInfoSpace->unlock();
+    *out << "\"Readout Pipeline\" : [ " << std::endl << items.str() << " ]" << std::endl;
+  }
   *out << " } " << std::endl;
 }
@@ -0,0 +1,294 @@
+/**
+ * class: GEMRunFileReader
+ * description: Memory-mapped random access and parallel iteration over GEMRunFile containers
+ */
+
+#include "gem/readout/GEMRunFileReader.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+#include "toolbox/string.h"
+
+#include "gem/readout/exception/Exception.h"
+
+gem::readout::GEMRunFileReader::GEMRunFileReader() :
+  m_gemLogger(log4cplus::Logger::getInstance(LOG4CPLUS_TEXT("gem:readout:GEMRunFileReader"))),
+  m_fd(-1),
+  p_data(NULL),
+  m_size(0),
+  p_offsets(NULL),
+  m_nEvents(0),
+  m_indexRecovered(false)
+{
+  std::memset(&m_header, 0, sizeof(m_header));
+}
+
+gem::readout::GEMRunFileReader::GEMRunFileReader(std::string const& fileName) :
+  GEMRunFileReader()
+{
+  open(fileName);
+}
+
+gem::readout::GEMRunFileReader::~GEMRunFileReader()
+{
+  close();
+}
+
+void gem::readout::GEMRunFileReader::open(std::string const& fileName)
+{
+  close();
+
+  m_fd = ::open(fileName.c_str(), O_RDONLY);
+  struct stat st;
+  if (m_fd < 0 || fstat(m_fd, &st) != 0) {
+    std::string msg = toolbox::toString("GEMRunFileReader::open unable to open %s: %s",
+                                        fileName.c_str(), std::strerror(errno));
+    close();
+    ERROR(msg);
+    XCEPT_RAISE(gem::readout::exception::Exception, msg);
+  }
+
+  m_size = st.st_size;
+  if (m_size < sizeof(GEMRunFile::FileHeader)) {
+    std::string msg = toolbox::toString("GEMRunFileReader::open %s is too short for a run file", fileName.c_str());
+    close();
+    ERROR(msg);
+    XCEPT_RAISE(gem::readout::exception::Exception, msg);
+  }
+
+  void* data = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+  if (data == MAP_FAILED) {
+    std::string msg = toolbox::toString("GEMRunFileReader::open unable to map %s: %s",
+                                        fileName.c_str(), std::strerror(errno));
+    close();
+    ERROR(msg);
+    XCEPT_RAISE(gem::readout::exception::Exception, msg);
+  }
+  p_data     = static_cast<char const*>(data);
+  m_fileName = fileName;
+
+  std::memcpy(&m_header, p_data, sizeof(m_header));
+  if (m_header.magic != GEMRunFile::FILE_MAGIC || m_header.version != GEMRunFile::VERSION ||
+      m_header.headerSize < sizeof(m_header) || m_header.headerSize > m_size || (m_header.headerSize % 8)) {
+    std::string msg = toolbox::toString("GEMRunFileReader::open %s is not a version %d run file",
+                                        fileName.c_str(), GEMRunFile::VERSION);
+    close();
+    ERROR(msg);
+    XCEPT_RAISE(gem::readout::exception::Exception, msg);
+  }
+
+  if (!loadIndex())
+    rebuildIndex();
+
+  INFO("GEMRunFileReader::open " << m_fileName << " run " << m_header.runNumber
+       << ", " << m_nEvents << " events" << (m_indexRecovered ? " (index rebuilt)" : ""));
+}
+
+void gem::readout::GEMRunFileReader::close()
+{
+  if (p_data)
+    munmap(const_cast<char*>(p_data), m_size);
+  if (m_fd >= 0)
+    ::close(m_fd);
+
+  m_fd        = -1;
+  p_data      = NULL;
+  m_size      = 0;
+  p_offsets   = NULL;
+  m_nEvents   = 0;
+  m_fileName.clear();
+  m_rebuiltIndex.clear();
+  m_indexRecovered = false;
+}
+
+bool gem::readout::GEMRunFileReader::loadIndex()
+{
+  if (m_size < m_header.headerSize + sizeof(GEMRunFile::FileTrailer))
+    return false;
+
+  GEMRunFile::FileTrailer trailer;
+  std::memcpy(&trailer, p_data + m_size - sizeof(trailer), sizeof(trailer));
+  if (trailer.magic != GEMRunFile::TRAILER_MAGIC)
+    return false;
+
+  size_t const indexEnd = m_size - sizeof(trailer);
+  if (trailer.indexOffset < m_header.headerSize || (trailer.indexOffset % 8) ||
+      trailer.indexOffset + sizeof(GEMRunFile::RecordHeader) > indexEnd) {
+    WARN("GEMRunFileReader::loadIndex " << m_fileName << " has an invalid index offset " << trailer.indexOffset);
+    return false;
+  }
+
+  GEMRunFile::RecordHeader const* record =
+    reinterpret_cast<GEMRunFile::RecordHeader const*>(p_data + trailer.indexOffset);
+  if (record->type != GEMRunFile::INDEX_RECORD || record->nWords != trailer.nEvents ||
+      trailer.indexOffset + sizeof(*record) + trailer.nEvents*sizeof(uint64_t) != indexEnd) {
+    WARN("GEMRunFileReader::loadIndex " << m_fileName << " has a corrupted index");
+    return false;
+  }
+
+  p_offsets = reinterpret_cast<uint64_t const*>(p_data + trailer.indexOffset + sizeof(*record));
+  m_nEvents = trailer.nEvents;
+  return true;
+}
+
+void gem::readout::GEMRunFileReader::rebuildIndex()
+{
+  WARN("GEMRunFileReader::rebuildIndex " << m_fileName << " has no index, walking the records");
+  m_indexRecovered = true;
+  m_rebuiltIndex.clear();
+
+  uint64_t skipped = 0;
+  size_t   pos     = m_header.headerSize;
+  while (pos + sizeof(GEMRunFile::RecordHeader) <= m_size) {
+    GEMRunFile::RecordHeader const* record = reinterpret_cast<GEMRunFile::RecordHeader const*>(p_data + pos);
+    size_t const end = pos + sizeof(*record) + static_cast<size_t>(record->nWords)*sizeof(uint64_t);
+
+    if (record->type == GEMRunFile::EVENT_RECORD && record->nWords >= GEMRunFile::EVENT_FIXED_WORDS) {
+      if (end > m_size) {
+        WARN("GEMRunFileReader::rebuildIndex " << m_fileName << " ends with a truncated event");
+        break;
+      }
+      m_rebuiltIndex.push_back(pos);
+      pos = end;
+    } else if (record->type == GEMRunFile::SYNC_RECORD && record->nWords == 1 && end <= m_size) {
+      uint64_t const before = *reinterpret_cast<uint64_t const*>(p_data + pos + sizeof(*record));
+      if (before != m_rebuiltIndex.size())
+        WARN("GEMRunFileReader::rebuildIndex " << m_fileName << " sync record after event " << before
+             << " found after " << m_rebuiltIndex.size() << " events");
+      pos = end;
+    } else if (record->type == GEMRunFile::INDEX_RECORD) {
+      break;
+    } else {
+      // corrupted record, look for the next sync record
+      pos     += sizeof(uint64_t);
+      skipped += sizeof(uint64_t);
+      while (pos + sizeof(GEMRunFile::RecordHeader) <= m_size &&
+             reinterpret_cast<GEMRunFile::RecordHeader const*>(p_data + pos)->type != GEMRunFile::SYNC_RECORD) {
+        pos     += sizeof(uint64_t);
+        skipped += sizeof(uint64_t);
+      }
+    }
+  }
+
+  if (skipped)
+    WARN("GEMRunFileReader::rebuildIndex " << m_fileName << " skipped " << skipped << " corrupted bytes");
+
+  p_offsets = m_rebuiltIndex.empty() ? NULL : &m_rebuiltIndex[0];
+  m_nEvents = m_rebuiltIndex.size();
+}
+
+gem::readout::GEMRunFileReader::EventView gem::readout::GEMRunFileReader::event(size_t const& n) const
+{
+  if (n >= m_nEvents) {
+    std::string msg = toolbox::toString("GEMRunFileReader::event %d requested, %s has %d events",
+                                        static_cast<int>(n), m_fileName.c_str(), static_cast<int>(m_nEvents));
+    XCEPT_RAISE(gem::readout::exception::ValueError, msg);
+  }
+
+  uint64_t const offset = p_offsets[n];
+  GEMRunFile::RecordHeader const* record = reinterpret_cast<GEMRunFile::RecordHeader const*>(p_data + offset);
+  if ((offset % 8) || offset + sizeof(*record) > m_size || record->type != GEMRunFile::EVENT_RECORD ||
+      offset + sizeof(*record) + static_cast<size_t>(record->nWords)*sizeof(uint64_t) > m_size) {
+    std::string msg = toolbox::toString("GEMRunFileReader::event %d of %s is corrupted",
+                                        static_cast<int>(n), m_fileName.c_str());
+    XCEPT_RAISE(gem::readout::exception::ValueError, msg);
+  }
+
+  EventView view = {reinterpret_cast<uint64_t const*>(p_data + offset + sizeof(*record)), record->nWords};
+  return view;
+}
+
+bool gem::readout::GEMRunFileReader::decode(EventView const& event, AMCGEMData& gem, AMCGEBData& geb)
+{
+  if (event.nWords < GEMRunFile::EVENT_FIXED_WORDS ||
+      (event.nWords - GEMRunFile::EVENT_FIXED_WORDS) % GEMRunFile::VFAT_WORDS)
+    return false;
+
+  uint64_t const* word = event.words;
+  gem.header1 = *word++;
+  gem.header2 = *word++;
+  gem.header3 = *word++;
+  geb.header  = *word++;
+  geb.runhed  = *word++;
+
+  uint32_t const nVFATs = event.nVFATs();
+  geb.vfats.resize(nVFATs);
+  for (uint32_t vfat = 0; vfat < nVFATs; ++vfat, word += GEMRunFile::VFAT_WORDS) {
+    AMCVFATData& data = geb.vfats[vfat];
+    data.BC     = word[0] >> 48;
+    data.EC     = (word[0] >> 32) & 0xffff;
+    data.ChipID = (word[0] >> 16) & 0xffff;
+    data.msData = ((word[0] & 0xffff) << 48) | (word[1] >> 16);
+    data.lsData = ((word[1] & 0xffff) << 48) | (word[2] >> 16);
+    data.crc    = word[2] & 0xffff;
+    data.BXfrOH = word[3];
+  }
+
+  geb.trailer  = *word++;
+  gem.trailer2 = *word++;
+  gem.trailer1 = *word++;
+  return true;
+}
+
+void gem::readout::GEMRunFileReader::forEachChunk(size_t const& nThreads, ChunkTask const& task,
+                                                  size_t const& chunkSize) const
+{
+  runChunks(m_nEvents, nThreads, task, chunkSize);
+}
+
+void gem::readout::GEMRunFileReader::runChunks(size_t const& nItems, size_t const& nThreads, ChunkTask const& task,
+                                               size_t const& chunkSize)
+{
+  if (nItems == 0)
+    return;
+
+  size_t const workers = std::max(nThreads, static_cast<size_t>(1));
+  // a few chunks per thread balance uneven chunks without too much contention on the counter
+  size_t const chunk   = chunkSize > 0 ? chunkSize : std::max(nItems/(16*workers), static_cast<size_t>(1));
+
+  std::atomic<size_t> next(0);
+  std::atomic<bool>   failed(false);
+  std::exception_ptr  error;
+  std::mutex          errorMutex;
+
+  auto work = [&]() {
+    for (size_t first = next.fetch_add(chunk); first < nItems && !failed; first = next.fetch_add(chunk)) {
+      try {
+        task(first, std::min(first + chunk, nItems));
+      } catch (...) {
+        std::lock_guard<std::mutex> guard(errorMutex);
+        if (!failed)
+          error = std::current_exception();
+        failed = true;
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < workers; ++i) {
+    try {
+      threads.push_back(std::thread(work));
+    } catch (std::system_error const& e) {
+      // the chunks are taken by the threads already running
+      break;
+    }
+  }
+  work();
+  for (auto thread = threads.begin(); thread != threads.end(); ++thread)
+    thread->join();
+
+  if (error)
+    std::rethrow_exception(error);
+}
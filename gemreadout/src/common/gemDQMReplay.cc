@@ -0,0 +1,498 @@
+/**
+ * gemDQMReplay
+ * description: offline replay of the gemOnlineDQM histograms from recorded data files,
+ *              the events are unpacked and histogrammed on several threads
+ *
+ * usage: gemDQMReplay [-j threads] [-s slot file] [-m map directory] [-o output directory] file...
+ * Files written with the "Run" output type are read through their index, files written with
+ * the "Bin" output type are split on the CDF/AMC13 words around each event.
+ * The AMC13 readout chunk files hold the raw AMC13 events, the GEM AMC payloads are unpacked
+ * from each of them.
+ */
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "log4cplus/configurator.h"
+
+#include "toolbox/string.h"
+#include "xcept/Exception.h"
+
+#include "TCanvas.h"
+#include "TFile.h"
+#include "TH1F.h"
+#include "TH2F.h"
+#include "TROOT.h"
+#include "TSystem.h"
+
+#include "gem/readout/GEMDQMHistograms.h"
+#include "gem/readout/GEMRunFileReader.h"
+#include "gem/readout/exception/Exception.h"
+
+namespace {
+  // words wrapped around each event by the "Bin" output type, see GEMEventWriter
+  const uint64_t CDF_HEADER    = 0x5fffffffffffffff;
+  const uint64_t AMC13_HEADER1 = 0xff1ffffffffffff0;
+  const uint64_t AMC13_TRAILER = 0xbadc0ffeebadcafe;
+  const uint64_t CDF_TRAILER   = 0xafffffffffffffff;
+
+  // BOE_1 of the CDF header of a real AMC13 event, the "Bin" header sets every other bit too
+  const uint64_t CDF_HEADER_MASK  = 0xf000000000000000;
+  const uint64_t CDF_HEADER_BOE   = 0x5000000000000000;
+  const uint64_t CDF_TRAILER_EOE  = 0xa000000000000000;
+  // More and Segmented bits of an AMC header, the payload is split over several blocks
+  const uint64_t AMC_SEGMENTED    = 0x3000000000000000;
+  const size_t   AMC13_FIXED_WORDS = 4;  ///< CDF and AMC13 headers and trailers
+  const size_t   AMC_FIXED_WORDS   = 5;  ///< AMC headers, GEM event header and trailer, AMC trailer
+
+  const size_t BIN_FIXED_WORDS = 12;  ///< 3 CDF/AMC13 headers, 3 AMC headers, GEB header and trailer, 4 trailers
+  const size_t BIN_VFAT_WORDS  = 3;
+
+  typedef gem::readout::GEMDQMHistograms DQMHistograms;
+
+  struct ReplayConfig {
+    size_t      nThreads;
+    std::string slotFile;
+    std::string mapDirectory;
+    std::string outputDirectory;
+  };
+
+  /**
+   * @brief thread-local histograms of one chunk of events, merged into the total when done
+   */
+  class ChunkAccumulator
+  {
+  public:
+    ChunkAccumulator(DQMHistograms& total, std::mutex& totalMutex,
+                     std::shared_ptr<const gem::readout::GEMslotContents> const& slotContents,
+                     std::shared_ptr<const gem::readout::GEMDQMStripMap>  const& stripMap) :
+      m_total(total),
+      m_totalMutex(totalMutex),
+      p_slotContents(slotContents),
+      m_histograms(slotContents, stripMap)
+    {
+    }
+
+    void fill(gem::AMCGEBData const& geb)
+    {
+      GEBdata unpacked = DQMHistograms::toGEBdata(geb, *p_slotContents);
+      m_histograms.fill(unpacked);
+    }
+
+    void merge()
+    {
+      std::lock_guard<std::mutex> guard(m_totalMutex);
+      m_total.merge(m_histograms);
+    }
+
+  private:
+    DQMHistograms& m_total;
+    std::mutex&    m_totalMutex;
+    std::shared_ptr<const gem::readout::GEMslotContents> p_slotContents;
+    DQMHistograms  m_histograms;
+  };
+
+  /**
+   * @brief read-only mapping of a whole file, unmapped when it goes out of scope
+   */
+  class MappedFile
+  {
+  public:
+    explicit MappedFile(std::string const& fileName) :
+      m_fd(::open(fileName.c_str(), O_RDONLY)),
+      p_data(NULL),
+      m_size(0)
+    {
+      struct stat st;
+      if (m_fd < 0 || fstat(m_fd, &st) != 0) {
+        std::string msg = toolbox::toString("unable to open %s: %s", fileName.c_str(), std::strerror(errno));
+        close();
+        XCEPT_RAISE(gem::readout::exception::Exception, msg);
+      }
+      m_size = st.st_size;
+      if (m_size == 0)
+        return;
+
+      void* data = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+      if (data == MAP_FAILED) {
+        std::string msg = toolbox::toString("unable to map %s: %s", fileName.c_str(), std::strerror(errno));
+        close();
+        XCEPT_RAISE(gem::readout::exception::Exception, msg);
+      }
+      p_data = static_cast<char const*>(data);
+    }
+
+    ~MappedFile() { close(); }
+
+    uint64_t const* words()  const { return reinterpret_cast<uint64_t const*>(p_data); }
+    size_t          nWords() const { return m_size/sizeof(uint64_t); }
+
+  private:
+    void close()
+    {
+      if (p_data)
+        munmap(const_cast<char*>(p_data), m_size);
+      if (m_fd >= 0)
+        ::close(m_fd);
+      m_fd   = -1;
+      p_data = NULL;
+    }
+
+    int         m_fd;
+    char const* p_data;
+    size_t      m_size;
+
+    // Prevent copying
+    MappedFile(MappedFile const&);
+    MappedFile& operator=(MappedFile const&);
+  };
+
+  /**
+   * @brief unpacks the 3-word VFAT blocks of a chamber
+   * @returns the word after the last block
+   */
+  uint64_t const* decodeVFATBlocks(uint64_t const* word, size_t const& nVFATs, gem::AMCGEBData& geb)
+  {
+    geb.vfats.resize(nVFATs);
+    for (size_t vfat = 0; vfat < nVFATs; ++vfat, word += BIN_VFAT_WORDS) {
+      gem::AMCVFATData& data = geb.vfats[vfat];
+      data.BC     = word[0] >> 48;
+      data.EC     = (word[0] >> 32) & 0xffff;
+      data.ChipID = (word[0] >> 16) & 0xffff;
+      data.msData = ((word[0] & 0xffff) << 48) | (word[1] >> 16);
+      data.lsData = ((word[1] & 0xffff) << 48) | (word[2] >> 16);
+      data.crc    = word[2] & 0xffff;
+      data.BXfrOH = 0;
+    }
+    return word;
+  }
+
+  /**
+   * @brief unpacks one event of the "Bin" output type, the CDF/AMC13 words are already checked
+   */
+  void decodeBinEvent(uint64_t const* words, size_t const& nWords, gem::AMCGEBData& geb)
+  {
+    uint64_t const* word = words + 6;  // CDF/AMC13 and AMC headers
+    geb.header = *word++;
+    geb.runhed = 0;
+    geb.trailer = *decodeVFATBlocks(word, (nWords - BIN_FIXED_WORDS)/BIN_VFAT_WORDS, geb);
+  }
+
+  /**
+   * @brief unpacks the chambers of a GEM AMC payload as written by the AMC firmware
+   * @returns false if the chamber sizes do not add up to the payload, the chambers before are filled
+   */
+  bool decodeAMCPayload(uint64_t const* words, size_t const& nWords, ChunkAccumulator& chunk, gem::AMCGEBData& geb)
+  {
+    if (nWords < AMC_FIXED_WORDS)
+      return false;
+
+    // the number of chambers is the DAV count of the GEM event header
+    size_t const nGEBs = (words[2] >> 11) & 0x1f;
+    uint64_t const* word = words + 3;
+    uint64_t const* end  = words + nWords - 2;
+    for (size_t chamber = 0; chamber < nGEBs; ++chamber) {
+      if (end - word < 2)
+        return false;
+      size_t const nVFATWords = (word[0] >> 23) & 0xfff;
+      if (nVFATWords % BIN_VFAT_WORDS || static_cast<size_t>(end - word) < nVFATWords + 2)
+        return false;
+      geb.header = *word++;
+      geb.runhed = 0;
+      word = decodeVFATBlocks(word, nVFATWords/BIN_VFAT_WORDS, geb);
+      geb.trailer = *word++;
+      chunk.fill(geb);
+    }
+    return word == end;
+  }
+
+  bool isRunFile(std::string const& fileName)
+  {
+    std::ifstream file(fileName.c_str(), std::ios::binary);
+    uint64_t magic = 0;
+    file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    return file.good() && magic == gem::readout::GEMRunFile::FILE_MAGIC;
+  }
+
+  size_t replayRunFile(std::string const& fileName, ReplayConfig const& config, DQMHistograms& total,
+                       std::shared_ptr<const gem::readout::GEMslotContents> const& slotContents,
+                       std::shared_ptr<const gem::readout::GEMDQMStripMap>  const& stripMap)
+  {
+    gem::readout::GEMRunFileReader reader(fileName);
+    std::mutex totalMutex;
+    reader.forEachChunk(config.nThreads, [&](size_t const& first, size_t const& last) {
+        ChunkAccumulator chunk(total, totalMutex, slotContents, stripMap);
+        gem::AMCGEMData gem;
+        gem::AMCGEBData geb;
+        for (size_t n = first; n < last; ++n)
+          if (gem::readout::GEMRunFileReader::decode(reader.event(n), gem, geb))
+            chunk.fill(geb);
+        chunk.merge();
+      });
+    return reader.nEvents();
+  }
+
+  size_t replayBinFile(std::string const& fileName, ReplayConfig const& config, DQMHistograms& total,
+                       std::shared_ptr<const gem::readout::GEMslotContents> const& slotContents,
+                       std::shared_ptr<const gem::readout::GEMDQMStripMap>  const& stripMap)
+  {
+    MappedFile const file(fileName);
+    uint64_t const* words  = file.words();
+    size_t   const  nWords = file.nWords();
+
+    // the event boundaries are found sequentially, the unpacking is then done in parallel
+    std::vector<std::pair<size_t, size_t> > events;
+    size_t skipped = 0;
+    for (size_t pos = 0; pos + BIN_FIXED_WORDS <= nWords; ) {
+      if (words[pos] != CDF_HEADER || words[pos + 1] != AMC13_HEADER1) {
+        ++pos;
+        ++skipped;
+        continue;
+      }
+      size_t end = pos + BIN_FIXED_WORDS - 1;
+      while (end < nWords && !(words[end] == CDF_TRAILER && words[end - 1] == AMC13_TRAILER))
+        ++end;
+      if (end == nWords)
+        break;
+      size_t const nEventWords = end + 1 - pos;
+      if ((nEventWords - BIN_FIXED_WORDS) % BIN_VFAT_WORDS)
+        skipped += nEventWords;
+      else
+        events.push_back(std::make_pair(pos, nEventWords));
+      pos = end + 1;
+    }
+    if (skipped)
+      std::cerr << "gemDQMReplay: " << fileName << " has " << skipped << " words outside of valid events" << std::endl;
+
+    std::mutex totalMutex;
+    gem::readout::GEMRunFileReader::runChunks(events.size(), config.nThreads,
+                                              [&](size_t const& first, size_t const& last) {
+        ChunkAccumulator chunk(total, totalMutex, slotContents, stripMap);
+        gem::AMCGEBData geb;
+        for (size_t n = first; n < last; ++n) {
+          decodeBinEvent(words + events[n].first, events[n].second, geb);
+          chunk.fill(geb);
+        }
+        chunk.merge();
+      });
+    return events.size();
+  }
+
+  /**
+   * @brief replays a chunk file of the AMC13 readout, the raw events of the AMC13 monitor buffer
+   * @returns the number of AMC13 events
+   */
+  size_t replayAMC13File(std::string const& fileName, ReplayConfig const& config, DQMHistograms& total,
+                         std::shared_ptr<const gem::readout::GEMslotContents> const& slotContents,
+                         std::shared_ptr<const gem::readout::GEMDQMStripMap>  const& stripMap)
+  {
+    MappedFile const file(fileName);
+    uint64_t const* words  = file.words();
+    size_t   const  nWords = file.nWords();
+
+    // the events are walked sequentially through the AMC sizes and checked against the length
+    // in the CDF trailer, the AMC payloads are then unpacked in parallel
+    std::vector<std::pair<size_t, size_t> > payloads;
+    size_t nEvents = 0;
+    size_t skipped = 0;
+    size_t segmented = 0;
+    for (size_t pos = 0; pos + AMC13_FIXED_WORDS <= nWords; ) {
+      bool valid = (words[pos] & CDF_HEADER_MASK) == CDF_HEADER_BOE;
+      size_t const nAMCs = (words[pos + 1] >> 52) & 0xf;
+      size_t end = pos + 2 + nAMCs;
+      size_t const firstPayload = payloads.size();
+      bool isSegmented = false;
+      for (size_t amc = 0; valid && amc < nAMCs; ++amc) {
+        uint64_t const amcHeader = words[pos + 2 + amc];
+        size_t const amcWords = (amcHeader >> 32) & 0xffffff;
+        isSegmented |= (amcHeader & AMC_SEGMENTED) != 0;
+        if (amcWords)
+          payloads.push_back(std::make_pair(end, amcWords));
+        end += amcWords;
+        valid = end + 2 <= nWords;
+      }
+      valid = valid && end + 2 <= nWords
+        && (words[end + 1] & CDF_HEADER_MASK) == CDF_TRAILER_EOE
+        && ((words[end + 1] >> 32) & 0xffffff) == end + 2 - pos;
+      if (valid && isSegmented) {
+        // the block headers of a segmented event are interleaved with the payloads, not unpacked
+        payloads.resize(firstPayload);
+        ++segmented;
+      }
+      if (!valid) {
+        payloads.resize(firstPayload);
+        ++pos;
+        ++skipped;
+        continue;
+      }
+      ++nEvents;
+      pos = end + 2;
+    }
+    if (skipped)
+      std::cerr << "gemDQMReplay: " << fileName << " has " << skipped << " words outside of valid events" << std::endl;
+    if (segmented)
+      std::cerr << "gemDQMReplay: " << fileName << " has " << segmented << " segmented events, not unpacked" << std::endl;
+
+    std::mutex totalMutex;
+    std::atomic<size_t> badPayloads(0);
+    gem::readout::GEMRunFileReader::runChunks(payloads.size(), config.nThreads,
+                                              [&](size_t const& first, size_t const& last) {
+        ChunkAccumulator chunk(total, totalMutex, slotContents, stripMap);
+        gem::AMCGEBData geb;
+        for (size_t n = first; n < last; ++n)
+          if (!decodeAMCPayload(words + payloads[n].first, payloads[n].second, chunk, geb))
+            ++badPayloads;
+        chunk.merge();
+      });
+    if (badPayloads)
+      std::cerr << "gemDQMReplay: " << fileName << " has " << badPayloads.load()
+                << " AMC payloads with inconsistent chamber sizes" << std::endl;
+    return nEvents;
+  }
+
+  /**
+   * @brief tells the AMC13 readout chunk files from the "Bin" files, whose CDF header has every bit set
+   */
+  bool isAMC13File(std::string const& fileName)
+  {
+    std::ifstream file(fileName.c_str(), std::ios::binary);
+    uint64_t header = 0;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    return file.good() && header != CDF_HEADER && (header & CDF_HEADER_MASK) == CDF_HEADER_BOE;
+  }
+
+  TH1* toROOT(gem::readout::GEMDQMHistogram const& histogram)
+  {
+    TH1* root = NULL;
+    if (histogram.is2D()) {
+      root = new TH2F(histogram.name().c_str(), histogram.title().c_str(),
+                      histogram.nBinsX(), histogram.xLow(), histogram.xHigh(),
+                      histogram.nBinsY(), histogram.yLow(), histogram.yHigh());
+      for (int binY = 0; binY <= histogram.nBinsY() + 1; ++binY)
+        for (int binX = 0; binX <= histogram.nBinsX() + 1; ++binX)
+          root->SetBinContent(binX, binY, histogram.binContent(binX, binY));
+    } else {
+      root = new TH1F(histogram.name().c_str(), histogram.title().c_str(),
+                      histogram.nBinsX(), histogram.xLow(), histogram.xHigh());
+      for (int binX = 0; binX <= histogram.nBinsX() + 1; ++binX)
+        root->SetBinContent(binX, histogram.binContent(binX));
+    }
+    root->SetEntries(histogram.entries());
+    return root;
+  }
+
+  bool writeOutput(DQMHistograms const& total, std::string const& directory)
+  {
+    gROOT->SetBatch(true);
+    // AccessPathName is true if the path does not exist
+    if (gSystem->AccessPathName(directory.c_str()) && gSystem->mkdir(directory.c_str(), true) != 0) {
+      std::cerr << "gemDQMReplay: unable to create " << directory << std::endl;
+      return false;
+    }
+
+    TFile output((directory + "/gemDQMReplay.root").c_str(), "RECREATE");
+    TCanvas canvas("c", "c", 600, 600);
+    std::vector<gem::readout::GEMDQMHistogram const*> const histograms = total.histograms();
+    for (auto histogram = histograms.begin(); histogram != histograms.end(); ++histogram) {
+      TH1* root = toROOT(**histogram);
+      root->Write();
+      // same file names as gemOnlineDQM::print
+      canvas.cd();
+      root->Draw();
+      canvas.Print((directory + "/" + (*histogram)->title() + ".png").c_str(), "png");
+      delete root;
+    }
+    output.Close();
+    return true;
+  }
+
+  void usage()
+  {
+    std::cerr << "usage: gemDQMReplay [-j threads] [-s slot file] [-m map directory] [-o output directory] file..."
+              << std::endl;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  log4cplus::BasicConfigurator logConfig;
+  logConfig.configure();
+
+  ReplayConfig config;
+  config.nThreads        = std::max(std::thread::hardware_concurrency(), 1u);
+  config.slotFile        = "slot_table.csv";
+  config.outputDirectory = "./temp_plots";
+  char const* buildHome  = std::getenv("BUILD_HOME");
+  config.mapDirectory    = std::string(buildHome ? buildHome : "") + "/gem-light-dqm/dqm-root/data";
+
+  int option;
+  while ((option = getopt(argc, argv, "j:s:m:o:h")) != -1) {
+    switch (option) {
+    case 'j':
+      config.nThreads = std::strtoul(optarg, NULL, 10);
+      break;
+    case 's':
+      config.slotFile = optarg;
+      break;
+    case 'm':
+      config.mapDirectory = optarg;
+      break;
+    case 'o':
+      config.outputDirectory = optarg;
+      break;
+    default:
+      usage();
+      return 1;
+    }
+  }
+  if (optind >= argc) {
+    usage();
+    return 1;
+  }
+
+  std::shared_ptr<const gem::readout::GEMslotContents> slotContents =
+    gem::readout::GEMslotContents::getSlotContents(config.slotFile);
+  std::shared_ptr<const gem::readout::GEMDQMStripMap> stripMap =
+    gem::readout::GEMDQMStripMap::load(config.mapDirectory);
+  DQMHistograms total(slotContents, stripMap);
+
+  size_t nEvents = 0;
+  for (int arg = optind; arg < argc; ++arg) {
+    std::string const fileName(argv[arg]);
+    try {
+      size_t n = 0;
+      if (isRunFile(fileName))
+        n = replayRunFile(fileName, config, total, slotContents, stripMap);
+      else if (isAMC13File(fileName))
+        n = replayAMC13File(fileName, config, total, slotContents, stripMap);
+      else
+        n = replayBinFile(fileName, config, total, slotContents, stripMap);
+      std::cout << "gemDQMReplay: " << fileName << ", " << n << " events" << std::endl;
+      nEvents += n;
+    } catch (xcept::Exception const& e) {
+      std::cerr << "gemDQMReplay: unable to replay " << fileName << ": " << e.what() << std::endl;
+      return 1;
+    }
+  }
+
+  std::cout << "gemDQMReplay: " << nEvents << " events, " << total.vfatBlocks() << " VFAT blocks, "
+            << total.badVFATBlocks() << " with bad control bits or CRC" << std::endl;
+  return writeOutput(total, config.outputDirectory) ? 0 : 1;
+}
@@ -1,9 +1,13 @@
+// sequence number of the last update, only the items changed since are sent by the application
+var jsonSequence = 0;
+
 function sendrequest( jsonurl )
 {
     if (window.jQuery) {
         // can use jQuery libraries rather than raw javascript
-        $.getJSON(jsonurl)
+        $.getJSON(jsonurl, { since: jsonSequence })
             .done(function(data) {
+                    jsonSequence = data.sequence || 0;
                     updateStatePage( data );
                 })
             .fail(function(data, textStatus, error) {
@@ -20,10 +24,11 @@ function sendrequest( jsonurl )
             {
                 if (xmlhttp.readyState==4 && xmlhttp.status==200) {
                     var res = eval( "(" + xmlhttp.responseText + ")" );
+                    jsonSequence = res.sequence || 0;
                     updateStatePage( res );
                 }
             };
-        xmlhttp.open("GET", jsonurl, true);
+        xmlhttp.open("GET", jsonurl + "?since=" + jsonSequence, true);
         xmlhttp.send();
     }
 };
@@ -32,6 +37,8 @@ function updateStatePage( statejson )
 {
     //console.log("statejson:"+statejson);
     for ( var set in statejson ) {
+        if ( set === "sequence" )
+            continue;
         //console.log("set:"+set);
         var arr = statejson[set];
         //console.log("statejson[set]:"+statejson[set]);
@@ -221,7 +221,7 @@ namespace gem {
 
       private:
 
-        std::unique_ptr<gem::readout::GEMslotContents> slotInfo;
+        std::shared_ptr<const gem::readout::GEMslotContents> slotInfo;
 
         log4cplus::Logger m_gemLogger;
 
@@ -3,9 +3,15 @@
 #ifndef GEM_SUPERVISOR_GEMGLOBALSTATE_H
 #define GEM_SUPERVISOR_GEMGLOBALSTATE_H
 
+#include <deque>
+#include <functional>
 #include <map>
 #include <string>
 #include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
 
 #include "toolbox/task/TimerListener.h"
 #include "toolbox/fsm/FiniteStateMachine.h"
@@ -27,6 +33,7 @@ namespace gem {
 
     class GEMSupervisor;
     class GEMGlobalState;
+    struct GEMStateQuery;
 
     struct GEMApplicationState {
       GEMApplicationState();
@@ -38,7 +45,10 @@ namespace gem {
 
     private:
       friend class GEMGlobalState;
-      xoap::MessageReference updateMsg;
+      // last state query sent to the application, may still be outstanding
+      std::shared_ptr<GEMStateQuery> query;
+      // number of state change notifications received from the application
+      uint64_t notifications;
     };
 
     /**
@@ -109,9 +119,64 @@ namespace gem {
 
         /**
          * @brief updates the global state based on the individual states of the managed applications
+         * The state of every application is queried concurrently by a fixed pool of query threads,
+         * and the update returns once all have replied or the query timeout has expired.
+         * Applications that did not reply in time keep their previous state and are not queried
+         * again until the outstanding query completes.
          */
         void update();
 
+        /**
+         * @brief updates the stored state of an application from a state change notification
+         * @param className class name of the application
+         * @param instance instance number of the application
+         * @param stateName name of the new state
+         * @param stateMessage state message of the application
+         */
+        void applicationStateChanged(std::string const& className, uint32_t const& instance,
+                                     std::string const& stateName, std::string const& stateMessage);
+
+        /**
+         * @brief wakes up all threads waiting for a state update, e.g., after the supervisor FSM changed state
+         */
+        void notifyStateUpdate();
+
+        /**
+         * @brief blocks until condition() is true, re-evaluating it after every state update
+         * Waits are woken up by state change notifications, if none arrive within the poll interval
+         * an update is performed from the waiting thread
+         * @param condition callable returning true when the wait is over
+         */
+        template <typename Condition>
+          void waitFor(Condition const& condition)
+          {
+            uint64_t lastUpdate = getUpdateCount();
+            while (!condition()) {
+              if (!waitForUpdate(lastUpdate, m_pollInterval))
+                update();
+            }
+          }
+
+        /**
+         * @brief blocks until the composite state of the group of applications is the requested state
+         * @param apps the group of applications
+         * @param state the state the group must reach
+         */
+        void waitForCompositeState(std::vector<xdaq::ApplicationDescriptor*> const& apps,
+                                   toolbox::fsm::State const& state);
+
+        /**
+         * @brief sets the maximum time to wait for the reply to a state query
+         * @param timeout in milliseconds
+         */
+        void setQueryTimeout(uint32_t const& timeout) { m_queryTimeout = timeout; };
+
+        /**
+         * @brief sets the interval after which a waiting thread polls the states itself
+         * @param interval in milliseconds
+         */
+        void setPollInterval(uint32_t const& interval) { m_pollInterval = interval; };
+
         /**
          * @brief starts the update timer
          */
@@ -141,11 +206,17 @@ namespace gem {
 
         static std::string getStateName(toolbox::fsm::State state);
 
-	std::string getStateName() const { return m_globalStateName; };
+        /**
+         * @brief converts the state name reported by an application into the corresponding GEM FSM state
+         * @returns STATE_NULL if the name is not known
+         */
+        static toolbox::fsm::State getStateFromName(std::string const& stateName);
+
+        std::string getStateName() const;
 
-	std::string getStateMessage() const { return m_globalStateMessage; };
+        std::string getStateMessage() const;
 
-        void setGlobalStateMessage(std::string const& stateMessage) { m_globalStateMessage = stateMessage; };
+        void setGlobalStateMessage(std::string const& stateMessage);
 
         static int getStatePriority(toolbox::fsm::State state);
 
@@ -171,16 +242,45 @@ namespace gem {
 
       private:
         /**
-         * @brief updates the stored application state
-         * @param app is the application descriptor
+         * @brief copies the results of the completed state queries into the application states
+         * must be called with m_mutex held
+         */
+        void applyQueryResults();
+
+        /**
+         * @brief recomputes the global state
+         * must be called with m_mutex held, the supervisor is informed of a change by
+         * notifyGlobalStateChange once the lock has been released
+         * @param before set to the global state before the update
+         * @returns true if the global state changed
+         */
+        bool refreshGlobalState(toolbox::fsm::State& before);
+
+        /**
+         * @brief informs the supervisor of a change of the global state, must be called without m_mutex held
+         */
+        void notifyGlobalStateChange(toolbox::fsm::State const& before, toolbox::fsm::State const& after);
+
+        /**
+         * @brief runs the queued state queries until the GEMGlobalState is destroyed
          */
-        void updateApplication(xdaq::ApplicationDescriptor* app);
+        void queryWorker();
 
         /**
          * @brief updates the global state based on the individual states of the managed applications
          */
         void calculateGlobals();
 
+        /**
+         * @brief waits for the next state update
+         * @param lastUpdate update count seen by the caller, set to the current count on return
+         * @param timeout maximum time to wait in milliseconds
+         * @returns true if an update happened before the timeout
+         */
+        bool waitForUpdate(uint64_t& lastUpdate, uint32_t const& timeout);
+
+        uint64_t getUpdateCount() const;
+
         toolbox::fsm::State getProperCompositeState(toolbox::fsm::State const& initial,
                                                     toolbox::fsm::State const& final,
                                                     std::string         const& states);
@@ -198,6 +298,21 @@ namespace gem {
         toolbox::fsm::State m_globalState, m_forceGlobal;
         log4cplus::Logger m_gemLogger;
         mutable gem::utils::Lock m_mutex;
+
+        uint32_t m_queryTimeout;  // ms to wait for the replies to the state queries
+        uint32_t m_pollInterval;  // ms a waiting thread waits for a notification before polling
+
+        // state update signalling for waitFor
+        mutable std::mutex      m_updateMutex;
+        std::condition_variable m_updateCondition;
+        uint64_t                m_updateCount;
+
+        // state query threads, joined in the destructor so no query outlives p_appContext
+        std::vector<std::thread>           m_queryWorkers;
+        std::deque<std::function<void()> > m_queryJobs;
+        std::mutex                         m_queryMutex;
+        std::condition_variable            m_queryCondition;
+        bool                               m_stopQueries;
       };
   }  // namespace supervisor
 }  // namespace gem
@@ -62,6 +62,19 @@ namespace gem {
 	xoap::MessageReference EndScanPoint(xoap::MessageReference mns);
           // throw (xoap::exception::Exception);
 
+        /**
+         * @brief receives the state change notifications sent by the supervised applications
+         * @param msg StateNotification message containing the application and its new state
+         * @returns xoap::MessageReference acknowledging the notification
+         */
+        xoap::MessageReference stateNotification(xoap::MessageReference msg);
+          // throw (xoap::exception::Exception);
+
+        /**
+         * @brief wakes up the transitions waiting on the supervisor state
+         */
+        virtual void stateChanged(toolbox::fsm::FiniteStateMachine &fsm);
+
         std::vector<xdaq::ApplicationDescriptor*> getSupervisedAppDescriptors() {
           return v_supervisedApps; };
 
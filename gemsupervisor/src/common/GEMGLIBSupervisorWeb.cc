@@ -164,7 +164,7 @@ void gem::supervisor::GEMGLIBSupervisorWeb::actionPerformed(xdata::Event& event)
         ss << "Device name: " << chip->toString() << std::endl;
       }
     INFO(ss.str());
-    slotInfo = std::unique_ptr<gem::readout::GEMslotContents>(new gem::readout::GEMslotContents(confParams_.bag.slotFileName.toString()));
+    slotInfo = gem::readout::GEMslotContents::getSlotContents(confParams_.bag.slotFileName.toString());
   }
 
   // get the workloop instance after loading config parameters
@@ -734,8 +734,10 @@ bool gem::supervisor::GEMGLIBSupervisorWeb::selectAction(toolbox::task::WorkLoop
     return true;
   else if (gemDataParker->queueDepth() > 0)
     return true;
-  else
-    return false;
+
+  // queue drained after the run stopped, push the buffered events to disk
+  gemDataParker->flushOutput();
+  return false;
 }
 
 
@@ -844,6 +846,9 @@ void gem::supervisor::GEMGLIBSupervisorWeb::configureAction(toolbox::Event::Refe
 
   tmpType = confParams_.bag.outputType.toString();
 
+  // pick up any change to the slot file since the last run, the data parker shares the same map
+  slotInfo = gem::readout::GEMslotContents::reloadSlotContents(confParams_.bag.slotFileName.toString());
+
   // Book GEM Data Parker
   gemDataParker =
     std::shared_ptr<gem::readout::GEMDataParker>(new gem::readout::GEMDataParker(*glibDevice_,
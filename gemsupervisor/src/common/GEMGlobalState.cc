@@ -1,5 +1,7 @@
 #include "gem/supervisor/GEMGlobalState.h"
 
+#include <chrono>
+
 #include "toolbox/task/TimerFactory.h"
 #include "toolbox/task/Timer.h"
 
@@ -9,11 +11,160 @@
 #include "gem/supervisor/GEMSupervisor.h"
 #include "gem/utils/LockGuard.h"
 
+/**
+ * Result of one state query, shared between the GEMGlobalState and the thread sending the query,
+ * such that a query which overruns the timeout can complete without touching the application map
+ */
+struct gem::supervisor::GEMStateQuery {
+  explicit GEMStateQuery(uint64_t const& notificationCount) :
+    done(false),
+    applied(false),
+    issued(std::chrono::steady_clock::now()),
+    notificationsAtIssue(notificationCount),
+    state(gem::base::STATE_NULL),
+    hasMessage(false)
+  {}
+
+  std::mutex mutex;
+  bool done;
+  bool applied;
+  std::chrono::steady_clock::time_point issued;
+  uint64_t notificationsAtIssue;  // state notifications received when the query was sent
+  toolbox::fsm::State state;      // STATE_NULL if the reply did not contain a known state
+  bool hasMessage;
+  std::string stateMessage;
+};
+
+namespace {
+  const uint32_t DEFAULT_QUERY_TIMEOUT = 2000;  // ms
+  const uint32_t DEFAULT_POLL_INTERVAL = 250;   // ms
+  const size_t   N_QUERY_WORKERS       = 8;     // state queries sent at the same time
+
+  // completion count for the queries sent by one GEMGlobalState::update call
+  struct StateQueryBatch {
+    StateQueryBatch() : pending(0) {}
+    std::mutex              mutex;
+    std::condition_variable allDone;
+    size_t                  pending;
+  };
+
+  /**
+   * Sends the state request to the application and parses the reply into the query result,
+   * runs in a query worker thread, so it must only use the arguments it was given
+   */
+  void queryApplicationState(log4cplus::Logger m_gemLogger,
+                             xdaq::ApplicationContext* appContext,
+                             xdaq::ApplicationDescriptor* srcApp,
+                             xdaq::ApplicationDescriptor* app,
+                             std::shared_ptr<gem::supervisor::GEMStateQuery> query,
+                             std::shared_ptr<StateQueryBatch> batch)
+  {
+    toolbox::fsm::State state = gem::base::STATE_NULL;
+    bool        hasMessage    = false;
+    std::string stateMessage  = "";
+
+    std::string appUrn = "urn:xdaq-application:" + app->getClassName();
+    bool isGEMApp      = (appUrn.find("tcds") == std::string::npos);
+    std::string nstag  = "gemapp";
+    std::string errMsg = "";
+
+    xoap::MessageReference msg, answer;
+    try {
+      msg = gem::utils::soap::GEMSOAPToolBox::createStateRequestMessage("app", appUrn, isGEMApp);
+      TRACE("GEMGlobalState::queryApplicationState::p_appContext " << std::endl
+            << appContext->getContextDescriptor()->getURL()  << std::endl
+            << " p_srcAppContext " << srcApp->getContextDescriptor()->getURL() << std::endl
+            << " appContext "      << app->getContextDescriptor()->getURL());
+      answer = appContext->postSOAP(msg, *srcApp, *app);
+    } catch (xoap::exception::Exception& e) {
+      errMsg = toolbox::toString("(xoap::exception::Exception) %s", e.what());
+    } catch (xdaq::exception::Exception& e) {
+      errMsg = toolbox::toString("(xdaq::exception::Exception) %s", e.what());
+    } catch (xcept::Exception& e) {
+      errMsg = toolbox::toString("(xcept::Exception) %s", e.what());
+    } catch (std::exception& e) {
+      errMsg = toolbox::toString("(std::exception) %s", e.what());
+    } catch (...) {
+      errMsg = "(unknown exception)";
+    }
+
+    if (!errMsg.empty()) {
+      WARN("GEMGlobalState::queryApplicationState caught exception communicating with "
+           << app->getClassName() << ":" << app->getInstance()
+           << ". Applcation probably crashed, setting state to FAILED " << errMsg);
+      state        = gem::base::STATE_FAILED;
+      hasMessage   = true;
+      stateMessage = "Communication failure, assuming state is FAILED, may mean application/executive crash.";
+    } else {
+      try {
+        // parse answer here
+        xoap::SOAPElement props = answer->getSOAPPart().getEnvelope().getBody().getChildElements()[0].getChildElements()[0];
+        if (isGEMApp) {
+          xoap::SOAPName messageReply("StateMessage", nstag, appUrn);
+          std::vector<xoap::SOAPElement> basic = props.getChildElements(messageReply);
+          if (basic.size() == 1) {
+            stateMessage = basic[0].getValue();
+            hasMessage   = true;
+            DEBUG("GEMGlobalState::queryApplicationState " << app->getClassName() << ":"
+                  << static_cast<int>(app->getInstance())
+                  << " returned state message " << stateMessage);
+          }
+        }
+
+        xoap::SOAPName stateReply(isGEMApp ? "StateName" : "stateName", nstag, appUrn);
+        std::vector<xoap::SOAPElement> basic = props.getChildElements(stateReply);
+        if (basic.size() == 1) {
+          std::string stateString = basic[0].getValue();
+          DEBUG("GEMGlobalState::queryApplicationState " << app->getClassName() << ":"
+                << static_cast<int>(app->getInstance())
+                << " returned state " << stateString);
+          state = gem::supervisor::GEMGlobalState::getStateFromName(stateString);
+          if (state == gem::base::STATE_NULL)
+            WARN("GEMGlobalState::queryApplicationState " << app->getClassName() << ":"
+                 << static_cast<int>(app->getInstance()) << " " << stateString);
+        } else {
+          if (answer->getSOAPPart().getEnvelope().getBody().hasFault()) {
+            ERROR("SOAP fault getting state: " << std::endl << "SOAP request:" << std::endl
+                  << gem::utils::soap::GEMSOAPToolBox::messageToString(msg));
+            ERROR("SOAP fault getting state: " << std::endl << "SOAP reply:"   << std::endl
+                  << answer->getSOAPPart().getEnvelope().getBody().getFault().getFaultString()
+                  << std::endl << gem::utils::soap::GEMSOAPToolBox::messageToString(answer));
+          }
+          DEBUG("GEMGlobalState::queryApplicationState " << app->getClassName() << ":"
+                << static_cast<int>(app->getInstance())
+                << std::endl << static_cast<int>(basic.size())
+                << std::endl << gem::utils::soap::GEMSOAPToolBox::messageToString(answer));
+        }
+      } catch (xcept::Exception& e) {
+        ERROR("GEMGlobalState::queryApplicationState unable to parse the reply from "
+              << app->getClassName() << ":" << app->getInstance() << " " << e.what());
+      } catch (std::exception& e) {
+        ERROR("GEMGlobalState::queryApplicationState unable to parse the reply from "
+              << app->getClassName() << ":" << app->getInstance() << " " << e.what());
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> guard(query->mutex);
+      query->state        = state;
+      query->hasMessage   = hasMessage;
+      query->stateMessage = stateMessage;
+      query->done         = true;
+    }
+    {
+      std::lock_guard<std::mutex> guard(batch->mutex);
+      --(batch->pending);
+    }
+    batch->allDone.notify_all();
+  }
+}
+
 gem::supervisor::GEMApplicationState::GEMApplicationState()
 {
   state          = gem::base::STATE_NULL;
   progress       = 1.0;
   progressWeight = 1.0;
+  notifications  = 0;
 }
 
 gem::supervisor::GEMGlobalState::GEMGlobalState(xdaq::ApplicationContext* context, GEMSupervisor* gemSupervisor) :
@@ -28,15 +179,46 @@ gem::supervisor::GEMGlobalState::GEMGlobalState(xdaq::ApplicationContext* contex
   m_globalState(gem::base::STATE_INITIAL),
   m_forceGlobal(gem::base::STATE_NULL),
   m_gemLogger(gemSupervisor->getApplicationLogger()),
-  m_mutex(toolbox::BSem::FULL, true)
+  m_mutex(toolbox::BSem::FULL, true),
+  m_queryTimeout(DEFAULT_QUERY_TIMEOUT),
+  m_pollInterval(DEFAULT_POLL_INTERVAL),
+  m_updateCount(0),
+  m_stopQueries(false)
 {
-  // default constructor
+  for (size_t i = 0; i < N_QUERY_WORKERS; ++i)
+    m_queryWorkers.push_back(std::thread(&GEMGlobalState::queryWorker, this));
 }
 
 
 gem::supervisor::GEMGlobalState::~GEMGlobalState()
 {
   // delete p_timer;
+  {
+    std::lock_guard<std::mutex> guard(m_queryMutex);
+    m_stopQueries = true;
+    // queries not started yet are dropped, their update call has already given up on them
+    m_queryJobs.clear();
+  }
+  m_queryCondition.notify_all();
+  for (auto worker = m_queryWorkers.begin(); worker != m_queryWorkers.end(); ++worker)
+    if (worker->joinable())
+      worker->join();
+}
+
+void gem::supervisor::GEMGlobalState::queryWorker()
+{
+  while (true) {
+    std::function<void()> job;
+    {
+      std::unique_lock<std::mutex> lock(m_queryMutex);
+      m_queryCondition.wait(lock, [this]() { return m_stopQueries || !m_queryJobs.empty(); });
+      if (m_stopQueries)
+        return;
+      job = m_queryJobs.front();
+      m_queryJobs.pop_front();
+    }
+    job();
+  }
 }
 
 
@@ -48,11 +230,7 @@ void gem::supervisor::GEMGlobalState::addApplication(xdaq::ApplicationDescriptor
   m_states.insert(std::pair<xdaq::ApplicationDescriptor*, GEMApplicationState>(app, GEMApplicationState()));
 
   ApplicationMap::iterator i = m_states.find(app);
-  std::string appURN = "urn:xdaq-application:"+app->getClassName();
-  bool isGEMApp = true;
-  if (appURN.find("tcds") != std::string::npos)
-    isGEMApp = false;
-  i->second.updateMsg = gem::utils::soap::GEMSOAPToolBox::createStateRequestMessage("app", appURN, isGEMApp);
+  i->second.isGEMNative = (app->getClassName().find("tcds") == std::string::npos);
 }
 
 void gem::supervisor::GEMGlobalState::clear()
@@ -64,18 +242,190 @@ void gem::supervisor::GEMGlobalState::clear()
 void gem::supervisor::GEMGlobalState::update()
 {
   DEBUG("GEMGlobalState::update");
-  gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_mutex);
+  std::shared_ptr<StateQueryBatch> batch = std::make_shared<StateQueryBatch>();
+  std::vector<std::pair<xdaq::ApplicationDescriptor*, std::shared_ptr<GEMStateQuery> > > queries;
+  {
+    gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_mutex);
+    for (auto i = m_states.begin(); i != m_states.end(); ++i) {
+      std::shared_ptr<GEMStateQuery> previous = i->second.query;
+      if (previous) {
+        std::lock_guard<std::mutex> guard(previous->mutex);
+        if (!previous->done) {
+          DEBUG("GEMGlobalState::update previous query to " << i->first->getClassName() << ":"
+                << i->first->getInstance() << " still outstanding");
+          continue;
+        }
+      }
+      i->second.query = std::make_shared<GEMStateQuery>(i->second.notifications);
+      queries.push_back(std::make_pair(i->first, i->second.query));
+    }
+  }
+
+  // query all applications concurrently, the replies are applied under the lock afterwards
+  batch->pending = queries.size();
+  {
+    std::lock_guard<std::mutex> guard(m_queryMutex);
+    for (auto q = queries.begin(); q != queries.end(); ++q)
+      m_queryJobs.push_back(std::bind(queryApplicationState, m_gemLogger, p_appContext, p_srcApp,
+                                      q->first, q->second, batch));
+  }
+  m_queryCondition.notify_all();
+
+  {
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    if (!batch->allDone.wait_for(lock, std::chrono::milliseconds(m_queryTimeout),
+                                 [&batch]() { return batch->pending == 0; }))
+      WARN("GEMGlobalState::update " << batch->pending << " of " << queries.size()
+           << " state queries did not complete within " << m_queryTimeout << "ms");
+  }
+
+  toolbox::fsm::State before, after;
+  bool changed;
+  {
+    gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_mutex);
+    applyQueryResults();
+    changed = refreshGlobalState(before);
+    after   = m_globalState;
+  }
+  if (changed)
+    notifyGlobalStateChange(before, after);
+  notifyStateUpdate();
+}
+
+void gem::supervisor::GEMGlobalState::applyQueryResults()
+{
   for (auto i = m_states.begin(); i != m_states.end(); ++i) {
-    updateApplication(i->first);
+    std::shared_ptr<GEMStateQuery> query = i->second.query;
+    if (!query)
+      continue;
+
+    std::lock_guard<std::mutex> guard(query->mutex);
+    if (!query->done) {
+      // the query may have been sent by a concurrent update which is still waiting for it
+      if (std::chrono::steady_clock::now() - query->issued > std::chrono::milliseconds(m_queryTimeout))
+        i->second.stateMessage = toolbox::toString("No reply to state query within %d ms", m_queryTimeout);
+      continue;
+    }
+    if (query->applied)
+      continue;
+    query->applied = true;
+
+    // a notification received while the query was in flight is more recent than the reply
+    if (query->notificationsAtIssue != i->second.notifications)
+      continue;
+    if (query->state != gem::base::STATE_NULL)
+      i->second.state = query->state;
+    if (query->hasMessage)
+      i->second.stateMessage = query->stateMessage;
   }
-  toolbox::fsm::State before = m_globalState;
+}
+
+bool gem::supervisor::GEMGlobalState::refreshGlobalState(toolbox::fsm::State& before)
+{
+  before = m_globalState;
   calculateGlobals();
   m_globalStateName = getStateName(m_globalState);
   DEBUG("GEMGlobalState::update before=" << before << " after=" << m_globalState);
-  if (before != m_globalState) {
-    p_gemSupervisor->globalStateChanged(before, m_globalState);
-    setGlobalStateMessage("Reached terminal state: " + m_globalState);
+  if (before == m_globalState)
+    return false;
+  setGlobalStateMessage("Reached terminal state: " + m_globalStateName);
+  return true;
+}
+
+void gem::supervisor::GEMGlobalState::notifyGlobalStateChange(toolbox::fsm::State const& before,
+                                                              toolbox::fsm::State const& after)
+{
+  // the supervisor may query this object or wait on its own locks, so m_mutex is not held here
+  p_gemSupervisor->globalStateChanged(before, after);
+}
+
+void gem::supervisor::GEMGlobalState::applicationStateChanged(std::string const& className,
+                                                              uint32_t    const& instance,
+                                                              std::string const& stateName,
+                                                              std::string const& stateMessage)
+{
+  DEBUG("GEMGlobalState::applicationStateChanged " << className << ":" << instance << " " << stateName);
+  toolbox::fsm::State state = getStateFromName(stateName);
+  toolbox::fsm::State before, after;
+  bool changed;
+  {
+    gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_mutex);
+    auto i = m_states.begin();
+    for (; i != m_states.end(); ++i)
+      if (i->first->getClassName() == className && i->first->getInstance() == instance)
+        break;
+
+    if (i == m_states.end()) {
+      DEBUG("GEMGlobalState::applicationStateChanged ignoring unmanaged application "
+            << className << ":" << instance);
+      return;
+    }
+
+    ++(i->second.notifications);
+    if (state != gem::base::STATE_NULL)
+      i->second.state = state;
+    else
+      WARN("GEMGlobalState::applicationStateChanged " << className << ":" << instance << " " << stateName);
+    i->second.stateMessage = stateMessage;
+    changed = refreshGlobalState(before);
+    after   = m_globalState;
   }
+  if (changed)
+    notifyGlobalStateChange(before, after);
+  notifyStateUpdate();
+}
+
+void gem::supervisor::GEMGlobalState::notifyStateUpdate()
+{
+  {
+    std::lock_guard<std::mutex> guard(m_updateMutex);
+    ++m_updateCount;
+  }
+  m_updateCondition.notify_all();
+}
+
+uint64_t gem::supervisor::GEMGlobalState::getUpdateCount() const
+{
+  std::lock_guard<std::mutex> guard(m_updateMutex);
+  return m_updateCount;
+}
+
+bool gem::supervisor::GEMGlobalState::waitForUpdate(uint64_t& lastUpdate, uint32_t const& timeout)
+{
+  std::unique_lock<std::mutex> lock(m_updateMutex);
+  bool updated = m_updateCondition.wait_for(lock, std::chrono::milliseconds(timeout),
+                                            [this, &lastUpdate]() { return m_updateCount != lastUpdate; });
+  lastUpdate = m_updateCount;
+  return updated;
+}
+
+void gem::supervisor::GEMGlobalState::waitForCompositeState(std::vector<xdaq::ApplicationDescriptor*> const& apps,
+                                                            toolbox::fsm::State const& state)
+{
+  waitFor([this, &apps, &state]() {
+      toolbox::fsm::State compState = compositeState(apps);
+      DEBUG("GEMGlobalState::waitForCompositeState waiting for group to reach " << getStateName(state)
+            << ", currently " << getStateName(compState));
+      return compState == state;
+    });
+}
+
+std::string gem::supervisor::GEMGlobalState::getStateName() const
+{
+  gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_mutex);
+  return m_globalStateName;
+}
+
+std::string gem::supervisor::GEMGlobalState::getStateMessage() const
+{
+  gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_mutex);
+  return m_globalStateMessage;
+}
+
+void gem::supervisor::GEMGlobalState::setGlobalStateMessage(std::string const& stateMessage)
+{
+  gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_mutex);
+  m_globalStateMessage = stateMessage;
 }
 
 void gem::supervisor::GEMGlobalState::startTimer()
@@ -260,159 +610,6 @@ toolbox::fsm::State gem::supervisor::GEMGlobalState::getProperCompositeState(too
 }
 
 
-void gem::supervisor::GEMGlobalState::updateApplication(xdaq::ApplicationDescriptor* app)
-{
-  ApplicationMap::iterator i   = m_states.find(app);
-  xoap::MessageReference   msg = xoap::createMessage(i->second.updateMsg), answer;
-  std::string nstag = "gemapp";
-  std::stringstream debugstream;
-  msg->writeTo(debugstream);
-  try {
-    // what about sending a message to a different context?
-    TRACE("GEMGlobalState::updateApplication::p_appContext " << p_appContext->getSessionId());
-         // << " p_srcAppContext " << p_srcApp->getApplicationContext()->getSessionId()
-         // << " appContext "      << app->getApplicationContext()->getSessionId());
-    TRACE("GEMGlobalState::updateApplication::p_appContext " << std::endl
-         << p_appContext->getContextDescriptor()->getURL()  << std::endl
-         << " p_srcAppContext " << p_srcApp->getContextDescriptor()->getURL() << std::endl
-         << " appContext "      << app->getContextDescriptor()->getURL());
-    answer = p_appContext->postSOAP(msg, *p_srcApp, *app);
-    // answer = static_cast<xdaq::Application>(app)->getApplicationContext()->postSOAP(msg, *p_srcApp, *app);
-  } catch (xoap::exception::Exception& e) {
-    WARN("GEMGlobalState::updateApplication caught exception communicating with " << app->getClassName() << ":" << app->getInstance()
-         << ". Applcation probably crashed, setting state to FAILED"
-         << " (xoap::exception::Exception)" << e.what());
-    INFO("GEMGlobalState::updateApplication tried sending SOAP [" << debugstream.str() << "]");
-    i->second.state        = gem::base::STATE_FAILED;
-    i->second.stateMessage = "Communication failure, assuming state is FAILED, may mean application/executive crash.";
-    return;
-  } catch (xdaq::exception::Exception& e) {
-    WARN("GEMGlobalState::updateApplication caught exception communicating with " << app->getClassName() << ":" << app->getInstance()
-         << ". Applcation probably crashed, setting state to FAILED"
-         << " (xdaq::exception::Exception)" << e.what());
-    INFO("GEMGlobalState::updateApplication tried sending SOAP [" << debugstream.str() << "]");
-    i->second.state        = gem::base::STATE_FAILED;
-    i->second.stateMessage = "Communication failure, assuming state is FAILED, may mean application/executive crash.";
-    return;
-  } catch (xcept::Exception& e) {
-    WARN("GEMGlobalState::updateApplication caught exception communicating with " << app->getClassName() << ":" << app->getInstance()
-         << ". Applcation probably crashed, setting state to FAILED"
-         << " (xcept::Exception)" << e.what());
-    INFO("GEMGlobalState::updateApplication tried sending SOAP [" << debugstream.str() << "]");
-    i->second.state        = gem::base::STATE_FAILED;
-    i->second.stateMessage = "Communication failure, assuming state is FAILED, may mean application/executive crash.";
-    return;
-  } catch (std::exception& e) {
-    WARN("GEMGlobalState::updateApplication caught exception communicating with " << app->getClassName() << ":" << app->getInstance()
-         << ". Applcation probably crashed, setting state to FAILED"
-         << " (std::exception)" << e.what());
-    INFO("GEMGlobalState::updateApplication tried sending SOAP [" << debugstream.str() << "]");
-    i->second.state        = gem::base::STATE_FAILED;
-    i->second.stateMessage = "Communication failure, assuming state is FAILED, may mean application/executive crash.";
-    return;
-  } catch (...) {
-    WARN("GEMGlobalState::updateApplication caught exception communicating with " << app->getClassName() << ":" << app->getInstance()
-         << ". Applcation probably crashed, setting state to FAILED");
-    INFO("GEMGlobalState::updateApplication tried sending SOAP [" << debugstream.str() << "]");
-    i->second.state        = gem::base::STATE_FAILED;
-    i->second.stateMessage = "Communication failure, assuming state is FAILED, may mean application/executive crash.";
-    return;
-  }
-
-  // parse answer here
-  std::string       appUrn = "urn:xdaq-application:" + app->getClassName();
-
-  if (appUrn.find("tcds") == std::string::npos) {
-    std::string responseName = "StateMessage";
-    xoap::SOAPName stateReply(responseName, nstag, appUrn);
-
-    xoap::SOAPElement props = answer->getSOAPPart().getEnvelope().getBody().getChildElements()[0].getChildElements()[0];
-    std::vector<xoap::SOAPElement> basic = props.getChildElements(stateReply);
-    if (basic.size() == 1) {
-      std::string stateMessage = basic[0].getValue();
-      DEBUG("GEMGlobalState::updateApplication " << app->getClassName() << ":" << static_cast<int>(app->getInstance())
-            << " returned state message " << stateMessage);
-      i->second.stateMessage = stateMessage;
-    }
-  }
-
-  std::string responseName = "StateName";
-  if (appUrn.find("tcds") != std::string::npos)
-    responseName = "stateName";
-  xoap::SOAPName stateReply(responseName, nstag, appUrn);
-
-  xoap::SOAPElement props = answer->getSOAPPart().getEnvelope().getBody().getChildElements()[0].getChildElements()[0];
-  std::vector<xoap::SOAPElement> basic = props.getChildElements(stateReply);
-  if (basic.size() == 1) {
-    std::string stateString = basic[0].getValue();
-    DEBUG("GEMGlobalState::updateApplication " << app->getClassName() << ":" << static_cast<int>(app->getInstance())
-          << " returned state " << stateString);
-
-    if (!strcasecmp(stateString.c_str(), "Uninitialized"))
-      i->second.state = gem::base::STATE_UNINIT;
-    else if (!strcasecmp(stateString.c_str(), "Halted"))
-      i->second.state = gem::base::STATE_HALTED;
-    else if (!strcasecmp(stateString.c_str(), "Cold-Init"))
-      i->second.state = gem::base::STATE_COLD;
-    else if (!strcasecmp(stateString.c_str(), "Initial"))
-      i->second.state = gem::base::STATE_INITIAL;
-    else if (!strcasecmp(stateString.c_str(), "Configured"))
-      i->second.state = gem::base::STATE_CONFIGURED;
-    else if (!strcasecmp(stateString.c_str(), "Active"))
-      i->second.state = gem::base::STATE_RUNNING;
-    else if (!strcasecmp(stateString.c_str(), "Enabled"))
-      i->second.state = gem::base::STATE_RUNNING;
-    else if (!strcasecmp(stateString.c_str(), "Running"))
-      i->second.state = gem::base::STATE_RUNNING;
-    else if (!strcasecmp(stateString.c_str(), "Paused"))
-      i->second.state = gem::base::STATE_PAUSED;
-    else if (!strcasecmp(stateString.c_str(), "Suspended"))
-      i->second.state = gem::base::STATE_PAUSED;
-
-    else if (!strcasecmp(stateString.c_str(), "Initializing"))
-      i->second.state = gem::base::STATE_INITIALIZING;
-    else if (!strcasecmp(stateString.c_str(), "Configuring"))
-      i->second.state = gem::base::STATE_CONFIGURING;
-    else if (!strcasecmp(stateString.c_str(), "Halting"))
-      i->second.state = gem::base::STATE_HALTING;
-    else if (!strcasecmp(stateString.c_str(), "Pausing"))
-      i->second.state = gem::base::STATE_PAUSING;
-    else if (!strcasecmp(stateString.c_str(), "Stopping"))
-      i->second.state = gem::base::STATE_STOPPING;
-    else if (!strcasecmp(stateString.c_str(), "Starting"))
-      i->second.state = gem::base::STATE_STARTING;
-    else if (!strcasecmp(stateString.c_str(), "Resuming"))
-      i->second.state = gem::base::STATE_RESUMING;
-    else if (!strcasecmp(stateString.c_str(), "Resetting"))
-      i->second.state = gem::base::STATE_RESETTING;
-    else if (!strcasecmp(stateString.c_str(), "Fixing"))
-      i->second.state = gem::base::STATE_FIXING;
-    else if (!strcasecmp(stateString.c_str(), "Failed"))
-      i->second.state = gem::base::STATE_FAILED;
-    else if (!strcasecmp(stateString.c_str(), "Error"))
-      i->second.state = gem::base::STATE_FAILED;
-    else
-      WARN("GEMGlobalState::updateApplication " << app->getClassName() << ":" << static_cast<int>(app->getInstance())
-           << " " << stateString);
-  } else {
-    std::string toolInput;
-    xoap::dumpTree(msg->getSOAPPart().getEnvelope().getDOMNode(), toolInput);
-    std::string  tool;
-    xoap::dumpTree(answer->getSOAPPart().getEnvelope().getDOMNode(), tool);
-
-    if (answer->getSOAPPart().getEnvelope().getBody().hasFault()) {
-      ERROR("SOAP fault getting state: " << std::endl << "SOAP request:" << std::endl << toolInput);
-      ERROR("SOAP fault getting state: " << std::endl << "SOAP reply:"   << std::endl
-            << answer->getSOAPPart().getEnvelope().getBody().getFault().getFaultString()
-            << std::endl << tool);
-    }
-    DEBUG("GEMGlobalState::updateApplication " << app->getClassName() << ":" << static_cast<int>(app->getInstance())
-          << std::endl << static_cast<int>(basic.size())
-          << std::endl << tool);
-  }
-}
-
-
 toolbox::fsm::State gem::supervisor::GEMGlobalState::compositeState(std::vector<xdaq::ApplicationDescriptor*> const& apps)
 {
   gem::utils::LockGuard<gem::utils::Lock> guardedLock(m_mutex);
@@ -496,6 +693,38 @@ std::string gem::supervisor::GEMGlobalState::getStateName(toolbox::fsm::State st
   }
 }
 
+toolbox::fsm::State gem::supervisor::GEMGlobalState::getStateFromName(std::string const& stateName)
+{
+  static const std::pair<std::string, toolbox::fsm::State> stateNames[] = {
+    std::make_pair("Uninitialized", gem::base::STATE_UNINIT),
+    std::make_pair("Halted",        gem::base::STATE_HALTED),
+    std::make_pair("Cold-Init",     gem::base::STATE_COLD),
+    std::make_pair("Initial",       gem::base::STATE_INITIAL),
+    std::make_pair("Configured",    gem::base::STATE_CONFIGURED),
+    std::make_pair("Active",        gem::base::STATE_RUNNING),
+    std::make_pair("Enabled",       gem::base::STATE_RUNNING),
+    std::make_pair("Running",       gem::base::STATE_RUNNING),
+    std::make_pair("Paused",        gem::base::STATE_PAUSED),
+    std::make_pair("Suspended",     gem::base::STATE_PAUSED),
+    std::make_pair("Initializing",  gem::base::STATE_INITIALIZING),
+    std::make_pair("Configuring",   gem::base::STATE_CONFIGURING),
+    std::make_pair("Halting",       gem::base::STATE_HALTING),
+    std::make_pair("Pausing",       gem::base::STATE_PAUSING),
+    std::make_pair("Stopping",      gem::base::STATE_STOPPING),
+    std::make_pair("Starting",      gem::base::STATE_STARTING),
+    std::make_pair("Resuming",      gem::base::STATE_RESUMING),
+    std::make_pair("Resetting",     gem::base::STATE_RESETTING),
+    std::make_pair("Fixing",        gem::base::STATE_FIXING),
+    std::make_pair("Failed",        gem::base::STATE_FAILED),
+    std::make_pair("Error",         gem::base::STATE_FAILED)
+  };
+
+  for (auto const& name : stateNames)
+    if (!strcasecmp(stateName.c_str(), name.first.c_str()))
+      return name.second;
+  return gem::base::STATE_NULL;
+}
+
 int gem::supervisor::GEMGlobalState::getStatePriority(toolbox::fsm::State state)
 {
   static const toolbox::fsm::State statePriority[] = {
@@ -63,6 +63,7 @@ gem::supervisor::GEMSupervisor::GEMSupervisor(xdaq::ApplicationStub* stub) :
 {
 
   xoap::bind(this, &gem::supervisor::GEMSupervisor::EndScanPoint, "EndScanPoint",  XDAQ_NS_URI);
+  xoap::bind(this, &gem::supervisor::GEMSupervisor::stateNotification, "StateNotification", XDAQ_NS_URI);
   // xgi::framework::deferredbind(this, this, &GEMSupervisor::xgiDefault, "Default");
 
   DEBUG("Creating the GEMSupervisorWeb interface");
@@ -271,13 +272,14 @@ void gem::supervisor::GEMSupervisor::initializeAction()
   init();
 
   // while ((m_gemfsm.getCurrentState()) != m_gemfsm.getStateName(gem::base::STATE_CONFIGURING)) {  // deal with possible race condition
-  while (!(m_globalState.getStateName() == "Initial" && getCurrentState() == "Initializing")) {
-    INFO("GEMSupervisor::initializeAction global state not in " << gem::base::STATE_INITIAL
-	 << " sleeping (" << m_globalState.getStateName() << ","
-	 << getCurrentState() << ")");
-    usleep(100);
-    m_globalState.update();
-  }
+  m_globalState.waitFor([this]() {
+      bool const ready = (m_globalState.getStateName() == "Initial" && getCurrentState() == "Initializing");
+      if (!ready)
+        DEBUG("GEMSupervisor::initializeAction global state not in " << gem::base::STATE_INITIAL
+              << " sleeping (" << m_globalState.getStateName() << ","
+              << getCurrentState() << ")");
+      return ready;
+    });
 
 
   if (m_useLocalDBInstance)
@@ -310,12 +312,8 @@ void gem::supervisor::GEMSupervisor::initializeAction()
         }
       }
       // check that group state of *i has moved to desired state before continuing
-      while (m_globalState.compositeState(*i) != gem::base::STATE_HALTED) {
-        DEBUG("GEMSupervisor::initializeAction waiting for group to reach Halted: "
-              << m_globalState.compositeState(*i));
-        usleep(10);
-        m_globalState.update();
-      }
+      DEBUG("GEMSupervisor::initializeAction waiting for group to reach Halted");
+      m_globalState.waitForCompositeState(*i, gem::base::STATE_HALTED);
     }
     // why is initializeAction treated differently than the other state transitions?
     // should make this uniform, or was it due to wanting to fail on DB errors?
@@ -373,16 +371,17 @@ void gem::supervisor::GEMSupervisor::configureAction()
 {
   INFO("GEMSupervisor::configureAction start");
 
-  while (!((m_globalState.getStateName() == "Halted"     && getCurrentState() == "Configuring") ||
-           // (m_globalState.getStateName() == "Paused"     && getCurrentState() == "Configuring") || // FIXME do we allow this???
-           (m_globalState.getStateName() == "Configured" && getCurrentState() == "Configuring"))) {
-    INFO("GEMSupervisor::configureAction global state not in " << gem::base::STATE_HALTED
-	 << " or "  << gem::base::STATE_CONFIGURED
-	 << " sleeping (" << m_globalState.getStateName() << ","
-	 << getCurrentState() << ")");
-    usleep(10);
-    m_globalState.update();
-  }
+  m_globalState.waitFor([this]() {
+      bool const ready = ((m_globalState.getStateName() == "Halted"     && getCurrentState() == "Configuring") ||
+                          // (m_globalState.getStateName() == "Paused"     && getCurrentState() == "Configuring") || // FIXME do we allow this???
+                          (m_globalState.getStateName() == "Configured" && getCurrentState() == "Configuring"));
+      if (!ready)
+        DEBUG("GEMSupervisor::configureAction global state not in " << gem::base::STATE_HALTED
+              << " or "  << gem::base::STATE_CONFIGURED
+              << " sleeping (" << m_globalState.getStateName() << ","
+              << getCurrentState() << ")");
+      return ready;
+    });
 
   try {
     for (auto i = v_supervisedApps.begin(); i != v_supervisedApps.end(); ++i) {
@@ -463,12 +462,8 @@ void gem::supervisor::GEMSupervisor::configureAction()
         }
       }
       // check that group state of *i has moved to desired state before continuing
-      while (m_globalState.compositeState(*i) != gem::base::STATE_CONFIGURED) {
-        DEBUG("GEMSupervisor::configureAction waiting for group to reach Configured: "
-              << m_globalState.compositeState(*i));
-        usleep(10);
-        m_globalState.update();
-      }
+      DEBUG("GEMSupervisor::configureAction waiting for group to reach Configured");
+      m_globalState.waitForCompositeState(*i, gem::base::STATE_CONFIGURED);
     }
 
     /*
@@ -545,13 +540,14 @@ void gem::supervisor::GEMSupervisor::startAction()
 {
   INFO("GEMSupervisor::startAction start");
 
-  while (!(m_globalState.getStateName() == "Configured" && getCurrentState() == "Starting")) {
-    INFO("GEMSupervisor::startAction global state not in " << gem::base::STATE_CONFIGURED
-	 << " sleeping (" << m_globalState.getStateName() << ","
-	 << getCurrentState() << ")");
-    usleep(10);
-    m_globalState.update();
-  }
+  m_globalState.waitFor([this]() {
+      bool const ready = (m_globalState.getStateName() == "Configured" && getCurrentState() == "Starting");
+      if (!ready)
+        DEBUG("GEMSupervisor::startAction global state not in " << gem::base::STATE_CONFIGURED
+              << " sleeping (" << m_globalState.getStateName() << ","
+              << getCurrentState() << ")");
+      return ready;
+    });
 
   try {
     updateRunNumber();
@@ -614,12 +610,8 @@ void gem::supervisor::GEMSupervisor::startAction()
         }
       }
       // check that group state of *i has moved to desired state before continuing
-      while (m_globalState.compositeState(*i) != gem::base::STATE_RUNNING) {
-        DEBUG("GEMSupervisor::startAction waiting for group to reach Running: "
-              << m_globalState.compositeState(*i));
-        usleep(10);
-        m_globalState.update();
-      }
+      DEBUG("GEMSupervisor::startAction waiting for group to reach Running");
+      m_globalState.waitForCompositeState(*i, gem::base::STATE_RUNNING);
     }
   } catch (gem::supervisor::exception::Exception& e) {
     std::stringstream msg;
@@ -675,13 +667,14 @@ void gem::supervisor::GEMSupervisor::pauseAction()
 {
   INFO("GEMSupervisor::pauseAction start");
 
-  while (!(m_globalState.getStateName() == "Running" && getCurrentState() == "Pausing")) {
-    INFO("GEMSupervisor::pauseAction global state not in " << gem::base::STATE_RUNNING
-	 << " sleeping (" << m_globalState.getStateName() << ","
-	 << getCurrentState() << ")");
-    usleep(10);
-    m_globalState.update();
-  }
+  m_globalState.waitFor([this]() {
+      bool const ready = (m_globalState.getStateName() == "Running" && getCurrentState() == "Pausing");
+      if (!ready)
+        DEBUG("GEMSupervisor::pauseAction global state not in " << gem::base::STATE_RUNNING
+              << " sleeping (" << m_globalState.getStateName() << ","
+              << getCurrentState() << ")");
+      return ready;
+    });
 
   try {
     auto disableorder = getDisableOrder();
@@ -691,12 +684,8 @@ void gem::supervisor::GEMSupervisor::pauseAction()
         gem::utils::soap::GEMSOAPToolBox::sendCommand("Pause", p_appContext, p_appDescriptor, *j);
       }
       // check that group state of *i has moved to desired state before continuing
-      while (m_globalState.compositeState(*i) != gem::base::STATE_PAUSED) {
-        DEBUG("GEMSupervisor::pauseAction waiting for group to reach Paused: "
-              << m_globalState.compositeState(*i));
-        usleep(10);
-        m_globalState.update();
-      }
+      DEBUG("GEMSupervisor::pauseAction waiting for group to reach Paused");
+      m_globalState.waitForCompositeState(*i, gem::base::STATE_PAUSED);
     }
   } catch (gem::supervisor::exception::Exception& e) {
     std::stringstream msg;
@@ -752,13 +741,14 @@ void gem::supervisor::GEMSupervisor::resumeAction()
 {
   INFO("GEMSupervisor::resumeAction start");
 
-  while (!(m_globalState.getStateName() == "Paused" && getCurrentState() == "Resuming")) {
-    INFO("GEMSupervisor::pauseAction global state not in " << gem::base::STATE_PAUSED
-	 << " sleeping (" << m_globalState.getStateName() << ","
-	 << getCurrentState() << ")");
-    usleep(10);
-    m_globalState.update();
-  }
+  m_globalState.waitFor([this]() {
+      bool const ready = (m_globalState.getStateName() == "Paused" && getCurrentState() == "Resuming");
+      if (!ready)
+        DEBUG("GEMSupervisor::pauseAction global state not in " << gem::base::STATE_PAUSED
+              << " sleeping (" << m_globalState.getStateName() << ","
+              << getCurrentState() << ")");
+      return ready;
+    });
 
   try {
     auto resumeorder = getEnableOrder();
@@ -768,12 +758,8 @@ void gem::supervisor::GEMSupervisor::resumeAction()
         gem::utils::soap::GEMSOAPToolBox::sendCommand("Resume", p_appContext, p_appDescriptor, *j);
       }
       // check that group state of *i has moved to desired state before continuing
-      while (m_globalState.compositeState(*i) != gem::base::STATE_RUNNING) {
-        DEBUG("GEMSupervisor::resumeAction waiting for group to reach Running: "
-              << m_globalState.compositeState(*i));
-        usleep(10);
-        m_globalState.update();
-      }
+      DEBUG("GEMSupervisor::resumeAction waiting for group to reach Running");
+      m_globalState.waitForCompositeState(*i, gem::base::STATE_RUNNING);
     }
   } catch (gem::supervisor::exception::Exception& e) {
     std::stringstream msg;
@@ -829,15 +815,16 @@ void gem::supervisor::GEMSupervisor::stopAction()
 {
   INFO("GEMSupervisor::stopAction start");
 
-  while (!((m_globalState.getStateName() == "Running" && getCurrentState() == "Stopping") ||
-           (m_globalState.getStateName() == "Paused"  && getCurrentState() == "Stopping"))) {
-    INFO("GEMSupervisor::pauseAction global state not in " << gem::base::STATE_RUNNING
-	 << " or " << gem::base::STATE_PAUSED
-	 << " sleeping (" << m_globalState.getStateName() << ","
-	 << getCurrentState() << ")");
-    usleep(10);
-    m_globalState.update();
-  }
+  m_globalState.waitFor([this]() {
+      bool const ready = ((m_globalState.getStateName() == "Running" && getCurrentState() == "Stopping") ||
+                          (m_globalState.getStateName() == "Paused"  && getCurrentState() == "Stopping"));
+      if (!ready)
+        DEBUG("GEMSupervisor::pauseAction global state not in " << gem::base::STATE_RUNNING
+              << " or " << gem::base::STATE_PAUSED
+              << " sleeping (" << m_globalState.getStateName() << ","
+              << getCurrentState() << ")");
+      return ready;
+    });
 
   try {
     auto disableorder = getDisableOrder();
@@ -847,12 +834,8 @@ void gem::supervisor::GEMSupervisor::stopAction()
         gem::utils::soap::GEMSOAPToolBox::sendCommand("Stop", p_appContext, p_appDescriptor, *j);
       }
       // check that group state of *i has moved to desired state before continuing
-      while (m_globalState.compositeState(*i) != gem::base::STATE_CONFIGURED) {
-        DEBUG("GEMSupervisor::stopAction waiting for group to reach Configured: "
-              << m_globalState.compositeState(*i));
-        usleep(10);
-        m_globalState.update();
-      }
+      DEBUG("GEMSupervisor::stopAction waiting for group to reach Configured");
+      m_globalState.waitForCompositeState(*i, gem::base::STATE_CONFIGURED);
     }
   } catch (gem::supervisor::exception::Exception& e) {
     std::stringstream msg;
@@ -916,12 +899,8 @@ void gem::supervisor::GEMSupervisor::haltAction()
         gem::utils::soap::GEMSOAPToolBox::sendCommand("Halt", p_appContext, p_appDescriptor, *j);
       }
       // check that group state of *i has moved to desired state before continuing
-      while (m_globalState.compositeState(*i) != gem::base::STATE_HALTED) {
-        DEBUG("GEMSupervisor::haltAction waiting for group to reach Halted: "
-              << m_globalState.compositeState(*i));
-        usleep(10);
-        m_globalState.update();
-      }
+      DEBUG("GEMSupervisor::haltAction waiting for group to reach Halted");
+      m_globalState.waitForCompositeState(*i, gem::base::STATE_HALTED);
     }
   } catch (gem::supervisor::exception::Exception& e) {
     std::stringstream msg;
@@ -1330,24 +1309,26 @@ xoap::MessageReference gem::supervisor::GEMSupervisor::EndScanPoint(xoap::Messag
       INFO("GEMSupervisor::EndScanPoint ThresholdScan VT1 " << updatedParameter);
     }
 
-    while (!(m_globalState.getStateName() == "Running" && getCurrentState() == "Running")) {
-      TRACE("GEMSupervisor::EndScanPoint GlobalState = " << m_globalState.getStateName()
-	    << " FSM state " << getCurrentState());
-      usleep(10);
-      m_globalState.update();
-    }
+    m_globalState.waitFor([this]() {
+        bool const ready = (m_globalState.getStateName() == "Running" && getCurrentState() == "Running");
+        if (!ready)
+          TRACE("GEMSupervisor::EndScanPoint GlobalState = " << m_globalState.getStateName()
+                << " FSM state " << getCurrentState());
+        return ready;
+      });
 
     INFO("GEMSupervisor::EndScanPoint GlobalState = " << m_globalState.getStateName()
 	  << " FSM state " << getCurrentState()
 	  << " calling pauseAction");
     fireEvent("Pause");
 
-    while (!(m_globalState.getStateName() == "Paused" && getCurrentState() == "Paused")) {
-      TRACE("GEMSupervisor::EndScanPoint GlobalState = " << m_globalState.getStateName()
-	    << " FSM state " << getCurrentState());
-      usleep(10);
-      m_globalState.update();
-    }
+    m_globalState.waitFor([this]() {
+        bool const ready = (m_globalState.getStateName() == "Paused" && getCurrentState() == "Paused");
+        if (!ready)
+          TRACE("GEMSupervisor::EndScanPoint GlobalState = " << m_globalState.getStateName()
+                << " FSM state " << getCurrentState());
+        return ready;
+      });
 
     INFO("GEMSupervisor::EndScanPoint GlobalState = " << m_globalState.getStateName()
 	  << " FSM state " << getCurrentState()
@@ -1355,12 +1336,13 @@ xoap::MessageReference gem::supervisor::GEMSupervisor::EndScanPoint(xoap::Messag
     fireEvent("Resume");
 
     m_scanParameter = updatedParameter;
-    while (!(m_globalState.getStateName() == "Running" && getCurrentState() == "Running")) {
-      TRACE("GEMSupervisor::EndScanPoint GlobalState = " << m_globalState.getStateName()
-	    << " FSM state " << getCurrentState());
-      usleep(10);
-      m_globalState.update();
-    }
+    m_globalState.waitFor([this]() {
+        bool const ready = (m_globalState.getStateName() == "Running" && getCurrentState() == "Running");
+        if (!ready)
+          TRACE("GEMSupervisor::EndScanPoint GlobalState = " << m_globalState.getStateName()
+                << " FSM state " << getCurrentState());
+        return ready;
+      });
   } else {
     INFO("GEMSupervisor::EndScanPoint Scan Finished " << updatedParameter);
     INFO("GEMSupervisor::EndScanPoint GlobalState = " << m_globalState.getStateName()
@@ -1390,6 +1372,47 @@ xoap::MessageReference gem::supervisor::GEMSupervisor::EndScanPoint(xoap::Messag
   XCEPT_RAISE(xoap::exception::Exception,"command not found");
 }
 
+xoap::MessageReference gem::supervisor::GEMSupervisor::stateNotification(xoap::MessageReference msg)
+//  throw (xoap::exception::Exception)
+{
+  std::string commandName = "StateNotification";
+  try {
+    std::unordered_map<std::string, std::string> notification =
+      gem::utils::soap::GEMSOAPToolBox::extractStateNotification(msg);
+    DEBUG("GEMSupervisor::stateNotification " << notification.at("ClassName") << ":"
+          << notification.at("Instance") << " is now " << notification.at("StateName"));
+    m_globalState.applicationStateChanged(notification.at("ClassName"),
+                                          std::stoul(notification.at("Instance")),
+                                          notification.at("StateName"),
+                                          notification.at("StateMessage"));
+  } catch (xoap::exception::Exception& err) {
+    std::string msgBase = "Unable to parse the state notification";
+    WARN(toolbox::toString("%s: %s.", msgBase.c_str(), xcept::stdformat_exception(err).c_str()));
+    XCEPT_RETHROW(xoap::exception::Exception, msgBase, err);
+  } catch (std::exception& err) {
+    std::string msgBase = "Unable to parse the state notification";
+    WARN(toolbox::toString("%s: %s.", msgBase.c_str(), err.what()));
+    XCEPT_RAISE(xoap::exception::Exception, toolbox::toString("%s: %s.", msgBase.c_str(), err.what()));
+  }
+
+  try {
+    return
+      gem::utils::soap::GEMSOAPToolBox::makeSOAPReply(commandName, "Received");
+  } catch(xcept::Exception& err) {
+    std::string msgBase = toolbox::toString("Failed to create SOAP reply for command '%s'",
+                                            commandName.c_str());
+    ERROR(toolbox::toString("%s: %s.", msgBase.c_str(), xcept::stdformat_exception(err).c_str()));
+    XCEPT_RETHROW(xoap::exception::Exception, msgBase, err);
+  }
+}
+
+void gem::supervisor::GEMSupervisor::stateChanged(toolbox::fsm::FiniteStateMachine &fsm)
+{
+  gem::base::GEMFSMApplication::stateChanged(fsm);
+  // transitions wait on the supervisor FSM state as well as the global state
+  m_globalState.notifyStateUpdate();
+}
+
 /////////////////////////////////////////
 //* Order of transition operations*//
 /*
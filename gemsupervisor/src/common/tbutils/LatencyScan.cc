@@ -702,6 +702,11 @@ void gem::supervisor::tbutils::LatencyScan::configureAction(toolbox::Event::Refe
 
     confParams_.bag.deviceChipID = (*chip)->getChipID();
     (*chip)->setDeviceIPAddress(confParams_.bag.deviceIP);
+
+    // current register file in one transaction, the settings below are staged and
+    // only the registers that change are written, in one transaction
+    (*chip)->readShadowRegisters();
+    (*chip)->setShadowDeferred(true);
     (*chip)->setRunMode(0);
 
     TRACE("loading default settings");
@@ -745,6 +750,9 @@ void gem::supervisor::tbutils::LatencyScan::configureAction(toolbox::Event::Refe
     TRACE( "setting starting latency value");
     (*chip)->setLatency(    scanParams_.bag.minLatency);
 
+    TRACE( "writing the modified registers");
+    (*chip)->setShadowDeferred(false);
+
     TRACE( "reading back current latency value");
     currentLatency_ = (*chip)->getLatency();
 
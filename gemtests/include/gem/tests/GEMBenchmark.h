@@ -0,0 +1,89 @@
+/** @file GEMBenchmark.h */
+
+#ifndef GEM_TESTS_GEMBENCHMARK_H
+#define GEM_TESTS_GEMBENCHMARK_H
+
+#include <stdint.h>
+
+#include <functional>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace gem {
+  namespace tests {
+
+    /**
+     * @class GEMBenchmark
+     * @brief Times repeated iterations of a hot path and summarises them
+     *
+     * Each iteration is timed on its own, the latency percentiles are taken over the
+     * iterations and the rate over the operations (transactions, words, events) they report.
+     * The results are written as one JSON document so that runs can be compared by scripts.
+     */
+    class GEMBenchmark
+    {
+    public:
+      struct Result {
+        std::string name;
+        std::string unit;        ///< what is counted as one operation, e.g., "transactions"
+        uint64_t    iterations;
+        uint64_t    operations;
+        double      seconds;     ///< summed time of the timed iterations
+        double      meanUS;      ///< per iteration
+        double      p50US;
+        double      p99US;
+        double      maxUS;
+
+        double rate()           const { return seconds > 0 ? operations/seconds : 0.; };
+        double usPerOperation() const { return operations ? 1e6*seconds/operations : 0.; };
+      };
+
+      /**
+       * @brief one iteration of a benchmark
+       * @returns the number of operations done in the iteration
+       */
+      typedef std::function<uint64_t()> Iteration;
+
+      /**
+       * @param iterations number of timed iterations of each benchmark
+       * @param warmup number of untimed iterations run first
+       */
+      GEMBenchmark(size_t const& iterations, size_t const& warmup);
+
+      /**
+       * @brief runs and records one benchmark
+       * Exceptions thrown by the iteration are passed on, nothing is recorded in that case
+       */
+      Result const& run(std::string const& name, std::string const& unit, Iteration const& iteration);
+
+      std::vector<Result> const& results() const { return m_results; };
+
+      /**
+       * @brief writes {"context": {...}, "benchmarks": [...]}
+       * @param context free form key/value pairs describing the run, e.g., the target
+       */
+      void writeJSON(std::ostream& out, std::map<std::string, std::string> const& context) const;
+
+      /**
+       * @brief writes one line per benchmark for humans
+       */
+      void print(std::ostream& out) const;
+
+      /**
+       * @brief computes the summary of a set of iteration times, the samples are sorted
+       */
+      static Result summarise(std::string const& name, std::string const& unit,
+                              std::vector<double>& samplesUS, uint64_t const& operations);
+
+    private:
+      size_t m_iterations;
+      size_t m_warmup;
+
+      std::vector<Result> m_results;
+    };  // class GEMBenchmark
+  }  // namespace gem::tests
+}  // namespace gem
+
+#endif  // GEM_TESTS_GEMBENCHMARK_H
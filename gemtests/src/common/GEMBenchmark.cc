@@ -0,0 +1,124 @@
+/**
+ * class: GEMBenchmark
+ * description: timing and summary of the hot path benchmarks
+ */
+
+#include "gem/tests/GEMBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+
+namespace {
+  /**
+   * @returns the nearest-rank percentile of sorted samples
+   */
+  double percentile(std::vector<double> const& sorted, double const& fraction)
+  {
+    if (sorted.empty())
+      return 0.;
+    size_t rank = static_cast<size_t>(std::ceil(fraction*sorted.size()));
+    rank = std::min(std::max(rank, static_cast<size_t>(1)), sorted.size());
+    return sorted[rank - 1];
+  }
+
+  std::string escape(std::string const& text)
+  {
+    std::string escaped;
+    for (auto c = text.begin(); c != text.end(); ++c) {
+      if (*c == '"' || *c == '\\')
+        escaped += '\\';
+      escaped += *c;
+    }
+    return escaped;
+  }
+}
+
+gem::tests::GEMBenchmark::GEMBenchmark(size_t const& iterations, size_t const& warmup) :
+  m_iterations(std::max(iterations, static_cast<size_t>(1))),
+  m_warmup(warmup)
+{
+}
+
+gem::tests::GEMBenchmark::Result const& gem::tests::GEMBenchmark::run(std::string const& name,
+                                                                      std::string const& unit,
+                                                                      Iteration const& iteration)
+{
+  for (size_t n = 0; n < m_warmup; ++n)
+    iteration();
+
+  std::vector<double> samples;
+  samples.reserve(m_iterations);
+  uint64_t operations = 0;
+  for (size_t n = 0; n < m_iterations; ++n) {
+    std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+    operations += iteration();
+    samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+  }
+
+  m_results.push_back(summarise(name, unit, samples, operations));
+  return m_results.back();
+}
+
+gem::tests::GEMBenchmark::Result gem::tests::GEMBenchmark::summarise(std::string const& name,
+                                                                     std::string const& unit,
+                                                                     std::vector<double>& samplesUS,
+                                                                     uint64_t const& operations)
+{
+  Result result;
+  result.name       = name;
+  result.unit       = unit;
+  result.iterations = samplesUS.size();
+  result.operations = operations;
+
+  std::sort(samplesUS.begin(), samplesUS.end());
+  double total = 0.;
+  for (auto sample = samplesUS.begin(); sample != samplesUS.end(); ++sample)
+    total += *sample;
+  result.seconds = total*1e-6;
+  result.meanUS  = samplesUS.empty() ? 0. : total/samplesUS.size();
+  result.p50US   = percentile(samplesUS, 0.50);
+  result.p99US   = percentile(samplesUS, 0.99);
+  result.maxUS   = samplesUS.empty() ? 0. : samplesUS.back();
+  return result;
+}
+
+void gem::tests::GEMBenchmark::writeJSON(std::ostream& out, std::map<std::string, std::string> const& context) const
+{
+  out << "{\n  \"context\": {";
+  for (auto item = context.begin(); item != context.end(); ++item)
+    out << (item == context.begin() ? "" : ",") << "\n    \"" << escape(item->first) << "\": \""
+        << escape(item->second) << "\"";
+  out << "\n  },\n  \"benchmarks\": [";
+
+  std::ios::fmtflags const flags = out.flags();
+  out << std::setprecision(6);
+  for (auto result = m_results.begin(); result != m_results.end(); ++result)
+    out << (result == m_results.begin() ? "" : ",") << "\n    {"
+        << "\"name\": \""           << escape(result->name) << "\", "
+        << "\"unit\": \""           << escape(result->unit) << "\", "
+        << "\"iterations\": "       << result->iterations   << ", "
+        << "\"operations\": "       << result->operations   << ", "
+        << "\"seconds\": "          << result->seconds      << ", "
+        << "\"per_second\": "       << result->rate()       << ", "
+        << "\"us_per_operation\": " << result->usPerOperation() << ", "
+        << "\"mean_us\": "          << result->meanUS       << ", "
+        << "\"p50_us\": "           << result->p50US        << ", "
+        << "\"p99_us\": "           << result->p99US        << ", "
+        << "\"max_us\": "           << result->maxUS        << "}";
+  out << "\n  ]\n}" << std::endl;
+  out.flags(flags);
+}
+
+void gem::tests::GEMBenchmark::print(std::ostream& out) const
+{
+  std::ios::fmtflags const flags = out.flags();
+  out << std::fixed << std::setprecision(2);
+  for (auto result = m_results.begin(); result != m_results.end(); ++result)
+    out << std::left << std::setw(16) << result->name << std::right
+        << std::setw(14) << result->rate() << " " << result->unit << "/s"
+        << std::setw(12) << result->usPerOperation() << " us/op"
+        << "  p50 " << result->p50US << " us, p99 " << result->p99US << " us per iteration" << std::endl;
+  out.flags(flags);
+}
@@ -0,0 +1,457 @@
+/**
+ * gemBenchmark
+ * description: benchmarks of the register access, monitoring refresh, readout and event writing hot paths
+ *
+ * usage: gemBenchmark -a address_table [-c uri] [-n iterations] [-W warmup iterations] [-b benchmark,...]
+ *                     [-e events per readout iteration] [-k OptoHybrid] [-s slot file] [-l packet latency in us]
+ *                     [-o output JSON file]
+ * Without -c an in-process gemHwEmulator serving the address table is started on a free port,
+ * with -c the benchmarks run against that target, e.g., a crate or a uHAL dummy hardware.
+ * Benchmarks: readReg, readRegs, readBlock, monitor, readout, writer (all by default).
+ */
+
+#include <stdint.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "log4cplus/configurator.h"
+
+#include "xcept/Exception.h"
+#include "uhal/uhal.hpp"
+
+#include "gem/hw/emulator/GEMHwEmulatorModel.h"
+#include "gem/hw/emulator/IPbusUDPServer.h"
+#include "gem/hw/glib/HwGLIB.h"
+
+#include "gem/datachecker/GEMDataChecker.h"
+#include "gem/readout/GEMEventBuilder.h"
+#include "gem/readout/GEMEventWriter.h"
+#include "gem/readout/GEMVFATDecoder.h"
+#include "gem/readout/GEMslotContents.h"
+
+#include "gem/tests/GEMBenchmark.h"
+
+namespace {
+  typedef gem::hw::GEMHwDevice::RegisterHandle RegisterHandle;
+
+  // blocks read by the GLIBMonitor sets, relative to the device base node
+  const char* const MONITORED_NODES[] = {"GLIB_SYSTEM.SYSTEM", "TTC.CMD_COUNTERS", "DAQ"};
+
+  // registers read by the readRegs benchmark, relative to the device base node
+  const char* const STATUS_REGISTERS[] = {"GLIB_SYSTEM.SYSTEM.BOARD_ID", "GLIB_SYSTEM.SYSTEM.SYSTEM_ID",
+                                          "GLIB_SYSTEM.SYSTEM.FIRMWARE.ID", "GLIB_SYSTEM.SYSTEM.FIRMWARE.DATE",
+                                          "TTC.CMD_COUNTERS.L1A", "TTC.CMD_COUNTERS.BC0",
+                                          "TTC.CMD_COUNTERS.RESYNC", "DAQ.STATUS"};
+
+  const size_t MAX_EMPTY_POLLS = 1000;  ///< FIFO polls without data before a readout iteration gives up
+
+  struct BenchmarkConfig {
+    std::string addressTable;
+    std::string uri;
+    size_t      iterations;
+    size_t      warmup;
+    std::string benchmarks;
+    uint32_t    eventsPerIteration;
+    uint32_t    link;
+    std::string slotFile;
+    uint32_t    packetLatency;
+    std::string outputFile;
+  };
+
+  bool selected(BenchmarkConfig const& config, std::string const& name)
+  {
+    return config.benchmarks.empty() || ("," + config.benchmarks + ",").find("," + name + ",") != std::string::npos;
+  }
+
+  /**
+   * @returns the readable single registers below each node, as GEMHwMonitor::compileMonitorables resolves them
+   */
+  gem::hw::masked_register_pair_list monitoredRegisters(gem::hw::glib::HwGLIB& glib)
+  {
+    gem::hw::masked_register_pair_list registers;
+    uhal::HwInterface& hw = glib.getGEMHwInterface();
+    for (size_t n = 0; n < sizeof(MONITORED_NODES)/sizeof(MONITORED_NODES[0]); ++n) {
+      try {
+        uhal::Node const& top = hw.getNode(glib.getDeviceBaseNode() + "." + MONITORED_NODES[n]);
+        for (uhal::Node::const_iterator node = top.begin(); node != top.end(); ++node)
+          if (node->getMode() == uhal::defs::SINGLE && (node->getPermission() & uhal::defs::READ))
+            registers.push_back(std::make_pair(std::make_pair(node->getAddress(), node->getMask()), 0));
+      } catch (uhal::exception::exception const& e) {
+        std::cerr << "gemBenchmark: " << MONITORED_NODES[n] << " is not in the address table" << std::endl;
+      }
+    }
+    return registers;
+  }
+
+  RegisterHandle const& requireHandle(gem::hw::glib::HwGLIB& glib, std::string const& regName)
+  {
+    RegisterHandle const& handle = glib.getRegisterHandle(glib.getDeviceBaseNode(), regName);
+    if (!handle.valid)
+      throw std::runtime_error(regName + " is not in the address table");
+    return handle;
+  }
+
+  /**
+   * @brief hardware to file readout of one link: trigger a burst, drain the tracking data FIFO,
+   * decode, validate, build and write the events, as GEMDataParker::getGLIBData and GEMEventMaker do
+   */
+  class ReadoutChain
+  {
+  public:
+    ReadoutChain(gem::hw::glib::HwGLIB& glib, BenchmarkConfig const& config,
+                 std::shared_ptr<const gem::readout::GEMslotContents> const& slotContents) :
+      m_glib(glib),
+      m_nEvents(config.eventsPerIteration),
+      m_link(config.link),
+      p_slotContents(slotContents),
+      m_builder(gem::readout::GEMEventBuilder::DEFAULT_WINDOW, 0),
+      m_writer("Bin"),
+      m_nEventsWritten(0)
+    {
+      std::stringstream oh, fifo;
+      oh   << "OH.OH" << static_cast<int>(m_link) << ".T1Controller";
+      fifo << "TRK_DATA.OptoHybrid_" << static_cast<int>(m_link);
+      m_t1      = oh.str();
+      m_toggle  = &requireHandle(m_glib, m_t1 + ".TOGGLE");
+      m_depth   = &requireHandle(m_glib, fifo.str() + ".DEPTH");
+      m_fifo    = &requireHandle(m_glib, fifo.str() + ".FIFO");
+
+      // bursts of L1As from the T1 generator
+      m_glib.writeReg(m_glib.getDeviceBaseNode(), m_t1 + ".MODE",     0x0);
+      m_glib.writeReg(m_glib.getDeviceBaseNode(), m_t1 + ".TYPE",     0x0);
+      m_glib.writeReg(m_glib.getDeviceBaseNode(), m_t1 + ".NUMBER",   m_nEvents);
+      m_glib.writeReg(m_glib.getDeviceBaseNode(), m_t1 + ".INTERVAL", 0x1);
+      m_writer.open("/dev/null");
+    }
+
+    /**
+     * @returns the number of events written
+     */
+    uint64_t iteration()
+    {
+      m_glib.writeReg(*m_toggle, 0x1);
+      uint64_t const first = m_nEventsWritten;
+      size_t nBlocks    = 0;
+      size_t emptyPolls = 0;
+      // the burst has been read once the FIFO is empty again
+      while (emptyPolls < MAX_EMPTY_POLLS) {
+        uint32_t const depth = m_glib.readReg(*m_depth);
+        if (depth < gem::readout::GEMVFATDecoder::BLOCK_WORDS) {
+          if (nBlocks)
+            break;
+          ++emptyPolls;
+          continue;
+        }
+        m_words.resize(depth);
+        size_t const nWords = m_glib.readBlock(*m_fifo, m_words.data(), depth);
+
+        size_t skipped = 0;
+        m_batch.clear();
+        nBlocks += gem::readout::GEMVFATDecoder::decodeBuffer(m_words.data(), nWords, m_batch, skipped);
+        for (size_t block = 0; block < m_batch.size(); ++block) {
+          m_batch.get(block, m_vfat);
+          uint16_t const chipID = gem::readout::GEMVFATDecoder::chipID(m_vfat.ChipID);
+          // the emulator numbers its chips (OptoHybrid << 5) | slot
+          int const slot = p_slotContents ? p_slotContents->GEBslotIndex(chipID) : (chipID & 0x1f);
+          m_builder.addBlock(m_link, slot, gem::datachecker::GEMDataChecker::isCRCGood(m_vfat), m_vfat);
+          writeEvents();
+        }
+      }
+      m_builder.flush();
+      writeEvents();
+      return m_nEventsWritten - first;
+    }
+
+  private:
+    void writeEvents()
+    {
+      while (m_builder.popEvent(m_event)) {
+        if (m_event.vfats.empty())
+          continue;
+        m_geb.vfats.swap(m_event.vfats);
+        m_geb.header   = static_cast<uint64_t>(3*m_geb.vfats.size()) << 23;
+        m_geb.runhed   = 0;
+        m_geb.trailer  = 0;
+        m_gem.header1  = (0x1ull << 60) | (static_cast<uint64_t>(m_event.EC) << 32) |
+          (static_cast<uint64_t>(m_event.BC) << 20) | 0x1;
+        m_gem.header2  = (0x1ull << 56) | (0x1 << 16) | 0x1;
+        m_gem.header3  = (static_cast<uint64_t>(m_event.davMask) << 40) | (m_geb.vfats.size() << 11) | (0x1 << 8) | 0x1;
+        m_gem.trailer2 = 0;
+        m_gem.trailer1 = 0;
+        m_writer.writeGEMevent(m_gem, m_geb);
+        m_geb.vfats.swap(m_event.vfats);
+        ++m_nEventsWritten;
+      }
+    }
+
+    gem::hw::glib::HwGLIB& m_glib;
+    uint32_t               m_nEvents;
+    uint8_t                m_link;
+    std::string            m_t1;
+    RegisterHandle const*  m_toggle;
+    RegisterHandle const*  m_depth;
+    RegisterHandle const*  m_fifo;
+
+    std::shared_ptr<const gem::readout::GEMslotContents> p_slotContents;
+
+    std::vector<uint32_t>                  m_words;
+    gem::readout::VFATBlockBatch           m_batch;
+    gem::AMCVFATData                       m_vfat;
+    gem::readout::GEMEventBuilder          m_builder;
+    gem::readout::GEMEventBuilder::Event   m_event;
+    gem::AMCGEMData                        m_gem;
+    gem::AMCGEBData                        m_geb;
+    gem::readout::GEMEventWriter           m_writer;
+    uint64_t                               m_nEventsWritten;
+  };
+
+  /**
+   * @brief events of 24 VFAT blocks with random hits written in the "Bin" format
+   */
+  uint64_t writeSyntheticEvent(gem::readout::GEMEventWriter& writer, std::vector<gem::AMCGEBData> const& gebs,
+                       size_t& next)
+  {
+    gem::AMCGEMData gem;
+    gem.header1  = (0x1ull << 60) | (static_cast<uint64_t>(next & 0xffffff) << 32) | 0x1;
+    gem.header2  = 0x1;
+    gem.header3  = (0xffffffull << 40) | (24 << 11) | 0x1;
+    gem.trailer2 = 0;
+    gem.trailer1 = 0;
+    writer.writeGEMevent(gem, gebs[next++ % gebs.size()]);
+    return 1;
+  }
+
+  std::vector<gem::AMCGEBData> syntheticEvents(size_t const& nEvents)
+  {
+    std::vector<gem::AMCGEBData> gebs(nEvents);
+    uint64_t random = 0x5eed;
+    for (size_t event = 0; event < nEvents; ++event) {
+      gem::AMCGEBData& geb = gebs[event];
+      geb.header  = static_cast<uint64_t>(3*24) << 23;
+      geb.runhed  = 0;
+      geb.trailer = 0;
+      geb.vfats.resize(24);
+      for (size_t slot = 0; slot < geb.vfats.size(); ++slot) {
+        gem::AMCVFATData& vfat = geb.vfats[slot];
+        random ^= random >> 12; random ^= random << 25; random ^= random >> 27;
+        vfat.BC     = 0xa000 | (event & 0xfff);
+        vfat.EC     = 0xc000 | ((event & 0xff) << 4);
+        vfat.ChipID = 0xe000 | slot;
+        vfat.msData = random & (random >> 7);
+        vfat.lsData = random & (random >> 13);
+        vfat.BXfrOH = 0;
+        vfat.crc    = gem::datachecker::GEMDataChecker::checkCRC(vfat);
+      }
+    }
+    return gebs;
+  }
+
+  /**
+   * @brief runs one benchmark, a failure (e.g., a register missing from the address table) only skips it
+   */
+  void runBenchmark(std::string const& name, std::function<void()> const& benchmark)
+  {
+    try {
+      benchmark();
+    } catch (xcept::Exception const& e) {
+      std::cerr << "gemBenchmark: skipping " << name << ": " << e.what() << std::endl;
+    } catch (std::exception const& e) {
+      std::cerr << "gemBenchmark: skipping " << name << ": " << e.what() << std::endl;
+    }
+  }
+
+  void usage()
+  {
+    std::cerr << "usage: gemBenchmark -a address_table [-c uri] [-n iterations] [-W warmup iterations]"
+              << " [-b benchmark,...]" << std::endl
+              << "                    [-e events per readout iteration] [-k OptoHybrid] [-s slot file]"
+              << " [-l packet latency in us] [-o output JSON file]" << std::endl
+              << "benchmarks: readReg, readRegs, readBlock, monitor, readout, writer" << std::endl;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  log4cplus::BasicConfigurator logConfig;
+  logConfig.configure();
+  log4cplus::Logger logger = log4cplus::Logger::getInstance("gemBenchmark");
+  logger.setLogLevel(log4cplus::WARN_LOG_LEVEL);
+
+  BenchmarkConfig config;
+  config.iterations         = 1000;
+  config.warmup             = 100;
+  config.eventsPerIteration = 100;
+  config.link               = 0;
+  config.packetLatency      = 0;
+
+  int option;
+  while ((option = getopt(argc, argv, "a:c:n:W:b:e:k:s:l:o:h")) != -1) {
+    switch (option) {
+    case 'a':
+      config.addressTable = optarg;
+      break;
+    case 'c':
+      config.uri = optarg;
+      break;
+    case 'n':
+      config.iterations = std::strtoul(optarg, NULL, 10);
+      break;
+    case 'W':
+      config.warmup = std::strtoul(optarg, NULL, 10);
+      break;
+    case 'b':
+      config.benchmarks = optarg;
+      break;
+    case 'e':
+      config.eventsPerIteration = std::strtoul(optarg, NULL, 10);
+      break;
+    case 'k':
+      config.link = std::strtoul(optarg, NULL, 10);
+      break;
+    case 's':
+      config.slotFile = optarg;
+      break;
+    case 'l':
+      config.packetLatency = std::strtoul(optarg, NULL, 10);
+      break;
+    case 'o':
+      config.outputFile = optarg;
+      break;
+    default:
+      usage();
+      return 1;
+    }
+  }
+  if (config.addressTable.empty()) {
+    usage();
+    return 1;
+  }
+
+  std::map<std::string, std::string> context;
+  gem::tests::GEMBenchmark benchmark(config.iterations, config.warmup);
+  std::unique_ptr<gem::hw::emulator::GEMHwEmulatorModel> emulator;
+  std::unique_ptr<gem::hw::emulator::IPbusUDPServer>     server;
+  std::thread                                            serverThread;
+
+  try {
+    if (config.uri.empty()) {
+      emulator.reset(new gem::hw::emulator::GEMHwEmulatorModel(gem::hw::emulator::GEMHwEmulatorModel::Config(),
+                                                               logger));
+      emulator->addAddressTable(config.addressTable);
+      gem::hw::emulator::IPbusUDPServer::Latency latency;
+      latency.packet = config.packetLatency;
+      server.reset(new gem::hw::emulator::IPbusUDPServer(*emulator, 0, latency, logger));
+      std::stringstream uri;
+      uri << "ipbusudp-2.0://127.0.0.1:" << server->port();
+      config.uri   = uri.str();
+      serverThread = std::thread([&server]() { server->run(); });
+      context["target"] = "gemHwEmulator";
+      std::stringstream packetLatency;
+      packetLatency << config.packetLatency;
+      context["packet_latency_us"] = packetLatency.str();
+    } else {
+      context["target"] = "external";
+    }
+    context["uri"]           = config.uri;
+    context["address_table"] = config.addressTable;
+
+    gem::hw::glib::HwGLIB glib("gemBenchmark", config.uri, config.addressTable);
+    std::string const base = glib.getDeviceBaseNode();
+
+    if (selected(config, "readReg"))
+      runBenchmark("readReg", [&]() {
+          RegisterHandle const& reg = requireHandle(glib, STATUS_REGISTERS[0]);
+          benchmark.run("readReg", "transactions", [&glib, &reg]() { glib.readReg(reg); return 1; });
+          benchmark.run("readRegByName", "transactions", [&glib, &base]() {
+              glib.readReg(base, STATUS_REGISTERS[0]);
+              return 1;
+            });
+        });
+
+    if (selected(config, "readRegs"))
+      runBenchmark("readRegs", [&]() {
+          gem::hw::masked_register_pair_list registers;
+          for (size_t n = 0; n < sizeof(STATUS_REGISTERS)/sizeof(STATUS_REGISTERS[0]); ++n) {
+            RegisterHandle const& reg = glib.getRegisterHandle(base, STATUS_REGISTERS[n]);
+            if (reg.valid)
+              registers.push_back(std::make_pair(std::make_pair(reg.address, reg.mask), 0));
+          }
+          benchmark.run("readRegs", "transactions", [&glib, &registers]() {
+              glib.readRegs(registers, -1);
+              return registers.size();
+            });
+        });
+
+    if (selected(config, "readBlock"))
+      runBenchmark("readBlock", [&]() {
+          std::stringstream fifo;
+          fifo << "TRK_DATA.OptoHybrid_" << config.link << ".FIFO";
+          RegisterHandle const& reg = requireHandle(glib, fifo.str());
+          std::vector<uint32_t> buffer(gem::readout::GEMVFATDecoder::BLOCK_WORDS*256);
+          benchmark.run("readBlock", "words", [&glib, &reg, &buffer]() {
+              return glib.readBlock(reg, buffer.data(), buffer.size());
+            });
+        });
+
+    if (selected(config, "monitor"))
+      runBenchmark("monitor", [&]() {
+          // the hardware part of GLIBMonitor::updateMonitorables, the info space publication needs an executive
+          gem::hw::masked_register_pair_list registers = monitoredRegisters(glib);
+          benchmark.run("monitor", "registers", [&glib, &registers]() {
+              glib.readRegs(registers, -1);
+              return registers.size();
+            });
+        });
+
+    if (selected(config, "readout"))
+      runBenchmark("readout", [&]() {
+          std::shared_ptr<const gem::readout::GEMslotContents> slotContents;
+          if (!config.slotFile.empty())
+            slotContents = gem::readout::GEMslotContents::getSlotContents(config.slotFile);
+          ReadoutChain chain(glib, config, slotContents);
+          benchmark.run("readout", "events", [&chain]() { return chain.iteration(); });
+        });
+  } catch (xcept::Exception const& e) {
+    std::cerr << "gemBenchmark: unable to set up the target: " << e.what() << std::endl;
+  } catch (std::exception const& e) {
+    std::cerr << "gemBenchmark: unable to set up the target: " << e.what() << std::endl;
+  }
+
+  // software only
+  if (selected(config, "writer"))
+    runBenchmark("writer", [&]() {
+        gem::readout::GEMEventWriter writer("Bin");
+        writer.open("/dev/null");
+        std::vector<gem::AMCGEBData> const gebs = syntheticEvents(256);
+        size_t next = 0;
+        benchmark.run("writer", "events", [&writer, &gebs, &next]() {
+            return writeSyntheticEvent(writer, gebs, next);
+          });
+        writer.close();
+      });
+
+  if (server) {
+    server->stop();
+    serverThread.join();
+  }
+
+  benchmark.print(std::cerr);
+  if (config.outputFile.empty()) {
+    benchmark.writeJSON(std::cout, context);
+  } else {
+    std::ofstream output(config.outputFile.c_str());
+    benchmark.writeJSON(output, context);
+  }
+  return benchmark.results().empty() ? 1 : 0;
+}
@@ -0,0 +1,68 @@
+/** @file LatencyHistogram.h */
+
+#ifndef GEM_UTILS_LATENCYHISTOGRAM_H
+#define GEM_UTILS_LATENCYHISTOGRAM_H
+
+#include <stdint.h>
+
+#include <atomic>
+#include <ostream>
+
+namespace gem {
+  namespace utils {
+
+    /**
+     * @class LatencyHistogram
+     * @brief Lock free histogram of durations in power of two microsecond buckets
+     *
+     * Bucket 0 counts durations below 1us, bucket i those in [2^(i-1), 2^i) us,
+     * the last bucket everything longer.
+     * Any number of threads may record while another one reads, the reads are not a consistent
+     * snapshot but each counter is exact.
+     */
+    class LatencyHistogram
+    {
+    public:
+      static const unsigned N_BUCKETS = 24;
+
+      LatencyHistogram();
+
+      void record(uint64_t const& ns);
+
+      uint64_t count()   const { return m_count.load(std::memory_order_relaxed); };
+      uint64_t totalNs() const { return m_totalNs.load(std::memory_order_relaxed); };
+      uint64_t maxNs()   const { return m_maxNs.load(std::memory_order_relaxed); };
+      uint64_t bucket(unsigned const& i) const { return m_buckets[i].load(std::memory_order_relaxed); };
+
+      /**
+       * @returns the upper edge in us of the bucket containing the requested fraction of the entries,
+       *          0 if the histogram is empty
+       */
+      uint64_t percentileUS(double const& fraction) const;
+
+      /**
+       * @returns the upper edge in us of bucket i, the overflow bucket has none and returns the lower edge
+       */
+      static uint64_t bucketEdgeUS(unsigned const& i);
+
+      /**
+       * @brief writes {"count", "total_us", "max_us", "p50_us", "p99_us", "buckets_us"}
+       * The buckets are only the filled ones, as [upper edge, entries]
+       */
+      void writeJSON(std::ostream& out) const;
+
+      void reset();
+
+    private:
+      std::atomic<uint64_t> m_buckets[N_BUCKETS];
+      std::atomic<uint64_t> m_count;
+      std::atomic<uint64_t> m_totalNs;
+      std::atomic<uint64_t> m_maxNs;
+
+      LatencyHistogram(LatencyHistogram const&);
+      LatencyHistogram& operator=(LatencyHistogram const&);
+    };  // class LatencyHistogram
+  }  // namespace gem::utils
+}  // namespace gem
+
+#endif  // GEM_UTILS_LATENCYHISTOGRAM_H
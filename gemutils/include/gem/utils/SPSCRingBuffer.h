@@ -0,0 +1,185 @@
+/** @file SPSCRingBuffer.h */
+
+#ifndef GEM_UTILS_SPSCRINGBUFFER_H
+#define GEM_UTILS_SPSCRINGBUFFER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace gem {
+  namespace utils {
+
+    /**
+     * @class SPSCRingBuffer
+     * @brief Fixed capacity, lock-free, single-producer/single-consumer ring buffer
+     *
+     * One thread may push (e.g., the thread draining the hardware FIFO) while one other thread
+     * peeks and pops (e.g., the thread building the events), without locks or allocations.
+     * Elements are copied in and handed out in bulk, the consumer reads them in place through a
+     * Span, which may wrap around the end of the storage.
+     * The capacity is rounded up to a power of two.
+     */
+    template <typename T>
+      class SPSCRingBuffer
+      {
+      public:
+        /**
+         * @brief view of a contiguous range of elements in the buffer, split in two if it wraps around
+         */
+        class Span
+        {
+        public:
+          Span() : p_first(nullptr), m_firstSize(0), p_second(nullptr), m_secondSize(0) {};
+          Span(T const* first, size_t const& firstSize, T const* second, size_t const& secondSize) :
+            p_first(first), m_firstSize(firstSize), p_second(second), m_secondSize(secondSize) {};
+
+          size_t size()  const { return m_firstSize + m_secondSize; };
+          bool   empty() const { return size() == 0; };
+
+          T const& operator[](size_t const& i) const {
+            return (i < m_firstSize) ? p_first[i] : p_second[i - m_firstSize];
+          };
+
+        private:
+          T const* p_first;
+          size_t   m_firstSize;
+          T const* p_second;
+          size_t   m_secondSize;
+        };
+
+        /**
+         * @brief Constructor
+         * @param capacity minimum number of elements the buffer must hold
+         */
+        explicit SPSCRingBuffer(size_t const& capacity) :
+          m_capacity(roundUpPowerOfTwo(capacity)),
+          m_mask(m_capacity - 1),
+          p_storage(new T[m_capacity]),
+          m_head(0),
+          m_tailCache(0),
+          m_tail(0),
+          m_headCache(0)
+        {};
+
+        ~SPSCRingBuffer() {};
+
+        size_t capacity() const { return m_capacity; };
+
+        /**
+         * @brief number of elements in the buffer, exact when called from the producer or the consumer
+         */
+        size_t size() const {
+          return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+        };
+
+        bool empty() const { return size() == 0; };
+
+        /**
+         * @brief space left in the buffer, a lower bound when called from the producer
+         */
+        size_t available() const { return m_capacity - size(); };
+
+        /**
+         * @brief copies n elements into the buffer, producer only
+         * @returns false, without copying anything, if there is not enough space for all n elements
+         */
+        bool push(T const* data, size_t const& n) {
+          size_t const tail = m_tail.load(std::memory_order_relaxed);
+          if (m_capacity - (tail - m_headCache) < n) {
+            m_headCache = m_head.load(std::memory_order_acquire);
+            if (m_capacity - (tail - m_headCache) < n)
+              return false;
+          }
+
+          size_t const start = tail & m_mask;
+          size_t const first = std::min(n, m_capacity - start);
+          std::copy(data, data + first, p_storage.get() + start);
+          std::copy(data + first, data + n, p_storage.get());
+          m_tail.store(tail + n, std::memory_order_release);
+          return true;
+        };
+
+        /**
+         * @brief copies a whole contiguous container (e.g., std::vector) into the buffer, producer only
+         * @returns false, without copying anything, if there is not enough space for all elements
+         */
+        template <typename Container>
+          bool push(Container const& data) { return push(data.data(), data.size()); };
+
+        /**
+         * @brief gives access to the next n elements without removing them, consumer only
+         * @returns an empty Span if fewer than n elements are in the buffer
+         */
+        Span peek(size_t const& n) const {
+          size_t const head = m_head.load(std::memory_order_relaxed);
+          if (m_tailCache - head < n) {
+            m_tailCache = m_tail.load(std::memory_order_acquire);
+            if (m_tailCache - head < n)
+              return Span();
+          }
+
+          size_t const start = head & m_mask;
+          size_t const first = std::min(n, m_capacity - start);
+          return Span(p_storage.get() + start, first, p_storage.get(), n - first);
+        };
+
+        /**
+         * @brief returns the next element without removing it, consumer only, the buffer must not be empty
+         */
+        T const& front() const { return peek(1)[0]; };
+
+        /**
+         * @brief releases the next n elements, consumer only, n must not exceed the size
+         */
+        void pop(size_t const& n=1) {
+          m_head.store(m_head.load(std::memory_order_relaxed) + n, std::memory_order_release);
+        };
+
+        /**
+         * @brief drops all elements, must only be called when neither producer nor consumer are active
+         */
+        void clear() {
+          m_head.store(0, std::memory_order_relaxed);
+          m_tail.store(0, std::memory_order_relaxed);
+          m_headCache = 0;
+          m_tailCache = 0;
+        };
+
+      private:
+        static size_t roundUpPowerOfTwo(size_t const& n) {
+          size_t p = 1;
+          while (p < n)
+            p <<= 1;
+          return p;
+        };
+
+        // padding keeps the producer and consumer indices on separate cache lines,
+        // without requiring an over-aligned allocation of the owning object
+        static const size_t CACHE_LINE_SIZE = 64;
+
+        size_t const         m_capacity;
+        size_t const         m_mask;
+        std::unique_ptr<T[]> p_storage;
+        char m_padding0[CACHE_LINE_SIZE];
+
+        // consumer side, the head index and the last tail value seen by the consumer
+        std::atomic<size_t> m_head;
+        mutable size_t      m_tailCache;
+        char m_padding1[CACHE_LINE_SIZE];
+
+        // producer side, the tail index and the last head value seen by the producer
+        std::atomic<size_t> m_tail;
+        size_t              m_headCache;
+        char m_padding2[CACHE_LINE_SIZE];
+
+        // Prevent copying.
+        SPSCRingBuffer(SPSCRingBuffer const&);
+        SPSCRingBuffer& operator=(SPSCRingBuffer const&);
+      };
+
+  }  // namespace utils
+}  // namespace gem
+
+#endif  // GEM_UTILS_SPSCRINGBUFFER_H
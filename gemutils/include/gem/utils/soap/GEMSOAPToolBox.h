@@ -4,6 +4,7 @@
 #define GEM_UTILS_SOAP_GEMSOAPTOOLBOX_H
 
 // using the SOAP toolbox defined in the TCDS code base with extra functionality from the EMU codebase
+#include <functional>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -192,9 +193,7 @@ namespace gem {
               cs.addAttribute(tname, getXSDType(*s));
               cs.addTextNode(s->toString());
             }
-            std::string tool;
-            xoap::dumpTree(msg->getSOAPPart().getEnvelope().getDOMNode(),tool);
-            DEBUG("GEMSOAPToolBox::sendApplicationParameterBag: " << tool);
+            DEBUG("GEMSOAPToolBox::sendApplicationParameterBag: " << messageToString(msg));
             answer = appCxt->postSOAP(msg, *srcDsc, *destDsc);
           } catch (gem::utils::exception::Exception& e) {
             std::string errMsg = toolbox::toString("Send application parameter bag %s failed [%s] (gem::utils::exception::Exception)",
@@ -218,6 +217,7 @@ namespace gem {
 
         /**
          * @brief Creates a SOAP message requesting informtion about an application FSM state
+         * The message is a copy of one prebuilt per namespace tag and application URN
          * @param nstag Namespace tag to append to the parameter request
          * @param appURN URN of the application to send the request to
          * @param isGEMApp whether to query additional parameters that are only in GEM applications
@@ -227,6 +227,26 @@ namespace gem {
                                                                 std::string const& appURN,
                                                                 bool const& isGEMApp);
 
+        /**
+         * @brief Creates a SOAP message notifying a supervising application of an FSM state change
+         * @param className class name of the application whose state changed
+         * @param instance instance number of the application whose state changed
+         * @param stateName name of the new FSM state
+         * @param stateMessage state message of the application
+         * returns xoap::MessageReference to calling application
+         */
+        static xoap::MessageReference createStateNotificationMessage(std::string const& className,
+                                                                     uint32_t    const& instance,
+                                                                     std::string const& stateName,
+                                                                     std::string const& stateMessage);
+
+        /**
+         * @brief Extracts the contents of a message created by createStateNotificationMessage
+         * @param msg the received SOAP message
+         * returns a map of ClassName, Instance, StateName and StateMessage to their values
+         */
+        static std::unordered_map<std::string, std::string> extractStateNotification(xoap::MessageReference const& msg);
+
         /**
          * @brief Returns the FSM state from the given application
          * @param appCxt context in which the source/receiver applications are running
@@ -256,6 +276,15 @@ namespace gem {
          */
         static std::string getXSDType(xdata::Serializable const& item);
 
+        /**
+         * @brief Serializes the envelope of a SOAP message for logging
+         * Only call it inside the logging macros, which evaluate their message only when the logger is
+         * enabled for that level, so that nothing is serialized for the messages that are not logged
+         * @param msg the message to serialize
+         * returns std::string with the XML of the envelope
+         */
+        static std::string messageToString(xoap::MessageReference const& msg);
+
         // methods copied from emu/soap/toolbox
         /*
           xoap::MessageReference createMessage( const gem::utils::soap::QualifiedName &command,
@@ -282,6 +311,16 @@ namespace gem {
           const uint64_t timeoutInSec );
         */
       private:
+        /**
+         * @brief Returns a copy of the prebuilt message stored under key, building and storing it on first use
+         * The messages sent to and by the applications differ only by the command, the target class
+         * and a few values, so the copy of a prebuilt DOM replaces building the envelope on every call
+         * @param key identifies the message, e.g., the command name and the class of the target application
+         * @param build creates the message, only called the first time the key is requested
+         * returns xoap::MessageReference to a copy which the caller may modify
+         */
+        static xoap::MessageReference cloneMessageTemplate(std::string const& key,
+                                                           std::function<xoap::MessageReference()> const& build);
 
       protected:
         GEMSOAPToolBox();
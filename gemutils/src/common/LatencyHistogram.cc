@@ -0,0 +1,82 @@
+/**
+ * class: LatencyHistogram
+ * description: lock free histogram of durations in power of two microsecond buckets
+ */
+
+#include "gem/utils/LatencyHistogram.h"
+
+const unsigned gem::utils::LatencyHistogram::N_BUCKETS;
+
+gem::utils::LatencyHistogram::LatencyHistogram()
+{
+  reset();
+}
+
+void gem::utils::LatencyHistogram::record(uint64_t const& ns)
+{
+  uint64_t const us = ns/1000;
+  unsigned bin = us ? 1 + (63 - __builtin_clzll(us)) : 0;
+  if (bin > N_BUCKETS - 1)
+    bin = N_BUCKETS - 1;
+
+  m_buckets[bin].fetch_add(1, std::memory_order_relaxed);
+  m_count.fetch_add(1, std::memory_order_relaxed);
+  m_totalNs.fetch_add(ns, std::memory_order_relaxed);
+  uint64_t max = m_maxNs.load(std::memory_order_relaxed);
+  while (ns > max && !m_maxNs.compare_exchange_weak(max, ns, std::memory_order_relaxed))
+    ;
+}
+
+uint64_t gem::utils::LatencyHistogram::percentileUS(double const& fraction) const
+{
+  // the buckets are read one by one while others may record, the result is approximate anyway
+  uint64_t total = 0;
+  for (unsigned i = 0; i < N_BUCKETS; ++i)
+    total += bucket(i);
+  if (!total)
+    return 0;
+
+  uint64_t const rank = static_cast<uint64_t>(fraction*total + 0.5);
+  uint64_t seen = 0;
+  for (unsigned i = 0; i < N_BUCKETS; ++i) {
+    seen += bucket(i);
+    if (seen >= rank && seen)
+      return bucketEdgeUS(i);
+  }
+  return bucketEdgeUS(N_BUCKETS - 1);
+}
+
+uint64_t gem::utils::LatencyHistogram::bucketEdgeUS(unsigned const& i)
+{
+  if (i >= N_BUCKETS - 1)
+    return 1ULL << (N_BUCKETS - 2);
+  return 1ULL << i;
+}
+
+void gem::utils::LatencyHistogram::writeJSON(std::ostream& out) const
+{
+  out << "{\"count\": " << count()
+      << ", \"total_us\": " << totalNs()/1000
+      << ", \"max_us\": "   << maxNs()/1000
+      << ", \"p50_us\": "   << percentileUS(0.50)
+      << ", \"p99_us\": "   << percentileUS(0.99)
+      << ", \"buckets_us\": [";
+  bool first = true;
+  for (unsigned i = 0; i < N_BUCKETS; ++i) {
+    uint64_t const entries = bucket(i);
+    if (!entries)
+      continue;
+    out << (first ? "" : ", ") << "[" << bucketEdgeUS(i) << ", " << entries << "]";
+    first = false;
+  }
+  out << "]}";
+}
+
+void gem::utils::LatencyHistogram::reset()
+{
+  for (unsigned i = 0; i < N_BUCKETS; ++i)
+    m_buckets[i].store(0, std::memory_order_relaxed);
+  m_count.store(0, std::memory_order_relaxed);
+  m_totalNs.store(0, std::memory_order_relaxed);
+  m_maxNs.store(0, std::memory_order_relaxed);
+}
@@ -1,15 +1,57 @@
 #include <gem/utils/soap/GEMSOAPToolBox.h>
 
+#include <mutex>
+
+namespace {
+  /**
+   * Prebuilt messages, the DOM of a stored message is only ever read (when copied) while holding the mutex
+   */
+  std::mutex                                              templateMutex;
+  std::unordered_map<std::string, xoap::MessageReference> messageTemplates;
+
+  /**
+   * @returns the element depth levels below the SOAP body, following the first child element on each level
+   */
+  xoap::SOAPElement firstBodyElement(xoap::MessageReference const& msg, size_t const& depth)
+  {
+    xoap::SOAPElement element = msg->getSOAPPart().getEnvelope().getBody().getChildElements().at(0);
+    for (size_t level = 1; level < depth; ++level)
+      element = element.getChildElements().at(0);
+    return element;
+  }
+}
+
+xoap::MessageReference gem::utils::soap::GEMSOAPToolBox::cloneMessageTemplate(std::string const& key,
+                                                                              std::function<xoap::MessageReference()> const& build)
+{
+  std::lock_guard<std::mutex> guard(templateMutex);
+  auto stored = messageTemplates.find(key);
+  if (stored == messageTemplates.end()) {
+    log4cplus::Logger m_gemLogger(log4cplus::Logger::getInstance("GEMSOAPToolBoxLogger"));
+    DEBUG("GEMSOAPToolBox::cloneMessageTemplate building template '" << key << "'");
+    stored = messageTemplates.emplace(key, build()).first;
+  }
+  return xoap::createMessage(stored->second);
+}
+
+std::string gem::utils::soap::GEMSOAPToolBox::messageToString(xoap::MessageReference const& msg)
+{
+  std::string tool;
+  xoap::dumpTree(msg->getSOAPPart().getEnvelope().getDOMNode(), tool);
+  return tool;
+}
+
 xoap::MessageReference gem::utils::soap::GEMSOAPToolBox::makeSOAPReply(std::string const& command,
                                                                        std::string const& response)
 {
-  log4cplus::Logger m_gemLogger(log4cplus::Logger::getInstance("GEMSOAPToolBoxLogger"));
-  xoap::MessageReference reply        = xoap::createMessage();
-  xoap::SOAPEnvelope     envelope     = reply->getSOAPPart().getEnvelope();
-  xoap::SOAPName         responseName = envelope.createName(command, "xdaq", XDAQ_NS_URI);
-  xoap::SOAPElement      bodyElement  = envelope.getBody().addBodyElement(responseName);
-  bodyElement.addTextNode(response);
-  return reply;
+  return cloneMessageTemplate("Reply:" + command + ":" + response, [&]() {
+      xoap::MessageReference reply        = xoap::createMessage();
+      xoap::SOAPEnvelope     envelope     = reply->getSOAPPart().getEnvelope();
+      xoap::SOAPName         responseName = envelope.createName(command, "xdaq", XDAQ_NS_URI);
+      xoap::SOAPElement      bodyElement  = envelope.getBody().addBodyElement(responseName);
+      bodyElement.addTextNode(response);
+      return reply;
+    });
 }
 
 xoap::MessageReference gem::utils::soap::GEMSOAPToolBox::makeSOAPFaultReply(std::string const& faultString,
@@ -50,33 +92,23 @@ xoap::MessageReference gem::utils::soap::GEMSOAPToolBox::makeFSMSOAPReply(std::s
                                                                           std::string const& state)
 {
   log4cplus::Logger m_gemLogger(log4cplus::Logger::getInstance("GEMSOAPToolBoxLogger"));
-  // xoap::MessageFactory* messageFactory = xoap::MessageFactory::getInstance(soapProtocolVersion);
-  xoap::MessageReference reply           = xoap::createMessage();
-  xoap::SOAPEnvelope     envelope        = reply->getSOAPPart().getEnvelope();
-  xoap::SOAPBody         body            = envelope.getBody();
-  std::string            responseString  = event + "Response";
-  TRACE("GEMSOAPToolBox::makeFSMSOAPReply responseString "
-            << responseString);
-  xoap::SOAPName         responseName    = envelope.createName(responseString, "xdaq", XDAQ_NS_URI);
-  TRACE("GEMSOAPToolBox::makeFSMSOAPReply responseName "
-            << responseName.getLocalName());
-  xoap::SOAPBodyElement  responseElement = body.addBodyElement(responseName);
-  TRACE("GEMSOAPToolBox::makeFSMSOAPReply responseElement "
-            << responseElement.getTextContent());
-  xoap::SOAPName         stateName       = envelope.createName("state", "xdaq", XDAQ_NS_URI);
-  TRACE("GEMSOAPToolBox::makeFSMSOAPReply stateName "
-            << stateName.getLocalName());
-  xoap::SOAPElement      stateElement    = responseElement.addChildElement(stateName);
-  TRACE("GEMSOAPToolBox::makeFSMSOAPReply stateElement"
-            << stateElement.getTextContent());
-  xoap::SOAPName         attributeName   = envelope.createName("stateName", "xdaq", XDAQ_NS_URI);
-  TRACE("GEMSOAPToolBox::makeFSMSOAPReplyattributeName "
-            << attributeName.getLocalName());
-  stateElement.addAttribute(attributeName, state);
-  DEBUG("GEMSOAPToolBox::makeFSMSOAPReply reply ");
-  std::string tool;
-  reply->writeTo(tool);
-  DEBUG(tool);
+  xoap::MessageReference reply = cloneMessageTemplate("FSMReply:" + event + ":" + state, [&]() {
+      // xoap::MessageFactory* messageFactory = xoap::MessageFactory::getInstance(soapProtocolVersion);
+      xoap::MessageReference msg             = xoap::createMessage();
+      xoap::SOAPEnvelope     envelope        = msg->getSOAPPart().getEnvelope();
+      xoap::SOAPBody         body            = envelope.getBody();
+      std::string            responseString  = event + "Response";
+      TRACE("GEMSOAPToolBox::makeFSMSOAPReply responseString "
+                << responseString);
+      xoap::SOAPName         responseName    = envelope.createName(responseString, "xdaq", XDAQ_NS_URI);
+      xoap::SOAPBodyElement  responseElement = body.addBodyElement(responseName);
+      xoap::SOAPName         stateName       = envelope.createName("state", "xdaq", XDAQ_NS_URI);
+      xoap::SOAPElement      stateElement    = responseElement.addChildElement(stateName);
+      xoap::SOAPName         attributeName   = envelope.createName("stateName", "xdaq", XDAQ_NS_URI);
+      stateElement.addAttribute(attributeName, state);
+      return msg;
+    });
+  DEBUG("GEMSOAPToolBox::makeFSMSOAPReply reply " << messageToString(reply));
   return reply;
 }
 
@@ -113,37 +145,33 @@ bool gem::utils::soap::GEMSOAPToolBox::sendCommand(std::string const& cmd,
 {
   log4cplus::Logger m_gemLogger(log4cplus::Logger::getInstance("GEMSOAPToolBoxLogger"));
   try {
-    xoap::MessageReference msg = xoap::createMessage();
-
-    xoap::SOAPEnvelope env = msg->getSOAPPart().getEnvelope();
-    xoap::SOAPName soapcmd = env.createName(cmd, "xdaq", XDAQ_NS_URI);
-    xoap::SOAPElement cont = env.getBody().addBodyElement(soapcmd);
-
     DEBUG("GEMSOAPToolBox::sendCommand '" << cmd << "'"
           << " in '"   << appCxt->getContextDescriptor()->getURL() << "'"
           << " from '" << srcDsc->getClassName() << "'"
           << " to '"   << destDsc->getClassName() << "'");
 
-    if (destDsc->getClassName().find("tcds") != std::string::npos) {
-      xoap::SOAPName cmdtype = env.createName("actionRequestorId", "xdaq", srcDsc->getClassName());
-      std::stringstream tcdscmd;
-      tcdscmd << cmd << " xdaq:actionRequestorId=\""
-              << srcDsc->getClassName() << "\"";
-      DEBUG("GEMSOAPToolBox::sendTCDSCommand '" << tcdscmd.str() << "'" << " to '" << destDsc->getClassName() << "'");
-      cont.addAttribute(cmdtype,srcDsc->getClassName());
-    }
+    std::string const key = "Command:" + cmd + ":" + srcDsc->getClassName() + ":" + destDsc->getClassName();
+    xoap::MessageReference msg = cloneMessageTemplate(key, [&]() {
+        xoap::MessageReference tmpl = xoap::createMessage();
+
+        xoap::SOAPEnvelope env = tmpl->getSOAPPart().getEnvelope();
+        xoap::SOAPName soapcmd = env.createName(cmd, "xdaq", XDAQ_NS_URI);
+        xoap::SOAPElement cont = env.getBody().addBodyElement(soapcmd);
+
+        if (destDsc->getClassName().find("tcds") != std::string::npos) {
+          xoap::SOAPName cmdtype = env.createName("actionRequestorId", "xdaq", srcDsc->getClassName());
+          DEBUG("GEMSOAPToolBox::sendTCDSCommand '" << cmd << " xdaq:actionRequestorId=\""
+                << srcDsc->getClassName() << "\"'" << " to '" << destDsc->getClassName() << "'");
+          cont.addAttribute(cmdtype,srcDsc->getClassName());
+        }
+        return tmpl;
+      });
 
-    std::string tool;
-    // xoap::dumpTree(msg->getSOAPPart().getEnvelope().getDOMNode(),tool);
-    msg->writeTo(tool);
-    DEBUG("GEMSOAPToolBox::sendCommand '" << cmd << "': SOAP msg " << tool);
+    DEBUG("GEMSOAPToolBox::sendCommand '" << cmd << "': SOAP msg " << messageToString(msg));
     // BUG FIXME: if this throws, we get a terminate, why???
-    tool.clear();
 
     xoap::MessageReference reply = appCxt->postSOAP(msg, *srcDsc, *destDsc);
-    // xoap::dumpTree(reply->getSOAPPart().getEnvelope().getDOMNode(),tool);
-    reply->writeTo(tool);
-    DEBUG("GEMSOAPToolBox::sendCommand '" << cmd << "': SOAP reply " << tool);
+    DEBUG("GEMSOAPToolBox::sendCommand '" << cmd << "': SOAP reply " << messageToString(reply));
   } catch (xdaq::exception::Exception& e) {
     std::string errMsg = toolbox::toString("Command %s failed [%s]", cmd.c_str(), e.what());
     XCEPT_RETHROW(gem::utils::exception::SOAPException, errMsg, e);
@@ -171,36 +199,32 @@ bool gem::utils::soap::GEMSOAPToolBox::sendTCDSCommand(std::string const& cmd,
 {
   log4cplus::Logger m_gemLogger(log4cplus::Logger::getInstance("GEMSOAPToolBoxLogger"));
   try {
-    xoap::MessageReference msg = xoap::createMessage();
-
-    xoap::SOAPEnvelope env = msg->getSOAPPart().getEnvelope();
-    xoap::SOAPName soapcmd = env.createName(cmd, "xdaq", XDAQ_NS_URI);
-    xoap::SOAPElement cont = env.getBody().addBodyElement(soapcmd);
-
     DEBUG("GEMSOAPToolBox::sendTCDSCommand '" << cmd << "'"
           << " in '"   << appCxt->getContextDescriptor()->getURL() << "'"
           << " from '" << srcDsc->getClassName() << "'"
           << " to '"   << destDsc->getClassName() << "'");
 
-    if (destDsc->getClassName().find("tcds") != std::string::npos) {
-      xoap::SOAPName cmdtype = env.createName("actionRequestorId", "xdaq", srcDsc->getClassName());
-      std::stringstream tcdscmd;
-      tcdscmd << cmd << " xdaq:actionRequestorId=\""
-              << srcDsc->getClassName() << "\"";
-      DEBUG("GEMSOAPToolBox::sendTCDSCommand '" << tcdscmd.str() << "'" << " to '" << destDsc->getClassName() << "'");
-      cont.addAttribute(cmdtype,"");
-    }
+    std::string const key = "TCDSCommand:" + cmd + ":" + srcDsc->getClassName() + ":" + destDsc->getClassName();
+    xoap::MessageReference msg = cloneMessageTemplate(key, [&]() {
+        xoap::MessageReference tmpl = xoap::createMessage();
+
+        xoap::SOAPEnvelope env = tmpl->getSOAPPart().getEnvelope();
+        xoap::SOAPName soapcmd = env.createName(cmd, "xdaq", XDAQ_NS_URI);
+        xoap::SOAPElement cont = env.getBody().addBodyElement(soapcmd);
+
+        if (destDsc->getClassName().find("tcds") != std::string::npos) {
+          xoap::SOAPName cmdtype = env.createName("actionRequestorId", "xdaq", srcDsc->getClassName());
+          DEBUG("GEMSOAPToolBox::sendTCDSCommand '" << cmd << " xdaq:actionRequestorId=\""
+                << srcDsc->getClassName() << "\"'" << " to '" << destDsc->getClassName() << "'");
+          cont.addAttribute(cmdtype,"");
+        }
+        return tmpl;
+      });
 
-    std::string tool;
-    // xoap::dumpTree(msg->getSOAPPart().getEnvelope().getDOMNode(),tool);
-    msg->writeTo(tool);
-    INFO("GEMSOAPToolBox::sendTCDSCommand '" << cmd << "': SOAP msg " << tool);
-    tool.clear();
+    INFO("GEMSOAPToolBox::sendTCDSCommand '" << cmd << "': SOAP msg " << messageToString(msg));
 
     xoap::MessageReference reply = appCxt->postSOAP(msg, *srcDsc, *destDsc);
-    // xoap::dumpTree(reply->getSOAPPart().getEnvelope().getDOMNode(),tool);
-    reply->writeTo(tool);
-    INFO("GEMSOAPToolBox::sendTCDSCommand '" << cmd << "': SOAP reply " << tool);
+    INFO("GEMSOAPToolBox::sendTCDSCommand '" << cmd << "': SOAP reply " << messageToString(reply));
   } catch (xdaq::exception::Exception& e) {
     std::string errMsg = toolbox::toString("Command %s failed [%s]", cmd.c_str(), e.what());
     XCEPT_RETHROW(gem::utils::exception::SOAPException, errMsg, e);
@@ -230,37 +254,36 @@ bool gem::utils::soap::GEMSOAPToolBox::sendParameter(std::vector<std::string> co
     return false;
 
   try {
-    xoap::MessageReference msg = xoap::createMessage();
-
-    xoap::SOAPEnvelope env       = msg->getSOAPPart().getEnvelope();
-    xoap::SOAPName     soapcmd   = env.createName("ParameterSet", "xdaq", XDAQ_NS_URI);
-    xoap::SOAPElement  container = env.getBody().addBodyElement(soapcmd);
-
-    // from hcal supervisor
-    env.addNamespaceDeclaration("xsd", "http://www.w3.org/2001/XMLSchema");
-    env.addNamespaceDeclaration("xsi", "http://www.w3.org/2001/XMLSchema-instance");
-    env.addNamespaceDeclaration("soapenc", "http://schemas.xmlsoap.org/soap/encoding/");
-    xoap::SOAPName    type       = env.createName("type", "xsi", "http://www.w3.org/2001/XMLSchema-instance");
-    std::string       appURN     = "urn:xdaq-application:"+destDsc->getClassName();
-    xoap::SOAPName    properties = env.createName("properties", "props", appURN);
-    xoap::SOAPElement property   = container.addChildElement(properties);
-    property.addAttribute(type, "soapenc:Struct");
-    xoap::SOAPName    cfgStyleName = env.createName(parameter.at(0), "props", appURN);
-    xoap::SOAPElement cs           = property.addChildElement(cfgStyleName);
-    cs.addAttribute(type, parameter.at(2));
-    cs.addTextNode(parameter.at(1));
-    // end from hcal supervisor
-
-    std::string tool;
-    // xoap::dumpTree(msg->getSOAPPart().getEnvelope().getDOMNode(),tool);
-    msg->writeTo(tool);
-    INFO("GEMSOAPToolBox::sendParameter SOAP msg " << tool);
-    tool.clear();
+    std::string const key = "Parameter:" + destDsc->getClassName() + ":" + parameter.at(0) + ":" + parameter.at(2);
+    xoap::MessageReference msg = cloneMessageTemplate(key, [&]() {
+        xoap::MessageReference tmpl = xoap::createMessage();
+
+        xoap::SOAPEnvelope env       = tmpl->getSOAPPart().getEnvelope();
+        xoap::SOAPName     soapcmd   = env.createName("ParameterSet", "xdaq", XDAQ_NS_URI);
+        xoap::SOAPElement  container = env.getBody().addBodyElement(soapcmd);
+
+        // from hcal supervisor
+        env.addNamespaceDeclaration("xsd", "http://www.w3.org/2001/XMLSchema");
+        env.addNamespaceDeclaration("xsi", "http://www.w3.org/2001/XMLSchema-instance");
+        env.addNamespaceDeclaration("soapenc", "http://schemas.xmlsoap.org/soap/encoding/");
+        xoap::SOAPName    type       = env.createName("type", "xsi", "http://www.w3.org/2001/XMLSchema-instance");
+        std::string       appURN     = "urn:xdaq-application:"+destDsc->getClassName();
+        xoap::SOAPName    properties = env.createName("properties", "props", appURN);
+        xoap::SOAPElement property   = container.addChildElement(properties);
+        property.addAttribute(type, "soapenc:Struct");
+        xoap::SOAPName    cfgStyleName = env.createName(parameter.at(0), "props", appURN);
+        xoap::SOAPElement cs           = property.addChildElement(cfgStyleName);
+        cs.addAttribute(type, parameter.at(2));
+        // end from hcal supervisor
+        return tmpl;
+      });
+    // ParameterSet/properties/<parameter>
+    firstBodyElement(msg, 3).addTextNode(parameter.at(1));
+
+    INFO("GEMSOAPToolBox::sendParameter SOAP msg " << messageToString(msg));
 
     xoap::MessageReference reply = appCxt->postSOAP(msg, *srcDsc, *destDsc);
-    // xoap::dumpTree(reply->getSOAPPart().getEnvelope().getDOMNode(),tool);
-    reply->writeTo(tool);
-    INFO("GEMSOAPToolBox::sendParameter SOAP msg " << tool);
+    INFO("GEMSOAPToolBox::sendParameter SOAP msg " << messageToString(reply));
   } catch (xdaq::exception::Exception& e) {
     std::string errMsg = toolbox::toString("Send Parameter %s failed [%s]", parameter.at(0).c_str(), e.what());
     XCEPT_RETHROW(gem::utils::exception::SOAPException, errMsg, e);
@@ -308,23 +331,20 @@ bool gem::utils::soap::GEMSOAPToolBox::sendCommandWithParameter(std::string cons
 {
   log4cplus::Logger m_gemLogger(log4cplus::Logger::getInstance("GEMSOAPToolBoxLogger"));
   try {
-    xoap::MessageReference msg = xoap::createMessage();
+    xoap::MessageReference msg = cloneMessageTemplate("CommandWithParameter:" + cmd, [&]() {
+        xoap::MessageReference tmpl = xoap::createMessage();
 
-    xoap::SOAPEnvelope env = msg->getSOAPPart().getEnvelope();
-    xoap::SOAPName soapcmd = env.createName(cmd, "xdaq", XDAQ_NS_URI);
-    xoap::SOAPBodyElement paramValue = env.getBody().addBodyElement(soapcmd);
-    paramValue.addTextNode(toolbox::toString("%d", parameter));
+        xoap::SOAPEnvelope env = tmpl->getSOAPPart().getEnvelope();
+        xoap::SOAPName soapcmd = env.createName(cmd, "xdaq", XDAQ_NS_URI);
+        env.getBody().addBodyElement(soapcmd);
+        return tmpl;
+      });
+    firstBodyElement(msg, 1).addTextNode(toolbox::toString("%d", parameter));
 
-    std::string tool;
-    // xoap::dumpTree(msg->getSOAPPart().getEnvelope().getDOMNode(),tool);
-    msg->writeTo(tool);
-    INFO("GEMSOAPToolBox::sendCommandWithParameter SOAP msg " << tool);
-    tool.clear();
+    INFO("GEMSOAPToolBox::sendCommandWithParameter SOAP msg " << messageToString(msg));
 
     xoap::MessageReference reply = appCxt->postSOAP(msg, *srcDsc, *destDsc);
-    // xoap::dumpTree(reply->getSOAPPart().getEnvelope().getDOMNode(),tool);
-    reply->writeTo(tool);
-    INFO("GEMSOAPToolBox::sendCommandWithParameter SOAP msg " << tool);
+    INFO("GEMSOAPToolBox::sendCommandWithParameter SOAP msg " << messageToString(reply));
   } catch (xdaq::exception::Exception& e) {
     std::string errMsg = toolbox::toString("Sending parameter %s (value %d) failed [%s]", cmd.c_str(), parameter, e.what());
     XCEPT_RETHROW(gem::utils::exception::SOAPException,errMsg, e);
@@ -404,16 +424,10 @@ bool gem::utils::soap::GEMSOAPToolBox::sendCommandWithParameterBag(std::string c
             << elem->getChildElements().size() << " subchildren");
     }
 
-    std::string tool;
-    xoap::dumpTree(msg->getSOAPPart().getEnvelope().getDOMNode(),tool);
-    // msg->writeTo(tool);
-    INFO("GEMSOAPToolBox::sendCommandWithParameterBag: SOAP message is: " << tool);
-    tool.clear();
+    INFO("GEMSOAPToolBox::sendCommandWithParameterBag: SOAP message is: " << messageToString(msg));
 
     reply = appCxt->postSOAP(msg, *srcDsc, *destDsc);
-    xoap::dumpTree(reply->getSOAPPart().getEnvelope().getDOMNode(),tool);
-    // reply->writeTo(tool);
-    INFO("GEMSOAPToolBox::sendCommandWithParameterBag: SOAP reply is" << tool);
+    INFO("GEMSOAPToolBox::sendCommandWithParameterBag: SOAP reply is" << messageToString(reply));
   } catch (gem::utils::exception::Exception& e) {
     std::string errMsg = toolbox::toString("Send command with parameter bag failed [%s]", e.what());
     XCEPT_RETHROW(gem::utils::exception::SOAPException, errMsg, e);
@@ -445,34 +459,33 @@ bool gem::utils::soap::GEMSOAPToolBox::sendApplicationParameter(std::string cons
 {
   log4cplus::Logger m_gemLogger(log4cplus::Logger::getInstance("GEMSOAPToolBoxLogger"));
   try {
-    xoap::MessageReference msg = xoap::createMessage(), reply;
+    std::string const key = "ApplicationParameter:" + destDsc->getClassName() + ":" + parName + ":" + parType;
+    xoap::MessageReference msg = cloneMessageTemplate(key, [&]() {
+        xoap::MessageReference tmpl = xoap::createMessage();
+
+        xoap::SOAPEnvelope env       = tmpl->getSOAPPart().getEnvelope();
+        xoap::SOAPName     soapcmd   = env.createName("ParameterSet", "xdaq", XDAQ_NS_URI);
+        xoap::SOAPElement  container = env.getBody().addBodyElement(soapcmd);
+        env.addNamespaceDeclaration("xsd", "http://www.w3.org/2001/XMLSchema");
+        env.addNamespaceDeclaration("xsi", "http://www.w3.org/2001/XMLSchema-instance");
+        env.addNamespaceDeclaration("soapenc", "http://schemas.xmlsoap.org/soap/encoding/");
+        xoap::SOAPName    tname    = env.createName("type", "xsi", "http://www.w3.org/2001/XMLSchema-instance");
+        std::string       appURN   = "urn:xdaq-application:"+destDsc->getClassName();
+        xoap::SOAPName    pboxname = env.createName("Properties", "props", appURN);
+        xoap::SOAPElement pbox     = container.addChildElement(pboxname);
+        pbox.addAttribute(tname, "soapenc:Struct");
+        xoap::SOAPName    soapName = env.createName(parName, "props", appURN);
+        xoap::SOAPElement cs       = pbox.addChildElement(soapName);
+        cs.addAttribute(tname, parType);
+        return tmpl;
+      });
+    // ParameterSet/Properties/<parName>
+    firstBodyElement(msg, 3).addTextNode(parValue);
+
+    INFO("GEMSOAPToolBox::sendApplicationParameter message:" << std::endl << messageToString(msg));
 
-    xoap::SOAPEnvelope env       = msg->getSOAPPart().getEnvelope();
-    xoap::SOAPName     soapcmd   = env.createName("ParameterSet", "xdaq", XDAQ_NS_URI);
-    xoap::SOAPElement  container = env.getBody().addBodyElement(soapcmd);
-    env.addNamespaceDeclaration("xsd", "http://www.w3.org/2001/XMLSchema");
-    env.addNamespaceDeclaration("xsi", "http://www.w3.org/2001/XMLSchema-instance");
-    env.addNamespaceDeclaration("soapenc", "http://schemas.xmlsoap.org/soap/encoding/");
-    xoap::SOAPName    tname    = env.createName("type", "xsi", "http://www.w3.org/2001/XMLSchema-instance");
-    std::string       appURN   = "urn:xdaq-application:"+destDsc->getClassName();
-    xoap::SOAPName    pboxname = env.createName("Properties", "props", appURN);
-    xoap::SOAPElement pbox     = container.addChildElement(pboxname);
-    pbox.addAttribute(tname, "soapenc:Struct");
-    xoap::SOAPName    soapName = env.createName(parName, "props", appURN);
-    xoap::SOAPElement cs       = pbox.addChildElement(soapName);
-    cs.addAttribute(tname, parType);
-    cs.addTextNode(parValue);
-
-    std::string tool;
-    INFO("GEMSOAPToolBox::sendApplicationParameter message:");
-    msg->writeTo(tool);
-    INFO(tool);
-    tool.clear();
-
-    reply = appCxt->postSOAP(msg, *srcDsc, *destDsc);
-    INFO("GEMSOAPToolBox::sendApplicationParameter reply:");
-    reply->writeTo(tool);
-    INFO(tool);
+    xoap::MessageReference reply = appCxt->postSOAP(msg, *srcDsc, *destDsc);
+    INFO("GEMSOAPToolBox::sendApplicationParameter reply:" << std::endl << messageToString(reply));
   } catch (gem::utils::exception::Exception& e) {
     std::string errMsg = toolbox::toString("Send application parameter %s[%s,%s] failed [%s]",
                                            parName.c_str(), parType.c_str(), parValue.c_str(), e.what());
@@ -555,39 +568,77 @@ xoap::MessageReference gem::utils::soap::GEMSOAPToolBox::createStateRequestMessa
                                                                                    std::string const& appURN,
                                                                                    bool const& isGEMApp)
 {
-  log4cplus::Logger m_gemLogger(log4cplus::Logger::getInstance("GEMSOAPToolBoxLogger"));
+  std::string const key = "StateRequest:" + nstag + ":" + appURN + (isGEMApp ? ":gem" : "");
+  return cloneMessageTemplate(key, [&]() {
+      xoap::MessageReference msg = xoap::createMessage();
+
+      xoap::SOAPEnvelope env       = msg->getSOAPPart().getEnvelope();
+      xoap::SOAPName     soapcmd   = env.createName("ParameterGet", "xdaq", XDAQ_NS_URI);
+      xoap::SOAPName     tname     = env.createName("type", "xsi", "http://www.w3.org/2001/XMLSchema-instance");
+      xoap::SOAPElement  container = env.getBody().addBodyElement(soapcmd);
+      env.addNamespaceDeclaration("xsd", "http://www.w3.org/2001/XMLSchema");
+      env.addNamespaceDeclaration("xsi", "http://www.w3.org/2001/XMLSchema-instance");
+      env.addNamespaceDeclaration("soapenc", "http://schemas.xmlsoap.org/soap/encoding/");
+      xoap::SOAPName    pboxname = env.createName("properties", nstag, appURN);
+      xoap::SOAPElement prop     = container.addChildElement(pboxname);
+      prop.addAttribute(tname, "soapenc:Struct");
+
+      if (isGEMApp) {
+        xoap::SOAPName    msgN   = env.createName("StateMessage",  nstag, appURN);
+        xoap::SOAPElement msgE   = prop.addChildElement(msgN);
+        xoap::SOAPName    progN  = env.createName("StateProgress", nstag, appURN);
+        xoap::SOAPElement progE  = prop.addChildElement(progN);
+        xoap::SOAPName    stateN = env.createName("StateName",     nstag, appURN);
+        xoap::SOAPElement stateE = prop.addChildElement(stateN);
+        msgE.addAttribute(  tname, "xsd:string");
+        progE.addAttribute( tname, "xsd:double");
+        stateE.addAttribute(tname, "xsd:string");
+      } else {
+        xoap::SOAPName    stateN = env.createName("stateName", nstag, appURN);
+        xoap::SOAPElement stateE = prop.addChildElement(stateN);
+        stateE.addAttribute(tname, "xsd:string");
+      }
+
+      return msg;
+    });
+}
+
+xoap::MessageReference gem::utils::soap::GEMSOAPToolBox::createStateNotificationMessage(std::string const& className,
+                                                                                        uint32_t    const& instance,
+                                                                                        std::string const& stateName,
+                                                                                        std::string const& stateMessage)
+{
   xoap::MessageReference msg = xoap::createMessage();
 
   xoap::SOAPEnvelope env       = msg->getSOAPPart().getEnvelope();
-  xoap::SOAPName     soapcmd   = env.createName("ParameterGet", "xdaq", XDAQ_NS_URI);
-  xoap::SOAPName     tname     = env.createName("type", "xsi", "http://www.w3.org/2001/XMLSchema-instance");
+  xoap::SOAPName     soapcmd   = env.createName("StateNotification", "xdaq", XDAQ_NS_URI);
   xoap::SOAPElement  container = env.getBody().addBodyElement(soapcmd);
-  env.addNamespaceDeclaration("xsd", "http://www.w3.org/2001/XMLSchema");
-  env.addNamespaceDeclaration("xsi", "http://www.w3.org/2001/XMLSchema-instance");
-  env.addNamespaceDeclaration("soapenc", "http://schemas.xmlsoap.org/soap/encoding/");
-  xoap::SOAPName    pboxname = env.createName("properties", nstag, appURN);
-  xoap::SOAPElement prop     = container.addChildElement(pboxname);
-  prop.addAttribute(tname, "soapenc:Struct");
-
-  if (isGEMApp) {
-    xoap::SOAPName    msgN   = env.createName("StateMessage",  nstag, appURN);
-    xoap::SOAPElement msgE   = prop.addChildElement(msgN);
-    xoap::SOAPName    progN  = env.createName("StateProgress", nstag, appURN);
-    xoap::SOAPElement progE  = prop.addChildElement(progN);
-    xoap::SOAPName    stateN = env.createName("StateName",     nstag, appURN);
-    xoap::SOAPElement stateE = prop.addChildElement(stateN);
-    msgE.addAttribute(  tname, "xsd:string");
-    progE.addAttribute( tname, "xsd:double");
-    stateE.addAttribute(tname, "xsd:string");
-  } else {
-    xoap::SOAPName    stateN = env.createName("stateName", nstag, appURN);
-    xoap::SOAPElement stateE = prop.addChildElement(stateN);
-    stateE.addAttribute(tname, "xsd:string");
-  }
+
+  container.addChildElement(env.createName("ClassName",    "xdaq", XDAQ_NS_URI)).addTextNode(className);
+  container.addChildElement(env.createName("Instance",     "xdaq", XDAQ_NS_URI)).addTextNode(toolbox::toString("%d", instance));
+  container.addChildElement(env.createName("StateName",    "xdaq", XDAQ_NS_URI)).addTextNode(stateName);
+  container.addChildElement(env.createName("StateMessage", "xdaq", XDAQ_NS_URI)).addTextNode(stateMessage);
 
   return msg;
 }
 
+std::unordered_map<std::string, std::string> gem::utils::soap::GEMSOAPToolBox::extractStateNotification(xoap::MessageReference const& msg)
+{
+  std::unordered_map<std::string, std::string> notification;
+  std::vector<xoap::SOAPElement> bodyList = msg->getSOAPPart().getEnvelope().getBody().getChildElements();
+  if (bodyList.size() != 1) {
+    XCEPT_RAISE(xoap::exception::Exception,
+                toolbox::toString("Expected exactly one element "
+                                  "in StateNotification SOAP message, "
+                                  "but found %d.", bodyList.size()));
+  }
+
+  std::vector<xoap::SOAPElement> fields = bodyList[0].getChildElements();
+  for (auto field = fields.begin(); field != fields.end(); ++field)
+    notification[field->getElementName().getLocalName()] = field->getValue();
+  return notification;
+}
+
 std::string gem::utils::soap::GEMSOAPToolBox::getApplicationState(xdaq::ApplicationContext*    appCxt,
                                                                   xdaq::ApplicationDescriptor* srcDsc,
                                                                   xdaq::ApplicationDescriptor* destDsc)
@@ -605,13 +656,9 @@ std::string gem::utils::soap::GEMSOAPToolBox::getApplicationState(xdaq::Applicat
       isGEMApp     = false;
     }
 
-    xoap::MessageReference msg =
-      xoap::createMessage(gem::utils::soap::GEMSOAPToolBox::createStateRequestMessage("app", appURN, isGEMApp));
+    xoap::MessageReference msg = gem::utils::soap::GEMSOAPToolBox::createStateRequestMessage("app", appURN, isGEMApp);
     std::string nstag = "gemapp";
 
-    std::stringstream debugstream;
-    msg->writeTo(debugstream);
-
     xoap::MessageReference answer = appCxt->postSOAP(msg, *srcDsc, *destDsc);
 
     xoap::SOAPName stateReply(responseName, nstag, appURN);
@@ -624,16 +671,11 @@ std::string gem::utils::soap::GEMSOAPToolBox::getApplicationState(xdaq::Applicat
             << " returned state " << stateString);
       return stateString;
     } else {
-      std::string toolInput;
-      xoap::dumpTree(msg->getSOAPPart().getEnvelope().getDOMNode(),    toolInput);
-      std::string  toolOutput;
-      xoap::dumpTree(answer->getSOAPPart().getEnvelope().getDOMNode(), toolOutput);
-
       if (answer->getSOAPPart().getEnvelope().getBody().hasFault()) {
         std::stringstream errMsg;
         errMsg << "SOAP fault getting state: " << std::endl
-               << "SOAP request:"      << std::endl << toolInput  << std::endl
-               << "SOAP reply:"        << std::endl << toolOutput << std::endl
+               << "SOAP request:"      << std::endl << messageToString(msg)    << std::endl
+               << "SOAP reply:"        << std::endl << messageToString(answer) << std::endl
                << "SOAP fault string:" << std::endl
                << answer->getSOAPPart().getEnvelope().getBody().getFault().getFaultString();
         XCEPT_RAISE(gem::utils::exception::SOAPException, errMsg.str());